@@ -0,0 +1,23 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+/// @namespace AllocationCounter
+/// @brief Counts heap allocations, to check that code meant to be allocation free is.
+///
+/// Built with TETRIS_COUNT_ALLOCATIONS, AllocationCounter.cpp replaces the global operator new and
+/// delete with versions that count every allocation through them; otherwise it leaves the allocator
+/// alone and counts nothing. It is compiled into the executables that report the count, never into
+/// tetrisCore, so a program loading libtetris_env keeps its own allocator.
+/// Allocations with extended alignment go through the aligned operator new and aren't counted.
+namespace AllocationCounter
+{
+    /// Checks whether allocations are being counted.
+    /// @return True when built with TETRIS_COUNT_ALLOCATIONS.
+    bool isEnabled();
+
+    /// Gets the number of allocations made so far by every thread.
+    /// @return The count, always 0 when not enabled.
+    long long getCount();
+}
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,229 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ArenaAgent.h"
+#include "Game.h"
+#include "WorkerPool.h"
+
+/// @struct ArenaOptions
+/// @brief How an Arena runs its tournament.
+struct ArenaOptions
+{
+    int games = 2;             ///< Games each pairing plays per round, every pairing of a round on the same seeds.
+    int rounds = 0;            ///< Swiss rounds, 0 for a round robin where every agent meets every other once.
+    int pieces = 500;          ///< Pieces each side may place, a game both survive is decided on garbage sent.
+    double moveLimit = 0.0;    ///< Milliseconds a move may take before the agent forfeits, checked once it returns, 0 for no limit.
+    double hangLimit = 10000.0; ///< Milliseconds a plugin's move may run before the arena stops waiting and it forfeits, 0 to wait for ever.
+    unsigned int seed = 1;     ///< Seeds the piece sequences.
+    int threads = 1;           ///< Threads playing games, each game runs on one.
+};
+
+/// @struct ArenaGame
+/// @brief One game between two agents.
+struct ArenaGame
+{
+    int round = 0;                  ///< Round the game was played in.
+    int agents[2] = {0, 0};         ///< The two agents.
+    unsigned int seed = 0;          ///< Piece sequence both sides played.
+    double score = 0.5;             ///< The first agent's result, 1 for a win, 0.5 for a draw and 0 for a loss.
+    int pieces[2] = {0, 0};         ///< Pieces each side placed.
+    int lines[2] = {0, 0};          ///< Rows each side cleared.
+    int sent[2] = {0, 0};           ///< Garbage rows each side sent after cancelling its own.
+    bool toppedOut[2] = {false, false}; ///< Whether each side's stack reached the top.
+    bool forfeit[2] = {false, false};   ///< Whether each side went over the time limit or resigned.
+    std::vector<float> micros[2];   ///< Each side's move times in microseconds, in order.
+};
+
+/// @struct ArenaStanding
+/// @brief One agent's results over a tournament.
+struct ArenaStanding
+{
+    int agent = 0;              ///< The agent.
+    double elo = 0.0;           ///< Rating fitted to every game, 1500 for an agent that draws everything.
+    double points = 0.0;        ///< Wins plus half the draws, byes counted as wins.
+    int wins = 0;               ///< Games won.
+    int draws = 0;              ///< Games drawn.
+    int losses = 0;             ///< Games lost.
+    int forfeits = 0;           ///< Games lost on time or by resigning.
+    double lines = 0.0;         ///< Rows cleared per game.
+    long long moves = 0;        ///< Moves timed.
+    double medianMicros = 0.0;  ///< Median move time.
+    double slowMicros = 0.0;    ///< 99th percentile move time.
+    double maxMicros = 0.0;     ///< Slowest move.
+    std::vector<long long> histogram; ///< Moves per octave of microseconds, bucket b from 2^b up to 2^(b+1), bucket 0 from 0.
+};
+
+/// @class ArenaAgent
+/// @brief One entrant of a tournament: a plugin loaded from a shared library or a built-in bot.
+///
+/// "search:D" is the placement search looking D pieces ahead and "mcts:MS" the Monte Carlo tree
+/// search thinking MS milliseconds a move on one thread; built-ins read the game directly instead
+/// of going through the C structs. Any other spec is a shared library opened with dlopen, which
+/// must export tetris_agent_api(), see ArenaAgent.h.
+class ArenaAgent
+{
+public:
+    /// What plays the moves.
+    enum class Kind
+    {
+        Plugin,     ///< A shared library.
+        Search,     ///< BasicPlacementSearch::FindBest.
+        TreeSearch  ///< BasicMonteCarloSearch::Think.
+    };
+
+    ArenaAgent() = default;
+
+    /// Destructor, closes the library.
+    ~ArenaAgent();
+
+    ArenaAgent(const ArenaAgent&) = delete;
+    ArenaAgent& operator=(const ArenaAgent&) = delete;
+
+    /// Loads a plugin or sets up a built-in, printing why it failed.
+    /// @param spec A library path, "search:D" or "mcts:MS".
+    /// @return False if the spec is malformed or the library isn't a plugin of this ABI version.
+    bool Load(const std::string& spec);
+
+    /// Gets what plays the moves.
+    /// @return The kind.
+    Kind getKind() const { return _kind; }
+
+    /// Gets the name shown in the tables.
+    /// @return The plugin's name or the built-in's spec.
+    const std::string& getName() const { return _name; }
+
+    /// Renames the agent, the arena numbers agents that share a name.
+    /// @param name The new name.
+    void setName(const std::string& name) { _name = name; }
+
+    /// Gets the plugin's functions.
+    /// @return The table, nullptr for a built-in.
+    const TetrisAgentApi* getApi() const { return _api; }
+
+    /// Gets the built-in's setting.
+    /// @return The search depth or the thinking time in milliseconds.
+    double getSetting() const { return _setting; }
+
+    /// Records that a move of the plugin was left running, the library then stays loaded until the process exits.
+    void Abandon() const { ++_abandoned; }
+
+    /// Gets the number of moves left running.
+    /// @return The moves abandoned past ArenaOptions::hangLimit.
+    int getAbandoned() const { return _abandoned; }
+
+private:
+    Kind _kind = Kind::Search;          ///< What plays the moves.
+    std::string _name;                  ///< Name shown in the tables.
+    void* _library = nullptr;           ///< dlopen handle of a plugin.
+    const TetrisAgentApi* _api = nullptr; ///< The plugin's functions.
+    double _setting = 1.0;              ///< Search depth or thinking time of a built-in.
+    mutable std::atomic<int> _abandoned{0}; ///< Moves left running, their threads may still be in the library.
+};
+
+/// @class Arena
+/// @brief Plays agents against each other in a round robin or Swiss tournament and rates them.
+///
+/// A game is a duel on two standard boards with the same seed, so both sides get the same pieces.
+/// Each turn both sides place one piece, then the rows they cleared go to the other as garbage,
+/// cancelling garbage of their own first, the same exchange VersusMatch makes. The first side to
+/// top out loses, a move over the time limit or a resignation loses straight away, and a game
+/// both survive to the piece limit goes to whoever sent more garbage, then cleared more rows.
+/// Both sides forfeiting on the same turn is a draw. The time limit is checked once a move
+/// returns; a plugin's moves run on a thread of the seat's own, and one still running after the
+/// hang limit is reported and left behind, the seat forfeiting so the tournament carries on.
+///
+/// Every pairing of a round plays the same seeds, so differences between agents come from their
+/// moves rather than their luck. A round robin is one round with every pair; a Swiss round pairs
+/// agents on equal points that haven't met where it can, the odd one out getting a bye. The
+/// games of a round are handed to the threads of a WorkerPool one at a time, each game on a
+/// single thread, and every move is timed. Ratings are the Bradley-Terry maximum likelihood
+/// fit to all the games on the Elo scale, with a prior of one draw against a 1500 anchor so an
+/// agent that wins or loses everything still gets a finite rating.
+class Arena
+{
+public:
+    /// Constructor.
+    /// @param options Tournament settings.
+    explicit Arena(const ArenaOptions& options);
+
+    /// Adds an entrant, see ArenaAgent::Load.
+    /// @param spec A library path, "search:D" or "mcts:MS".
+    /// @return False if it couldn't be loaded, the reason is printed.
+    bool AddAgent(const std::string& spec);
+
+    /// Plays the tournament.
+    /// @param progress Called after each round with the round's index.
+    template <typename Progress>
+    void Run(Progress&& progress)
+    {
+        int rounds = _options.rounds > 0 ? _options.rounds : 1;
+        for (int round = 0; round < rounds; ++round)
+        {
+            PlayRound(round, _options.rounds > 0 ? SwissPairings() : RoundRobinPairings());
+            progress(round);
+        }
+    }
+
+    /// Plays one game.
+    /// @param first The first agent.
+    /// @param second The second agent.
+    /// @param seed The piece sequence.
+    /// @param options Piece and time limits.
+    /// @param game Receives the result, round and agents are left as they are.
+    static void PlayGame(const ArenaAgent& first, const ArenaAgent& second, unsigned int seed, const ArenaOptions& options,
+                         ArenaGame& game);
+
+    /// Gets every game played so far.
+    /// @return The games, round by round.
+    const std::vector<ArenaGame>& getGames() const { return _games; }
+
+    /// Gets each agent's results, best rated first.
+    /// @return One standing per agent.
+    std::vector<ArenaStanding> getStandings() const;
+
+    /// Gets an entrant.
+    /// @param agent Its index, in the order added.
+    /// @return The agent.
+    const ArenaAgent& getAgent(int agent) const { return *_agents[agent]; }
+
+    /// Gets the number of entrants.
+    /// @return The count.
+    int getAgentCount() const { return static_cast<int>(_agents.size()); }
+
+    /// Gets the settings.
+    /// @return The options.
+    const ArenaOptions& getOptions() const { return _options; }
+
+private:
+    using Pairings = std::vector<std::pair<int, int>>;
+
+    /// Pairs every agent with every other.
+    /// @return The pairs.
+    Pairings RoundRobinPairings() const;
+
+    /// Pairs agents on equal points that haven't met, giving the lowest ranked without one a bye.
+    /// @return The pairs.
+    Pairings SwissPairings();
+
+    /// Plays options.games games for every pair over all threads.
+    /// @param round The round, picks the seeds.
+    /// @param pairings The pairs.
+    void PlayRound(int round, const Pairings& pairings);
+
+    /// Fits the ratings to the games played.
+    /// @return One Elo per agent.
+    std::vector<double> FitRatings() const;
+
+    ArenaOptions _options;                              ///< Tournament settings.
+    std::vector<std::unique_ptr<ArenaAgent>> _agents;   ///< The entrants.
+    std::vector<ArenaGame> _games;                      ///< Every game, round by round.
+    std::vector<int> _byes;                             ///< Byes each agent has had.
+    std::unique_ptr<WorkerPool> _pool;                  ///< Threads playing games.
+};
+
+#endif // ARENA_H
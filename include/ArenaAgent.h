@@ -0,0 +1,87 @@
+#ifndef ARENAAGENT_H
+#define ARENAAGENT_H
+
+#include <stdint.h>
+
+/* The C interface tetris_arena loads agent plugins through. A plugin is a shared library that
+   exports tetris_agent_api(); it needs nothing from the engine, the shapes come in the config.
+   An agent places pieces rather than pressing buttons: it names a rotation and a column, the
+   arena turns the piece to it at the spawn row, shifts it and drops it straight down.
+   Games run on several threads at once, so the functions must be safe to call on different
+   agents concurrently; one agent is only ever called from one thread at a time. */
+
+/* Bumped whenever a struct below changes, the arena refuses plugins built for another version. */
+#define TETRIS_AGENT_ABI_VERSION 1
+
+#if defined(_WIN32)
+#define TETRIS_AGENT_VISIBLE __declspec(dllexport)
+#else
+#define TETRIS_AGENT_VISIBLE __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+#define TETRIS_AGENT_EXPORT extern "C" TETRIS_AGENT_VISIBLE
+#else
+#define TETRIS_AGENT_EXPORT TETRIS_AGENT_VISIBLE
+#endif
+
+enum
+{
+    TETRIS_AGENT_MAX_ROWS = 64,
+    TETRIS_AGENT_PIECES = 7,
+    TETRIS_AGENT_ROTATIONS = 4,
+    TETRIS_AGENT_PREVIEW = 5
+};
+
+/* What an agent is told once, when the arena creates it for a game. */
+typedef struct TetrisAgentConfig
+{
+    int32_t width;              /* board columns */
+    int32_t height;             /* board rows */
+    int32_t moveLimitMicros;    /* a move taking longer forfeits the game, 0 for no limit */
+    uint32_t seed;              /* the game's piece sequence seed, for agents that want their own randomness */
+    /* shapes[type - 1][rotation][i] is row i of the piece's 4x4 box counted up from its bottom,
+       bit j set where column j of the box is filled */
+    uint8_t shapes[TETRIS_AGENT_PIECES][TETRIS_AGENT_ROTATIONS][4];
+} TetrisAgentConfig;
+
+/* The game as the agent sees it before each move. */
+typedef struct TetrisAgentState
+{
+    uint64_t rows[TETRIS_AGENT_MAX_ROWS]; /* the stack without the active piece, row 0 at the bottom, bit j column j */
+    int32_t piece;                        /* active piece type, 1..TETRIS_AGENT_PIECES */
+    int32_t rotation;                     /* its rotation index at spawn */
+    int32_t x;                            /* column of the left edge of its box at spawn */
+    int32_t y;                            /* row of the bottom of its box at spawn */
+    int32_t preview[TETRIS_AGENT_PREVIEW]; /* upcoming piece types, next first */
+    int32_t pieces;                       /* pieces placed so far */
+    int32_t lines;                        /* rows cleared so far */
+    int32_t pendingGarbage;               /* garbage rows the opponent has sent, inserted at the next lock without a clear */
+    int32_t opponentHeight;               /* rows of the opponent's stack */
+} TetrisAgentState;
+
+/* Where to drop the active piece. */
+typedef struct TetrisAgentMove
+{
+    int32_t rotation; /* rotation index, 0..TETRIS_AGENT_ROTATIONS-1 */
+    int32_t x;        /* column of the left edge of the piece box, shifting stops at the walls */
+} TetrisAgentMove;
+
+/* The functions and name of one kind of agent. */
+typedef struct TetrisAgentApi
+{
+    uint32_t abiVersion; /* TETRIS_AGENT_ABI_VERSION */
+    const char* name;    /* shown in the tables, unique among the agents of a tournament is best */
+    /* makes an agent for one game, NULL on failure */
+    void* (*create)(const TetrisAgentConfig* config);
+    /* picks a move, returns 0 or anything else to resign */
+    int (*choose)(void* agent, const TetrisAgentState* state, TetrisAgentMove* move);
+    /* frees an agent once its game is over */
+    void (*destroy)(void* agent);
+} TetrisAgentApi;
+
+/* The symbol the arena looks up, the returned table must outlive the library. */
+typedef const TetrisAgentApi* (*TetrisAgentEntry)(void);
+#define TETRIS_AGENT_ENTRY "tetris_agent_api"
+
+#endif /* ARENAAGENT_H */
@@ -1,43 +1,86 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include <array>
+#include <cstdint>
 #include <iostream>
+#include <type_traits>
 #include <vector>
+#include "PieceSet.h"
+#include "PieceTable.h"
 #include "Tetromino.h"
-#include "ngl/Vec4.h"
 
-/// @struct BlockInfo
-/// @brief Holds information about each block on the game board including occupancy and color.
-struct BlockInfo {
-    bool occupied; ///< Flag indicating whether the block is occupied.
-    ngl::Vec4 colour; ///< Color of the block, represented using ngl::Vec4.
-};
-
-/// @class Board
+/// Board dimension meaning "chosen at construction" instead of at compile time.
+constexpr int Dynamic = 0;
+
+/// Smallest unsigned integer holding one row of a board, std::uint64_t for runtime widths.
+template <int Width>
+using RowMaskFor = std::conditional_t<Width == Dynamic || (Width > 32), std::uint64_t,
+                   std::conditional_t<(Width > 16), std::uint32_t,
+                   std::conditional_t<(Width > 8), std::uint16_t, std::uint8_t>>>;
+
+/// Mixes the bits of a 64-bit value so every input bit affects every output bit (splitmix64's finaliser).
+/// @param value The value to mix.
+/// @return The mixed value.
+inline std::uint64_t ZobristMix(std::uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+/// Fixed size array when the element count is known at compile time, vector otherwise.
+template <typename T, int Count>
+using BoardStorage = std::conditional_t<Count == Dynamic, std::vector<T>, std::array<T, Count>>;
+
+/// @class BasicBoard
 /// @brief Manages the game board for a Tetris game, including block positions and interactions.
-class Board{
+///
+/// Each row is stored as a bit mask so collision, placement and line clears work a row at a
+/// time. Colours are kept alongside as a 3-bit palette index per cell, stored as three more
+/// masks per row, one per bit, so they move with their rows for the same cost. With the width and height fixed at compile
+/// time the masks use the narrowest integer and every loop over the board or a piece has
+/// constant bounds. Pass Dynamic for either dimension to size the board at runtime instead.
+/// A Zobrist hash of the occupancy is kept up to date as rows change, see getHash().
+/// Instantiations are compiled in Board.cpp; add a line there for a new size.
+/// @tparam Width Columns, at most MaxWidth, or Dynamic.
+/// @tparam Height Rows, or Dynamic.
+/// @tparam PieceSet Shapes of the pieces played, see StandardTetrominoes.
+template <int Width, int Height, typename PieceSet = StandardTetrominoes>
+class BasicBoard{
 public:
-    /// Default constructor.
-    Board() = default;
+    /// Widest supported board, leaves room in a 64-bit row to shift a piece past the right edge.
+    static constexpr int MaxWidth = 56;
+    static_assert(Width <= MaxWidth, "Board too wide for 64-bit row masks");
+
+    static constexpr int FixedWidth = Width;   ///< Columns, Dynamic if chosen at runtime.
+    static constexpr int FixedHeight = Height; ///< Rows, Dynamic if chosen at runtime.
+
+    using Pieces = PieceSet;                ///< Piece set played on this board.
+    using RowMask = RowMaskFor<Width>;      ///< One row of occupancy, bit j is column j.
 
     /// Constructor to create a board with specified dimensions.
-    /// @param width The width of the board.
-    /// @param height The height of the board.
-    Board(int width, int height);
+    /// @param width The width of the board, must equal Width unless Width is Dynamic.
+    /// @param height The height of the board, must equal Height unless Height is Dynamic.
+    explicit BasicBoard(int width = Width, int height = Height);
 
-    /// Retrieves the color of the block at the specified position.
+    /// Gets the palette index of a block, see PaletteSize.
     /// @param row The row index of the block.
     /// @param col The column index of the block.
-    /// @return The color of the block if occupied; otherwise, returns transparent color.
-    ngl::Vec4 GetBlock(int row, int col) const;
-
-    /// Checks for collisions with the Tetromino.
+    /// @return The index, only meaningful where getRow() says the cell is occupied.
+    int getPaletteIndex(int row, int col) const
+    {
+        return static_cast<int>((_palette[0][row] >> col & 1) | (_palette[1][row] >> col & 1) << 1 |
+                                (_palette[2][row] >> col & 1) << 2);
+    }
+
+    /// Checks for collisions with the Tetromino, ignoring the cells it already covers.
     /// @param tetromino The tetromino to check.
     /// @param Down The downward movement to apply.
     /// @param Left The leftward movement to apply.
     /// @param Right The rightward movement to apply.
     /// @return True if there is a collision; otherwise, false.
-    bool IsCollision(const Tetromino& tetromino, int Down, int Left, int Right);
+    bool IsCollision(const Tetromino& tetromino, int Down, int Left, int Right) const;
 
     /// Clears the Tetromino from the board.
     /// @param tetromino The tetromino to clear.
@@ -50,7 +93,7 @@ public:
     /// Moves the Tetromino in the specified direction.
     /// @param tetromino The tetromino to move.
     /// @param direction The direction to move the tetromino.
-    /// @return True if the move was successful; otherwise, false.
+    /// @return True if the move was blocked; otherwise, false.
     bool MoveTetromino(Tetromino& tetromino, int direction);
 
     /// Rotates the Tetromino on the board.
@@ -58,28 +101,152 @@ public:
     /// @return True if the rotation was successful; otherwise, false.
     bool RotateTetromino(Tetromino& tetromino);
 
-    /// Clears any full rows on the board and updates the score accordingly.
-    void ClearFullRows();
+    /// Checks whether a tetromino that isn't on the board yet would overlap the edges or the stack.
+    /// @param tetromino The tetromino to check, e.g. one about to spawn.
+    /// @return True if any of its blocks is out of bounds or on an occupied cell.
+    bool Overlaps(const Tetromino& tetromino) const;
+
+    /// Checks whether a cell is occupied, treating everything outside the board as a wall.
+    /// @param row The row index.
+    /// @param col The column index.
+    /// @return True if the cell is occupied or out of bounds.
+    bool IsBlocked(int row, int col) const;
+
+    /// Clears any full rows on the board.
+    /// @return The number of rows cleared.
+    int ClearFullRows() { return ClearFullRows(0, getHeight() - 1); }
+
+    /// Clears full rows, only looking for them between two rows, e.g. the rows a piece just locked in.
+    /// Rows above the range still move down; rows below it aren't touched.
+    /// @param bottom The lowest row that may be full.
+    /// @param top The highest row that may be full.
+    /// @return The number of rows cleared.
+    int ClearFullRows(int bottom, int top);
+
+    /// Pushes the stack up and fills the bottom rows with garbage, leaving one empty column.
+    /// @param count The number of garbage rows to insert.
+    /// @param hole The column left empty in every garbage row.
+    /// @return True if any block was pushed off the top of the board.
+    bool AddGarbageRows(int count, int hole);
 
     /// Gets the height of the board.
     /// @return The height of the board.
-    int getHeight() const;
+    int getHeight() const { return Height == Dynamic ? height_ : Height; }
 
     /// Gets the width of the board.
     /// @return The width of the board.
-    int getWidth() const;
-
-    /// Gets the current score.
-    /// @return The score.
-    int getScore() const;
+    int getWidth() const { return Width == Dynamic ? width_ : Width; }
+
+    /// Gets the column new pieces spawn in.
+    /// @return The left edge of the spawn box, roughly centred.
+    int getSpawnX() const { return getWidth() / 2 - 1; }
+
+    /// Gets the row new pieces spawn in.
+    /// @return The bottom of the spawn box, touching the top of the board.
+    int getSpawnY() const { return getHeight() - PieceSet::Size; }
+
+    /// Gets the occupancy of one row.
+    /// @param row The row index.
+    /// @return The row mask, bit j set if column j is occupied.
+    RowMask getRow(int row) const { return _rows[row]; }
+
+    /// Checks whether a row is complete and would be cleared.
+    /// @param row The row index.
+    /// @return True if every column of the row is occupied.
+    bool IsRowFull(int row) const { return _rows[row] == static_cast<RowMask>(FullRow()); }
+
+    /// Gets the Zobrist hash of the occupancy, the XOR of RowKey() over every row. It is updated
+    /// incrementally as pieces are drawn, locked and cleared, so reading it costs nothing.
+    /// Boards with equal occupancy hash equal whatever their colours.
+    /// @return The 64-bit hash, 0 for an empty board.
+    std::uint64_t getHash() const { return _hash; }
+
+    /// Gets the Zobrist key of one row's contents. Keys are derived by mixing rather than drawn from
+    /// a table, so every board size shares them and an empty row's key is 0.
+    /// @param row The row index.
+    /// @param mask The row's occupancy.
+    /// @return The key XORed into the board hash for this row.
+    static std::uint64_t RowKey(int row, std::uint64_t mask)
+    {
+        return mask ? ZobristMix(mask + 0x9e3779b97f4a7c15ull * static_cast<std::uint64_t>(row + 1)) : 0;
+    }
+
+    /// Hashes the board's contents, used to check that two simulations agree.
+    /// @return A 32-bit FNV-1a hash of occupancy and colours.
+    std::uint32_t Checksum() const;
 
 private:
+    /// Bits of a palette index, enough for PaletteSize colours.
+    static constexpr int PaletteBits = 3;
+    static_assert(PaletteSize <= 1 << PaletteBits, "Palette indices don't fit the colour planes");
+
     int width_;  ///< Width of the board.
     int height_; ///< Height of the board.
-    int _score = 0; ///< Current score.
 
-    /// 2D vector holding block information for each position on the board.
-    std::vector<std::vector<BlockInfo>> _blockInfo;
+    BoardStorage<RowMask, Height> _rows;       ///< Occupancy of each row, row 0 at the bottom.
+    std::array<BoardStorage<RowMask, Height>, PaletteBits> _palette; ///< Bit i of each cell's palette index, per row.
+    std::uint64_t _hash = 0;                    ///< Zobrist hash of _rows, see getHash().
+
+    /// Replaces one row's occupancy and updates the hash.
+    /// @param row The row index.
+    /// @param mask The new occupancy.
+    void SetRow(int row, RowMask mask)
+    {
+        _hash ^= RowKey(row, _rows[row]) ^ RowKey(row, mask);
+        _rows[row] = mask;
+    }
+
+    /// Gets the part of the hash contributed by a range of rows.
+    /// @param bottom The lowest row.
+    /// @param top One past the highest row.
+    /// @return The XOR of the rows' keys.
+    std::uint64_t HashRows(int bottom, int top) const;
+
+    /// Gets a mask with every column of a row set.
+    /// @return The full row mask.
+    std::uint64_t FullRow() const { return (1ull << getWidth()) - 1; }
+
+    /// Moves a row of a piece shape to a column.
+    /// @param bits The shape row, bit j is column j of the piece box.
+    /// @param x The board column of the left edge of the piece box.
+    /// @param out Receives the row in board columns.
+    /// @return False if any block lands off either side of the board.
+    bool ShiftRow(std::uint64_t bits, int x, std::uint64_t& out) const;
+
+    /// Gets the cells a tetromino covers in one row at its current position.
+    /// @param tetromino The tetromino on the board.
+    /// @param row The board row.
+    /// @return The covered columns as a row mask.
+    std::uint64_t CoveredRow(const Tetromino& tetromino, int row) const;
+
+    /// Checks whether a shape would overlap the edges or the stack, ignoring a tetromino already on the board.
+    /// @param shape The shape to test.
+    /// @param x The column of the left edge of the shape box.
+    /// @param y The row of the bottom edge of the shape box.
+    /// @param placed The tetromino whose cells are ignored, nullptr if it isn't on the board.
+    /// @return True if there is a collision.
+    bool Collides(const typename PieceSet::Shape& shape, int x, int y, const Tetromino* placed) const;
 };
 
+/// Standard 10x20 board the game is played on.
+using Board = BasicBoard<10, 20>;
+
+/// Guideline 10x40 board, the top half is buffer for pieces pushed up by garbage.
+using TallBoard = BasicBoard<10, 40>;
+
+/// Board sized at runtime for custom modes.
+using DynamicBoard = BasicBoard<Dynamic, Dynamic>;
+
+/// Standard board played with pentominoes, see CustomPieces::Use.
+using PentominoBoard = BasicBoard<10, 20, Pentominoes>;
+
+/// Board sized at runtime played with custom polyominoes up to 8x8.
+using PolyominoBoard = BasicBoard<Dynamic, Dynamic, Polyominoes>;
+
+extern template class BasicBoard<10, 20>;
+extern template class BasicBoard<10, 40>;
+extern template class BasicBoard<Dynamic, Dynamic>;
+extern template class BasicBoard<10, 20, Pentominoes>;
+extern template class BasicBoard<Dynamic, Dynamic, Polyominoes>;
+
 #endif // BOARD_H
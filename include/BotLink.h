@@ -0,0 +1,125 @@
+#ifndef BOTLINK_H
+#define BOTLINK_H
+
+#include <cstdint>
+#include <string>
+#include "Game.h"
+
+struct BotSegment;
+
+/// @class BotLink
+/// @brief Shared memory between the game and a bot in another process, no sockets and no serialisation.
+///
+/// The game creates a named POSIX shared memory segment and publishes the state of one board
+/// into it, the bot opens the same name. The state is guarded by a seqlock: the game bumps a
+/// sequence number to odd, writes and bumps it back to even, and the bot copies the state and
+/// keeps the copy only if the sequence was even and unchanged across it, so the game never waits
+/// for the bot. Placements go back through a single producer, single consumer ring of Commands,
+/// each tagged with the piece count of the snapshot it answers so stale ones can be dropped.
+/// Both sides poll, a round trip is the time to copy a snapshot and a command through the cache.
+class BotLink
+{
+public:
+    /// Rows a snapshot holds, enough for any fixed size board.
+    static constexpr int MaxRows = 64;
+
+    /// Commands the ring holds.
+    static constexpr int RingSize = 16;
+
+    /// @struct Snapshot
+    /// @brief One board as the bot sees it.
+    struct Snapshot
+    {
+        std::uint64_t frame = 0;        ///< Simulation frame the state is from.
+        std::int64_t published = 0;     ///< Now() when the game published it, echoed in the command.
+        std::uint64_t rows[MaxRows]{};  ///< The stack without the active piece, row 0 at the bottom, bit j is column j.
+        std::int32_t width = 0;         ///< Board columns.
+        std::int32_t height = 0;        ///< Board rows.
+        std::int32_t pieces = 0;        ///< Pieces locked so far, the active piece is the next.
+        std::int32_t lines = 0;         ///< Rows cleared so far.
+        std::int32_t score = 0;         ///< Points scored.
+        std::int32_t x = 0;             ///< Column of the left edge of the active piece's box.
+        std::int32_t y = 0;             ///< Row of the bottom of the active piece's box.
+        std::uint8_t piece = 0;         ///< Active piece type, 1 onwards.
+        std::uint8_t rotation = 0;      ///< Active piece rotation index.
+        std::uint8_t preview[PreviewSize]{}; ///< Upcoming piece types, next first.
+        std::uint8_t gameOver = 0;      ///< 1 once the game has ended.
+    };
+
+    /// @struct Command
+    /// @brief Where the bot wants the active piece dropped, straight down from the spawn row.
+    struct Command
+    {
+        std::int32_t pieces = 0;    ///< Snapshot::pieces of the snapshot answered, ignored once another piece is active.
+        std::int32_t rotation = 0;  ///< Rotation index to turn to.
+        std::int32_t x = 0;         ///< Column of the left edge of the piece box.
+        std::int64_t published = 0; ///< Snapshot::published of the snapshot answered, for timing the round trip.
+    };
+
+    BotLink() = default;
+
+    /// Destructor, unmaps the segment and removes its name if this side created it.
+    ~BotLink();
+
+    BotLink(const BotLink&) = delete;
+    BotLink& operator=(const BotLink&) = delete;
+
+    /// Creates the segment, the game's side, replacing one left behind by an earlier run.
+    /// @param name The segment name, a leading '/' is added if missing.
+    /// @return False if it couldn't be created or mapped.
+    bool Create(const std::string& name);
+
+    /// Opens a segment the game created, the bot's side.
+    /// @param name The segment name.
+    /// @return False if there is no such segment yet or it isn't a bot link.
+    bool Open(const std::string& name);
+
+    /// Checks whether a segment is mapped.
+    /// @return True after Create() or Open() succeeded.
+    bool isOpen() const { return _segment != nullptr; }
+
+    /// Publishes a snapshot, game side only.
+    /// @param snapshot The state.
+    void Publish(const Snapshot& snapshot);
+
+    /// Copies the latest snapshot, retrying while the game is writing one.
+    /// @param snapshot Receives the state.
+    /// @return The sequence number it was published under, even, 0 if nothing has been published.
+    std::uint32_t Read(Snapshot& snapshot) const;
+
+    /// Gets the sequence number, cheap enough to spin on while waiting for a new snapshot.
+    /// @return The number, odd while a snapshot is being written.
+    std::uint32_t getSequence() const;
+
+    /// Queues a command, bot side only.
+    /// @param command The placement.
+    /// @return False if the ring is full.
+    bool Submit(const Command& command);
+
+    /// Takes the oldest queued command, game side only.
+    /// @param command Receives the placement.
+    /// @return False if the ring is empty.
+    bool Receive(Command& command);
+
+    /// Fills a snapshot from a game, taking the active piece out of the board's rows.
+    /// @param game The game.
+    /// @param frame The simulation frame.
+    /// @param snapshot Receives the state, published set to Now().
+    static void Capture(const Game& game, std::uint64_t frame, Snapshot& snapshot);
+
+    /// Gets the clock both sides time the round trip with.
+    /// @return steady_clock nanoseconds, the same clock in every process on the machine.
+    static std::int64_t Now();
+
+private:
+    /// Maps the segment of an open descriptor.
+    /// @param descriptor The shared memory descriptor, closed here.
+    /// @return False if it couldn't be mapped.
+    bool Map(int descriptor);
+
+    BotSegment* _segment = nullptr; ///< The mapped segment.
+    std::string _name;              ///< Segment name, removed on destruction if _owner.
+    bool _owner = false;            ///< Whether this side created the segment.
+};
+
+#endif // BOTLINK_H
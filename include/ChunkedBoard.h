@@ -0,0 +1,149 @@
+#ifndef CHUNKEDBOARD_H
+#define CHUNKEDBOARD_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "PieceSet.h"
+#include "Tetromino.h"
+
+/// @class ChunkedBoard
+/// @brief A very large, mostly empty board stored as ChunkSize x ChunkSize tiles allocated on demand.
+///
+/// For sandbox and co-op grids thousands of columns wide, where a dense board would cost memory and
+/// time in proportion to its whole area. Each tile keeps the same layout as a BasicBoard row range,
+/// a 64-bit occupancy mask and three palette bit planes per row, plus a count of its occupied cells;
+/// a tile is created by the first cell set in it and freed when its count drops back to zero. The
+/// occupied tiles are also kept in a compact list, so walking the board, e.g. to draw it, costs the
+/// occupied area and not the board size. The grid of tile pointers is the only part that scales with
+/// the board, one pointer per 4096 cells.
+///
+/// Every change bumps a board revision and stamps it on the tile it touched, so a renderer can
+/// rebuild just the tiles that changed since it last looked.
+class ChunkedBoard
+{
+public:
+    /// Cells along each side of a tile, one 64-bit mask per tile row.
+    static constexpr int ChunkSize = 64;
+
+    /// Bits of a palette index, enough for PaletteSize colours.
+    static constexpr int PaletteBits = 3;
+
+    /// @struct Chunk
+    /// @brief One allocated tile of the board.
+    struct Chunk
+    {
+        std::array<std::uint64_t, ChunkSize> rows{};                              ///< Occupancy, bit j is column x * ChunkSize + j.
+        std::array<std::array<std::uint64_t, ChunkSize>, PaletteBits> palette{}; ///< Bit i of each cell's palette index, per row.
+        int x = 0;                     ///< Tile column, the tile's left cell is column x * ChunkSize.
+        int y = 0;                     ///< Tile row, the tile's bottom cell is row y * ChunkSize.
+        int occupied = 0;              ///< Cells set in the tile, it is freed when this reaches 0.
+        std::uint64_t revision = 0;    ///< Board revision of the last change to the tile.
+        int slot = 0;                  ///< Index of the tile in the board's list of occupied tiles.
+    };
+
+    /// Constructor to create an empty board.
+    /// @param width Columns, any number.
+    /// @param height Rows, any number.
+    ChunkedBoard(int width, int height);
+
+    /// Gets the width of the board.
+    /// @return The columns.
+    int getWidth() const { return _width; }
+
+    /// Gets the height of the board.
+    /// @return The rows.
+    int getHeight() const { return _height; }
+
+    /// Gets the tiles across the board.
+    /// @return The tile columns.
+    int getChunksAcross() const { return _across; }
+
+    /// Gets the tiles up the board.
+    /// @return The tile rows.
+    int getChunksDown() const { return _down; }
+
+    /// Checks whether a cell is occupied, treating everything outside the board as a wall.
+    /// @param row The row index.
+    /// @param col The column index.
+    /// @return True if the cell is occupied or out of bounds.
+    bool IsBlocked(int row, int col) const;
+
+    /// Gets the palette index of a block, see PaletteSize.
+    /// @param row The row index.
+    /// @param col The column index.
+    /// @return The index, only meaningful where IsBlocked() says the cell is occupied.
+    int getPaletteIndex(int row, int col) const;
+
+    /// Fills a cell, allocating its tile if it has none.
+    /// @param row The row index, inside the board.
+    /// @param col The column index, inside the board.
+    /// @param palette Palette index of the cell's colour.
+    void SetCell(int row, int col, int palette);
+
+    /// Empties a cell, freeing its tile if it was the tile's last.
+    /// @param row The row index, inside the board.
+    /// @param col The column index, inside the board.
+    void ClearCell(int row, int col);
+
+    /// Checks whether a tetromino would overlap the edges or the locked cells.
+    /// @param tetromino The tetromino to check.
+    /// @return True if any of its blocks is out of bounds or on an occupied cell.
+    bool Overlaps(const Tetromino& tetromino) const;
+
+    /// Adds a tetromino's blocks to the board in its colour.
+    /// @param tetromino The tetromino, which must not overlap.
+    void Place(const Tetromino& tetromino);
+
+    /// Clears full rows, only looking for them between two rows, e.g. the rows a piece just locked in.
+    /// A row can only be full if every tile along it exists, so on a sparse board this stops at the
+    /// first missing tile. Moving the rows above down only visits tile columns that have a tile there,
+    /// each up to its highest tile, and skips the empty tile rows in between.
+    /// @param bottom The lowest row that may be full.
+    /// @param top The highest row that may be full.
+    /// @return The number of rows cleared.
+    int ClearFullRows(int bottom, int top);
+
+    /// Gets the tile covering a cell range.
+    /// @param x The tile column.
+    /// @param y The tile row.
+    /// @return The tile, nullptr if none of its cells are occupied.
+    const Chunk* getChunk(int x, int y) const { return _chunks[static_cast<std::size_t>(y) * _across + x].get(); }
+
+    /// Gets the number of allocated tiles.
+    /// @return The tiles holding at least one cell.
+    int getChunkCount() const { return static_cast<int>(_occupied.size()); }
+
+    /// Gets one of the allocated tiles, in no particular order.
+    /// @param index The index, 0..getChunkCount()-1.
+    /// @return The tile.
+    const Chunk& getOccupiedChunk(int index) const { return *_occupied[index]; }
+
+    /// Gets the revision of the board, bumped by every change.
+    /// @return The revision, 0 for a board never changed.
+    std::uint64_t getRevision() const { return _revision; }
+
+private:
+    /// Replaces the cells of one tile row, allocating or freeing the tile as needed.
+    /// @param x The tile column.
+    /// @param row The board row.
+    /// @param bits The new occupancy of the tile row.
+    /// @param palette The new palette bit planes of the tile row.
+    void SetChunkRow(int x, int row, std::uint64_t bits, const std::array<std::uint64_t, PaletteBits>& palette);
+
+    /// Gets a mask with every column of a tile row that lies on the board set.
+    /// @param x The tile column.
+    /// @return The full tile row mask, narrower for the rightmost tile.
+    std::uint64_t FullChunkRow(int x) const;
+
+    int _width;  ///< Columns.
+    int _height; ///< Rows.
+    int _across; ///< Tile columns.
+    int _down;   ///< Tile rows.
+    std::vector<std::unique_ptr<Chunk>> _chunks; ///< Every tile position, row by row, null where empty.
+    std::vector<Chunk*> _occupied;              ///< The allocated tiles, each knows its slot here.
+    std::uint64_t _revision = 0;                ///< Changes made to the board.
+};
+
+#endif // CHUNKEDBOARD_H
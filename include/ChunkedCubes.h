@@ -0,0 +1,62 @@
+#ifndef CHUNKEDCUBES_H_
+#define CHUNKEDCUBES_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <ngl/Mat4.h>
+#include <ngl/Vec3.h>
+#include "ChunkedBoard.h"
+#include "Cube.h"
+#include "InstancedCubes.h"
+
+/// @class ChunkedCubes
+/// @brief Draws a ChunkedBoard with one instance buffer per occupied tile, skipping tiles off screen.
+///
+/// Only the board's occupied tiles are walked. Each is tested against the view frustum and, if it
+/// can be seen, its buffer is rebuilt when the tile changed since it was last uploaded and drawn with
+/// one instanced call. A tile scrolled into view is brought up to date the first time it is drawn,
+/// and the buffers of tiles the board freed are released.
+class ChunkedCubes
+{
+public:
+    /// Draws every visible tile of a board with the currently bound shader, uploading the ones that changed.
+    /// @param _board The board.
+    /// @param _origin Where the board's bottom left cell is drawn, before the shader's board offset.
+    /// @param _boardOffset The shader's offset for board 0, to place the tiles for culling.
+    /// @param _mvp The matrix the shader draws with.
+    void draw(const ChunkedBoard &_board, const ngl::Vec3 &_origin, const ngl::Vec3 &_boardOffset,
+              const ngl::Mat4 &_mvp);
+
+    /// Gets the tiles drawn by the last draw().
+    /// @return The tiles inside the frustum.
+    int visible() const { return m_visible; }
+
+    /// Gets the tile buffers uploaded by the last draw().
+    /// @return The tiles that changed or came into view.
+    int uploads() const { return m_uploads; }
+
+private:
+    /// GPU copy of one tile.
+    struct Buffer
+    {
+        std::unique_ptr<InstancedCubes> cubes; ///< Instance buffer of the tile's cubes.
+        std::uint64_t revision = 0;            ///< Tile revision uploaded, 0 before the first upload.
+        std::uint64_t seen = 0;                ///< Draw the tile was last occupied in.
+    };
+
+    /// Copies a tile's cells into its buffer.
+    /// @param _chunk The tile.
+    /// @param _origin Where the board's bottom left cell is drawn.
+    /// @param _buffer The tile's buffer.
+    void upload(const ChunkedBoard::Chunk &_chunk, const ngl::Vec3 &_origin, Buffer &_buffer);
+
+    std::unordered_map<std::uint64_t, Buffer> m_buffers; ///< Buffers keyed by tile position.
+    std::vector<Cube> m_scratch;   ///< One tile's cubes on their way to the GPU.
+    std::uint64_t m_draws = 0;     ///< Calls to draw().
+    int m_visible = 0;             ///< Tiles drawn by the last draw().
+    int m_uploads = 0;             ///< Tiles uploaded by the last draw().
+};
+
+#endif // CHUNKEDCUBES_H_
@@ -1,62 +1,46 @@
 #ifndef CUBE_H_
 #define CUBE_H_
 
-#include <ngl/ShaderLib.h>
-#include <ngl/Transformation.h>
+#include <cstdint>
+#include <type_traits>
 #include <ngl/Vec3.h>
-#include <ngl/Vec4.h>
-#include <string>
 
-/// @class Cube
-/// @brief Manages the properties and rendering of a cube object in a 3D space.
-class Cube
+/// @struct Cube
+/// @brief Position and colour of one block to draw; the drawing itself is batched by InstancedCubes.
+///
+/// A plain 16 byte render item laid out exactly as the per-instance vertex data, so a frame's
+/// cubes are built in a FrameArena and uploaded to the GPU as they are, without a conversion pass.
+/// The colour is a palette index the vertex shader resolves, see Palette; the index just past the
+/// palette, PaletteSize, marks a cube of a cleared row, which the shaders flash and collapse instead.
+struct Cube
 {
-public:
-    /// Default constructor that initializes the position and color to default values.
-    Cube();
+    /// Default constructor, leaves the cube uninitialised so arrays of cubes cost nothing to create.
+    Cube() = default;
 
-    /// Constructor with parameters to set the cube's initial position and color.
-    /// @param _position Initial position of the cube as Vec3.
-    /// @param _colour Color of the cube as Vec4.
-    Cube(ngl::Vec3 _position, ngl::Vec4 _colour);
+    /// Constructor with parameters to set the cube's position and color.
+    /// @param _position Position of the cube on its board as Vec3.
+    /// @param _palette Palette index of the cube's colour, 0..PaletteSize-1, or PaletteSize for a cleared row's cube.
+    /// @param _board Index of the board the cube belongs to, selects the board offset in the shader.
+    Cube(ngl::Vec3 _position, int _palette, int _board = 0);
 
     /// Gets the position of the cube.
     /// @return The current position as Vec3.
-    ngl::Vec3 getPos() const { return m_pos; }
+    ngl::Vec3 getPos() const { return {m_pos[0], m_pos[1], m_pos[2]}; }
 
     /// Gets the color of the cube.
-    /// @return The current color as Vec4.
-    ngl::Vec4 getColour() const { return m_colour; }
-
-    /// Draws the cube using the specified shader and matrices.
-    /// @param _shaderName The name of the shader program to use.
-    /// @param _globalMat Global transformation matrix.
-    /// @param _view View matrix from the camera.
-    /// @param _project Projection matrix.
-    void draw(const std::string &_shaderName, const ngl::Mat4 &_globalMat,
-              const ngl::Mat4 &_view, const ngl::Mat4 &_project);
-
-    /// Updates the position of the cube (to be defined based on how positions are handled, e.g., physics or animation).
-    void updatePos();
-
-    /// Loads transformation matrices into the currently active shader.
-    /// @param _tx Transformation object containing local transformations.
-    /// @param _globalMat Global transformation matrix.
-    /// @param _view View matrix from the camera.
-    /// @param _project Projection matrix.
-    void loadMatricesToShader(ngl::Transformation &_tx, const ngl::Mat4 &_globalMat,
-                              const ngl::Mat4 &_view, const ngl::Mat4 &_project);
-
-private:
-    ngl::Vec3 m_pos; ///< Position of the cube in 3D space.
-    ngl::Vec4 m_colour; ///< Color of the cube.
-    ngl::Transformation m_transform; ///< Transformation object for handling local transformations.
-
-    // PBR specific material properties
-    ngl::Vec4 m_albedo;  // Base color of the cube.
-    float m_metallic;  // Metallic property of the material.
-    float m_roughness;  // Roughness property of the material.
-    float m_ao;  // Ambient occlusion factor.
+    /// @return The palette index.
+    int getPaletteIndex() const { return m_palette; }
+
+    /// Gets the board the cube belongs to.
+    /// @return The board index.
+    int getBoard() const { return m_board; }
+
+    float m_pos[3];            ///< Position of the cube on its board.
+    std::uint8_t m_palette;    ///< Palette index of the colour, PaletteSize for a cleared row's cube.
+    std::uint8_t m_board;      ///< Board index, used to look up the board offset.
 };
 
+static_assert(std::is_trivial<Cube>::value && std::is_standard_layout<Cube>::value,
+              "Cubes are copied straight into the instance buffer");
+
 #endif // CUBE_H_
@@ -0,0 +1,225 @@
+#ifndef DATASETSHARD_H
+#define DATASETSHARD_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "Game.h"
+
+/// @class DatasetSample
+/// @brief A zero-copy view of one training sample inside a mapped shard.
+///
+/// A sample is the standard board before a piece was placed, the piece, where it went and how
+/// the game went on, bit packed into RecordSize bytes:
+///   bytes 0-24   the stack without the active piece, 10 bits a row from row 0 at the bottom,
+///                bit j of row r is bit r * 10 + j counting from bit 0 of byte 0
+///   byte 25      piece type (bits 0-2), rotation index (bits 3-4), rows the placement cleared (bits 5-7)
+///   byte 26      column of the piece box plus 3 (bits 0-3), set when the game ended by topping out (bit 4)
+///   bytes 27-28  the five preview pieces, 3 bits each, next first, little endian
+///   bytes 29-31  rows the game cleared from this placement on, little endian
+class DatasetSample
+{
+public:
+    /// Bytes of one record.
+    static constexpr int RecordSize = 32;
+
+    /// Constructor.
+    /// @param record The record, RecordSize bytes that outlive the view.
+    explicit DatasetSample(const std::uint8_t* record) : _record(record) {}
+
+    /// Gets a row of the stack.
+    /// @param row The row, 0 at the bottom.
+    /// @return Bit j set where column j is filled.
+    Board::RowMask getRow(int row) const
+    {
+        int bit = row * Board::FixedWidth;
+        const std::uint8_t* bytes = _record + bit / 8;
+        std::uint32_t window = bytes[0] | static_cast<std::uint32_t>(bytes[1]) << 8 | static_cast<std::uint32_t>(bytes[2]) << 16;
+        return static_cast<Board::RowMask>(window >> (bit % 8) & ((1u << Board::FixedWidth) - 1));
+    }
+
+    /// Gets the piece placed.
+    /// @return The type, 1 onwards.
+    int getPiece() const { return _record[25] & 7; }
+
+    /// Gets the rotation it was placed in.
+    /// @return The rotation index.
+    int getRotation() const { return _record[25] >> 3 & 3; }
+
+    /// Gets the column it was dropped in.
+    /// @return The column of the left edge of the piece box.
+    int getX() const { return (_record[26] & 15) - 3; }
+
+    /// Gets a preview piece.
+    /// @param index 0 for the next piece.
+    /// @return The type.
+    int getPreview(int index) const { return (_record[27] | _record[28] << 8) >> (index * 3) & 7; }
+
+    /// Gets the rows the placement cleared.
+    /// @return 0 to 4.
+    int getLinesCleared() const { return _record[25] >> 5; }
+
+    /// Gets the rows the game cleared from this placement on, this one's included.
+    /// @return The rows.
+    int getFutureLines() const { return _record[29] | _record[30] << 8 | _record[31] << 16; }
+
+    /// Checks how the game ended.
+    /// @return True if it topped out, false if it was stopped at the piece limit.
+    bool isToppedOut() const { return (_record[26] & 16) != 0; }
+
+    /// Gets the raw record.
+    /// @return RecordSize bytes.
+    const std::uint8_t* getData() const { return _record; }
+
+private:
+    const std::uint8_t* _record; ///< The record.
+};
+
+/// @class DatasetWriter
+/// @brief Streams samples from games into shard files, one writer per thread.
+///
+/// Samples are packed as their placements are made and held until the game ends, since the
+/// outcome is only known then, and then appended to a buffer that goes to disk in large writes.
+/// A shard is written as PREFIX-NNNNN.tds.tmp and renamed once it is full or the writer closes,
+/// with its record count in the header, so a reader never sees a shard still being written.
+/// Writers share nothing, each thread gives its own a different prefix and no lock is taken.
+class DatasetWriter
+{
+public:
+    /// Constructor, nothing is created until the first sample.
+    /// @param prefix Path and name prefix of this writer's shards.
+    /// @param shardRecords Records per shard before another is started.
+    explicit DatasetWriter(const std::string& prefix, std::uint64_t shardRecords = 1 << 22);
+
+    /// Destructor, closes the shard being written.
+    ~DatasetWriter();
+
+    DatasetWriter(const DatasetWriter&) = delete;
+    DatasetWriter& operator=(const DatasetWriter&) = delete;
+
+    /// Records a placement, call once the piece has been turned and shifted and before it drops.
+    /// @param game The game, its active piece is the one being placed.
+    /// @param rotation The rotation index it drops in, the piece's own rather than the one aimed for.
+    /// @param x The column of the left edge of its box it drops from.
+    void Add(const Game& game, int rotation, int x);
+
+    /// Fills in the outcome of every sample of the game and queues them for the shard.
+    /// @param game The game, over or stopped.
+    /// @return False if a write failed.
+    bool EndGame(const Game& game);
+
+    /// Writes what is queued, finishes the shard and renames it into place.
+    /// @return False if a write failed, the shard's file is then closed and removed.
+    bool Close();
+
+    /// Gets the records written or queued.
+    /// @return The count over every shard.
+    std::uint64_t getRecordCount() const { return _records; }
+
+    /// Gets the shards finished so far.
+    /// @return Their paths.
+    const std::vector<std::string>& getShards() const { return _shards; }
+
+private:
+    /// Writes the queued records to the open shard, opening one if needed.
+    /// @return False if a write failed.
+    bool Flush();
+
+    /// A sample waiting for its game to end.
+    struct Pending
+    {
+        std::uint8_t record[DatasetSample::RecordSize]; ///< Packed with the outcome left blank.
+        int lines;                                      ///< Rows the game had cleared before the placement.
+    };
+
+    std::string _prefix;                ///< Shard path prefix.
+    std::uint64_t _shardRecords;        ///< Records per shard.
+    std::vector<Pending> _game;         ///< Samples of the game being played.
+    std::vector<std::uint8_t> _buffer;  ///< Records queued for the shard.
+    std::FILE* _file = nullptr;         ///< The shard being written.
+    std::uint64_t _inShard = 0;         ///< Records in the shard being written, queued included.
+    std::uint64_t _games = 0;           ///< Games ending in the shard being written.
+    std::uint64_t _records = 0;         ///< Records over every shard.
+    int _shardIndex = 0;                ///< Number of the shard being written.
+    std::vector<std::string> _shards;   ///< Finished shards.
+    bool _failed = false;               ///< Set once a write failed.
+};
+
+/// @class DatasetShard
+/// @brief One shard file mapped read-only, handing out views of its records.
+class DatasetShard
+{
+public:
+    DatasetShard() = default;
+
+    /// Destructor, unmaps the file.
+    ~DatasetShard();
+
+    DatasetShard(const DatasetShard&) = delete;
+    DatasetShard& operator=(const DatasetShard&) = delete;
+
+    /// Maps a shard and checks its header, printing why it can't be used.
+    /// @param path The shard file.
+    /// @return False if it isn't a finished shard of this format.
+    bool Open(const std::string& path);
+
+    /// Gets the number of records.
+    /// @return The count.
+    std::uint64_t getRecordCount() const { return _count; }
+
+    /// Gets the number of games the records came from.
+    /// @return The count.
+    std::uint64_t getGameCount() const { return _gameCount; }
+
+    /// Gets a record.
+    /// @param index The record, below getRecordCount().
+    /// @return A view into the mapping.
+    DatasetSample operator[](std::uint64_t index) const
+    {
+        return DatasetSample(_records + index * DatasetSample::RecordSize);
+    }
+
+private:
+    void* _mapping = nullptr;               ///< The mapped file.
+    std::size_t _size = 0;                  ///< Bytes mapped.
+    const std::uint8_t* _records = nullptr; ///< The first record.
+    std::uint64_t _count = 0;               ///< Records in the shard.
+    std::uint64_t _gameCount = 0;           ///< Games in the shard.
+};
+
+/// @class DatasetReader
+/// @brief Many shards as one indexable set of samples, for uniform random sampling.
+class DatasetReader
+{
+public:
+    /// Maps another shard.
+    /// @param path The shard file.
+    /// @return False if it couldn't be opened, see DatasetShard::Open.
+    bool Add(const std::string& path);
+
+    /// Gets the number of records over every shard.
+    /// @return The count.
+    std::uint64_t getRecordCount() const { return _starts.empty() ? 0 : _starts.back(); }
+
+    /// Gets a record by its index over every shard.
+    /// @param index The record, below getRecordCount().
+    /// @return A view into the shard's mapping.
+    DatasetSample operator[](std::uint64_t index) const;
+
+    /// Picks a record uniformly.
+    /// @param random The generator, there must be at least one record.
+    /// @return A view into the shard's mapping.
+    DatasetSample Sample(std::mt19937_64& random) const
+    {
+        return (*this)[random() % getRecordCount()];
+    }
+
+private:
+    std::vector<std::unique_ptr<DatasetShard>> _shards; ///< The mapped shards.
+    std::vector<std::uint64_t> _starts;                 ///< Records before each shard and then the total, one more than _shards.
+};
+
+#endif // DATASETSHARD_H
@@ -0,0 +1,61 @@
+#ifndef FRAMEARENA_H_
+#define FRAMEARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/// @class FrameArena
+/// @brief Bump allocator for data that lives for one frame, such as the frame's render items.
+///
+/// Allocating moves a pointer through one block and Reset() moves it back, so nothing is freed
+/// item by item. A frame that needs more than the block spills into extra blocks; the next Reset()
+/// replaces them all with one block big enough for that frame, so once the arena has seen the
+/// largest frame it never touches the heap again.
+class FrameArena
+{
+public:
+    /// Constructor.
+    /// @param _bytes Size of the first block.
+    explicit FrameArena(std::size_t _bytes = 64 * 1024);
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    /// Allocates uninitialised storage for an array, valid until the next Reset().
+    /// @param _count The number of elements.
+    /// @return The array, never nullptr.
+    template <typename T>
+    T *allocate(std::size_t _count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "The arena never runs destructors");
+        return static_cast<T *>(allocateBytes(_count * sizeof(T), alignof(T)));
+    }
+
+    /// Releases everything allocated since the last reset, growing the block if the frame spilled.
+    void reset();
+
+    /// Gets the bytes the arena can hand out without allocating.
+    /// @return The block size.
+    std::size_t getCapacity() const { return m_capacity; }
+
+    /// Gets the bytes handed out since the last reset.
+    /// @return The bytes used, including alignment padding.
+    std::size_t getUsed() const { return m_used + m_spilled; }
+
+private:
+    /// Allocates raw storage.
+    /// @param _bytes The size.
+    /// @param _align The alignment, a power of two no greater than alignof(std::max_align_t).
+    /// @return The storage.
+    void *allocateBytes(std::size_t _bytes, std::size_t _align);
+
+    std::unique_ptr<unsigned char[]> m_block;                  ///< Main block.
+    std::size_t m_capacity = 0;                                ///< Size of m_block.
+    std::size_t m_used = 0;                                    ///< Bytes of m_block handed out.
+    std::vector<std::unique_ptr<unsigned char[]>> m_overflow;  ///< Extra blocks of a frame that didn't fit.
+    std::size_t m_spilled = 0;                                 ///< Bytes handed out from m_overflow.
+};
+
+#endif // FRAMEARENA_H_
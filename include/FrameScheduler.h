@@ -0,0 +1,61 @@
+#ifndef FRAMESCHEDULER_H_
+#define FRAMESCHEDULER_H_
+
+#include <functional>
+
+/// Parts of the scene that need work before the next frame, a bitmask of RenderLayer.
+using RenderLayers = unsigned int;
+
+/// @enum RenderLayer
+/// @brief Bits of RenderLayers.
+enum RenderLayer : RenderLayers
+{
+    LayerStack = 1 << 0,    ///< Locked cubes, re-uploaded and redrawn into the stack shadow map.
+    LayerPieces = 1 << 1,   ///< Falling pieces, re-uploaded and redrawn into the piece shadow map.
+    LayerCamera = 1 << 2,   ///< View, mouse transform or light, the frame is only redrawn.
+    LayerSettings = 1 << 3, ///< Shading tier, palette, shaders or polygon mode, the frame is only redrawn.
+    LayerAnimation = 1 << 4 ///< A lock or clear animation is playing, the frame is only redrawn at the new time.
+};
+
+/// @class FrameScheduler
+/// @brief Collects what changed between frames and asks for a frame only when something did.
+///
+/// Any number of invalidations between two frames cost one frame request; the window's update()
+/// is throttled to the display's refresh, so the scene is drawn at most once per vsync and not at
+/// all while nothing changes. Each frame takes the dirty layers, so the renderer only redoes the
+/// work for those, e.g. the stack's shadow map is left alone while just a piece falls.
+class FrameScheduler
+{
+public:
+    /// Constructor.
+    /// @param _requestFrame Asks for a frame to be drawn, called once per frame at most.
+    explicit FrameScheduler(std::function<void()> _requestFrame);
+
+    /// Marks layers as changed, requesting a frame if none is pending.
+    /// @param _layers The layers.
+    void invalidate(RenderLayers _layers);
+
+    /// Checks whether a frame has been requested and not drawn yet.
+    /// @return True if layers are dirty.
+    bool isPending() const { return m_dirty != 0; }
+
+    /// Starts drawing a frame, taking the dirty layers.
+    /// @return The layers changed since the last frame, possibly none if the window system asked for the frame.
+    RenderLayers beginFrame();
+
+    /// Gets the number of invalidations made.
+    /// @return Invalidations since construction.
+    long long invalidations() const { return m_invalidations; }
+
+    /// Gets the number of frames drawn.
+    /// @return Frames since construction.
+    long long frames() const { return m_frames; }
+
+private:
+    std::function<void()> m_requestFrame; ///< Asks for a frame.
+    RenderLayers m_dirty = 0;             ///< Layers changed since the last frame.
+    long long m_invalidations = 0;        ///< Calls to invalidate() with any layer.
+    long long m_frames = 0;               ///< Calls to beginFrame().
+};
+
+#endif // FRAMESCHEDULER_H_
@@ -0,0 +1,310 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include "Board.h"
+#include "Tetromino.h"
+
+/// Buttons held during one simulation frame, a bitmask of InputButton.
+using InputFrame = std::uint8_t;
+
+/// @enum InputButton
+/// @brief Bits of an InputFrame.
+enum InputButton : InputFrame
+{
+    InputLeft = 1 << 0,   ///< Move left.
+    InputRight = 1 << 1,  ///< Move right.
+    InputDown = 1 << 2,   ///< Move down.
+    InputRotate = 1 << 3  ///< Rotate clockwise.
+};
+
+/// Upcoming pieces a game shows in advance.
+constexpr int PreviewSize = 5;
+
+/// @enum TSpin
+/// @brief How the last rotation before a lock tucked a T piece in, by the three-corner rule.
+enum class TSpin : std::uint8_t
+{
+    None, ///< Not a T-spin.
+    Mini, ///< Three corners filled but not both in front of the T's flat side.
+    Full  ///< Three corners filled including both in front of the T's flat side.
+};
+
+/// @struct GameHandling
+/// @brief How held buttons repeat and how long a landed piece waits, in simulation frames.
+///
+/// Both players of a match, and both peers of a netplay session, must use the same handling.
+struct GameHandling
+{
+    int das = 10;            ///< Frames left or right is held before it repeats, delayed auto shift.
+    int arr = 2;             ///< Frames between repeated shifts once they start, 0 shifts straight to the wall.
+    int softDropFactor = 20; ///< Gravity multiplier while down is held.
+    int lockDelay = 30;      ///< Frames a piece rests on the stack before it locks.
+    int lockResets = 15;     ///< Moves and rotations on the stack that restart the lock delay, per piece.
+};
+
+/// @struct BasicGameState
+/// @brief Everything needed to put a game back exactly as it was, see BasicGame::SaveState.
+/// @tparam BoardType The board the game is played on.
+template <typename BoardType>
+struct BasicGameState
+{
+    BoardType board;                  ///< Board contents, copying a fixed size board allocates nothing.
+    Tetromino tetromino;              ///< Active tetromino.
+    std::array<std::uint8_t, PreviewSize> preview{}; ///< Upcoming piece types.
+    std::minstd_rand pieceRandom;     ///< Piece sequence position.
+    std::minstd_rand garbageRandom;   ///< Garbage hole sequence position.
+    int linesCleared = 0;             ///< Rows cleared by the most recent lock.
+    int pendingGarbage = 0;           ///< Garbage rows waiting to be inserted.
+    int gravityProgress = 0;          ///< Fraction of a row gravity has pulled, 16.16 fixed point.
+    int pieces = 0;                   ///< Tetrominoes locked so far.
+    int score = 0;                    ///< Points scored.
+    int lines = 0;                    ///< Rows cleared in total.
+    int level = 1;                    ///< Current level.
+    int startLevel = 1;               ///< Level the game started on.
+    int combo = -1;                   ///< Consecutive clearing locks minus one.
+    bool backToBack = false;          ///< Whether the last clear was a tetris or T-spin.
+    bool gameOver = false;            ///< Whether the stack has topped out.
+    bool lastMoveRotate = false;      ///< Whether the last successful action was a rotation.
+    TSpin lastSpin = TSpin::None;     ///< T-spin of the most recent lock.
+    Tetromino lockedPiece;            ///< Tetromino of the most recent lock, where it ended up.
+    std::uint32_t clearedRows = 0;    ///< Rows the most recent lock cleared, relative to the locked piece.
+    InputFrame lastInput = 0;         ///< Buttons held on the previous frame.
+    InputFrame shiftButton = 0;       ///< Left or right, whichever is auto shifting.
+    int shiftFrames = 0;              ///< Frames the shift button has been held.
+    int lockFrames = 0;               ///< Frames the piece has rested on the stack.
+    int lockResets = 0;               ///< Lock delay restarts used by the piece.
+};
+
+/// @class BasicGame
+/// @brief Runs one player's game: the board, the falling tetromino and the piece sequence.
+///
+/// Holds no rendering or timing state so several games can be stepped side by side,
+/// see VersusMatch. Stepping is deterministic: the same seed and the same InputFrame
+/// per frame always produce the same game, which is what rollback netplay relies on.
+/// Instantiated in Game.cpp for each board in Board.h.
+/// @tparam BoardType The board the game is played on, a BasicBoard.
+template <typename BoardType>
+class BasicGame
+{
+public:
+    /// Simulation frames per second.
+    static constexpr int FrameRate = 60;
+
+    /// Highest level, gravity stops getting faster here.
+    static constexpr int MaxLevel = 20;
+
+    /// Rows cleared per level.
+    static constexpr int LinesPerLevel = 10;
+
+    using State = BasicGameState<BoardType>; ///< Saved state of this kind of game.
+
+    /// Default constructor.
+    BasicGame() = default;
+
+    /// Constructor to start a game on an empty board.
+    /// @param board The board to play on.
+    /// @param seed Seed for the piece sequence, games with equal seeds get equal pieces.
+    /// @param startLevel Level to start on, 1..MaxLevel.
+    /// @param handling Button repeat and lock delay settings.
+    BasicGame(const BoardType& board, unsigned int seed, int startLevel = 1,
+              const GameHandling& handling = GameHandling());
+
+    /// Advances the game by one frame. Rotate and down act on the frame they are pressed, left and
+    /// right too and then repeat while held, see GameHandling::das. Gravity then pulls the tetromino
+    /// down at the rate for the current level, faster while down is held, and a tetromino resting
+    /// on the stack locks once it has rested for the lock delay.
+    /// Does nothing once the game is over.
+    /// @param input The buttons held during this frame.
+    /// @return True if the board changed.
+    bool Step(InputFrame input);
+
+    /// Moves the active tetromino, see Board::MoveTetromino for directions.
+    /// @param direction 1 for down, 2 for left, 3 for right.
+    /// @return True if the move was blocked; otherwise, false.
+    bool Move(int direction);
+
+    /// Rotates the active tetromino clockwise.
+    /// @return True if the rotation was successful; otherwise, false.
+    bool Rotate();
+
+    /// Advances one gravity step, locking the tetromino straight away if it can't move down.
+    /// @return True if a tetromino locked during this step.
+    bool Tick();
+
+    /// Gets the gravity for a level, following the guideline curve (0.8 - (level - 1) * 0.007)^(level - 1)
+    /// seconds per row, capped at 20 rows a frame.
+    /// @param level The level, clamped to 1..MaxLevel.
+    /// @return Rows per frame in 16.16 fixed point, integers so every machine agrees.
+    static int GravityPerFrame(int level);
+
+    /// Gets the guideline points for a lock before the level, back-to-back and combo bonuses.
+    /// @param lines The rows cleared, 0..4.
+    /// @param spin The T-spin of the lock.
+    /// @return The points.
+    static int ActionPoints(int lines, TSpin spin);
+
+    /// Queues garbage rows to be inserted the next time a piece locks without clearing a line.
+    /// @param lines The number of garbage rows.
+    void AddGarbage(int lines);
+
+    /// Cancels queued garbage against lines being sent by this player.
+    /// @param lines The number of lines this player is about to send.
+    /// @return The number of lines left to send after cancelling.
+    int CancelGarbage(int lines);
+
+    /// Saves the complete game state.
+    /// @param state Receives the state, its storage is reused between calls.
+    void SaveState(State& state) const;
+
+    /// Restores a state saved from a game on a board of the same size.
+    /// @param state The state to restore.
+    void LoadState(const State& state);
+
+    /// Hashes the game state, used to check that two simulations agree.
+    /// @return A 32-bit hash.
+    std::uint32_t Checksum() const;
+
+    /// Gets the board.
+    /// @return The board, including the active tetromino.
+    const BoardType& getBoard() const { return _board; }
+
+    /// Gets the active tetromino.
+    /// @return The falling tetromino.
+    const Tetromino& getTetromino() const { return _tetromino; }
+
+    /// Gets an upcoming piece.
+    /// @param index 0 for the next piece, up to PreviewSize - 1.
+    /// @return The piece type.
+    int getPreview(int index) const { return _preview[index]; }
+
+    /// Gets the number of rows cleared by the most recent lock.
+    /// @return The rows cleared.
+    int getLinesCleared() const { return _linesCleared; }
+
+    /// Gets the number of garbage rows waiting to be inserted.
+    /// @return The pending garbage rows.
+    int getPendingGarbage() const { return _pendingGarbage; }
+
+    /// Gets the number of tetrominoes locked so far.
+    /// @return The locked piece count.
+    int getPieces() const { return _pieces; }
+
+    /// Gets the current score.
+    /// @return The points scored.
+    int getScore() const { return _score; }
+
+    /// Gets the total rows cleared.
+    /// @return The rows cleared since the start.
+    int getLines() const { return _lines; }
+
+    /// Gets the current level.
+    /// @return The level, rising every LinesPerLevel rows.
+    int getLevel() const { return _level; }
+
+    /// Gets the combo count.
+    /// @return Consecutive clearing locks minus one, -1 if the last lock cleared nothing.
+    int getCombo() const { return _combo; }
+
+    /// Checks whether the next tetris or T-spin clear scores the back-to-back bonus.
+    /// @return True if the last clear was a tetris or T-spin.
+    bool isBackToBack() const { return _backToBack; }
+
+    /// Gets the T-spin of the most recent lock.
+    /// @return The T-spin kind.
+    TSpin getLastSpin() const { return _lastSpin; }
+
+    /// Gets the tetromino of the most recent lock, raised with any garbage the lock let in.
+    /// @return The tetromino as it was drawn into the board.
+    const Tetromino& getLockedPiece() const { return _lockedPiece; }
+
+    /// Gets the rows the most recent lock cleared, numbered as they were before clearing.
+    /// @return Bit i set if row getLockedPiece().GetY() + i was cleared.
+    std::uint32_t getClearedRows() const { return _clearedRows; }
+
+    /// Checks whether the game has ended, a new piece overlapped the stack or garbage pushed blocks off the top.
+    /// @return True once the game is over.
+    bool isGameOver() const { return _gameOver; }
+
+    /// Gets the button repeat and lock delay settings.
+    /// @return The handling.
+    const GameHandling& getHandling() const { return _handling; }
+
+    /// Gets how long the active tetromino has rested on the stack.
+    /// @return Frames towards the lock delay, 0 while it is falling.
+    int getLockFrames() const { return _lockFrames; }
+
+private:
+    /// Replaces the active tetromino with the next one from the sequence and draws it,
+    /// ending the game if it overlaps the stack.
+    void SpawnTetromino();
+
+    /// Draws the next piece type from the sequence.
+    /// @return The piece type.
+    std::uint8_t NextPieceType();
+
+    /// Locks the active tetromino where it is, clears rows, inserts garbage and spawns the next one.
+    /// Everything the lock changes, score, level and game over, is worked out here from the
+    /// rows the piece landed in, without scanning the rest of the board.
+    void Lock();
+
+    /// Shifts the active tetromino one column.
+    /// @param button InputLeft or InputRight.
+    /// @return True if it moved.
+    bool Shift(InputFrame button);
+
+    /// Restarts the lock delay after a move or rotation, if the piece is resting and has restarts left.
+    void RestartLockDelay();
+
+    /// Classifies the lock of the active tetromino by the three-corner rule.
+    /// @return The T-spin kind, always None for piece sets without a T.
+    TSpin DetectTSpin() const;
+
+    /// Adds the points for a lock and updates the combo, back-to-back and level.
+    /// @param lines The rows the lock cleared.
+    /// @param spin The T-spin of the lock.
+    void ScoreLock(int lines, TSpin spin);
+
+    BoardType _board;                 ///< Game board.
+    Tetromino _tetromino;             ///< Current Tetromino in play.
+    std::array<std::uint8_t, PreviewSize> _preview{}; ///< Upcoming piece types, next first.
+    std::minstd_rand _pieceRandom;    ///< Piece sequence, shared by games with the same seed.
+    std::minstd_rand _garbageRandom;  ///< Garbage hole columns, kept apart so garbage never shifts the piece sequence.
+    int _linesCleared = 0;            ///< Rows cleared by the most recent lock.
+    int _pendingGarbage = 0;          ///< Garbage rows waiting to be inserted.
+    int _gravityProgress = 0;         ///< Fraction of a row gravity has pulled, 16.16 fixed point.
+    int _pieces = 0;                  ///< Tetrominoes locked so far.
+    int _score = 0;                   ///< Points scored.
+    int _lines = 0;                   ///< Rows cleared in total.
+    int _level = 1;                   ///< Current level.
+    int _startLevel = 1;              ///< Level the game started on.
+    int _combo = -1;                  ///< Consecutive clearing locks minus one.
+    bool _backToBack = false;         ///< Whether the last clear was a tetris or T-spin.
+    bool _gameOver = false;           ///< Whether the stack has topped out.
+    bool _lastMoveRotate = false;     ///< Whether the last successful action was a rotation, needed for T-spins.
+    TSpin _lastSpin = TSpin::None;    ///< T-spin of the most recent lock.
+    Tetromino _lockedPiece;           ///< Tetromino of the most recent lock, where it ended up.
+    std::uint32_t _clearedRows = 0;   ///< Rows the most recent lock cleared, bit i for row i above the locked piece's bottom.
+    InputFrame _lastInput = 0;        ///< Buttons held on the previous frame, to find new presses.
+    InputFrame _shiftButton = 0;      ///< Left or right, whichever is auto shifting, the last pressed wins.
+    int _shiftFrames = 0;             ///< Frames the shift button has been held.
+    int _lockFrames = 0;              ///< Frames the tetromino has rested on the stack.
+    int _lockResets = 0;              ///< Lock delay restarts the tetromino has used.
+    GameHandling _handling;           ///< Button repeat and lock delay settings, not part of the state.
+};
+
+/// Game on the standard board, used by matches and netplay.
+using Game = BasicGame<Board>;
+
+/// Saved state of a Game.
+using GameState = Game::State;
+
+extern template class BasicGame<Board>;
+extern template class BasicGame<TallBoard>;
+extern template class BasicGame<DynamicBoard>;
+extern template class BasicGame<PentominoBoard>;
+extern template class BasicGame<PolyominoBoard>;
+
+#endif // GAME_H
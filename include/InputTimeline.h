@@ -0,0 +1,163 @@
+#ifndef INPUTTIMELINE_H
+#define INPUTTIMELINE_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "Game.h"
+#include "VersusMatch.h"
+
+/// @class LatencyHistogram
+/// @brief Counts durations in fixed buckets so percentiles can be read without keeping every sample.
+class LatencyHistogram
+{
+public:
+    static constexpr int BucketMicros = 100; ///< Width of a bucket.
+    static constexpr int Buckets = 500;      ///< Buckets, longer durations land in the last one.
+
+    /// Counts one duration.
+    /// @param duration The duration, negative counts as zero.
+    void Add(std::chrono::nanoseconds duration);
+
+    /// Forgets every sample.
+    void Clear();
+
+    /// Gets the duration a fraction of the samples are no longer than, to the bucket.
+    /// @param fraction The fraction, 0..1, e.g. 0.99 for the 99th percentile.
+    /// @return The upper edge of the bucket holding that sample in milliseconds, 0 with no samples.
+    double getPercentile(double fraction) const;
+
+    /// Gets the longest duration counted.
+    /// @return The longest duration in milliseconds.
+    double getMax() const { return static_cast<double>(_max.count()) * 1.0e-6; }
+
+    /// Gets the number of samples.
+    /// @return Durations counted since the last Clear().
+    long long getCount() const { return _count; }
+
+private:
+    std::array<std::uint32_t, Buckets> _counts{}; ///< Samples per bucket.
+    long long _count = 0;                         ///< Samples in total.
+    std::chrono::nanoseconds _max{0};             ///< Longest sample.
+};
+
+/// @class InputTimeline
+/// @brief Turns timestamped button presses and releases into one InputFrame per simulation frame.
+///
+/// Simulation frame n covers the time from start + n / FrameRate up to the start of frame n + 1, and
+/// is due once that time has passed. Each frame takes the events stamped before its end, so a button's
+/// press lands on the frame it happened in however late the loop wakes up, instead of on whichever
+/// tick first noticed the held key. A press and release inside one frame still reaches the game as a
+/// press, and a press that would run into the previous one without a frame between them is held back
+/// a frame so the game sees a fresh edge for every tap. Buttons held from frame to frame are left to
+/// the game's own auto shift, see GameHandling.
+///
+/// Each consumed event is also timed: how long it waited for its frame to end, how much later than
+/// that the frame was run, and the sum, the latency from the key to the simulation.
+class InputTimeline
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int MaxCatchUp = 4;         ///< Frames run at most per Advance(), older ones are skipped.
+    static constexpr int EventCapacity = 64;     ///< Events buffered per player, more are dropped.
+
+    /// Default constructor, for one player starting now.
+    InputTimeline() : InputTimeline(1, Clock::now()) {}
+
+    /// Constructor.
+    /// @param players Players sending input, 1..VersusMatch::MaxPlayers.
+    /// @param start When the first frame starts.
+    InputTimeline(int players, Clock::time_point start);
+
+    /// Buffers a button going down.
+    /// @param player The player.
+    /// @param button The InputButton.
+    /// @param time When it went down.
+    void Press(int player, InputFrame button, Clock::time_point time);
+
+    /// Buffers a button coming up.
+    /// @param player The player.
+    /// @param button The InputButton.
+    /// @param time When it came up.
+    void Release(int player, InputFrame button, Clock::time_point time);
+
+    /// Works out how many frames have ended by now and not been run, skipping any beyond MaxCatchUp
+    /// so a stalled loop doesn't replay seconds of game at once.
+    /// @param now The current time.
+    /// @return Frames to run with NextFrame() before the next call.
+    int Advance(Clock::time_point now);
+
+    /// Builds the next frame's input for every player from the events stamped before the frame ended.
+    /// @param inputs Receives one InputFrame per player.
+    /// @param now The time the frame is being run, for the latency figures.
+    void NextFrame(InputFrame* inputs, Clock::time_point now);
+
+    /// Gets when the next frame to run ends and becomes due, so a loop can sleep until then.
+    /// @return Its end time.
+    Clock::time_point getNextFrameEnd() const { return FrameEnd(_frame); }
+
+    /// Gets how long events waited for the end of their frame.
+    /// @return The histogram.
+    const LatencyHistogram& getQuantisation() const { return _quantisation; }
+
+    /// Gets how long after a frame ended it was run.
+    /// @return The histogram.
+    const LatencyHistogram& getProcessing() const { return _processing; }
+
+    /// Gets the time from an event to the frame that consumed it being run.
+    /// @return The histogram.
+    const LatencyHistogram& getTotal() const { return _total; }
+
+    /// Forgets the latency samples.
+    void ClearLatency();
+
+    /// Gets the number of frames skipped because the loop fell behind.
+    /// @return Frames never run.
+    long long getSkippedFrames() const { return _skipped; }
+
+    /// Gets the number of events dropped because a player's buffer was full.
+    /// @return Events lost.
+    long long getDroppedEvents() const { return _dropped; }
+
+private:
+    /// One buffered press or release.
+    struct Event
+    {
+        Clock::time_point time; ///< When it happened.
+        InputFrame button = 0;  ///< Which button.
+        bool press = false;     ///< Down or up.
+    };
+
+    /// A player's buffered events and buttons.
+    struct Player
+    {
+        std::array<Event, EventCapacity> events; ///< Ring buffer of events not yet consumed.
+        int head = 0;                            ///< Oldest event.
+        int size = 0;                            ///< Events buffered.
+        InputFrame held = 0;                     ///< Buttons down after the consumed events.
+        InputFrame last = 0;                     ///< Input of the previous frame.
+    };
+
+    /// Buffers an event.
+    /// @param player The player.
+    /// @param event The event.
+    void Push(int player, const Event& event);
+
+    /// Gets when a frame ends.
+    /// @param frame The frame.
+    /// @return Its end time.
+    Clock::time_point FrameEnd(long long frame) const;
+
+    std::array<Player, VersusMatch::MaxPlayers> _players{}; ///< Every player's events.
+    int _playerCount = 1;                 ///< Players in use.
+    Clock::time_point _start;             ///< When frame 0 started.
+    long long _frame = 0;                 ///< Next frame to run.
+    long long _skipped = 0;               ///< Frames skipped catching up.
+    long long _dropped = 0;               ///< Events dropped.
+    LatencyHistogram _quantisation;       ///< Event to frame end.
+    LatencyHistogram _processing;         ///< Frame end to the frame being run.
+    LatencyHistogram _total;              ///< Event to the frame being run.
+};
+
+#endif // INPUTTIMELINE_H
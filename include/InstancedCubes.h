@@ -0,0 +1,40 @@
+#ifndef INSTANCEDCUBES_H_
+#define INSTANCEDCUBES_H_
+
+#include <cstddef>
+#include <ngl/Types.h>
+#include "Cube.h"
+
+/// @class InstancedCubes
+/// @brief Draws every cube in the scene with a single instanced draw call.
+///
+/// Holds a unit cube mesh plus a per-instance buffer of Cube, which already is the instance layout:
+/// position, palette index and board index. The vertex shader adds the board's offset, so any
+/// number of boards costs one draw.
+class InstancedCubes
+{
+public:
+    /// Destructor, releases the GL buffers.
+    ~InstancedCubes();
+
+    /// Creates the cube mesh and the instance buffer, needs a current GL context.
+    void initialize();
+
+    /// Copies the cubes into the instance buffer, growing it only when needed.
+    /// @param _cubes The cubes to draw.
+    /// @param _count The number of cubes.
+    void upload(const Cube *_cubes, std::size_t _count);
+
+    /// Draws every uploaded cube with the currently bound shader.
+    void draw() const;
+
+private:
+    GLuint m_vao = 0;                  ///< Vertex array with mesh and instance attributes.
+    GLuint m_meshBuffer = 0;           ///< Cube positions and normals.
+    GLuint m_instanceBuffer = 0;       ///< Per-cube instance data.
+    GLsizei m_vertexCount = 0;         ///< Vertices in the cube mesh.
+    GLsizei m_instanceCount = 0;       ///< Instances uploaded.
+    std::size_t m_capacity = 0;        ///< Instances the GL buffer can hold.
+};
+
+#endif // INSTANCEDCUBES_H_
@@ -0,0 +1,107 @@
+#ifndef LOCKFREEQUEUE_H
+#define LOCKFREEQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/// @class LockFreeQueue
+/// @brief Bounded multi-producer / multi-consumer queue with no locks (D. Vyukov's sequence ring).
+///
+/// Each cell carries a sequence number telling producers and consumers whose turn it is,
+/// so a push or pop is one CAS on the shared index plus a store to the cell.
+/// @tparam T Trivially copyable element type.
+/// @tparam Capacity Number of cells, must be a power of two.
+template <typename T, std::size_t Capacity>
+class LockFreeQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    /// Constructor, marks every cell as free for the producer of its index.
+    LockFreeQueue()
+    {
+        for (std::size_t i = 0; i < Capacity; ++i)
+        {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LockFreeQueue(const LockFreeQueue &) = delete;
+    LockFreeQueue &operator=(const LockFreeQueue &) = delete;
+
+    /// Pushes a value if there is room.
+    /// @param value The value to push.
+    /// @return True if the value was queued, false if the queue is full.
+    bool TryPush(const T &value)
+    {
+        std::size_t pos = _enqueue.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = _cells[pos & (Capacity - 1)];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.data = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = _enqueue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Pops the oldest value if there is one.
+    /// @param value Receives the popped value.
+    /// @return True if a value was popped, false if the queue is empty.
+    bool TryPop(T &value)
+    {
+        std::size_t pos = _dequeue.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = _cells[pos & (Capacity - 1)];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    value = cell.data;
+                    cell.sequence.store(pos + Capacity, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // empty
+            }
+            else
+            {
+                pos = _dequeue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence; ///< Whose turn the cell is, see TryPush/TryPop.
+        T data;                            ///< Stored value.
+    };
+
+    std::array<Cell, Capacity> _cells;                  ///< Ring storage.
+    alignas(64) std::atomic<std::size_t> _enqueue{0};  ///< Next position to push, on its own cache line.
+    alignas(64) std::atomic<std::size_t> _dequeue{0};  ///< Next position to pop, on its own cache line.
+};
+
+#endif // LOCKFREEQUEUE_H
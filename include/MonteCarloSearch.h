@@ -0,0 +1,180 @@
+#ifndef MONTECARLOSEARCH_H
+#define MONTECARLOSEARCH_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "Game.h"
+#include "PlacementSearch.h"
+#include "WorkerPool.h"
+
+/// @struct MonteCarloStats
+/// @brief What the last Think() did.
+struct MonteCarloStats
+{
+    long long iterations = 0; ///< Descents from the root, summed over threads.
+    double seconds = 0.0;     ///< Time spent searching.
+    std::size_t nodes = 0;    ///< Nodes in the tree when the search stopped.
+    std::size_t reused = 0;   ///< Nodes carried over from the previous move's tree.
+    int depth = 0;            ///< Most pieces placed below the root by one descent.
+    bool full = false;        ///< Whether the node pool ran out before the time did.
+};
+
+/// @class BasicMonteCarloSearch
+/// @brief Monte Carlo tree search over piece placements, with the piece sequence as chance nodes.
+///
+/// A decision node places one piece, its children are every rotation and column the piece can
+/// be dropped straight down from the spawn row in, the same placements BasicPlacementSearch looks
+/// at. Each placement leads to a chance node for the piece after it: while that piece is in the
+/// preview the descent follows it, past the preview it is drawn uniformly like the game's own
+/// randomizer. A descent stops at the first chance node not visited before and scores its stack
+/// with BasicPlacementSearch::Evaluate() plus the lines cleared on the way; children are picked by
+/// UCB1 with their mean scores scaled to 0..1 between the worst and best sibling.
+///
+/// Every thread of a WorkerPool descends the same tree. Nodes come from a fixed pool handed out
+/// with one atomic add per expansion, and a node is expanded by whichever thread swaps its child
+/// index first; a thread finding a node mid-expansion scores it as a leaf instead of waiting.
+/// Each thread on a path counts as a virtual loss on every node of it until it backs its score
+/// up, so the others spread out over other children rather than all following the same one.
+///
+/// The tree is kept between moves: when the game has placed the suggested piece and the next one
+/// has spawned, the subtree under that placement and piece becomes the new root, copied to the
+/// front of a second pool so the space taken by the rest is reclaimed.
+/// Instantiated in MonteCarloSearch.cpp for the standard and tall boards.
+/// @tparam BoardType The board the game is played on, a BasicBoard with a fixed size.
+template <typename BoardType>
+class BasicMonteCarloSearch
+{
+    static_assert(BoardType::FixedWidth != Dynamic && BoardType::FixedHeight != Dynamic,
+                  "Descents keep the stack on the stack, the board size must be fixed");
+
+public:
+    using Placement = typename BasicPlacementSearch<BoardType>::Placement; ///< Where to drop the active piece.
+    using Rows = typename BasicPlacementSearch<BoardType>::Rows;           ///< Occupancy of every row of a stack.
+
+    /// Constructor, allocates both node pools.
+    /// @param threads Threads descending the tree, including the caller's.
+    /// @param nodes Capacity of each node pool, 24 bytes a node.
+    /// @param weights Evaluation weights for the leaves and the lines cleared.
+    BasicMonteCarloSearch(int threads, std::size_t nodes = 1 << 20, const SearchWeights& weights = SearchWeights());
+
+    /// Searches the placements of the game's active piece until the time is up or the pool is full.
+    /// @param game The game, its board, active piece and preview are read.
+    /// @param milliseconds The time budget.
+    /// @return The most visited placement, its score the mean of its descents.
+    Placement Think(const BasicGame<BoardType>& game, double milliseconds);
+
+    /// Forgets the tree, the next Think() starts from scratch.
+    void Reset();
+
+    /// Gets what the last Think() did.
+    /// @return The counts.
+    const MonteCarloStats& getStats() const { return _stats; }
+
+    /// Sets the exploration constant of UCB1, on scores scaled to 0..1.
+    /// @param exploration The constant, larger spreads descents wider.
+    void setExploration(double exploration) { _exploration = exploration; }
+
+    /// Sets how many visits a thread on a path counts for until it backs up.
+    /// @param visits Virtual visits scored as the worst sibling, 0 to turn virtual loss off.
+    void setVirtualLoss(int visits) { _virtualLoss = visits; }
+
+private:
+    using Pieces = typename BoardType::Pieces;
+    using Search = BasicPlacementSearch<BoardType>; ///< Drops pieces and scores stacks by the same rules.
+
+    /// Marks a node nobody has expanded yet.
+    static constexpr std::uint32_t Unexpanded = 0xffffffffu;
+
+    /// Marks a node a thread is expanding.
+    static constexpr std::uint32_t Expanding = 0xfffffffeu;
+
+    /// Most placements of one piece, every rotation at every column the piece box can start in.
+    static constexpr int MaxPlacements = Pieces::Rotations * (BoardType::FixedWidth + Pieces::Size - 1);
+
+    /// Pieces known at the root, the active one and the preview.
+    static constexpr int Known = PreviewSize + 1;
+
+    /// Most pieces one descent places.
+    static constexpr int MaxPly = 48;
+
+    /// A decision node, a piece to place, or a chance node, the stack after a placement.
+    struct Node
+    {
+        std::atomic<std::int64_t> total{0};       ///< Sum of the scores backed up through here.
+        std::atomic<std::uint32_t> visits{0};     ///< Scores backed up through here.
+        std::atomic<std::uint32_t> pending{0};    ///< Threads on a path through here, the virtual loss.
+        std::atomic<std::uint32_t> children{Unexpanded}; ///< Pool index of the first child, or a marker.
+        std::uint8_t childCount = 0;              ///< Children, written before children is published.
+        std::uint8_t piece = 0;                   ///< Decision node: the piece type.
+        std::uint8_t rotation = 0;                ///< Chance node: the rotation of the placement.
+        std::int8_t x = 0;                        ///< Chance node: the column of the placement.
+    };
+
+    /// Fixed block of nodes handed out front to back.
+    struct Pool
+    {
+        std::unique_ptr<Node[]> nodes;      ///< The nodes.
+        std::size_t capacity = 0;           ///< Nodes in the block.
+        std::atomic<std::size_t> used{0};   ///< Nodes handed out.
+    };
+
+    /// Hands out a block of nodes from the active pool, reset for use.
+    /// @param count Nodes in the block.
+    /// @return Index of the first, Unexpanded if the pool is full.
+    std::uint32_t Allocate(int count);
+
+    /// Gives a decision node its placements, or a chance node a decision node per piece type.
+    /// @param node The node, this thread swapped its children to Expanding.
+    /// @param decision True for a decision node.
+    /// @param rows The stack the node's piece goes on, for a decision node.
+    /// @return False if the pool is full, the node is left unexpanded.
+    bool Expand(Node& node, bool decision, const Rows& rows);
+
+    /// Picks the child of a decision node to descend into by UCB1 with virtual loss.
+    /// @param node The node, expanded with at least one child.
+    /// @return Index of the child in the pool.
+    std::uint32_t Select(const Node& node) const;
+
+    /// Runs one descent from the root, scores the leaf and backs the score up.
+    /// @param random This thread's piece draws past the preview.
+    /// @param depth Receives the pieces placed.
+    void Descend(std::minstd_rand& random, int& depth);
+
+    /// Makes the subtree under the played placement and the spawned piece the root, if the game
+    /// is where the last Think() left it one piece on.
+    /// @param game The game.
+    /// @param rows The game's stack without the active piece.
+    /// @return True if a subtree was kept.
+    bool Reroot(const BasicGame<BoardType>& game, const Rows& rows);
+
+    /// Copies a subtree to the front of the other pool and makes that pool the active one.
+    /// @param root Index of the subtree's root in the active pool.
+    void Compact(std::uint32_t root);
+
+    std::unique_ptr<WorkerPool> _pool;        ///< Threads descending the tree.
+    SearchWeights _weights;                   ///< Leaf evaluation weights.
+    std::array<Pool, 2> _pools;               ///< The active pool and the one the next compaction copies into.
+    int _active = 0;                          ///< Index of the active pool.
+    std::uint32_t _root = Unexpanded;         ///< Root decision node, Unexpanded when there is no tree.
+    Rows _rootRows{};                         ///< The root's stack.
+    std::array<int, Known> _known{};          ///< Piece types of the root's piece and the preview.
+    int _rootPieces = -1;                     ///< Pieces the game had locked at the root.
+    std::uint32_t _played = Unexpanded;       ///< Chance node of the placement the last Think() returned.
+    double _exploration = 0.5;                ///< UCB1 exploration constant.
+    int _virtualLoss = 1;                     ///< Visits each pending thread counts for.
+    std::atomic<bool> _full{false};           ///< Set once an expansion found the pool full.
+    std::atomic<int> _depth{0};               ///< Deepest descent of the current search.
+    std::atomic<long long> _iterations{0};    ///< Descents of the current search.
+    std::atomic<unsigned int> _nextSeed{0};   ///< Hands each thread of a search its own random stream.
+    MonteCarloStats _stats;                   ///< What the last Think() did.
+};
+
+/// Tree search for games on the standard board.
+using MonteCarloSearch = BasicMonteCarloSearch<Board>;
+
+extern template class BasicMonteCarloSearch<Board>;
+extern template class BasicMonteCarloSearch<TallBoard>;
+
+#endif // MONTECARLOSEARCH_H
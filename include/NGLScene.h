@@ -8,9 +8,25 @@
 #include "WindowParams.h"
 #include <QOpenGLWindow>
 #include <QTimer>
+#include "BotLink.h"
+#include "ChunkedCubes.h"
 #include "Cube.h"
-#include "Tetromino.h"
-#include "Board.h"
+#include "FrameArena.h"
+#include "FrameScheduler.h"
+#include "InputTimeline.h"
+#include "InstancedCubes.h"
+#include "MonteCarloSearch.h"
+#include "Palette.h"
+#include "ShadingTiers.h"
+#include "SandboxGame.h"
+#include "ShadowMaps.h"
+#include "VersusMatch.h"
+#include "VoxelGame.h"
+#include "NetplaySession.h"
+#include <array>
+#include <chrono>
+#include <future>
+#include <memory>
 
 //----------------------------------------------------------------------------------------------------------------------
 /// @class NGLScene
@@ -38,20 +54,32 @@ public:
     /// Handle OpenGL window resizing
     void resizeGL(int _width, int _height) override;
 
-    /// Add a cube to the scene
-    void AddCube(const Cube& cube);
+    /// Set the match to play, one board per player
+    void setMatch(VersusMatch match);
 
-    /// Set the current Tetromino
-    void setTetromino(const Tetromino& tetromino);
+    /// Play online instead, the local keyboard drives this peer's board
+    void setNetplay(std::unique_ptr<NetplaySession> netplay);
 
-    /// Set the game board
-    void setBoard(const Board& board);
+    /// Play the 3D well mode instead, one player
+    void setVoxelGame(std::unique_ptr<VoxelGame> _game);
 
-    /// Update cubes based on game state changes
+    /// Play co-op on one large sparse board instead
+    void setSandbox(std::unique_ptr<SandboxGame> _game);
+
+    /// Let the tree search play the first board, thinking for a budget of milliseconds whenever a piece spawns
+    void setBot(std::unique_ptr<MonteCarloSearch> _bot, double _milliseconds);
+
+    /// Let a bot in another process play the first board through shared memory, see BotLink
+    void setBotLink(std::unique_ptr<BotLink> _link) { m_botLink = std::move(_link); }
+
+    /// Report how long key presses take to reach the simulation, every few seconds and on exit
+    void setMeasureInput(bool _measure) { m_measureInput = _measure; }
+
+    /// Rebuild this frame's cubes from every board, in the frame arena
     void updateCubes();
 
 private slots:
-    /// Slot to handle game loop ticks
+    /// Slot to handle game loop ticks, running every simulation frame that has ended since the last
     void gameLoopTick();
 
 private:
@@ -63,13 +91,66 @@ private:
     bool m_transformLight = false;  ///< Flag to determine if the light should be transformed
     ngl::Vec4 m_lightPos;           ///< Position of the light in the scene
     ngl::Real m_lightAngle;         ///< Angle of the light
+    ngl::Vec3 m_cameraPos;          ///< Position of the static camera
+    ShadingTiers m_shading;         ///< Shader variants and the tier currently drawn with
+    ShadowMaps m_shadows;           ///< Depth maps of the stacks and the falling pieces from the light
+    PaletteTheme m_palette = PaletteTheme::Classic; ///< Colours the boards' palette indices are drawn with
 
     /// Load transformation matrices into the shader program
     void loadMatricesToShader();
 
+    /// Load the material, light, board offsets and palette into a shading tier's program
+    void loadTierUniforms(ShadingTier _tier);
+
+    /// Load the floor's colours, light and shadow maps into its program
+    void loadFloorUniforms();
+
+    /// Load the offset of every board into a shading tier
+    void loadBoardOffsets(ShadingTier _tier);
+
+    /// Load the colours of the current palette theme into a shading tier
+    void loadPalette(ShadingTier _tier);
+
+    /// Load every board's last lock and clear into a shading tier, the shader animates them from the time alone
+    void loadBoardEvents(ShadingTier _tier);
+
+    /// Note the locks and clears made by the simulation frames just run, for the shader to animate
+    void recordBoardEvents(float _time);
+
+    /// Seconds since the window was made, the clock the animations run on
+    float animationTime() const;
+
     /// Handle key press events
     void keyPressEvent(QKeyEvent* _event) override;
 
+    /// Handle key release events
+    void keyReleaseEvent(QKeyEvent* _event) override;
+
+    /// The match being shown, either local or the netplay session's
+    const VersusMatch& activeMatch() const;
+
+    /// The number of boards laid out, the 3D well takes the place of one
+    int boardCount() const;
+
+    /// Rebuild this frame's cubes from the 3D well, in the frame arena
+    void updateVoxelCubes();
+
+    /// Rebuild this frame's falling piece cubes from the sandbox, its board is drawn by m_chunkCubes
+    void updateSandboxCubes();
+
+    /// Where the sandbox board's bottom left cell is drawn, so the first player's lane is in view
+    ngl::Vec3 sandboxOrigin() const;
+
+    /// The buttons the bot holds this frame, searching first if its piece has just spawned, or taking
+    /// the external bot's placement once it arrives
+    InputFrame botInput();
+
+    /// Arm the single shot timer for the end of the next simulation frame
+    void scheduleTick();
+
+    /// Print the key to simulation latency figures
+    void reportInputLatency() const;
+
     /// Handle mouse movement events
     void mouseMoveEvent(QMouseEvent* _event) override;
 
@@ -82,10 +163,46 @@ private:
     /// Handle mouse wheel events
     void wheelEvent(QWheelEvent* _event) override;
 
-    std::vector<Cube> m_cubes;      ///< Vector of cubes representing parts of the Tetris game
-    Tetromino m_tetromino;          ///< Current Tetromino in play
-    Board m_board;                  ///< Game board
-    QTimer m_timer;                 ///< Timer for game loop ticks
+    FrameArena m_frameArena;        ///< Storage for each frame's render items, reset every rebuild
+    Cube* m_cubes = nullptr;        ///< This frame's locked cubes, in m_frameArena
+    std::size_t m_cubeCount = 0;    ///< Number of cubes in m_cubes
+    Cube* m_pieceCubes = nullptr;   ///< This frame's falling piece cubes, in m_frameArena
+    std::size_t m_pieceCubeCount = 0; ///< Number of cubes in m_pieceCubes
+    std::uint64_t m_stackKey = 0;   ///< Hash of every board's locked stack, the stack shadow is redrawn when it changes
+    std::uint64_t m_sceneKey = 0;   ///< Hash of every board and piece count, the cubes are rebuilt when it changes
+    static constexpr int LockedCells = 4;      ///< Cells of a locked tetromino the shader flashes
+    std::array<int, VersusMatch::MaxPlayers> m_eventPieces{};   ///< Pieces locked on each board when its events were last noted
+    std::array<float, VersusMatch::MaxPlayers> m_lockTimes{};   ///< When each board's last piece locked
+    std::array<float, VersusMatch::MaxPlayers> m_clearTimes{};  ///< When each board's last rows cleared
+    std::array<int, VersusMatch::MaxPlayers> m_clearedRows{};   ///< Rows each board's last clear took out, a bit per row before the clear, the lowest 31 rows only
+    std::array<int, VersusMatch::MaxPlayers * LockedCells> m_lockedCells{}; ///< Cells of each board's last locked piece after its clear, row * 256 + column
+    float m_animationEnd = 0.0f;    ///< When the animations started so far have all finished
+    bool m_eventsChanged = false;   ///< Whether the shading tiers need the events loading again
+    FrameScheduler m_scheduler;     ///< Dirty layers and the pending frame request
+    int m_frames = 0;               ///< Simulation frames run, allocations are checked once warmed up
+    InstancedCubes m_instances;     ///< GPU copy of m_cubes drawn in one call
+    InstancedCubes m_pieceInstances; ///< GPU copy of m_pieceCubes drawn in one call
+    ChunkedCubes m_chunkCubes;      ///< GPU copy of the sandbox board, a buffer per occupied tile
+    VersusMatch m_match;            ///< Every player's game
+    std::unique_ptr<NetplaySession> m_netplay; ///< Online session, replaces m_match when set
+    std::unique_ptr<VoxelGame> m_voxel;        ///< 3D well game, replaces m_match when set
+    std::unique_ptr<SandboxGame> m_sandbox;    ///< Co-op game on a large board, replaces m_match when set
+    std::unique_ptr<MonteCarloSearch> m_bot;   ///< Tree search playing the first board in place of the keyboard, when set
+    double m_botBudget = 0.0;       ///< Milliseconds the bot thinks per piece
+    std::unique_ptr<BotLink> m_botLink;        ///< Shared memory to a bot process playing the first board, when set
+    MonteCarloSearch::Placement m_botTarget; ///< Where the bot is taking its current piece
+    int m_botPieces = -1;           ///< Pieces locked on the bot's board when its target was last reset
+    Game m_botGame;                 ///< Copy of the bot's game the running search reads
+    int m_botThinkingPieces = -1;   ///< Pieces locked on the bot's board when the last search started
+    std::future<MonteCarloSearch::Placement> m_botThinking; ///< Search running on its own thread, declared after what it reads
+    InputFrame m_botLast = 0;       ///< Buttons the bot held last frame, it releases between presses
+    static constexpr int LocalPlayers = 2;     ///< Players sharing the keyboard
+    InputTimeline m_input;          ///< Timestamped key presses, handed out to the simulation frame they fall in
+    bool m_measureInput = false;    ///< Whether to report the key to simulation latency
+    int m_piecesLocked = 0;         ///< Pieces locked across all boards, to spot when scores change
+    std::chrono::steady_clock::time_point m_created; ///< When the window was made, to time startup
+    bool m_firstFrame = true;       ///< Whether the first frame is still to be drawn
+    QTimer m_timer;                 ///< Single shot timer for the next simulation frame's end, left stopped once every local game is over
 };
 
 #endif // NGLSCENE_H_
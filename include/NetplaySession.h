@@ -0,0 +1,94 @@
+#ifndef NETPLAYSESSION_H
+#define NETPLAYSESSION_H
+
+#include <memory>
+#include <string>
+#include "RollbackSession.h"
+#include "UdpLink.h"
+
+/// @struct NetplayOptions
+/// @brief How to connect a NetplaySession and what network conditions to simulate.
+struct NetplayOptions
+{
+    bool server = false;            ///< True to wait for a client, false to connect to a server.
+    std::string host = "127.0.0.1"; ///< Server address, used by clients.
+    int port = 7000;                ///< Server port.
+    int inputDelay = 2;             ///< Frames of input delay, chosen by the server.
+    unsigned int seed = 0;          ///< Piece sequence seed, chosen by the server.
+    int latencyMs = 0;              ///< Injected one-way latency.
+    int jitterMs = 0;               ///< Injected random extra latency.
+    double loss = 0.0;              ///< Injected datagram loss probability.
+};
+
+/// @class NetplaySession
+/// @brief Runs a RollbackSession against a peer over UDP.
+///
+/// Every frame sends all local input the peer hasn't acknowledged, so a lost datagram is
+/// covered by the next one, along with the checksum of the newest confirmed state so both
+/// sides can spot a desync.
+class NetplaySession
+{
+public:
+    /// Connects to the peer, blocking until the handshake completes or times out.
+    /// The server picks the seed and input delay and sends them to the client.
+    /// @param board The empty board both players start with.
+    /// @param options Connection and impairment settings.
+    /// @param timeoutMs How long to wait for the peer.
+    /// @return True if connected.
+    bool Connect(const Board& board, const NetplayOptions& options, int timeoutMs);
+
+    /// Reads every waiting datagram from the peer.
+    void Poll();
+
+    /// Simulates the next frame if the rollback window allows it, then sends input to the peer.
+    /// @param localInput The buttons held locally this frame.
+    /// @return False if the frame was skipped waiting for the peer.
+    bool AdvanceFrame(InputFrame localInput);
+
+    /// Settles any rollback and keeps the peer up to date without advancing, e.g. after the last frame.
+    void Service();
+
+    /// Sends unacknowledged input and the confirmed checksum.
+    void SendInputs();
+
+    /// Gets the rollback session.
+    /// @return The session, only valid after Connect succeeded.
+    const RollbackSession& getSession() const { return *_session; }
+
+    /// Gets the number of frames skipped waiting for the peer.
+    /// @return The stall count.
+    int getStalls() const { return _stalls; }
+
+    /// Gets the number of checksums compared with the peer.
+    /// @return The comparison count.
+    int getChecksumsCompared() const { return _checksumsCompared; }
+
+    /// Checks whether a checksum comparison ever failed.
+    /// @return True if the two simulations diverged.
+    bool hasDesynced() const { return _desyncFrame >= 0; }
+
+    /// Gets the first frame found to differ from the peer.
+    /// @return The frame, or -1 if none.
+    int getDesyncFrame() const { return _desyncFrame; }
+
+    /// Gets the number of datagrams dropped by loss injection.
+    /// @return The dropped count.
+    int getDropped() const { return _link.getDropped(); }
+
+private:
+    /// Compares the peer's last announced checksum with ours once we have that frame confirmed.
+    void CheckRemoteChecksum();
+
+    UdpLink _link;                              ///< Socket to the peer.
+    std::unique_ptr<RollbackSession> _session;  ///< Rollback state, created by Connect.
+    unsigned int _seed = 0;                     ///< Seed agreed in the handshake.
+    int _inputDelay = 0;                        ///< Input delay agreed in the handshake.
+    int _peerAck = -1;                          ///< Last of our frames the peer has confirmed.
+    int _remoteChecksumFrame = -1;              ///< Frame of the peer's last unchecked checksum.
+    std::uint32_t _remoteChecksum = 0;          ///< The peer's checksum for that frame.
+    int _stalls = 0;                            ///< Frames skipped waiting for the peer.
+    int _checksumsCompared = 0;                 ///< Checksums that matched or failed.
+    int _desyncFrame = -1;                      ///< First frame that differed from the peer.
+};
+
+#endif // NETPLAYSESSION_H
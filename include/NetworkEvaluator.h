@@ -0,0 +1,136 @@
+#ifndef NETWORKEVALUATOR_H
+#define NETWORKEVALUATOR_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/// @enum NetworkKernel
+/// @brief The int8 dot product routine a NetworkEvaluator runs its layers with.
+enum class NetworkKernel : std::uint8_t
+{
+    Portable, ///< Plain C++, runs anywhere.
+    Avx2,     ///< 32 multiply-adds per instruction pair with AVX2.
+    Vnni      ///< 32 multiply-adds per instruction with AVX-512 VNNI on 256-bit registers.
+};
+
+/// @class NetworkEvaluator
+/// @brief Scores boards with a small quantised multilayer perceptron, an alternative to the hand tuned heuristic.
+///
+/// The inputs are every cell of the board, 1 where it is filled, followed by the height of each
+/// column in rows. Each layer multiplies its int8 weights with the previous layer's activations,
+/// unsigned bytes, adds an int32 bias and, except for the last layer, shifts the sum right and
+/// clamps it to 0..127 for the next layer; the last layer has one output, the score, higher is
+/// better. Keeping activations under 128 lets the AVX2 kernel pair products in 16 bits without
+/// saturating. Rows of weights are padded to a multiple of 32 so every kernel runs whole vectors.
+/// The kernel is picked at load time from what the CPU supports and can be overridden to compare
+/// them; every kernel gives the same scores.
+///
+/// A network file is little endian: "TNN1", the board width and height and the layer count as
+/// uint32, then for each layer its output count and shift as uint32, the biases as int32 and the
+/// weights as int8, one row of inputs per output. Evaluating is const and allocation free, so one
+/// evaluator can be shared by every search thread.
+class NetworkEvaluator
+{
+public:
+    /// Most inputs a layer can take, enough for a 10x40 board and its column heights.
+    static constexpr int MaxInputs = 1024;
+
+    /// Most outputs a hidden layer can have.
+    static constexpr int MaxNeurons = 256;
+
+    /// Loads a network file.
+    /// @param path The file.
+    /// @return False if the file couldn't be read or doesn't hold a valid network, the error is printed.
+    bool Load(const std::string& path);
+
+    /// Reads a network written by Write().
+    /// @param in The stream.
+    /// @return False if it doesn't hold a valid network, the error is printed.
+    bool Read(std::istream& in);
+
+    /// Writes the network in the file format Load() reads.
+    /// @param out The stream.
+    void Write(std::ostream& out) const;
+
+    /// Replaces the network with random weights, for measuring speed or as a starting point for training.
+    /// @param width Board columns.
+    /// @param height Board rows.
+    /// @param hidden Outputs of each hidden layer, each 1..MaxNeurons.
+    /// @param seed Seed for the weights.
+    void Randomise(int width, int height, const std::vector<int>& hidden, unsigned int seed);
+
+    /// Scores boards.
+    /// @param rows The boards, getHeight() row masks each, bit j of a row is column j, one board after another.
+    /// @param count The number of boards.
+    /// @param scores Receives a score per board.
+    void EvaluateBatch(const std::uint64_t* rows, int count, int* scores) const;
+
+    /// Scores one board.
+    /// @param rows getHeight() row masks.
+    /// @return The score.
+    int Evaluate(const std::uint64_t* rows) const
+    {
+        int score = 0;
+        EvaluateBatch(rows, 1, &score);
+        return score;
+    }
+
+    /// Checks whether a network has been loaded.
+    /// @return True once Load(), Read() or Randomise() succeeded.
+    bool isLoaded() const { return !_layers.empty(); }
+
+    /// Gets the board columns the network was made for.
+    /// @return The width.
+    int getWidth() const { return _width; }
+
+    /// Gets the board rows the network was made for.
+    /// @return The height.
+    int getHeight() const { return _height; }
+
+    /// Gets the multiply-adds per board.
+    /// @return The sum over layers of inputs times outputs.
+    long long getOperations() const;
+
+    /// Gets the kernel the layers are run with.
+    /// @return The kernel.
+    NetworkKernel getKernel() const { return _kernel; }
+
+    /// Picks the kernel, falling back to the portable one if the CPU doesn't support it.
+    /// @param kernel The kernel.
+    /// @return The kernel now in use.
+    NetworkKernel setKernel(NetworkKernel kernel);
+
+    /// Gets the fastest kernel this CPU supports.
+    /// @return The kernel.
+    static NetworkKernel BestKernel();
+
+    /// Gets the name of a kernel.
+    /// @param kernel The kernel.
+    /// @return "portable", "avx2" or "vnni".
+    static const char* KernelName(NetworkKernel kernel);
+
+private:
+    /// One fully connected layer.
+    struct Layer
+    {
+        int inputs = 0;                 ///< Inputs used.
+        int stride = 0;                 ///< Inputs rounded up to a multiple of 32, the length of a weight row.
+        int outputs = 0;                ///< Outputs.
+        int shift = 0;                  ///< Right shift from the int32 sums to the next layer's activations.
+        std::vector<std::int32_t> biases;  ///< Bias of each output.
+        std::vector<std::int8_t> weights;  ///< outputs rows of stride weights, zero past inputs.
+    };
+
+    /// Checks the layer sizes chain up and fit the fixed buffers.
+    /// @return An empty string, or what is wrong.
+    std::string Validate() const;
+
+    int _width = 0;                         ///< Board columns.
+    int _height = 0;                        ///< Board rows.
+    std::vector<Layer> _layers;             ///< The layers in order, the last has one output.
+    NetworkKernel _kernel = NetworkKernel::Portable; ///< Kernel the layers run with.
+};
+
+#endif // NETWORKEVALUATOR_H
@@ -0,0 +1,38 @@
+#ifndef PALETTE_H_
+#define PALETTE_H_
+
+#include <array>
+#include <ngl/Vec3.h>
+#include "Tetromino.h"
+
+/// @enum PaletteTheme
+/// @brief Colour tables the palette indices stored on the boards can be drawn with.
+enum class PaletteTheme
+{
+    Classic = 0,    ///< The original saturated piece colours.
+    ColourBlind = 1 ///< Okabe-Ito colours, distinguishable with the common colour vision deficiencies.
+};
+
+/// @class Palette
+/// @brief The colour of every palette index, per theme.
+///
+/// Boards only store a palette index per cell and the vertex shader looks the colour up in a
+/// uniform array, so switching theme is one upload of PaletteSize colours.
+class Palette
+{
+public:
+    /// Number of themes.
+    static constexpr int ThemeCount = 2;
+
+    /// Gets a theme's colours.
+    /// @param _theme The theme.
+    /// @return One colour per palette index, GarbagePalette first.
+    static const std::array<ngl::Vec3, PaletteSize> &colours(PaletteTheme _theme);
+
+    /// Gets a theme's name for messages.
+    /// @param _theme The theme.
+    /// @return The name.
+    static const char *name(PaletteTheme _theme);
+};
+
+#endif // PALETTE_H_
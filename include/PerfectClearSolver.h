@@ -0,0 +1,176 @@
+#ifndef PERFECTCLEARSOLVER_H
+#define PERFECTCLEARSOLVER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Game.h"
+#include "PlacementSearch.h"
+#include "WorkerPool.h"
+
+/// @enum FinesseKey
+/// @brief One key action of a finesse path, each a single press.
+enum class FinesseKey : std::uint8_t
+{
+    Rotate,    ///< Tap rotate, clockwise.
+    Left,      ///< Tap left, one column.
+    Right,     ///< Tap right, one column.
+    DasLeft,   ///< Hold left until the piece reaches the wall or the stack.
+    DasRight,  ///< Hold right until the piece reaches the wall or the stack.
+    Drop       ///< Hold down until the piece locks.
+};
+
+/// @class BasicPerfectClearSolver
+/// @brief Finds piece sequences that clear the board completely, and the fewest keys to reach a placement.
+///
+/// A perfect clear within N lines only ever touches the bottom N rows, so the solver packs them
+/// into one 64-bit word, row r at bit r * Width, and searches placements of the active piece and
+/// the preview in order, each dropped straight down from above as BasicPlacementSearch does.
+/// Branches are cut when the empty cells aren't a multiple of four pieces, when more pieces are
+/// needed than remain, when a cell is covered (a straight drop can never fill it) and when a
+/// region walled off by full columns holds a number of cells no set of pieces can fill. Stacks
+/// already shown to fail are remembered, keyed by the packed rows, the lines left and the piece
+/// index, in a fixed table per thread. The placements of the active piece are split across a
+/// WorkerPool; the first in placement order that succeeds is returned, so the answer doesn't
+/// depend on the thread count.
+/// Instantiated in PerfectClearSolver.cpp for the 10 column boards.
+/// @tparam BoardType The board the game is played on, a BasicBoard with a fixed size.
+template <typename BoardType>
+class BasicPerfectClearSolver
+{
+    static_assert(BoardType::FixedWidth != Dynamic && BoardType::FixedHeight != Dynamic,
+                  "The solver packs rows of a fixed width");
+
+public:
+    /// Most lines a perfect clear can be searched within, as many rows as fit one 64-bit word.
+    static constexpr int MaxLines = 64 / BoardType::FixedWidth;
+
+    /// Pieces a solution can use, the active one and the preview.
+    static constexpr int MaxPieces = PreviewSize + 1;
+
+    /// Most keys a finesse path holds, a rotation per orientation, a shift per column and the drop.
+    static constexpr int MaxKeys = 16;
+
+    /// @struct Step
+    /// @brief Where one piece of a solution goes.
+    struct Step
+    {
+        int rotation = 0; ///< Rotation index to turn to at the spawn row.
+        int x = 0;        ///< Column of the left edge of the piece box.
+    };
+
+    /// @struct Solution
+    /// @brief A perfect clear, or why there isn't one.
+    struct Solution
+    {
+        std::array<Step, MaxPieces> steps{}; ///< Placement of each piece in order.
+        int pieces = 0;                      ///< Pieces the clear takes, 0 if none was found.
+        int lines = 0;                       ///< Lines the clear takes.
+        bool found = false;                  ///< Whether the board can be cleared.
+        bool complete = true;                ///< False if the node limit stopped the search early.
+        long long nodes = 0;                 ///< Stacks searched, summed over threads.
+    };
+
+    /// @struct FinessePath
+    /// @brief The fewest key presses that bring the active piece to a placement and lock it there.
+    struct FinessePath
+    {
+        std::array<FinesseKey, MaxKeys> keys{}; ///< The presses in order, the last is always Drop.
+        int count = 0;                          ///< Presses in keys.
+        bool valid = false;                     ///< False if the placement can't be reached from the spawn row.
+    };
+
+    /// Constructor.
+    /// @param threads Threads splitting each solve, including the caller's.
+    explicit BasicPerfectClearSolver(int threads);
+
+    /// Looks for a perfect clear of the game's stack with the active piece and the preview.
+    /// @param game The game, its board, active piece and preview are read.
+    /// @param maxLines Most lines the clear may take, each feasible height from the lowest up is tried, up to MaxLines.
+    /// @param nodeLimit Stacks each thread may search before giving up, 0 for no limit.
+    /// @return The first clear found at the lowest height, or found false.
+    Solution Solve(const BasicGame<BoardType>& game, int maxLines, long long nodeLimit = 0);
+
+    /// Finds the fewest key presses from the active piece's spawn position to a placement, trying
+    /// rotations and shifts at the spawn row where the game applies them.
+    /// @param game The game, its board and active piece are read.
+    /// @param target The placement, e.g. the first step of a Solution.
+    /// @return The path.
+    static FinessePath Finesse(const BasicGame<BoardType>& game, const Step& target);
+
+private:
+    using Pieces = typename BoardType::Pieces;
+    using Placements = BasicPlacementSearch<BoardType>; ///< Shifts pieces to their columns and reads the stack.
+    using Field = std::uint64_t; ///< The bottom rows of a stack, row r at bit r * Width.
+
+    /// A failed stack remembered by a thread.
+    struct MemoEntry
+    {
+        Field field = 0;          ///< Packed rows.
+        std::uint8_t lines = 0;   ///< Lines still to clear.
+        std::uint8_t ply = 0;     ///< Index of the next piece, 0 for an empty slot.
+    };
+
+    /// One thread's memo and counters.
+    struct Worker
+    {
+        std::vector<MemoEntry> memo; ///< Failed stacks, direct mapped.
+        long long nodes = 0;         ///< Stacks searched this solve.
+        bool aborted = false;        ///< Whether the node limit was hit.
+    };
+
+    /// One placement of the active piece and what became of it.
+    struct Branch
+    {
+        Step step;                            ///< The placement.
+        Field field = 0;                      ///< The stack after it.
+        int lines = 0;                        ///< Lines left after it.
+        bool found = false;                   ///< Whether a clear follows.
+        std::array<Step, MaxPieces> steps{};  ///< The rest of the clear.
+    };
+
+    /// Drops a piece into the packed rows, locks it and removes the rows it fills.
+    /// @param field The stack before.
+    /// @param lines Rows the stack may reach.
+    /// @param type The piece.
+    /// @param rotation Its rotation index.
+    /// @param x The column of the left edge of the piece box.
+    /// @param child Receives the stack after.
+    /// @return The lines left after the rows it filled are removed, -1 if it doesn't fit below the ceiling.
+    static int Place(Field field, int lines, int type, int rotation, int x, Field& child);
+
+    /// Checks the prunes that show a stack can't be cleared whatever the pieces.
+    /// @param field The stack.
+    /// @param lines Rows left to clear.
+    /// @param piecesLeft Pieces still to place.
+    /// @return True if the stack can't be cleared.
+    static bool Hopeless(Field field, int lines, int piecesLeft);
+
+    /// Searches the pieces from a ply onwards for a clear of a stack.
+    /// @param field The stack.
+    /// @param lines Rows left to clear.
+    /// @param ply Index of the next piece.
+    /// @param worker The calling thread's memo.
+    /// @param steps Receives the placement of each piece from ply on.
+    /// @return True if a clear was found.
+    bool Search(Field field, int lines, int ply, Worker& worker, std::array<Step, MaxPieces>& steps);
+
+    std::unique_ptr<WorkerPool> _pool;   ///< Threads splitting the active piece's placements.
+    std::vector<Worker> _workers;        ///< A memo per thread.
+    std::vector<Branch> _branches;       ///< Placements of the active piece, reused between solves.
+    std::array<int, MaxPieces> _pieces{}; ///< Piece of each ply of the current solve.
+    int _pieceCount = 0;                 ///< Pieces in the current solve.
+    long long _nodeLimit = 0;            ///< Per thread node limit of the current solve.
+    std::atomic<int> _firstFound{0};     ///< Lowest branch found so far, later branches are skipped.
+    std::atomic<int> _nextWorker{0};     ///< Hands each thread of a batch its own worker.
+};
+
+/// Solver for games on the standard board.
+using PerfectClearSolver = BasicPerfectClearSolver<Board>;
+
+extern template class BasicPerfectClearSolver<Board>;
+extern template class BasicPerfectClearSolver<TallBoard>;
+
+#endif // PERFECTCLEARSOLVER_H
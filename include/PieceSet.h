@@ -0,0 +1,75 @@
+#ifndef PIECESET_H
+#define PIECESET_H
+
+#include <array>
+#include <cstdint>
+
+/// @struct StandardTetrominoes
+/// @brief The seven tetrominoes as packed row masks, the default piece set of a BasicBoard.
+///
+/// A piece set is any type with the same members: getCount() pieces numbered from 1, each
+/// with Rotations orientations drawn in a Size x Size box (see also CustomPieces). A shape is
+/// one mask per row of the box, row 0 at the bottom, and bit j of a row is column j, so the
+/// binary literals below read mirrored left to right.
+struct StandardTetrominoes
+{
+    static constexpr int Count = 7;      ///< Number of pieces.
+    static constexpr int Size = 4;       ///< Width and height of the box every shape fits in.
+    static constexpr int Rotations = 4;  ///< Orientations per piece.
+    static constexpr int TBlock = 2;     ///< Type of the T piece, the only one that can T-spin.
+
+    /// One orientation of a piece, a row mask per row of the box.
+    using Shape = std::array<std::uint8_t, Size>;
+
+    /// Gets the number of pieces.
+    /// @return The piece count.
+    static constexpr int getCount() { return Count; }
+
+    /// Gets the shape of a piece.
+    /// @param type The piece, 1..Count.
+    /// @param rotation The orientation, 0..Rotations-1.
+    /// @return The row masks of the piece.
+    static constexpr const Shape& getShape(int type, int rotation) { return Shapes[type - 1][rotation]; }
+
+    /// Every orientation of every piece, indexed [type - 1][rotation].
+    static constexpr Shape Shapes[Count][Rotations] =
+            {
+            // I-Block //
+            {{0b0010, 0b0010, 0b0010, 0b0010},
+             {0b0000, 0b1111, 0b0000, 0b0000},
+             {0b0010, 0b0010, 0b0010, 0b0010},
+             {0b0000, 0b1111, 0b0000, 0b0000}},
+            // T-Block //
+            {{0b0000, 0b0111, 0b0010, 0b0000},
+             {0b0010, 0b0110, 0b0010, 0b0000},
+             {0b0010, 0b0111, 0b0000, 0b0000},
+             {0b0010, 0b0011, 0b0010, 0b0000}},
+            // O-Block //
+            {{0b0011, 0b0011, 0b0000, 0b0000},
+             {0b0011, 0b0011, 0b0000, 0b0000},
+             {0b0011, 0b0011, 0b0000, 0b0000},
+             {0b0011, 0b0011, 0b0000, 0b0000}},
+            // Z-Block //
+            {{0b0000, 0b0010, 0b0011, 0b0001},
+             {0b0000, 0b0011, 0b0110, 0b0000},
+             {0b0000, 0b0100, 0b0110, 0b0010},
+             {0b0000, 0b0000, 0b0011, 0b0110}},
+            // S-Block //
+            {{0b0001, 0b0011, 0b0010, 0b0000},
+             {0b0110, 0b0011, 0b0000, 0b0000},
+             {0b0010, 0b0110, 0b0100, 0b0000},
+             {0b0000, 0b0110, 0b0011, 0b0000}},
+            // L-Block //
+            {{0b0010, 0b0010, 0b0011, 0b0000},
+             {0b0000, 0b0111, 0b0100, 0b0000},
+             {0b0110, 0b0010, 0b0010, 0b0000},
+             {0b0001, 0b0111, 0b0000, 0b0000}},
+            // J-Block //
+            {{0b0001, 0b0001, 0b0011, 0b0000},
+             {0b0000, 0b0100, 0b0111, 0b0000},
+             {0b0011, 0b0010, 0b0010, 0b0000},
+             {0b0000, 0b0111, 0b0001, 0b0000}}
+            };
+};
+
+#endif // PIECESET_H
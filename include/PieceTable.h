@@ -0,0 +1,133 @@
+#ifndef PIECETABLE_H
+#define PIECETABLE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+/// @class PieceTable
+/// @brief Polyomino shapes loaded from a text file, with every rotation generated on load.
+///
+/// Each piece starts with a "piece <name>" line followed by its rows drawn top to bottom,
+/// X for a block and . for a gap; lines starting with # are comments. A piece may be up to
+/// MaxSize blocks wide and tall and must be connected. The blocks are centred in a square box
+/// the size of their longer side, rounding towards the bottom left, and rotations are made by
+/// turning them clockwise about the box's centre so a piece turns in place. They are stored as
+/// the same packed row masks as StandardTetrominoes: row 0 at the bottom, bit j is column j.
+class PieceTable
+{
+public:
+    /// Largest piece box, one byte per row.
+    static constexpr int MaxSize = 8;
+
+    /// Orientations generated per piece.
+    static constexpr int Rotations = 4;
+
+    /// One orientation of a piece, a row mask per row of the box.
+    using Shape = std::array<std::uint8_t, MaxSize>;
+
+    /// Loads a piece file, replacing any pieces already loaded.
+    /// @param path The file to read.
+    /// @return False if the file couldn't be read or a piece is invalid, the error is printed.
+    bool Load(const std::string& path);
+
+    /// Parses piece definitions from a stream, replacing any pieces already loaded.
+    /// @param input The stream to read.
+    /// @param source Name used in error messages.
+    /// @return False if a piece is invalid, the error is printed.
+    bool Parse(std::istream& input, const std::string& source);
+
+    /// Adds one piece from its rows.
+    /// @param name The piece name.
+    /// @param rows The rows from top to bottom, X for a block.
+    /// @return False if the piece is empty, too big or not connected.
+    bool AddPiece(const std::string& name, const std::vector<std::string>& rows);
+
+    /// Gets the number of pieces.
+    /// @return The piece count.
+    int getCount() const { return static_cast<int>(_names.size()); }
+
+    /// Gets the box size of the largest piece.
+    /// @return The width and height every shape fits in.
+    int getSize() const { return _size; }
+
+    /// Gets a piece's name.
+    /// @param type The piece, 1..getCount().
+    /// @return The name from the file.
+    const std::string& getName(int type) const { return _names[type - 1]; }
+
+    /// Gets the shape of a piece.
+    /// @param type The piece, 1..getCount().
+    /// @param rotation The orientation, 0..Rotations-1.
+    /// @return The row masks of the piece.
+    const Shape& getShape(int type, int rotation) const { return _shapes[(type - 1) * Rotations + rotation]; }
+
+private:
+    std::vector<std::string> _names; ///< Name of each piece.
+    std::vector<Shape> _shapes;      ///< Rotations of each piece, Rotations entries per piece.
+    int _size = 0;                   ///< Box size of the largest piece.
+};
+
+/// @struct CustomPieces
+/// @brief Piece set for BasicBoard backed by a loaded PieceTable.
+///
+/// The shapes are copied into a process-wide table narrowed to Box rows, so board code
+/// is compiled for the box size of the variant while the pieces themselves come from a file.
+/// Call Use() before creating any game with this piece set.
+/// @tparam Box Width and height every piece fits in, at most PieceTable::MaxSize.
+template <int Box>
+struct CustomPieces
+{
+    static_assert(Box > 0 && Box <= PieceTable::MaxSize, "Piece box must fit in a byte per row");
+
+    static constexpr int Size = Box;                           ///< Width and height of the piece box.
+    static constexpr int Rotations = PieceTable::Rotations;    ///< Orientations per piece.
+
+    /// One orientation of a piece, a row mask per row of the box.
+    using Shape = std::array<std::uint8_t, Size>;
+
+    /// Makes a loaded table the active piece set.
+    /// @param table The pieces to play with.
+    /// @return False if the table is empty or a piece doesn't fit in the box.
+    static bool Use(const PieceTable& table)
+    {
+        if (table.getCount() == 0 || table.getSize() > Size)
+        {
+            return false;
+        }
+        _shapes.resize(static_cast<std::size_t>(table.getCount()) * Rotations);
+        for (int type = 1; type <= table.getCount(); ++type)
+        {
+            for (int rotation = 0; rotation < Rotations; ++rotation)
+            {
+                const auto& shape = table.getShape(type, rotation);
+                std::copy(shape.begin(), shape.begin() + Size, _shapes[(type - 1) * Rotations + rotation].begin());
+            }
+        }
+        return true;
+    }
+
+    /// Gets the number of pieces.
+    /// @return The piece count of the active table.
+    static int getCount() { return static_cast<int>(_shapes.size()) / Rotations; }
+
+    /// Gets the shape of a piece.
+    /// @param type The piece, 1..getCount().
+    /// @param rotation The orientation, 0..Rotations-1.
+    /// @return The row masks of the piece.
+    static const Shape& getShape(int type, int rotation) { return _shapes[(type - 1) * Rotations + rotation]; }
+
+private:
+    static inline std::vector<Shape> _shapes; ///< Rotations of each piece.
+};
+
+/// Piece set for pentomino variants.
+using Pentominoes = CustomPieces<5>;
+
+/// Piece set for the largest custom polyominoes.
+using Polyominoes = CustomPieces<PieceTable::MaxSize>;
+
+#endif // PIECETABLE_H
@@ -0,0 +1,197 @@
+#ifndef PLACEMENTSEARCH_H
+#define PLACEMENTSEARCH_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Game.h"
+#include "NetworkEvaluator.h"
+#include "TranspositionTable.h"
+#include "WorkerPool.h"
+
+/// @struct SearchWeights
+/// @brief What a stack costs per column of height, covered hole and step between columns, and what a cleared line is worth.
+///
+/// The defaults are the search's hand tuned weights, tetris_tune looks for better ones.
+struct SearchWeights
+{
+    int height = 510;    ///< Cost per row of height summed over the columns.
+    int holes = 357;     ///< Cost per empty cell with a filled cell above it.
+    int bumpiness = 184; ///< Cost per row of difference between neighbouring columns.
+    int lines = 761;     ///< Value of each row cleared on the way.
+};
+
+/// @class BasicPlacementSearch
+/// @brief Finds where to drop the active piece by looking ahead through the preview.
+///
+/// Every rotation and column of the active piece is dropped straight down from the spawn row,
+/// then every placement of the next preview piece on each resulting stack and so on, to the
+/// requested depth; the stacks at the bottom are scored by a weighted sum of column heights,
+/// holes and bumpiness, with cleared lines added on the way. Stacks are identified by the
+/// board's Zobrist hash combined with the pieces still to come, so a stack reached twice,
+/// e.g. by the two equivalent orientations of an I, S or Z piece, or by different placements
+/// that clear the same lines, is looked up in a TranspositionTable instead of searched again.
+/// The placements of the active piece are split across a WorkerPool whose threads share the table.
+/// With a NetworkEvaluator set, the stacks are scored by the network instead, the last ply's stacks
+/// below each node in one batch.
+/// Instantiated in PlacementSearch.cpp for the fixed size boards.
+/// @tparam BoardType The board the game is played on, a BasicBoard with a fixed size.
+template <typename BoardType>
+class BasicPlacementSearch
+{
+    static_assert(BoardType::FixedWidth != Dynamic && BoardType::FixedHeight != Dynamic,
+                  "Search nodes keep the stack on the stack, the board size must be fixed");
+
+public:
+    /// Pieces a search can look at, the active one and the preview.
+    static constexpr int MaxDepth = PreviewSize + 1;
+
+    /// Score of a stack the next piece can't be placed on.
+    static constexpr int LossScore = -1000000000;
+
+    /// Occupancy of every row of a stack, row 0 at the bottom.
+    using Rows = std::array<typename BoardType::RowMask, BoardType::FixedHeight>;
+
+    /// Blocks of a piece in board columns, one mask per row of the piece box, bottom row first.
+    using PieceRows = std::array<std::uint64_t, BoardType::Pieces::Size>;
+
+    /// @struct Placement
+    /// @brief Where to drop the active piece.
+    struct Placement
+    {
+        int rotation = 0;   ///< Rotation index to turn to at the spawn row.
+        int x = 0;          ///< Column of the left edge of the piece box.
+        int score = 0;      ///< Value of the best line of play starting here.
+        bool valid = false; ///< False if the game is over or the piece fits nowhere.
+    };
+
+    /// Constructor.
+    /// @param table Results shared between searches and threads, nullptr to search without one.
+    /// @param threads Threads splitting each search, including the caller's.
+    /// @param weights Evaluation weights.
+    BasicPlacementSearch(TranspositionTable* table, int threads, const SearchWeights& weights = SearchWeights());
+
+    /// Searches the placements of the game's active piece.
+    /// @param game The game, its board, active piece and preview are read.
+    /// @param depth Pieces to look at, 1 for the active piece alone, up to MaxDepth.
+    /// @return The best placement.
+    Placement FindBest(const BasicGame<BoardType>& game, int depth);
+
+    /// Shifts a piece's rows from its box to a column of the board.
+    /// @param type The piece.
+    /// @param rotation Its rotation index.
+    /// @param x The column of the left edge of the piece box.
+    /// @param bits Receives the piece's rows.
+    /// @return False if any block is off the side of the board.
+    static bool ShiftPiece(int type, int rotation, int x, PieceRows& bits);
+
+    /// Drops a piece straight down from the spawn row, locks it and clears full rows, the rule every
+    /// search and bot places pieces by.
+    /// @param rows The stack, updated in place.
+    /// @param type The piece.
+    /// @param rotation Its rotation index.
+    /// @param x The column of the left edge of the piece box.
+    /// @return The rows cleared, -1 if the piece doesn't fit in that column at the spawn row, rows unchanged.
+    static int Drop(Rows& rows, int type, int rotation, int x);
+
+    /// Gets the locked stack of a game, whose board has the active piece drawn in.
+    /// @param game The game.
+    /// @return The board's rows without the active piece.
+    static Rows ExtractStack(const BasicGame<BoardType>& game);
+
+    /// Scores a stack, higher is better: low, flat and without covered holes.
+    /// @param rows The stack.
+    /// @param weights Evaluation weights.
+    /// @return The score.
+    static int Evaluate(const Rows& rows, const SearchWeights& weights = SearchWeights());
+
+    /// Gets the evaluation weights.
+    /// @return The weights.
+    const SearchWeights& getWeights() const { return _weights; }
+
+    /// Scores stacks with a network instead of Evaluate(), cleared lines are still valued by the weights.
+    /// @param network The network, made for this board size and outliving the search, nullptr for the heuristic.
+    /// @return False if the network was made for another board size, the search is left unchanged.
+    bool setNetwork(const NetworkEvaluator* network);
+
+    /// Gets the table traffic and leaf evaluations of every search since the last ResetStats().
+    /// @return The counts summed over threads.
+    const TranspositionStats& getStats() const { return _stats; }
+
+    /// Zeroes the counts returned by getStats().
+    void ResetStats() { _stats = TranspositionStats(); }
+
+private:
+    using Pieces = typename BoardType::Pieces;
+
+    /// Most placements of one piece, every rotation at every column the piece box can start in.
+    static constexpr int MaxPlacements = Pieces::Rotations * (BoardType::FixedWidth + Pieces::Size - 1);
+
+    /// A stack and its Zobrist hash, hashed the same way as BasicBoard::getHash().
+    struct Node
+    {
+        Rows rows;              ///< The stack.
+        std::uint64_t hash = 0; ///< XOR of BoardType::RowKey() over the rows.
+    };
+
+    /// One placement of the active piece and its value.
+    struct Candidate
+    {
+        int rotation = 0; ///< Rotation index.
+        int x = 0;        ///< Column of the left edge of the piece box.
+        int score = 0;    ///< Value once searched.
+    };
+
+    /// Finds where a piece dropped straight down from the spawn row comes to rest.
+    /// @param rows The stack.
+    /// @param bits The piece's rows, from ShiftPiece().
+    /// @param y Receives the row the bottom of the piece box lands on.
+    /// @return False if the piece doesn't fit at the spawn row.
+    static bool Land(const Rows& rows, const PieceRows& bits, int& y);
+
+    /// Drop() keeping the Zobrist hash up to date.
+    /// @param node The stack before.
+    /// @param type The piece.
+    /// @param rotation Its rotation index.
+    /// @param x The column of the left edge of the piece box.
+    /// @param child Receives the stack after.
+    /// @return The rows cleared, -1 if the piece doesn't fit in that column at the spawn row.
+    static int Place(const Node& node, int type, int rotation, int x, Node& child);
+
+    /// Scores the placements of the last ply's piece on a stack with the network, all in one batch.
+    /// @param node The stack.
+    /// @param ply Index of the piece, _depth - 1.
+    /// @param stats Counts the calling thread's work.
+    /// @param bestMove Receives the best placement.
+    /// @return The value of the best placement.
+    int SearchLastPly(const Node& node, int ply, TranspositionStats& stats, std::uint16_t& bestMove);
+
+    /// Gets the value of a stack with the pieces from a ply onwards still to place.
+    /// @param node The stack.
+    /// @param ply Index of the next piece, _depth to evaluate the stack itself.
+    /// @param stats Counts the calling thread's work.
+    /// @return The value of the best line of play.
+    int Search(const Node& node, int ply, TranspositionStats& stats);
+
+    TranspositionTable* _table;                   ///< Shared results, may be nullptr; only share one between searches with equal weights.
+    SearchWeights _weights;                       ///< Evaluation weights.
+    const NetworkEvaluator* _network = nullptr;   ///< Scores stacks in place of Evaluate() when set.
+    std::unique_ptr<WorkerPool> _pool;            ///< Threads splitting the active piece's placements.
+    std::vector<Candidate> _candidates;           ///< Placements of the active piece, reused between searches.
+    std::array<int, MaxDepth> _pieces{};          ///< Piece of each ply of the current search.
+    std::array<std::uint64_t, MaxDepth> _sequenceKeys{}; ///< Hash of the pieces from each ply to the end.
+    int _depth = 1;                               ///< Plies in the current search.
+    TranspositionStats _stats;                    ///< Counts summed over threads.
+    std::mutex _statsMutex;                       ///< Guards _stats while threads add their counts.
+};
+
+/// Search for games on the standard board.
+using PlacementSearch = BasicPlacementSearch<Board>;
+
+extern template class BasicPlacementSearch<Board>;
+extern template class BasicPlacementSearch<TallBoard>;
+extern template class BasicPlacementSearch<PentominoBoard>;
+
+#endif // PLACEMENTSEARCH_H
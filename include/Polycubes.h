@@ -0,0 +1,61 @@
+#ifndef POLYCUBES_H
+#define POLYCUBES_H
+
+#include <array>
+#include <cstdint>
+
+/// @enum VoxelAxis
+/// @brief Axes of a 3D well: x across, y into the well away from the viewer, z up.
+enum VoxelAxis : std::uint8_t
+{
+    AxisX, ///< Across the well.
+    AxisY, ///< Into the well.
+    AxisZ  ///< Up the well.
+};
+
+/// @struct Polycubes
+/// @brief The pieces of the 3D well mode, flat tetrominoes and a few that stand up out of the plane.
+///
+/// Each piece is a handful of unit cubes. Its orientations, every distinct result of quarter turns
+/// about the three axes, are worked out once from the cells the first time a table is asked for,
+/// each moved so its bounding box starts at the origin. An orientation keeps its cubes both as
+/// cells and as one 4x4 mask per layer of the box, bit x + 4 * y, for a well to widen to its own
+/// layer width, see BasicVoxelWell.
+struct Polycubes
+{
+    static constexpr int Count = 8;            ///< Number of pieces.
+    static constexpr int MaxCells = 4;         ///< Most cubes in a piece.
+    static constexpr int Size = 4;             ///< Edge of the box every orientation fits in.
+    static constexpr int MaxOrientations = 24; ///< Rotations of a cube, the most orientations a piece has.
+
+    /// One cube of a piece.
+    struct Cell
+    {
+        std::int8_t x; ///< Across.
+        std::int8_t y; ///< Into the well.
+        std::int8_t z; ///< Up.
+    };
+
+    /// One orientation of a piece.
+    struct Orientation
+    {
+        std::array<Cell, MaxCells> cells{};        ///< The cubes, inside the box from the origin.
+        int cellCount = 0;                         ///< Cubes in cells.
+        std::array<std::uint16_t, Size> layers{};  ///< Cubes of each layer of the box, bit x + 4 * y.
+        std::array<int, 3> size{};                 ///< Extent of the box along each VoxelAxis.
+        std::array<std::uint8_t, 3> turned{};      ///< Orientation after a quarter turn about each VoxelAxis.
+    };
+
+    /// Gets the number of distinct orientations of a piece.
+    /// @param type The piece, 1..Count.
+    /// @return The orientation count, 1..MaxOrientations.
+    static int getOrientationCount(int type);
+
+    /// Gets one orientation of a piece.
+    /// @param type The piece, 1..Count.
+    /// @param orientation The orientation, 0..getOrientationCount(type)-1; 0 is the piece as it spawns.
+    /// @return The orientation.
+    static const Orientation& getOrientation(int type, int orientation);
+};
+
+#endif // POLYCUBES_H
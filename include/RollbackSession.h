@@ -0,0 +1,132 @@
+#ifndef ROLLBACKSESSION_H
+#define ROLLBACKSESSION_H
+
+#include <array>
+#include <cstdint>
+#include "VersusMatch.h"
+
+/// @class RollbackSession
+/// @brief Two player rollback netcode over a deterministic VersusMatch.
+///
+/// Local input is applied InputDelay frames after it is captured. Remote input that hasn't
+/// arrived yet is predicted by repeating the last input received; when the real input turns
+/// out different the match is restored from the snapshot at the mispredicted frame and
+/// re-simulated up to the present. The session never runs more than MaxRollback frames
+/// ahead of the last remote input it has, so a rollback never goes further back than that.
+/// Transport is left to the caller, see NetplaySession.
+class RollbackSession
+{
+public:
+    /// Furthest the simulation may run ahead of confirmed remote input.
+    static constexpr int MaxRollback = 8;
+
+    /// Largest supported input delay.
+    static constexpr int MaxInputDelay = 8;
+
+    /// Frames of input and snapshots kept, covers the rollback window plus the input delay.
+    static constexpr int HistorySize = 32;
+
+    /// Constructor to start a session.
+    /// @param board The empty board both players start with.
+    /// @param seed Seed shared by both peers.
+    /// @param localPlayer 0 or 1, which board this peer controls.
+    /// @param inputDelay Frames between capturing local input and applying it, must match the peer's.
+    RollbackSession(const Board& board, unsigned int seed, int localPlayer, int inputDelay);
+
+    /// Checks whether the next frame can be simulated without exceeding the rollback window.
+    /// @return False if the peer has fallen too far behind and this frame should be skipped.
+    bool CanAdvance() const;
+
+    /// Restores and re-simulates from the earliest mispredicted frame, if there is one.
+    /// Called by AdvanceFrame; call it directly to settle the state while not advancing.
+    void ApplyRollback();
+
+    /// Applies any pending rollback, then simulates one frame.
+    /// @param localInput The buttons held locally this frame, applied InputDelay frames later.
+    void AdvanceFrame(InputFrame localInput);
+
+    /// Records input received from the peer, scheduling a rollback if it contradicts a prediction.
+    /// @param frame The frame the input applies to.
+    /// @param input The buttons the remote player held on that frame.
+    void AddRemoteInput(int frame, InputFrame input);
+
+    /// Gets local input that has been scheduled, for sending to the peer.
+    /// @param frame The frame the input applies to, must be below getLocalInputEnd().
+    /// @return The buttons held locally on that frame.
+    InputFrame getLocalInput(int frame) const { return _inputs[_localPlayer][frame % HistorySize]; }
+
+    /// Gets the first frame with no local input scheduled yet.
+    /// @return One past the last scheduled local input frame.
+    int getLocalInputEnd() const { return _frame + _inputDelay; }
+
+    /// Gets the next frame to simulate.
+    /// @return The current frame number.
+    int getFrame() const { return _frame; }
+
+    /// Gets the last frame for which every remote input up to it has arrived.
+    /// @return The last confirmed remote frame, -1 before the first.
+    int getConfirmedFrame() const { return _remoteConfirmed; }
+
+    /// Gets the checksum of the newest state that no future input can change.
+    /// @param frame Receives the frame whose starting state was hashed.
+    /// @return The checksum, compare with the peer's for the same frame to detect a desync.
+    std::uint32_t getConfirmedChecksum(int& frame) const;
+
+    /// Gets the checksum recorded for the start of a frame, valid for frames up to getConfirmedFrame() + 1
+    /// that are still within the history.
+    /// @param frame The frame to query.
+    /// @return The checksum.
+    std::uint32_t getChecksum(int frame) const { return _checksums[frame % HistorySize]; }
+
+    /// Gets the match being simulated.
+    /// @return The match with the latest predicted state.
+    const VersusMatch& getMatch() const { return _match; }
+
+    /// Gets which board this peer controls.
+    /// @return The local player index.
+    int getLocalPlayer() const { return _localPlayer; }
+
+    /// Rollback statistics for reporting.
+    struct Stats
+    {
+        int rollbacks = 0;             ///< Number of rollbacks performed.
+        int resimulatedFrames = 0;     ///< Total frames re-simulated.
+        int maxRollbackFrames = 0;     ///< Deepest rollback.
+        double totalResimMicros = 0.0; ///< Time spent restoring and re-simulating.
+        double maxResimMicros = 0.0;   ///< Slowest single rollback.
+    };
+
+    /// Gets the rollback statistics.
+    /// @return The statistics so far.
+    const Stats& getStats() const { return _stats; }
+
+private:
+    /// Saves the match state and checksum at the start of a frame.
+    /// @param frame The frame about to be simulated.
+    void SaveFrame(int frame);
+
+    /// Simulates one frame with the best inputs known for it.
+    /// @param frame The frame to simulate.
+    void SimulateFrame(int frame);
+
+    /// Predicts remote input for a frame that hasn't been received.
+    /// @return The last confirmed remote input, players tend to keep holding what they held.
+    InputFrame PredictRemote() const;
+
+    VersusMatch _match;                       ///< Match in its latest (possibly predicted) state.
+    int _localPlayer = 0;                     ///< Board controlled by this peer.
+    int _inputDelay = 0;                      ///< Frames between capture and use of local input.
+    int _frame = 0;                           ///< Next frame to simulate.
+    int _remoteConfirmed = -1;                ///< Last frame with all remote input up to it received.
+    int _rollbackFrom = -1;                   ///< Earliest mispredicted frame, -1 if none.
+
+    std::array<std::array<InputFrame, HistorySize>, 2> _inputs{}; ///< Input per player per frame.
+    std::array<int, HistorySize> _remoteFrames;                  ///< Frame whose remote input is held in each slot, -1 if none.
+    std::array<InputFrame, HistorySize> _remoteUsed{};           ///< Remote input each frame was simulated with.
+    std::array<MatchState, HistorySize> _snapshots;              ///< Match state at the start of each frame.
+    std::array<std::uint32_t, HistorySize> _checksums{};         ///< Checksum of each snapshot.
+
+    Stats _stats; ///< Rollback statistics.
+};
+
+#endif // ROLLBACKSESSION_H
@@ -0,0 +1,104 @@
+#ifndef SANDBOXGAME_H
+#define SANDBOXGAME_H
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include "ChunkedBoard.h"
+#include "Game.h"
+
+/// @class SandboxGame
+/// @brief Co-op play on one very large ChunkedBoard, each player dropping tetrominoes into their own lane.
+///
+/// A deliberately simple mode for big shared grids: every button acts on the frame it goes down,
+/// down held drops a row a frame, and a piece that can't fall locks on the next gravity step. The
+/// players' falling pieces only collide with the locked cells, not with each other. A row clears once
+/// it is full all the way across the board. A player whose next piece has nowhere to go is out.
+class SandboxGame
+{
+public:
+    /// Most players sharing a board.
+    static constexpr int MaxPlayers = 8;
+
+    /// Constructor to start on an empty board.
+    /// @param width Columns of the board.
+    /// @param height Rows of the board.
+    /// @param players Players, 1..MaxPlayers, each gets an equal lane of the board to spawn in.
+    /// @param seed Seed for the piece sequence.
+    /// @param level Level whose gravity the pieces fall with, 1..Game::MaxLevel.
+    SandboxGame(int width, int height, int players, unsigned int seed, int level = 1);
+
+    /// Advances every player by one frame.
+    /// @param inputs The InputButtons held by each player during this frame.
+    void Step(const InputFrame* inputs);
+
+    /// Gets the board.
+    /// @return The locked cells.
+    const ChunkedBoard& getBoard() const { return _board; }
+
+    /// Gets the number of players.
+    /// @return The player count.
+    int getPlayerCount() const { return _playerCount; }
+
+    /// Gets a player's falling piece.
+    /// @param player The player.
+    /// @return The tetromino, only meaningful while isPlaying() is true.
+    const Tetromino& getTetromino(int player) const { return _players[player].tetromino; }
+
+    /// Checks whether a player still has a piece falling.
+    /// @param player The player.
+    /// @return False once the player's piece had nowhere to spawn.
+    bool isPlaying(int player) const { return _players[player].playing; }
+
+    /// Gets the column a player's pieces spawn in.
+    /// @param player The player.
+    /// @return The left edge of the spawn box, in the middle of the player's lane.
+    int getSpawnX(int player) const;
+
+    /// Gets the pieces locked by every player.
+    /// @return The piece count.
+    int getPieces() const { return _pieces; }
+
+    /// Gets the rows cleared.
+    /// @return The row count.
+    int getLines() const { return _lines; }
+
+    /// Checks whether every player is out.
+    /// @return True once nobody has a piece falling.
+    bool isGameOver() const;
+
+private:
+    /// One player's falling piece.
+    struct Player
+    {
+        Tetromino tetromino;          ///< Falling piece.
+        int gravityProgress = 0;      ///< Fraction of a row gravity has pulled, 16.16 fixed point.
+        InputFrame lastInput = 0;     ///< Buttons held on the previous frame, to find new presses.
+        bool playing = true;          ///< Whether the player's last piece found room to spawn.
+    };
+
+    /// Tries to move a player's piece.
+    /// @param player The player.
+    /// @param dx Columns right.
+    /// @param dy Rows up.
+    /// @return True if the piece moved.
+    bool Move(Player& player, int dx, int dy);
+
+    /// Locks a player's piece, clears the rows it filled and spawns the next one.
+    /// @param player The index of the player.
+    void Lock(int player);
+
+    /// Puts a new piece at the top of a player's lane.
+    /// @param player The index of the player.
+    void Spawn(int player);
+
+    ChunkedBoard _board;                         ///< Locked cells.
+    std::array<Player, MaxPlayers> _players;     ///< Every player's piece.
+    int _playerCount;                            ///< Players in the game.
+    int _gravity;                                ///< Gravity per frame, 16.16 fixed point.
+    std::minstd_rand _random;                    ///< Piece sequence shared by every player.
+    int _pieces = 0;                             ///< Pieces locked.
+    int _lines = 0;                              ///< Rows cleared.
+};
+
+#endif // SANDBOXGAME_H
@@ -0,0 +1,84 @@
+#ifndef SHADERPROGRAMCACHE_H_
+#define SHADERPROGRAMCACHE_H_
+
+#include <ngl/Types.h>
+#include <cstdint>
+#include <string>
+
+/// @class ShaderProgramCache
+/// @brief Builds GL programs from a vertex and a fragment source file and keeps their linked binaries on disk.
+///
+/// A program's binary is saved under a key hashed from both sources and the GL vendor, renderer and
+/// version strings, so the next run on the same driver loads it with glProgramBinary instead of compiling.
+/// Editing a shader or updating the driver changes the key and that program is compiled again.
+/// Building is split into begin() and finish() so several programs can be in flight at once; with
+/// GL_KHR_parallel_shader_compile the driver compiles them on its own threads and isReady() polls
+/// GL_COMPLETION_STATUS_KHR, without it finish() simply waits for the driver. Code shared between
+/// fragment shaders lives in its own file, spliced in after the fragment shader's #version line.
+class ShaderProgramCache
+{
+public:
+    /// A program on its way from source or cache to being usable.
+    struct Build
+    {
+        GLuint program = 0;    ///< The program, 0 if the sources couldn't be read or once finished.
+        GLuint vertex = 0;     ///< Vertex shader while compiling, 0 when loaded from the cache.
+        GLuint fragment = 0;   ///< Fragment shader while compiling, 0 when loaded from the cache.
+        std::string cacheFile; ///< Where the linked binary is saved.
+        bool cached = false;   ///< Whether the program was loaded from the cache.
+    };
+
+    /// Constructor.
+    /// @param _directory Directory the binaries are kept in, created on the first save.
+    explicit ShaderProgramCache(std::string _directory = "shadercache");
+
+    /// Reads the driver strings and lets the driver compile on all its threads if it can.
+    /// Must be called with a current GL context before any build.
+    void initialize();
+
+    /// Starts building a program, from the cache if a binary for these sources and driver is there.
+    /// @param _vertexFile Vertex shader source file.
+    /// @param _fragmentFile Fragment shader source file.
+    /// @param _includeFile File spliced into the fragment shader after its #version line, none if empty.
+    /// @param _defines Lines placed before the included file, e.g. "#define NAME\n", to pick its variant.
+    /// @return The build to poll with isReady() and complete with finish().
+    Build begin(const std::string &_vertexFile, const std::string &_fragmentFile, const std::string &_includeFile = std::string(),
+                const std::string &_defines = std::string());
+
+    /// Checks whether a build can be finished without waiting for the driver.
+    /// @param _build The build.
+    /// @return True if finish() won't block.
+    bool isReady(const Build &_build) const;
+
+    /// Completes a build, saving the binary of a program that was compiled.
+    /// @param _build The build, empty afterwards.
+    /// @return The linked program, or 0 with the compile and link logs printed if it failed.
+    GLuint finish(Build &_build);
+
+    /// Checks whether the driver compiles in the background.
+    /// @return True if GL_KHR_parallel_shader_compile or its ARB twin is in use.
+    bool hasParallelCompile() const { return m_parallel; }
+
+    /// Gets the number of programs loaded from the cache.
+    /// @return Programs that skipped compiling.
+    int cacheHits() const { return m_hits; }
+
+    /// Gets the number of programs compiled from source.
+    /// @return Programs that missed the cache.
+    int compiles() const { return m_compiles; }
+
+private:
+    /// Saves a freshly linked program's binary, failures only cost the next run a compile.
+    /// @param _program The program.
+    /// @param _file Where to save it.
+    void save(GLuint _program, const std::string &_file) const;
+
+    std::string m_directory; ///< Directory the binaries are kept in.
+    std::string m_driver;    ///< GL vendor, renderer and version, part of every key.
+    bool m_binaries = false; ///< Whether the driver supports any program binary format.
+    bool m_parallel = false; ///< Whether the driver compiles in the background.
+    int m_hits = 0;          ///< Programs loaded from the cache.
+    int m_compiles = 0;      ///< Programs compiled from source.
+};
+
+#endif // SHADERPROGRAMCACHE_H_
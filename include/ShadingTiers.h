@@ -0,0 +1,189 @@
+#ifndef SHADINGTIERS_H_
+#define SHADINGTIERS_H_
+
+#include <ngl/Types.h>
+#include <ngl/Mat3.h>
+#include <ngl/Mat4.h>
+#include <ngl/Vec3.h>
+#include <QFileSystemWatcher>
+#include <array>
+#include <functional>
+#include "ShaderProgramCache.h"
+
+/// @enum ShadingTier
+/// @brief Fragment shading variants ordered from most to least expensive.
+enum class ShadingTier : int
+{
+    FullPBR = 0, ///< Cook-Torrance (GGX, Smith, Fresnel) with HDR tonemap and gamma.
+    Matcap  = 1, ///< BRDF baked into a normal-indexed lookup texture at startup.
+    Lambert = 2  ///< Wrapped Lambert diffuse, no tonemap or gamma.
+};
+
+/// @class ShadingTiers
+/// @brief Builds every shading variant at startup and picks which one the scene draws with.
+///
+/// In automatic mode the GPU time of each frame is measured with GL_TIME_ELAPSED queries
+/// and the tier is dropped once the smoothed frame time stays above the budget.
+/// Programs come from a ShaderProgramCache, and a tier whose sources change on disk is rebuilt
+/// in the background and swapped in once it links, the old program drawing until then. The
+/// floor's program is built, cached and reloaded the same way alongside the tiers.
+class ShadingTiers
+{
+public:
+    /// Number of shading tiers.
+    static constexpr int TierCount = 3;
+
+    /// Number of programs, every tier and then the floor.
+    static constexpr int ProgramCount = TierCount + 1;
+
+    /// Bit of updatePrograms() set when the floor's program was rebuilt.
+    static constexpr unsigned int FloorReloaded = 1u << TierCount;
+
+    /// Builds all shader variants and the floor's program, bakes the matcap lookup texture, creates the
+    /// timer queries and starts watching the shader files. Must be called with a current GL context.
+    /// @param _viewLightDir Direction towards the light in view space, used to bake the matcap.
+    /// @param _sourcesChanged Called when an edited shader file has left a rebuild waiting for updatePrograms().
+    void initialize(const ngl::Vec3 &_viewLightDir, std::function<void()> _sourcesChanged);
+
+    /// Gets the name of a tier's program.
+    /// @param _tier The tier to query.
+    /// @return The shader program name.
+    static const char *programName(ShadingTier _tier);
+
+    /// Gets the GL program of a tier.
+    /// @param _tier The tier to query.
+    /// @return The program, 0 if it failed to build.
+    GLuint program(ShadingTier _tier) const { return m_programs[static_cast<int>(_tier)]; }
+
+    /// Makes a tier's program current, the setUniform() calls that follow go to it.
+    /// @param _tier The tier.
+    void use(ShadingTier _tier);
+
+    /// Makes the active tier's program current.
+    void useActive() { use(m_tier); }
+
+    /// Makes the floor's program current, the setUniform() calls that follow go to it.
+    void useFloor();
+
+    /// Sets a uniform of the current program.
+    /// @param _name The uniform.
+    /// @param _value Its value.
+    void setUniform(const char *_name, int _value) const;
+    void setUniform(const char *_name, float _value) const;
+    void setUniform(const char *_name, float _x, float _y, float _z) const;
+    void setUniform(const char *_name, const ngl::Vec3 &_value) const;
+    void setUniform(const char *_name, const ngl::Mat3 &_value) const;
+    void setUniform(const char *_name, const ngl::Mat4 &_value) const;
+
+    /// Sets a vec3 array uniform of the current program.
+    /// @param _name The uniform.
+    /// @param _values The first element.
+    /// @param _count The number of elements.
+    void setUniform(const char *_name, const ngl::Vec3 *_values, int _count) const;
+
+    /// Sets a float array uniform of the current program.
+    /// @param _name The uniform.
+    /// @param _values The first element.
+    /// @param _count The number of elements.
+    void setUniform(const char *_name, const float *_values, int _count) const;
+
+    /// Sets an int array uniform of the current program.
+    /// @param _name The uniform.
+    /// @param _values The first element.
+    /// @param _count The number of elements.
+    void setUniform(const char *_name, const int *_values, int _count) const;
+
+    /// Starts rebuilding the programs whose files were edited and swaps in any rebuild that has finished.
+    /// Must be called with a current GL context, once a frame while isReloading().
+    /// @return A bit per tier, set if the tier has a new program whose uniforms need loading, and FloorReloaded.
+    unsigned int updatePrograms();
+
+    /// Checks whether rebuilds are waiting to start or finish.
+    /// @return True while updatePrograms() still has work to do.
+    bool isReloading() const;
+
+    /// Gets the program cache, for its statistics.
+    /// @return The cache.
+    const ShaderProgramCache &cache() const { return m_cache; }
+
+    /// Gets the program cache, to build the scene's other programs with.
+    /// @return The cache.
+    ShaderProgramCache &cache() { return m_cache; }
+
+    /// Gets the active tier.
+    /// @return The tier currently used for drawing.
+    ShadingTier tier() const { return m_tier; }
+
+    /// Selects a tier and leaves automatic mode.
+    /// @param _tier The tier to draw with.
+    void setTier(ShadingTier _tier);
+
+    /// Enables or disables automatic tier selection.
+    /// @param _enabled True to let frame time drive the tier.
+    void setAuto(bool _enabled);
+
+    /// Checks whether automatic tier selection is enabled.
+    /// @return True if the tier follows GPU frame time.
+    bool isAuto() const { return m_auto; }
+
+    /// Sets the GPU frame time budget used by automatic mode.
+    /// @param _ms Budget in milliseconds.
+    void setFrameBudget(float _ms) { m_budgetMs = _ms; }
+
+    /// Gets the smoothed GPU frame time.
+    /// @return Frame time in milliseconds, 0 until the first query has resolved.
+    float gpuFrameTime() const { return m_gpuMs; }
+
+    /// Binds the textures the active tier samples from.
+    void bindTextures() const;
+
+    /// Starts timing the GPU work of a frame.
+    void beginFrame();
+
+    /// Stops timing the frame and applies the automatic tier policy.
+    void endFrame();
+
+private:
+    /// Bakes diffuse, specular and Fresnel terms for a fixed light into an RGBA16F texture.
+    /// @param _viewLightDir Direction towards the light in view space.
+    void bakeMatcap(const ngl::Vec3 &_viewLightDir);
+
+    /// Reads back any finished timer query without stalling the pipeline.
+    void collectQueries();
+
+    /// Sets the uniforms a tier's program needs from ShadingTiers itself.
+    /// @param _tier The tier.
+    void loadTierDefaults(ShadingTier _tier);
+
+    /// Marks the programs built from a file for a rebuild.
+    /// @param _file The edited file.
+    void sourceChanged(const QString &_file);
+
+    /// Watches every shader file again, editors that save by renaming a new file over the old one
+    /// take it off the watch list.
+    /// @return The files that had dropped off and are back.
+    QStringList watchSources();
+
+    static constexpr int QueryCount = 3;        ///< Queries in flight, enough to never wait on the GPU.
+    static constexpr int MatcapSize = 64;       ///< Width and height of the matcap texture.
+    static constexpr int OverBudgetFrames = 30; ///< Consecutive slow frames before dropping a tier.
+
+    ShadingTier m_tier = ShadingTier::FullPBR; ///< Tier used for drawing.
+    bool m_auto = false;                       ///< Whether frame time drives the tier.
+    float m_budgetMs = 16.6f;                  ///< GPU frame time budget in milliseconds.
+    float m_gpuMs = 0.0f;                      ///< Exponential moving average of GPU frame time.
+    int m_overBudget = 0;                      ///< Consecutive frames over budget.
+    GLuint m_matcap = 0;                       ///< Matcap lookup texture.
+    std::array<GLuint, QueryCount> m_queries{}; ///< Ring of GL_TIME_ELAPSED queries.
+    std::array<bool, QueryCount> m_pending{};  ///< Whether each query is waiting for a result.
+    int m_query = 0;                           ///< Query slot used by the current frame.
+    ShaderProgramCache m_cache;                ///< Builds programs, from disk where it can.
+    std::array<GLuint, ProgramCount> m_programs{};     ///< Program of each tier, then the floor's.
+    GLuint m_current = 0;                      ///< Program setUniform() writes to.
+    std::array<ShaderProgramCache::Build, ProgramCount> m_builds; ///< Rebuild of each program in flight, program 0 if none.
+    std::array<bool, ProgramCount> m_stale{};          ///< Programs whose sources changed and that wait for a rebuild.
+    QFileSystemWatcher m_watcher;              ///< Reports edits to the shader files and their directory.
+    std::function<void()> m_sourcesChanged;    ///< Asks for the frame that starts a rebuild.
+};
+
+#endif // SHADINGTIERS_H_
@@ -0,0 +1,94 @@
+#ifndef SHADOWMAPS_H_
+#define SHADOWMAPS_H_
+
+#include <ngl/Types.h>
+#include <ngl/Mat4.h>
+#include <ngl/Vec3.h>
+#include <cstdint>
+#include "InstancedCubes.h"
+#include "ShaderProgramCache.h"
+
+/// @class ShadowMaps
+/// @brief Depth maps of the cubes as seen from the light, one for the locked stacks and one for the falling pieces.
+///
+/// The light's frustum is fitted round the whole scene rather than the camera's view, so the maps hold
+/// model space depths that stay valid however the camera or the mouse moves the scene. The stacks only
+/// change when a piece locks, a line clears or garbage rises, so their map is rendered only when the key
+/// identifying them changes; the few cubes of the falling pieces go into a second, smaller map each time
+/// they move. The lighting shaders multiply the light that reaches a fragment by both maps.
+class ShadowMaps
+{
+public:
+    static constexpr int StackSize = 2048; ///< Width and height of the stack map.
+    static constexpr int PieceSize = 1024; ///< Width and height of the falling piece map.
+    static constexpr int StackUnit = 1;    ///< Texture unit the stack map is bound to, unit 0 is the matcap.
+    static constexpr int PieceUnit = 2;    ///< Texture unit the falling piece map is bound to.
+
+    /// Destructor, releases the GL objects.
+    ~ShadowMaps();
+
+    /// Builds the depth program and creates both maps, needs a current GL context.
+    /// @param _cache Builds the depth program.
+    void initialize(ShaderProgramCache &_cache);
+
+    /// Places the light and fits its frustum round a sphere holding everything that casts or receives shadows.
+    /// @param _light Position of the light.
+    /// @param _centre Centre of the scene.
+    /// @param _radius Radius of the scene.
+    void setLight(const ngl::Vec3 &_light, const ngl::Vec3 &_centre, float _radius);
+
+    /// Loads the offset of every board into the depth program.
+    /// @param _offsets The offsets, indexed by Cube::m_board.
+    /// @param _count The number of offsets.
+    void setBoardOffsets(const ngl::Vec3 *_offsets, int _count);
+
+    /// Gets the matrix from model space to the light's clip space.
+    /// @return The light's projection times its view.
+    const ngl::Mat4 &lightMatrix() const { return m_lightMatrix; }
+
+    /// Renders the stack map, unless it already holds the stacks with this key.
+    /// @param _cubes The locked cubes of every board.
+    /// @param _key Identifies the stacks, equal keys mean equal occupancy.
+    /// @return True if the map was rendered.
+    bool renderStack(const InstancedCubes &_cubes, std::uint64_t _key);
+
+    /// Renders the falling piece map.
+    /// @param _cubes The cubes of every board's falling piece.
+    void renderPieces(const InstancedCubes &_cubes);
+
+    /// Binds both maps to StackUnit and PieceUnit.
+    void bindTextures() const;
+
+    /// Gets the number of times the stack map has been rendered.
+    /// @return The stack renders since initialize().
+    int stackRenders() const { return m_stackRenders; }
+
+private:
+    /// A depth texture and the framebuffer that renders into it.
+    struct Map
+    {
+        GLuint framebuffer = 0; ///< Framebuffer with the texture as its depth attachment.
+        GLuint texture = 0;     ///< Depth texture, sampled with comparison for filtered shadow edges.
+        int size = 0;           ///< Width and height in texels.
+    };
+
+    /// Creates a map and clears it to the far plane.
+    /// @param _map Receives the GL objects.
+    /// @param _size Width and height in texels.
+    static void createMap(Map &_map, int _size);
+
+    /// Renders cubes into a map, putting the framebuffer and viewport back afterwards.
+    /// @param _map The map.
+    /// @param _cubes The cubes.
+    void render(const Map &_map, const InstancedCubes &_cubes) const;
+
+    GLuint m_program = 0;           ///< Depth only program, same instance layout as the lighting shaders.
+    ngl::Mat4 m_lightMatrix;        ///< Model space to the light's clip space.
+    Map m_stack;                    ///< Depths of the locked stacks.
+    Map m_pieces;                   ///< Depths of the falling pieces.
+    std::uint64_t m_stackKey = 0;   ///< Key of the stacks in m_stack.
+    bool m_stackValid = false;      ///< Whether m_stack holds the stacks of m_stackKey.
+    int m_stackRenders = 0;         ///< Times m_stack was rendered.
+};
+
+#endif // SHADOWMAPS_H_
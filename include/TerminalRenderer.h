@@ -0,0 +1,161 @@
+#ifndef TERMINALRENDERER_H
+#define TERMINALRENDERER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Tetromino.h"
+
+/// @class TerminalRenderer
+/// @brief Draws boards and text on an ANSI terminal, sending only the cells that changed.
+///
+/// The screen is a grid of character cells, each a glyph and a colour. Drawing goes into a back
+/// grid; Present() compares it with the grid the terminal was last sent and appends, for each
+/// cell that differs, a cursor move if the cursor isn't already there, a colour change if the
+/// colour differs from the last one sent, and the glyph. A piece falling one row costs a few
+/// dozen bytes rather than a whole screen, which keeps a frame well inside an SSH packet.
+/// The grids and the output string are sized once, so drawing a frame allocates nothing.
+/// Boards are drawn two characters a column, so the cells come out roughly square.
+class TerminalRenderer
+{
+public:
+    /// Colour of a cell, palette index p is drawn as Colour(p + 1).
+    enum Colour : std::uint8_t
+    {
+        DefaultColour = 0,                 ///< The terminal's own colours, for text and empty cells.
+        WallColour = PaletteSize + 1,      ///< The well's walls and floor.
+        ColourCount = PaletteSize + 2      ///< Number of colours.
+    };
+
+    /// Characters each board column is drawn with.
+    static constexpr int CellWidth = 2;
+
+    /// Constructor, the first Present() redraws the whole screen.
+    /// @param columns Width of the screen in characters.
+    /// @param rows Height of the screen in characters.
+    TerminalRenderer(int columns, int rows);
+
+    /// Blanks the back grid, call before drawing each frame.
+    void Clear();
+
+    /// Draws text in the default colour, clipped to the screen.
+    /// @param column Character column of the first glyph, 0 at the left.
+    /// @param row Character row, 0 at the top.
+    /// @param text The text, one glyph per byte.
+    void DrawText(int column, int row, const std::string& text);
+
+    /// Draws a board in its well, the active piece included since the board holds it.
+    /// @param board The board, any BasicBoard.
+    /// @param column Character column of the left wall.
+    /// @param row Character row of the board's top row.
+    template <typename BoardType>
+    void DrawBoard(const BoardType& board, int column, int row)
+    {
+        int width = board.getWidth();
+        int height = board.getHeight();
+        for (int y = 0; y < height; ++y)
+        {
+            // board rows count up from the floor, screen rows down from the top
+            int line = row + height - 1 - y;
+            auto bits = board.getRow(y);
+            Put(column, line, '<', WallColour);
+            Put(column + 1, line, '!', WallColour);
+            for (int x = 0; x < width; ++x)
+            {
+                int left = column + 2 + x * CellWidth;
+                if (bits >> x & 1)
+                {
+                    auto colour = static_cast<std::uint8_t>(board.getPaletteIndex(y, x) + 1);
+                    Put(left, line, ' ', colour);
+                    Put(left + 1, line, ' ', colour);
+                }
+                else
+                {
+                    Put(left, line, ' ', DefaultColour);
+                    Put(left + 1, line, '.', DefaultColour);
+                }
+            }
+            Put(column + 2 + width * CellWidth, line, '!', WallColour);
+            Put(column + 3 + width * CellWidth, line, '>', WallColour);
+        }
+        Put(column, row + height, '<', WallColour);
+        Put(column + 1, row + height, '!', WallColour);
+        for (int x = 2; x < width * CellWidth + 2; ++x)
+        {
+            Put(column + x, row + height, '=', WallColour);
+        }
+        Put(column + 2 + width * CellWidth, row + height, '!', WallColour);
+        Put(column + 3 + width * CellWidth, row + height, '>', WallColour);
+    }
+
+    /// Gets the characters a board takes across, walls included.
+    /// @param width The board's columns.
+    /// @return The characters.
+    static int BoardColumns(int width) { return width * CellWidth + 4; }
+
+    /// Appends the escapes turning the front grid into the back grid and makes the back grid the front.
+    /// @return The bytes to send, valid until the next Present(); empty if nothing changed.
+    const std::string& Present();
+
+    /// Forgets what the terminal shows, the next Present() clears it and redraws every cell.
+    void Invalidate();
+
+    /// Writes bytes to a descriptor, retrying short and interrupted writes.
+    /// @param descriptor The terminal, usually 1.
+    /// @param bytes The bytes.
+    /// @return False if the write failed.
+    static bool Write(int descriptor, const std::string& bytes);
+
+    /// Gets the escapes that switch to the alternate screen and hide the cursor.
+    /// @return The bytes.
+    static const char* EnterSequence();
+
+    /// Gets the escapes that reset the colour, show the cursor and leave the alternate screen.
+    /// @return The bytes.
+    static const char* LeaveSequence();
+
+    /// Gets the width of the screen.
+    /// @return The width in characters.
+    int getColumns() const { return _columns; }
+
+    /// Gets the height of the screen.
+    /// @return The height in characters.
+    int getRows() const { return _rows; }
+
+private:
+    /// A character cell.
+    struct Cell
+    {
+        char glyph = ' ';                   ///< The character.
+        std::uint8_t colour = DefaultColour; ///< The Colour.
+
+        bool operator==(const Cell& other) const { return glyph == other.glyph && colour == other.colour; }
+    };
+
+    /// Sets a back grid cell, ignoring ones off the screen.
+    /// @param column The character column.
+    /// @param row The character row.
+    /// @param glyph The character.
+    /// @param colour The Colour.
+    void Put(int column, int row, char glyph, std::uint8_t colour)
+    {
+        if (column >= 0 && column < _columns && row >= 0 && row < _rows)
+        {
+            _back[static_cast<std::size_t>(row * _columns + column)] = {glyph, colour};
+        }
+    }
+
+    /// Appends a number in decimal to the output.
+    /// @param value The number, not negative.
+    void AppendNumber(int value);
+
+    int _columns;               ///< Screen width in characters.
+    int _rows;                  ///< Screen height in characters.
+    std::vector<Cell> _front;   ///< What the terminal shows.
+    std::vector<Cell> _back;    ///< The frame being drawn.
+    std::string _output;        ///< Escapes of the last Present(), its capacity kept between frames.
+    int _colour = -1;           ///< Colour the terminal draws with, -1 if unknown.
+    bool _clear = true;         ///< Whether the next Present() clears the screen first.
+};
+
+#endif // TERMINALRENDERER_H
@@ -0,0 +1,116 @@
+#ifndef TETRISVECENV_H
+#define TETRISVECENV_H
+
+#include <stdint.h>
+
+/* Observation layout of one environment, in bytes. Every environment's observation is
+   TETRIS_ENV_OBSERVATION_SIZE bytes and they are packed back to back in the caller's buffer. */
+enum
+{
+    TETRIS_ENV_ROWS = 20,
+    TETRIS_ENV_COLS = 10,
+    TETRIS_ENV_PREVIEW = 5,
+    /* ROWS x COLS cells, row 0 at the bottom: 0 empty, 1 locked block, 2 active piece */
+    TETRIS_ENV_BOARD_OFFSET = 0,
+    /* active piece type (1..7), rotation (0..3), then x and y of its 4x4 box as signed bytes */
+    TETRIS_ENV_PIECE_OFFSET = TETRIS_ENV_ROWS * TETRIS_ENV_COLS,
+    /* next PREVIEW piece types */
+    TETRIS_ENV_PREVIEW_OFFSET = TETRIS_ENV_PIECE_OFFSET + 4,
+    /* level, combo + 1 and back-to-back flag */
+    TETRIS_ENV_STATUS_OFFSET = TETRIS_ENV_PREVIEW_OFFSET + TETRIS_ENV_PREVIEW,
+    TETRIS_ENV_OBSERVATION_SIZE = TETRIS_ENV_STATUS_OFFSET + 3
+};
+
+/* Action bits, one byte per environment per step. Buttons act when pressed, so holding one
+   over consecutive steps moves once; release it for a step to move again. */
+enum
+{
+    TETRIS_ENV_LEFT = 1,
+    TETRIS_ENV_RIGHT = 2,
+    TETRIS_ENV_DOWN = 4,
+    TETRIS_ENV_ROTATE = 8
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct TetrisVecEnv TetrisVecEnv;
+
+/* Creates count environments stepped by threads threads, NULL on bad arguments. */
+TetrisVecEnv* tetris_vec_env_create(int count, int threads);
+
+/* Destroys environments made by tetris_vec_env_create. */
+void tetris_vec_env_destroy(TetrisVecEnv* env);
+
+/* Starts a new episode in every environment from seeds[count] and writes the first observations. */
+void tetris_vec_env_reset(TetrisVecEnv* env, const uint32_t* seeds, uint8_t* observations);
+
+/* Advances every environment one frame with actions[count]. Writes observations, the score gained
+   to rewards[count] and 1 to dones[count] where the game ended; those environments start a new
+   episode straight away and their observation is its first. */
+void tetris_vec_env_step(TetrisVecEnv* env, const uint8_t* actions, uint8_t* observations,
+                         float* rewards, uint8_t* dones);
+
+#ifdef __cplusplus
+}
+
+#include <memory>
+#include <vector>
+#include "Game.h"
+#include "WorkerPool.h"
+
+/// @class TetrisVecEnv
+/// @brief N independent games stepped together for reinforcement learning, behind the C API above.
+///
+/// One step is one 60Hz frame of every game. Observations, rewards and done flags are written
+/// straight into caller-owned buffers, and games and threads are created once up front, so a
+/// step allocates nothing. Games are split into one contiguous slice per thread so each thread
+/// writes its own part of the buffers.
+struct TetrisVecEnv
+{
+    /// Constructor.
+    /// @param count The number of environments.
+    /// @param threads Threads stepping them, including the caller's.
+    TetrisVecEnv(int count, int threads);
+
+    /// Starts a new episode in every environment, see tetris_vec_env_reset.
+    /// @param seeds One piece sequence seed per environment.
+    /// @param observations Receives getCount() observations.
+    void Reset(const std::uint32_t* seeds, std::uint8_t* observations);
+
+    /// Advances every environment one frame, see tetris_vec_env_step.
+    /// @param actions One InputFrame per environment.
+    /// @param observations Receives getCount() observations.
+    /// @param rewards Receives the score gained by each environment.
+    /// @param dones Receives 1 where the episode ended, 0 elsewhere.
+    void Step(const InputFrame* actions, std::uint8_t* observations, float* rewards, std::uint8_t* dones);
+
+    /// Gets the number of environments.
+    /// @return The environment count.
+    int getCount() const { return static_cast<int>(_games.size()); }
+
+    /// Gets one environment's game.
+    /// @param index The environment.
+    /// @return The game.
+    const Game& getGame(int index) const { return _games[index]; }
+
+private:
+    /// Starts a new episode in one environment.
+    /// @param index The environment.
+    /// @param seed The piece sequence seed.
+    void ResetGame(int index, std::uint32_t seed);
+
+    /// Writes one environment's observation.
+    /// @param index The environment.
+    /// @param out Receives TETRIS_ENV_OBSERVATION_SIZE bytes.
+    void WriteObservation(int index, std::uint8_t* out) const;
+
+    std::vector<Game> _games;             ///< One game per environment.
+    std::vector<std::uint32_t> _seeds;    ///< Seed of each environment's current episode.
+    std::unique_ptr<WorkerPool> _pool;    ///< Threads stepping the games.
+};
+
+#endif // __cplusplus
+
+#endif // TETRISVECENV_H
@@ -1,14 +1,23 @@
 #ifndef TETROMINO_H
 #define TETROMINO_H
 
-#include <array>
-#include "ngl/Vec4.h"
+#include "PieceSet.h"
+
+/// Colours a board cell can have. Cells store a 3-bit index that the shader looks up in a palette,
+/// see Palette.h: GarbagePalette for garbage and 1..7 for the seven tetromino types.
+constexpr int PaletteSize = 8;
+
+/// Palette index of garbage rows.
+constexpr int GarbagePalette = 0;
 
 /// @class Tetromino
 /// @brief Manages the properties and behavior of Tetromino blocks in a Tetris game.
 ///
 /// Provides functionality for managing different types of Tetromino blocks,
-/// including their rotation, position, and color. Blocks are defined within a 4x4 grid.
+/// including their rotation, position, and palette index. The piece only holds its type and
+/// rotation index; the board looks the shape up in its own piece set (StandardTetrominoes,
+/// Pentominoes or CustomPieces), so nothing here assumes four blocks or four rotations, and
+/// colours repeat every seven types.
 class Tetromino
 {
 public:
@@ -21,209 +30,39 @@ public:
     /// @param y The y-coordinate on the game board.
     Tetromino(int type, int x, int y);
 
-    /// Get the block type at the specified position within the tetromino shape.
-    /// @param row The row to query.
-    /// @param col The column to query.
-    /// @return The block type at the given position.
-    int getBlock(int row, int col) const;
-
-    /// Get the color of this Tetromino.
-    /// @return The color as an ngl::Vec4.
-    ngl::Vec4 getColour() const;
+    /// Get the palette index this Tetromino is drawn with.
+    /// @return The index, 1..PaletteSize-1.
+    int getPaletteIndex() const { return (_type - 1) % (PaletteSize - 1) + 1; }
 
     /// Get the x-coordinate of the Tetromino on the board.
     /// @return The x-coordinate.
-    int GetX() const;
+    int GetX() const { return _x; }
 
     /// Get the y-coordinate of the Tetromino on the board.
     /// @return The y-coordinate.
-    int GetY() const;
+    int GetY() const { return _y; }
 
     /// Set the position of the Tetromino.
     /// @param x The new x-coordinate on the board.
     /// @param y The new y-coordinate on the board.
-    void SetPosition(int x, int y);
+    void SetPosition(int x, int y) { _x = x; _y = y; }
+
+    /// Get the type of this Tetromino.
+    /// @return The type, 1..Count of the board's piece set.
+    int getType() const { return _type; }
 
-    /// Rotate the Tetromino to the next orientation.
-    void Rotate();
+    /// Get the current orientation.
+    /// @return The rotation index, 0..Rotations-1 of the board's piece set.
+    int getRotation() const { return _currentRotationState; }
 
-    /// Check if a specific block position is within the shape of the Tetromino.
-    /// @param i The row index to check.
-    /// @param j The column index to check.
-    /// @return True if the position is within the Tetromino's shape, false otherwise.
-    bool IsWithinShape(int i, int j) const;
+    /// Set the orientation directly.
+    /// @param rotation The rotation index.
+    void SetRotation(int rotation) { _currentRotationState = rotation; }
 
 private:
-    int _type;  ///< Stores the tetromino type (integer).
-    std::array<std::array<int, 4>, 4> _shape; ///< 4x4 "shape" array to represent the tetromino shape data.
-    int _x;  ///< X position on the board.
-    int _y;  ///< Y position on the board.
-    ngl::Vec4 _colour; ///< Colour of the Tetromino.
+    int _type = 1;  ///< Stores the tetromino type (integer).
+    int _x = 0;  ///< X position on the board.
+    int _y = 0;  ///< Y position on the board.
     int _currentRotationState = 0; ///< Index to track the current rotation state.
-
-    /// Initializes the shape of the Tetromino based on its type and current rotation.
-    void initializeShape();
-
-    /// Initializes the color of the Tetromino based on its type.
-    void initializeColor();
-
-    /// Stores each rotation shape for each type of tetromino
-    static constexpr int rotationStates[7][4][4][4] =// type, rotation, x, y
-            {
-            // I-Block //
-            //rot0
-            {{{0, 1, 0, 0},
-             {0, 1, 0, 0},
-             {0, 1, 0, 0},
-             {0, 1, 0, 0}},
-            //rot90
-            {{0, 0, 0, 0},
-            {1, 1, 1, 1},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}},
-            //rot180
-            {{0, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 1, 0, 0}},
-            //rot270
-            {{0, 0, 0, 0},
-            {1, 1, 1, 1},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}}},
-
-            // T-Block //
-            //rot0
-            {{{0, 0, 0, 0},
-             {1, 1, 1, 0},
-             {0, 1, 0, 0},
-             {0, 0, 0, 0}},
-            //rot90
-            {{0, 1, 0, 0},
-            {0, 1, 1, 0},
-            {0, 1, 0, 0},
-            {0, 0, 0, 0}},
-            //rot180
-            {{0, 1, 0, 0},
-            {1, 1, 1, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}},
-            //rot270
-            {{0, 1, 0, 0},
-            {1, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 0, 0, 0}}},
-
-            // O-Block //
-            {{
-              {1, 1, 0, 0},
-             {1, 1, 0, 0},
-             {0, 0, 0, 0},
-             {0, 0, 0, 0}},
-            {
-             {1, 1, 0, 0},
-            {1, 1, 0, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}},
-                    {
-             {1, 1, 0, 0},
-            {1, 1, 0, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}},
-                    {
-             {1, 1, 0, 0},
-            {1, 1, 0, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}}},
-
-            // Z-Block //
-            {        //rot0
-             {{0, 0, 0, 0},
-             {0, 1, 0, 0},
-             {1, 1, 0, 0},
-             {1, 0, 0, 0}},
-                    //rot90
-            {{0, 0, 0, 0},
-            {1, 1, 0, 0},
-            {0, 1, 1, 0},
-            {0, 0, 0, 0}},
-                    //rot180
-            {{0, 0, 0, 0},
-            {0, 0, 1, 0},
-            {0, 1, 1, 0},
-            {0, 1, 0, 0}},
-            //rot270
-            {{0, 0, 0, 0},
-            {0, 0, 0, 0},
-            {1, 1, 0, 0},
-            {0, 1, 1, 0}}},
-
-            // S-Block //
-            {//rot0
-             {{1, 0, 0, 0},
-             {1, 1, 0, 0},
-             {0, 1, 0, 0},
-             {0, 0, 0, 0}},
-            //rot90
-            {{0, 1, 1, 0},
-            {1, 1, 0, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}},
-            //rot180
-            {{0, 1, 0, 0},
-            {0, 1, 1, 0},
-            {0, 0, 1, 0},
-            {0, 0, 0, 0}},
-            //rot270
-            {{0, 0, 0, 0},
-            {0, 1, 1, 0},
-            {1, 1, 0, 0},
-            {0, 0, 0, 0}}},
-
-            // L-Block //
-            {//rot0
-             {{0, 1, 0, 0},
-             {0, 1, 0, 0},
-             {1, 1, 0, 0},
-             {0, 0, 0, 0}},
-            //rot90
-            {{0, 0, 0, 0},
-            {1, 1, 1, 0},
-            {0, 0, 1, 0},
-            {0, 0, 0, 0}},
-
-            //rot180
-            {{0, 1, 1, 0},
-            {0, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 0, 0, 0}},
-            //rot270
-            {{1, 0, 0, 0},
-            {1, 1, 1, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}}},
-
-            // J-Block //
-            { //rot0
-            {{1, 0, 0, 0},
-            {1, 0, 0, 0},
-            {1, 1, 0, 0},
-            {0, 0, 0, 0}},
-            //rot90
-            {{0, 0, 0, 0},
-            {0, 0, 1, 0},
-            {1, 1, 1, 0},
-            {0, 0, 0, 0}},
-            //rot180
-            {{1, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 0, 0, 0}},
-            //rot270
-            {{0, 0, 0, 0},
-            {1, 1, 1, 0},
-            {1, 0, 0, 0},
-            {0, 0, 0, 0}}},
-    };
 };
 #endif
@@ -0,0 +1,127 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/// @struct TranspositionEntry
+/// @brief What a search remembers about one position.
+struct TranspositionEntry
+{
+    std::int32_t score = 0;   ///< Value of the position.
+    std::uint8_t depth = 0;   ///< Plies searched below it, deeper results are kept in preference.
+    std::uint16_t move = 0;   ///< Best move found, encoded by the search.
+};
+
+/// @struct TranspositionStats
+/// @brief Table traffic counted by one search thread, summed with += across threads.
+struct TranspositionStats
+{
+    long long probes = 0;      ///< Lookups.
+    long long hits = 0;        ///< Lookups that found their position.
+    long long stores = 0;      ///< Results written.
+    long long replaced = 0;    ///< Writes that evicted a different position.
+    long long evaluations = 0; ///< Leaf positions evaluated by the search.
+
+    /// Gets the fraction of lookups that found their position.
+    /// @return The hit rate, 0..1.
+    double getHitRate() const { return probes ? static_cast<double>(hits) / static_cast<double>(probes) : 0.0; }
+
+    /// Adds another thread's counts.
+    /// @param other The counts to add.
+    /// @return This.
+    TranspositionStats& operator+=(const TranspositionStats& other)
+    {
+        probes += other.probes;
+        hits += other.hits;
+        stores += other.stores;
+        replaced += other.replaced;
+        evaluations += other.evaluations;
+        return *this;
+    }
+};
+
+/// @class TranspositionTable
+/// @brief Fixed-size hash table of search results shared by every search thread without locks.
+///
+/// Positions are keyed by 64-bit Zobrist hashes, see BasicBoard::getHash(). The table is an array of
+/// cache-line sized buckets of BucketSize slots; a key maps to one bucket and may sit in any slot of it.
+/// Each slot is two relaxed atomic words, the packed entry and the key XORed with it, so a slot torn
+/// by two threads writing at once fails the key check on the next probe and reads as a miss instead of
+/// returning another position's result. When a bucket is full the entry with the least search depth
+/// left in it is replaced, counting entries from earlier searches as shallower the older they are.
+class TranspositionTable
+{
+public:
+    /// Slots per bucket, one 64-byte cache line.
+    static constexpr int BucketSize = 4;
+
+    /// Constructor, the table starts empty.
+    /// @param megabytes Memory to use, rounded down to a power of two buckets.
+    explicit TranspositionTable(std::size_t megabytes);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    /// Looks up a position. Safe to call from any thread while others probe and store.
+    /// @param key The position's hash.
+    /// @param entry Receives the stored result on a hit.
+    /// @param stats Counts the probe, owned by the calling thread.
+    /// @return True if the position was found.
+    bool Probe(std::uint64_t key, TranspositionEntry& entry, TranspositionStats& stats) const;
+
+    /// Stores a result, replacing the position's previous entry or the least valuable one in its bucket.
+    /// Safe to call from any thread while others probe and store.
+    /// @param key The position's hash.
+    /// @param entry The result.
+    /// @param stats Counts the store, owned by the calling thread.
+    void Store(std::uint64_t key, const TranspositionEntry& entry, TranspositionStats& stats);
+
+    /// Marks the start of a new search so entries from earlier ones are replaced first.
+    /// Call between searches, not during one.
+    void NewSearch() { _generation = static_cast<std::uint8_t>(_generation + 1); }
+
+    /// Empties the table. Call between searches, not during one.
+    void Clear();
+
+    /// Gets the number of slots.
+    /// @return The capacity in entries.
+    std::size_t getCapacity() const { return (_mask + 1) * BucketSize; }
+
+private:
+    /// One entry, the packed data and the key XORed with it.
+    struct Slot
+    {
+        std::atomic<std::uint64_t> check{0}; ///< key ^ data.
+        std::atomic<std::uint64_t> data{0};  ///< Packed TranspositionEntry and generation, 0 when empty.
+    };
+
+    /// The slots a key can live in.
+    struct alignas(64) Bucket
+    {
+        Slot slots[BucketSize]; ///< Slots in no particular order.
+    };
+
+    /// Packs an entry with the current generation, never 0.
+    /// @param entry The entry.
+    /// @return The packed word.
+    std::uint64_t Pack(const TranspositionEntry& entry) const;
+
+    /// Unpacks a slot's data word.
+    /// @param data The packed word.
+    /// @return The entry.
+    static TranspositionEntry Unpack(std::uint64_t data);
+
+    /// Gets the bucket a key lives in.
+    /// @param key The position's hash.
+    /// @return The bucket.
+    Bucket& BucketFor(std::uint64_t key) const { return _buckets[(key >> 32 ^ key) & _mask]; }
+
+    std::unique_ptr<Bucket[]> _buckets; ///< The table.
+    std::size_t _mask = 0;              ///< Bucket count minus one.
+    std::uint8_t _generation = 1;       ///< Current search, wraps around.
+};
+
+#endif // TRANSPOSITIONTABLE_H
@@ -0,0 +1,106 @@
+#ifndef UDPLINK_H
+#define UDPLINK_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+
+/// @class UdpLink
+/// @brief Non-blocking UDP socket to a single peer, with optional latency, jitter and loss injection.
+///
+/// Impairments are applied on send so two processes on 127.0.0.1 can be tested under bad
+/// network conditions: dropped datagrams are discarded, delayed ones are held until Flush()
+/// finds them due.
+class UdpLink
+{
+public:
+    /// Default constructor.
+    UdpLink() = default;
+
+    /// Destructor, closes the socket.
+    ~UdpLink();
+
+    UdpLink(const UdpLink&) = delete;
+    UdpLink& operator=(const UdpLink&) = delete;
+
+    /// Opens a non-blocking socket bound to a local port.
+    /// @param port The local port, 0 to let the OS choose.
+    /// @return True if the socket was opened and bound.
+    bool Open(int port);
+
+    /// Sets the address datagrams are sent to.
+    /// @param host Dotted IPv4 address of the peer.
+    /// @param port Port of the peer.
+    /// @return True if the address was valid.
+    bool SetPeer(const std::string& host, int port);
+
+    /// Sets the address datagrams are sent to.
+    /// @param address The peer address, e.g. as returned by Receive().
+    void SetPeer(const sockaddr_in& address);
+
+    /// Checks whether a peer address has been set.
+    /// @return True once SetPeer has been called.
+    bool hasPeer() const { return _hasPeer; }
+
+    /// Checks whether a datagram came from the peer.
+    /// @param address The sender's address, as returned by Receive().
+    /// @return True if a peer is set and the address and port are the peer's.
+    bool isPeer(const sockaddr_in& address) const;
+
+    /// Configures the impairments applied to outgoing datagrams.
+    /// @param latencyMs Fixed one-way delay in milliseconds.
+    /// @param jitterMs Extra random delay of up to this many milliseconds.
+    /// @param loss Probability from 0 to 1 of dropping a datagram.
+    /// @param seed Seed for the loss and jitter rolls.
+    void SetImpairment(int latencyMs, int jitterMs, double loss, unsigned int seed);
+
+    /// Sends a datagram to the peer, subject to the configured impairments.
+    /// @param data The bytes to send.
+    /// @param size The number of bytes.
+    void Send(const std::uint8_t* data, std::size_t size);
+
+    /// Sends any delayed datagrams that are now due.
+    void Flush();
+
+    /// Receives one datagram if there is one waiting.
+    /// @param buffer Receives the datagram.
+    /// @param capacity The size of buffer.
+    /// @param from Receives the sender's address, may be null.
+    /// @return The datagram size, or -1 if nothing was waiting.
+    int Receive(std::uint8_t* buffer, std::size_t capacity, sockaddr_in* from = nullptr);
+
+    /// Gets the number of datagrams dropped by loss injection.
+    /// @return The dropped count.
+    int getDropped() const { return _dropped; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// A datagram held back to simulate latency.
+    struct Delayed
+    {
+        Clock::time_point due;          ///< When to send it.
+        std::vector<std::uint8_t> data; ///< The datagram.
+    };
+
+    /// Sends a datagram straight to the socket.
+    /// @param data The bytes to send.
+    /// @param size The number of bytes.
+    void SendNow(const std::uint8_t* data, std::size_t size);
+
+    int _socket = -1;               ///< Socket descriptor.
+    sockaddr_in _peer{};            ///< Peer address.
+    bool _hasPeer = false;          ///< Whether _peer is set.
+    int _latencyMs = 0;             ///< Fixed one-way delay.
+    int _jitterMs = 0;              ///< Random extra delay.
+    double _loss = 0.0;             ///< Drop probability.
+    std::minstd_rand _random;       ///< Loss and jitter rolls.
+    std::deque<Delayed> _delayed;   ///< Datagrams waiting out their latency, in due order.
+    int _dropped = 0;               ///< Datagrams dropped by loss injection.
+};
+
+#endif // UDPLINK_H
@@ -0,0 +1,95 @@
+#ifndef VERSUSMATCH_H
+#define VERSUSMATCH_H
+
+#include <memory>
+#include <vector>
+#include "Game.h"
+#include "LockFreeQueue.h"
+#include "WorkerPool.h"
+
+/// @struct MatchState
+/// @brief Saved state of every game in a match, see VersusMatch::SaveState.
+struct MatchState
+{
+    std::vector<GameState> games; ///< One state per player.
+};
+
+/// @class VersusMatch
+/// @brief Runs 1 to MaxPlayers games in lockstep, sending garbage rows between them.
+///
+/// Every board is advanced one frame per Step(), optionally spread over a WorkerPool. Garbage
+/// travels through a lock-free queue per receiver and is only delivered once every board
+/// has finished the step, so the result never depends on the order boards were simulated in.
+class VersusMatch
+{
+public:
+    /// Largest number of boards in one match.
+    static constexpr int MaxPlayers = 8;
+
+    /// Default constructor.
+    VersusMatch() = default;
+
+    /// Constructor to start a match.
+    /// @param players The number of boards, clamped to 1..MaxPlayers.
+    /// @param board The empty board every player starts with.
+    /// @param seed Seed shared by every player so all boards see the same pieces.
+    /// @param threads Threads stepping the boards, started once for the whole match; 1 steps them on the caller.
+    VersusMatch(int players, const Board& board, unsigned int seed, int threads = 1);
+
+    /// Advances every board by one frame and exchanges garbage.
+    /// @param inputs The buttons held by each player this frame, getPlayerCount() entries.
+    /// @return True if any board changed.
+    bool Step(const InputFrame* inputs);
+
+    /// Saves every game, in-flight garbage is always delivered by the end of Step() so needs no saving.
+    /// @param state Receives the state, its storage is reused between calls.
+    void SaveState(MatchState& state) const;
+
+    /// Restores a state saved from a match with the same number of players.
+    /// @param state The state to restore.
+    void LoadState(const MatchState& state);
+
+    /// Hashes every game, used to check that two simulations agree.
+    /// @return A 32-bit hash.
+    std::uint32_t Checksum() const;
+
+    /// Gets the number of boards.
+    /// @return The player count.
+    int getPlayerCount() const { return static_cast<int>(_games.size()); }
+
+    /// Gets a player's game.
+    /// @param player The player index.
+    /// @return The game for that player.
+    Game& getGame(int player) { return _games[player]; }
+
+    /// Gets a player's game.
+    /// @param player The player index.
+    /// @return The game for that player.
+    const Game& getGame(int player) const { return _games[player]; }
+
+    /// Gets the number of garbage rows sent for a number of cleared rows.
+    /// @param lines The rows cleared by one lock.
+    /// @return The garbage rows sent to the opponent.
+    static int AttackLines(int lines);
+
+private:
+    /// A batch of garbage rows in flight.
+    struct GarbagePacket
+    {
+        int sender; ///< Player who cleared the rows.
+        int lines;  ///< Garbage rows sent.
+    };
+    using GarbageQueue = LockFreeQueue<GarbagePacket, 64>;
+
+    /// Steps one board and posts any garbage it sends.
+    /// @param player The player index.
+    /// @param input The buttons the player holds this frame.
+    void StepPlayer(int player, InputFrame input);
+
+    std::vector<Game> _games;                           ///< One game per player.
+    std::vector<std::unique_ptr<GarbageQueue>> _inbox;  ///< Incoming garbage per player.
+    std::vector<char> _changed;                         ///< Whether each board changed during the current step.
+    std::unique_ptr<WorkerPool> _pool;                  ///< Threads stepping the boards, null to step them on the caller.
+};
+
+#endif // VERSUSMATCH_H
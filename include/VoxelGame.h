@@ -0,0 +1,144 @@
+#ifndef VOXELGAME_H
+#define VOXELGAME_H
+
+#include <cstdint>
+#include <random>
+#include "Game.h"
+#include "VoxelWell.h"
+
+/// @enum VoxelButton
+/// @brief Bits of an InputFrame in the 3D well mode, which has twice the buttons of the flat game.
+enum VoxelButton : InputFrame
+{
+    VoxelLeft = 1 << 0,  ///< Move left.
+    VoxelRight = 1 << 1, ///< Move right.
+    VoxelFar = 1 << 2,   ///< Move into the well.
+    VoxelNear = 1 << 3,  ///< Move towards the viewer.
+    VoxelTurnX = 1 << 4, ///< Quarter turn about the across axis.
+    VoxelTurnY = 1 << 5, ///< Quarter turn about the into the well axis.
+    VoxelTurnZ = 1 << 6, ///< Quarter turn about the vertical axis.
+    VoxelDrop = 1 << 7   ///< Drop to the bottom and lock.
+};
+
+/// @class BasicVoxelGame
+/// @brief Runs one game in a 3D well: polycubes fall down the well and full layers clear.
+///
+/// Plays like BasicGame turned on its side: every button acts on the frame it goes down, gravity
+/// pulls the piece down at the level's rate from the same table, and a piece that can't fall any
+/// further locks on the next gravity step. A turn that would hit a wall or the stack is retried one
+/// cell to either side and one cell up before it gives up. The piece sequence is seeded, so equal
+/// seeds and inputs play out identically.
+/// @tparam WellType The well, a BasicVoxelWell.
+template <typename WellType>
+class BasicVoxelGame
+{
+public:
+    /// Layers cleared per level.
+    static constexpr int LayersPerLevel = 5;
+
+    /// Default constructor.
+    BasicVoxelGame() = default;
+
+    /// Constructor to start a game in an empty well.
+    /// @param seed Seed for the piece sequence.
+    /// @param startLevel Level to start on, 1..Game::MaxLevel.
+    explicit BasicVoxelGame(unsigned int seed, int startLevel = 1);
+
+    /// Advances the game by one frame.
+    /// @param input The VoxelButtons held during this frame.
+    /// @return True if the well or the piece changed.
+    bool Step(InputFrame input);
+
+    /// Moves the piece.
+    /// @param dx Cells across.
+    /// @param dy Cells into the well.
+    /// @param dz Layers up.
+    /// @return True if the move was blocked; otherwise, false.
+    bool Move(int dx, int dy, int dz);
+
+    /// Turns the piece a quarter about an axis, keeping its box centred where it can.
+    /// @param axis The VoxelAxis to turn about.
+    /// @return True if the turn was successful; otherwise, false.
+    bool Rotate(int axis);
+
+    /// Drops the piece as far as it goes and locks it, two points per layer fallen.
+    void Drop();
+
+    /// Advances one gravity step, locking the piece if it can't move down.
+    /// @return True if a piece locked during this step.
+    bool Tick();
+
+    /// Gets the well.
+    /// @return The locked cubes.
+    const WellType& getWell() const { return _well; }
+
+    /// Gets the falling piece.
+    /// @return The piece, type 0 once the game is over.
+    const VoxelPiece& getPiece() const { return _piece; }
+
+    /// Gets the piece that spawns next.
+    /// @return Its type.
+    int getNextType() const { return _next; }
+
+    /// Gets the palette index a piece type is drawn with.
+    /// @param type The piece.
+    /// @return The index, 1..PaletteSize-1.
+    static int PaletteIndex(int type) { return (type - 1) % (PaletteSize - 1) + 1; }
+
+    /// Gets the points scored.
+    /// @return The score.
+    int getScore() const { return _score; }
+
+    /// Gets the layers cleared in total.
+    /// @return The layer count.
+    int getLayers() const { return _layers; }
+
+    /// Gets the layers cleared by the most recent lock.
+    /// @return The layer count.
+    int getLayersCleared() const { return _layersCleared; }
+
+    /// Gets the current level.
+    /// @return The level.
+    int getLevel() const { return _level; }
+
+    /// Gets the pieces locked.
+    /// @return The piece count.
+    int getPieces() const { return _pieces; }
+
+    /// Checks whether a new piece overlapped the stack.
+    /// @return True once the game is over.
+    bool isGameOver() const { return _gameOver; }
+
+private:
+    /// Locks the piece, clears layers and spawns the next one.
+    void Lock();
+
+    /// Puts the next piece at the top of the well, centred.
+    void SpawnPiece();
+
+    /// Draws a piece type from the sequence.
+    /// @return The type, 1..Polycubes::Count.
+    std::uint8_t NextPieceType();
+
+    WellType _well;                   ///< Locked cubes.
+    VoxelPiece _piece;                ///< Falling piece.
+    std::uint8_t _next = 0;           ///< Piece that spawns next.
+    std::minstd_rand _random;         ///< Piece sequence.
+    int _gravityProgress = 0;         ///< Fraction of a layer gravity has pulled, 16.16 fixed point.
+    int _score = 0;                   ///< Points scored.
+    int _layers = 0;                  ///< Layers cleared in total.
+    int _layersCleared = 0;           ///< Layers cleared by the most recent lock.
+    int _level = 1;                   ///< Current level.
+    int _startLevel = 1;              ///< Level the game started on.
+    int _pieces = 0;                  ///< Pieces locked.
+    bool _gameOver = false;           ///< Whether a new piece had nowhere to go.
+    InputFrame _lastInput = 0;        ///< Buttons held on the previous frame, to find new presses.
+};
+
+/// Game in the classic 5x5 pit.
+using VoxelGame = BasicVoxelGame<VoxelWell>;
+
+extern template class BasicVoxelGame<VoxelWell>;
+extern template class BasicVoxelGame<WideVoxelWell>;
+
+#endif // VOXELGAME_H
@@ -0,0 +1,145 @@
+#ifndef VOXELWELL_H
+#define VOXELWELL_H
+
+#include <array>
+#include <cstdint>
+#include "Board.h"
+#include "Polycubes.h"
+
+/// @struct VoxelPiece
+/// @brief A piece in a 3D well: which polycube, which way round and where its box starts.
+struct VoxelPiece
+{
+    std::uint8_t type = 0;        ///< Piece, 1..Polycubes::Count, 0 for none.
+    std::uint8_t orientation = 0; ///< Index into the piece's orientations.
+    int x = 0;                    ///< Column of the box's left side.
+    int y = 0;                    ///< Row of the box's near side.
+    int z = 0;                    ///< Layer of the box's bottom.
+
+    /// Gets the orientation's shape.
+    /// @return The cubes and layer masks.
+    const Polycubes::Orientation& getShape() const { return Polycubes::getOrientation(type, orientation); }
+};
+
+/// @class BasicVoxelWell
+/// @brief The locked cubes of a 3D well, Width x Depth cells a layer and Height layers deep.
+///
+/// The 3D counterpart of BasicBoard: each layer is one 64-bit occupancy mask, bit x + Width * y,
+/// so testing a piece against the well is an AND per layer of the piece and a full layer is a
+/// single compare. A piece orientation's masks are widened from Polycubes' 4x4 layers to the
+/// well's layer width once per well size, then placed by a shift. Colours ride alongside as three
+/// bit planes per layer and a Zobrist hash of the occupancy is kept as layers change, as on the
+/// board. The falling piece is not drawn into the well. Instantiations are compiled in VoxelWell.cpp.
+/// @tparam Width Cells across, Width * Depth at most 64.
+/// @tparam Depth Cells into the well.
+/// @tparam Height Layers.
+template <int Width, int Depth, int Height>
+class BasicVoxelWell
+{
+    static_assert(Width >= Polycubes::Size && Depth >= Polycubes::Size && Width * Depth <= 64,
+                  "A layer must hold any piece and fit a 64-bit mask");
+
+public:
+    using LayerMask = std::uint64_t; ///< One layer of occupancy, bit x + Width * y.
+
+    static constexpr int FixedWidth = Width;   ///< Cells across.
+    static constexpr int FixedDepth = Depth;   ///< Cells into the well.
+    static constexpr int FixedHeight = Height; ///< Layers.
+
+    /// Mask with every cell of a layer set.
+    static constexpr LayerMask FullLayer = Width * Depth == 64 ? ~0ull : (1ull << (Width * Depth)) - 1;
+
+    /// Gets the cells across.
+    /// @return Width.
+    static constexpr int getWidth() { return Width; }
+
+    /// Gets the cells into the well.
+    /// @return Depth.
+    static constexpr int getDepth() { return Depth; }
+
+    /// Gets the layers.
+    /// @return Height.
+    static constexpr int getHeight() { return Height; }
+
+    /// Checks whether a piece would stick out of the well or overlap locked cubes.
+    /// @param piece The piece.
+    /// @return True if there is a collision.
+    bool Collides(const VoxelPiece& piece) const;
+
+    /// Adds a piece's cubes to the well and removes every layer it filled, dropping the layers above.
+    /// @param piece The piece, which must not collide.
+    /// @param palette Palette index of its cubes.
+    /// @return The layers cleared.
+    int Lock(const VoxelPiece& piece, int palette);
+
+    /// Gets one layer of a piece at its position in the well.
+    /// @param piece The piece.
+    /// @param layer The layer of the piece box, 0..Polycubes::Size-1.
+    /// @return The covered cells of well layer piece.z + layer.
+    static LayerMask PieceLayer(const VoxelPiece& piece, int layer);
+
+    /// Gets the occupancy of one layer.
+    /// @param z The layer.
+    /// @return The layer mask.
+    LayerMask getLayer(int z) const { return _layers[z]; }
+
+    /// Gets the palette index of a locked cube.
+    /// @param x Cells across.
+    /// @param y Cells in.
+    /// @param z The layer.
+    /// @return The index, only meaningful where getLayer() says the cell is occupied.
+    int getPaletteIndex(int x, int y, int z) const
+    {
+        int bit = x + Width * y;
+        return static_cast<int>((_palette[0][z] >> bit & 1) | (_palette[1][z] >> bit & 1) << 1 |
+                                (_palette[2][z] >> bit & 1) << 2);
+    }
+
+    /// Gets the Zobrist hash of the occupancy, the XOR of LayerKey() over every layer.
+    /// @return The 64-bit hash, 0 for an empty well.
+    std::uint64_t getHash() const { return _hash; }
+
+    /// Gets the Zobrist key of one layer's contents.
+    /// @param z The layer.
+    /// @param mask The layer's occupancy.
+    /// @return The key XORed into the well hash for this layer.
+    static std::uint64_t LayerKey(int z, LayerMask mask)
+    {
+        return mask ? ZobristMix(mask ^ 0xd1b54a32d192ed03ull * static_cast<std::uint64_t>(z + 1)) : 0;
+    }
+
+private:
+    static constexpr int PaletteBits = 3; ///< Bits of a palette index.
+
+    /// Every orientation's layer masks at the well's origin, indexed [type - 1][orientation][layer].
+    using MaskTable = std::array<std::array<std::array<LayerMask, Polycubes::Size>, Polycubes::MaxOrientations>,
+                                 Polycubes::Count>;
+
+    /// Gets the orientation masks for this well size, built on first use.
+    /// @return The table.
+    static const MaskTable& Masks();
+
+    /// Replaces one layer's occupancy and updates the hash.
+    /// @param z The layer.
+    /// @param mask The new occupancy.
+    void SetLayer(int z, LayerMask mask)
+    {
+        _hash ^= LayerKey(z, _layers[z]) ^ LayerKey(z, mask);
+        _layers[z] = mask;
+    }
+
+    std::array<LayerMask, Height> _layers{};                         ///< Occupancy of each layer, 0 at the bottom.
+    std::array<std::array<LayerMask, Height>, PaletteBits> _palette{}; ///< Bit i of each cell's palette index, per layer.
+    std::uint64_t _hash = 0;                                         ///< Zobrist hash of _layers.
+};
+
+/// Classic 5x5 pit.
+using VoxelWell = BasicVoxelWell<5, 5, 12>;
+
+/// The widest pit a 64-bit layer holds.
+using WideVoxelWell = BasicVoxelWell<8, 8, 16>;
+
+extern template class BasicVoxelWell<5, 5, 12>;
+extern template class BasicVoxelWell<8, 8, 16>;
+
+#endif // VOXELWELL_H
@@ -0,0 +1,115 @@
+#ifndef WEIGHTTUNER_H
+#define WEIGHTTUNER_H
+
+#include <array>
+#include <iosfwd>
+#include <memory>
+#include <random>
+#include <vector>
+#include "PlacementSearch.h"
+#include "WorkerPool.h"
+
+/// @struct TunerOptions
+/// @brief How a WeightTuner samples and scores weights. Everything but threads is saved in a checkpoint,
+/// since each changes the results.
+struct TunerOptions
+{
+    int population = 32;      ///< Weight sets tried per generation.
+    int elite = 8;            ///< Best weight sets the next generation's distribution is fitted to.
+    int games = 16;           ///< Games each weight set plays per generation, the same seeds for every set.
+    int pieces = 500;         ///< Pieces a game may last, so good weights don't play forever.
+    int depth = 1;            ///< Pieces the search looks at, see BasicPlacementSearch::FindBest.
+    unsigned int seed = 1;    ///< Seeds the sampling and the games.
+    double initialSigma = 200.0; ///< Starting spread of every weight.
+    double minSigma = 10.0;   ///< Spread never shrinks below this, so the search keeps exploring.
+    int threads = 1;          ///< Threads playing games, doesn't change the results.
+};
+
+/// @struct TunerGeneration
+/// @brief The outcome of one generation.
+struct TunerGeneration
+{
+    int generation = 0;                ///< Generations run before this one.
+    double bestFitness = 0.0;          ///< Lines per game of the best weight set.
+    double meanFitness = 0.0;          ///< Lines per game averaged over the population.
+    SearchWeights best;                ///< The best weight set.
+    SearchWeights mean;                ///< The mean of the distribution after fitting, the tuned weights.
+    std::array<double, 4> sigma{};     ///< The spread of each weight after fitting.
+};
+
+/// @class WeightTuner
+/// @brief Tunes the placement search's evaluation weights with the cross-entropy method.
+///
+/// Each generation samples a population of weight sets from an independent Gaussian per weight,
+/// plays every set through the same seeded games and refits the Gaussians to the elite sets by
+/// lines cleared. The games are run with the engine's rules but hard dropped through Tick()
+/// rather than stepped frame by frame, and spread over a WorkerPool one game at a time so
+/// short and long games balance out between threads. Sampling uses std::mt19937_64 and its own
+/// normal transform, and games are seeded from the generation and game index, so a run with the
+/// same options gives the same weights on any machine and thread count, and a run resumed from a
+/// checkpoint carries on exactly as if it had never stopped.
+class WeightTuner
+{
+public:
+    static constexpr int Dimensions = 4; ///< Weights tuned, the fields of SearchWeights in order.
+
+    /// Constructor, starts from the search's default weights.
+    /// @param options Sampling and scoring settings.
+    explicit WeightTuner(const TunerOptions& options);
+
+    /// Samples, plays and scores one population and refits the distribution.
+    /// @return What the generation found.
+    TunerGeneration RunGeneration();
+
+    /// Plays one game with a weight set.
+    /// @param weights The evaluation weights.
+    /// @param seed The piece sequence.
+    /// @param pieces Pieces the game may last.
+    /// @param depth Pieces the search looks at.
+    /// @return Lines cleared.
+    static int PlayGame(const SearchWeights& weights, unsigned int seed, int pieces, int depth);
+
+    /// Writes the distribution, the random state and the options that affect results.
+    /// @param out The stream to write to.
+    void SaveCheckpoint(std::ostream& out) const;
+
+    /// Reads a checkpoint written by SaveCheckpoint(), replacing everything but the thread count.
+    /// @param in The stream to read from.
+    /// @return False if the stream isn't a checkpoint, the tuner is unchanged then.
+    bool LoadCheckpoint(std::istream& in);
+
+    /// Gets the number of generations run, counting those before a resumed checkpoint.
+    /// @return The generation count.
+    int getGeneration() const { return _generation; }
+
+    /// Gets the mean of the distribution, the best estimate of the weights so far.
+    /// @return The weights rounded to integers.
+    SearchWeights getMean() const { return ToWeights(_mean); }
+
+    /// Gets the options, as loaded from a checkpoint if one was.
+    /// @return The options.
+    const TunerOptions& getOptions() const { return _options; }
+
+private:
+    using Vector = std::array<double, Dimensions>;
+
+    /// Rounds a sample to weights.
+    /// @param values The sample.
+    /// @return The weights.
+    static SearchWeights ToWeights(const Vector& values);
+
+    /// Draws a standard normal sample.
+    /// @return The sample.
+    double Normal();
+
+    TunerOptions _options;                ///< Sampling and scoring settings.
+    Vector _mean{};                       ///< Centre of each weight's Gaussian.
+    Vector _sigma{};                      ///< Spread of each weight's Gaussian.
+    std::mt19937_64 _random;              ///< Sampling sequence, saved in checkpoints.
+    int _generation = 0;                  ///< Generations run.
+    std::unique_ptr<WorkerPool> _pool;    ///< Threads playing games.
+    std::vector<Vector> _samples;         ///< This generation's weight sets.
+    std::vector<int> _lines;              ///< Lines cleared by each set in each game, set major.
+};
+
+#endif // WEIGHTTUNER_H
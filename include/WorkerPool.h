@@ -0,0 +1,70 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @class WorkerPool
+/// @brief Fixed set of threads that split a range of work items between them.
+///
+/// The threads live as long as the pool, so running a batch costs a wake-up rather than
+/// thread creation, and nothing is allocated per batch: the task is passed by reference
+/// and must outlive Run(), which it always does since Run() waits for every thread.
+class WorkerPool
+{
+public:
+    /// Constructor, starts the worker threads.
+    /// @param threads Total threads including the caller's, 1 runs everything on the caller.
+    explicit WorkerPool(int threads);
+
+    /// Destructor, stops and joins the worker threads.
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /// Splits [0, count) into one contiguous slice per thread and waits until all are done.
+    /// @param count The number of work items.
+    /// @param task Callable as task(begin, end) for each slice.
+    template <typename Task>
+    void Run(int count, Task& task)
+    {
+        Dispatch(count, [](void* context, int begin, int end) { (*static_cast<Task*>(context))(begin, end); }, &task);
+    }
+
+    /// Gets the number of threads work is split over.
+    /// @return The thread count including the caller.
+    int getThreadCount() const { return static_cast<int>(_workers.size()) + 1; }
+
+private:
+    using TaskFunction = void (*)(void*, int, int);
+
+    /// Publishes a batch to the workers, runs the caller's slice and waits for the rest.
+    /// @param count The number of work items.
+    /// @param function Calls the task.
+    /// @param context The task.
+    void Dispatch(int count, TaskFunction function, void* context);
+
+    /// Body of each worker thread.
+    /// @param index The worker's slice, 1 onwards; the caller takes slice 0.
+    void WorkerLoop(int index);
+
+    /// Runs one thread's slice of the current batch.
+    /// @param index The slice.
+    void RunSlice(int index);
+
+    std::vector<std::thread> _workers;  ///< Worker threads, one fewer than getThreadCount().
+    std::mutex _mutex;                  ///< Guards the batch fields below.
+    std::condition_variable _start;     ///< Signalled when a batch is published or the pool stops.
+    std::condition_variable _done;      ///< Signalled when the last worker finishes its slice.
+    TaskFunction _function = nullptr;   ///< Current batch's task caller.
+    void* _context = nullptr;           ///< Current batch's task.
+    int _count = 0;                     ///< Current batch's item count.
+    int _generation = 0;                ///< Incremented per batch so workers run each batch once.
+    int _running = 0;                   ///< Workers still busy with the current batch.
+    bool _stop = false;                 ///< Set to shut the workers down.
+};
+
+#endif // WORKERPOOL_H
@@ -0,0 +1,17 @@
+#version 410 core
+// Checkered floor lined up with the board cells, lit by the light and shadowed by the cubes
+layout (location = 0) out vec4 fragColour;
+
+in vec3 worldPos;
+// with shadowCoord for shadow(), spliced in from Shadow.glsl
+
+uniform vec3 lightPosition;
+uniform vec3 colour1;
+uniform vec3 colour2;
+
+void main()
+{
+    vec3 albedo = mod(floor(worldPos.x) + floor(worldPos.z), 2.0) == 0.0 ? colour1 : colour2;
+    float NdotL = max(normalize(lightPosition - worldPos).y, 0.0);
+    fragColour = vec4(albedo * (0.3 + 0.7 * NdotL * shadow()), 1.0);
+}
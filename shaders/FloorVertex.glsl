@@ -0,0 +1,19 @@
+#version 410 core
+
+uniform mat4 MVP;
+// Floor plane to the model space the boards and the light's matrix use
+uniform mat4 model;
+uniform mat4 lightMatrix;
+
+layout(location = 0) in vec3 inVert;
+
+out vec3 worldPos;
+out vec4 shadowCoord;
+
+void main()
+{
+    vec4 position = model * vec4(inVert, 1.0);
+    worldPos = position.xyz;
+    shadowCoord = lightMatrix * position;
+    gl_Position = MVP * vec4(inVert, 1.0);
+}
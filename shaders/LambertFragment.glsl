@@ -0,0 +1,30 @@
+#version 330 core
+// Cheapest shading tier: wrapped Lambert diffuse straight to LDR, no tonemap or gamma.
+layout (location = 0) out vec4 fragColour;
+
+in vec3 worldPos;
+in vec3 normal;
+in vec3 albedo;
+// with shadowCoord for shadow(), spliced in from Shadow.glsl
+
+// material parameters
+uniform float metallic;
+uniform float roughness;
+uniform float ao;
+
+uniform vec3 lightPosition;
+
+void main()
+{
+    vec3 N = normalize(normal);
+    vec3 L = normalize(lightPosition - worldPos);
+
+    // rougher surfaces let the light wrap further round the terminator
+    float wrap = roughness * 0.5;
+    float NdotL = max((dot(N, L) + wrap) / (1.0 + wrap), 0.0) * shadow();
+
+    // metals have no diffuse term in the PBR tiers, keep some of that darkening here
+    vec3 color = albedo * (mix(1.0, 0.5, metallic) * NdotL + 0.1 * ao);
+
+    fragColour = vec4(color, 1.0);
+}
@@ -0,0 +1,48 @@
+#version 330 core
+// Cheaper variant of PBRFragment.glsl: the Cook-Torrance terms for a fixed light are
+// baked by ShadingTiers into a texture indexed by the view space normal.
+layout (location = 0) out vec4 fragColour;
+
+in vec3 worldPos;
+in vec3 normal;
+in vec3 albedo;
+// with shadowCoord for shadow(), spliced in from Shadow.glsl
+
+// material parameters
+uniform float metallic;
+uniform float roughness;
+uniform float ao;
+
+// lights
+uniform vec3 lightPosition;
+uniform vec3 lightColor;
+
+uniform float exposure = 2.2;
+
+// r = NdotL / PI, g = specular at roughness 0.25, b = specular at roughness 0.75, a = Fresnel weight
+uniform sampler2D brdfLUT;
+
+void main()
+{
+    vec3 N = normalize(normal);
+    vec4 lut = texture(brdfLUT, N.xy * 0.5 + 0.5);
+
+    float distance = length(lightPosition - worldPos);
+    vec3 radiance = lightColor / (distance * distance);
+
+    vec3 F0 = mix(vec3(0.04), albedo, metallic);
+    vec3 F = F0 + (1.0 - F0) * lut.a;
+    vec3 kD = (vec3(1.0) - F) * (1.0 - metallic);
+    float specular = mix(lut.g, lut.b, clamp((roughness - 0.25) * 2.0, 0.0, 1.0));
+
+    vec3 Lo = (kD * albedo * lut.r + F * specular) * radiance * shadow();
+    vec3 color = vec3(0.03) * albedo * ao + Lo;
+
+    // HDR tonemapping
+    color = color / (color + vec3(1.0));
+
+    // gamma correct
+    color = pow(color, vec3(1.0 / exposure));
+
+    fragColour = vec4(color, 1.0);
+}
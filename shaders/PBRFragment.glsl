@@ -4,9 +4,10 @@ layout (location = 0) out vec4 fragColour;
 
 in vec3 worldPos;
 in vec3 normal;
+in vec3 albedo;
+// with shadowCoord for shadow(), spliced in from Shadow.glsl
 
 // material parameters
-uniform vec3 albedo;
 uniform float metallic;
 uniform float roughness;
 uniform float ao;
@@ -114,6 +115,8 @@ void main()
     // add to outgoing radiance Lo
     Lo += (kD * albedo / PI + brdf) * radiance * NdotL;  // note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
 
+    Lo *= shadow();
+
     vec3 ambient = vec3(0.03) * albedo * ao;
 
     vec3 color = ambient + Lo;
@@ -3,24 +3,104 @@
 // Declare MVP and normalMatrix uniforms
 uniform mat4 MVP;
 uniform mat3 normalMatrix;
+// Offset of each board in a versus match, indexed by the instance's board
+uniform vec3 boardOffset[8];
+// Colour of each palette index stored on the boards, swapped to change theme
+uniform vec3 palette[8];
+// Model space to the light's clip space, see ShadowMaps
+uniform mat4 lightMatrix;
+
+// Animations are worked out here from the last lock and clear of each board, the CPU only
+// uploads those events and the time, so an animated frame costs it no more than a still one.
+// Seconds since the window opened
+uniform float time;
+// Whether the instances drawn are the locked stacks, the falling pieces never animate
+uniform bool stack;
+// Length of the lock flash, of the cleared rows' flash and collapse, and of the rows above falling
+uniform vec3 animationSeconds;
+// When each board's last piece locked and last rows cleared
+uniform float lockTime[8];
+uniform float clearTime[8];
+// Rows the last clear took out, bit r for row r as numbered before the clear
+uniform int clearedRows[8];
+// Cells of the last locked piece, four per board as row * 256 + column after the clear, -1 if cleared
+uniform int lockedCells[32];
 
 // Vertex attributes
 layout(location = 0) in vec3 inVert;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inUV;
+// Per-instance attributes, one instance per cube
+layout(location = 3) in vec3 inCubePos;
+layout(location = 4) in float inPalette;
+layout(location = 5) in float inBoard;
 
 // Outputs
 out vec3 worldPos;
 out vec3 normal;
+out vec3 albedo;
+out vec4 shadowCoord;
 
 void main()
 {
+    int board = int(inBoard);
+    // cubes of the cleared rows are drawn past the end of the palette, only while they collapse
+    bool clearing = int(inPalette) >= 8;
+    vec3 cubePos = inCubePos;
+    float scale = 1.0;
+    float flash = 0.0;
+    if (stack)
+    {
+        float lockAge = time - lockTime[board];
+        int cell = int(inCubePos.y) * 256 + int(inCubePos.x);
+        for (int i = 0; i < 4 && lockAge < animationSeconds.x; ++i)
+        {
+            if (lockedCells[board * 4 + i] == cell)
+            {
+                flash = 0.6 * (1.0 - lockAge / animationSeconds.x);
+            }
+        }
+
+        float clearAge = time - clearTime[board];
+        if (clearing)
+        {
+            // flash white and shrink away
+            float t = clamp(clearAge / animationSeconds.y, 0.0, 1.0);
+            flash = 1.0 - t;
+            scale = 1.0 - t * t;
+        }
+        else if (clearAge < animationSeconds.y + animationSeconds.z)
+        {
+            // find the row the cube stood in before the clear, then let it fall from there once
+            // the cleared rows are gone, speeding up as if under gravity
+            int row = int(inCubePos.y);
+            int from = row;
+            int rows = clearedRows[board];
+            for (int i = 0; i < 8 && rows != 0; ++i)
+            {
+                if (findLSB(rows) <= from)
+                {
+                    ++from;
+                }
+                rows &= rows - 1;
+            }
+            float t = clamp((clearAge - animationSeconds.y) / animationSeconds.z, 0.0, 1.0);
+            cubePos.y += float(from - row) * (1.0 - t * t);
+        }
+    }
+    vec3 position = inVert * scale + cubePos + boardOffset[board];
+
     // Transform vertex position to world space
-    worldPos = vec3(MVP * vec4(inVert, 1.0));
+    worldPos = vec3(MVP * vec4(position, 1.0));
 
     // Transform normal to world space
     normal = normalize(normalMatrix * inNormal);
 
+    // brighter than white so the flash still shows once the lighting has been applied
+    albedo = mix(clearing ? vec3(1.0) : palette[int(inPalette)], vec3(4.0), flash);
+
+    shadowCoord = lightMatrix * vec4(position, 1.0);
+
     // Output position
-    gl_Position = MVP * vec4(inVert, 1.0);
+    gl_Position = MVP * vec4(position, 1.0);
 }
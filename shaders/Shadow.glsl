@@ -0,0 +1,27 @@
+// Shadow lookup shared by every lit fragment shader, ShaderProgramCache splices it in after the
+// #version line. The shader that includes it passes shadowCoord down from its vertex shader.
+in vec4 shadowCoord;
+
+uniform sampler2DShadow stackShadow;
+uniform sampler2DShadow pieceShadow;
+
+// 1 where the light reaches, 0 in the shadow of the stacks or the falling pieces
+#ifdef SINGLE_TAP_SHADOW
+// one filtered lookup per map, for the cheapest tier
+float shadow()
+{
+    vec3 coord = shadowCoord.xyz / shadowCoord.w * 0.5 + 0.5;
+    return texture(stackShadow, coord) * texture(pieceShadow, coord);
+}
+#else
+// four filtered lookups a texel apart per map, which softens the stair steps of the edges
+float shadow()
+{
+    vec3 coord = shadowCoord.xyz / shadowCoord.w * 0.5 + 0.5;
+    float stack = textureOffset(stackShadow, coord, ivec2(-1, -1)) + textureOffset(stackShadow, coord, ivec2(1, -1)) +
+                  textureOffset(stackShadow, coord, ivec2(-1, 1)) + textureOffset(stackShadow, coord, ivec2(1, 1));
+    float piece = textureOffset(pieceShadow, coord, ivec2(-1, -1)) + textureOffset(pieceShadow, coord, ivec2(1, -1)) +
+                  textureOffset(pieceShadow, coord, ivec2(-1, 1)) + textureOffset(pieceShadow, coord, ivec2(1, 1));
+    return stack * piece * 0.0625;
+}
+#endif
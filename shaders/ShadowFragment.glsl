@@ -0,0 +1,6 @@
+#version 410 core
+
+// Only depth is written, by the fixed function
+void main()
+{
+}
@@ -0,0 +1,18 @@
+#version 410 core
+
+// Depth from the light, with the same per-instance layout as PBRVertex.glsl
+uniform mat4 lightMatrix;
+uniform vec3 boardOffset[8];
+
+layout(location = 0) in vec3 inVert;
+layout(location = 3) in vec3 inCubePos;
+layout(location = 4) in float inPalette;
+layout(location = 5) in float inBoard;
+
+void main()
+{
+    // the stack map is only redrawn when a stack changes, so it shows the stacks as they settle;
+    // cubes of cleared rows are only there while they collapse and cast nothing
+    float scale = int(inPalette) >= 8 ? 0.0 : 1.0;
+    gl_Position = lightMatrix * vec4(inVert * scale + inCubePos + boardOffset[int(inBoard)], 1.0);
+}
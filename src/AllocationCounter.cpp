@@ -0,0 +1,56 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef TETRIS_COUNT_ALLOCATIONS
+
+namespace
+{
+    std::atomic<long long> allocations{0};
+}
+
+// The array and nothrow forms call these by default, so replacing these counts them all.
+void *operator new(std::size_t _size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(_size ? _size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *_memory) noexcept
+{
+    std::free(_memory);
+}
+
+void operator delete(void *_memory, std::size_t) noexcept
+{
+    std::free(_memory);
+}
+
+bool AllocationCounter::isEnabled()
+{
+    return true;
+}
+
+long long AllocationCounter::getCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounter::isEnabled()
+{
+    return false;
+}
+
+long long AllocationCounter::getCount()
+{
+    return 0;
+}
+
+#endif
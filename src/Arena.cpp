@@ -0,0 +1,592 @@
+#include "Arena.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "BotLink.h"
+#include "MonteCarloSearch.h"
+#include "PlacementSearch.h"
+#include "VersusMatch.h"
+
+namespace
+{
+    using Pieces = Board::Pieces;
+    using Clock = std::chrono::steady_clock;
+
+    static_assert(Board::FixedHeight <= TETRIS_AGENT_MAX_ROWS && BotLink::MaxRows == TETRIS_AGENT_MAX_ROWS,
+                  "The agent state must hold every row");
+    static_assert(Pieces::Count == TETRIS_AGENT_PIECES && Pieces::Rotations == TETRIS_AGENT_ROTATIONS &&
+                  PreviewSize == TETRIS_AGENT_PREVIEW, "The agent ABI describes the standard piece set");
+
+    // Nodes in each of a tree search agent's pools, it thinks for milliseconds on one thread
+    constexpr std::size_t TreeNodes = 1 << 18;
+
+    unsigned int gameSeed(unsigned int seed, int round, int games, int game)
+    {
+        std::uint64_t index = static_cast<std::uint64_t>(round) * static_cast<std::uint64_t>(games) +
+                              static_cast<std::uint64_t>(game);
+        return static_cast<unsigned int>(ZobristMix(static_cast<std::uint64_t>(seed) << 32 ^ index));
+    }
+
+    // A plugin move handed to the seat's thread, shared with it since the thread outlives a seat that gave up on it.
+    struct PluginCall
+    {
+        std::mutex mutex;                   ///< Guards everything below.
+        std::condition_variable wake;       ///< Signalled when a move is asked for, made or the seat closes.
+        TetrisAgentState state{};           ///< What the plugin sees, written before the move is asked for.
+        TetrisAgentMove move{};             ///< The move made.
+        bool chosen = false;                ///< False if the plugin resigned.
+        double micros = 0.0;                ///< Time the plugin took.
+        bool pending = false;               ///< A move has been asked for and not made yet.
+        bool stop = false;                  ///< The seat is closed, the thread destroys the instance and ends.
+    };
+
+    // Makes a plugin's moves until its seat closes, then destroys the instance, which the thread owns.
+    void runPlugin(std::shared_ptr<PluginCall> call, const TetrisAgentApi* api, void* handle)
+    {
+        std::unique_lock<std::mutex> lock(call->mutex);
+        while (true)
+        {
+            call->wake.wait(lock, [&] { return call->pending || call->stop; });
+            if (!call->pending)
+            {
+                break;
+            }
+            lock.unlock();
+            TetrisAgentMove move{};
+            auto start = Clock::now();
+            bool chosen = api->choose(handle, &call->state, &move) == 0;
+            double micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            lock.lock();
+            call->move = move;
+            call->chosen = chosen;
+            call->micros = micros;
+            call->pending = false;
+            call->wake.notify_all();
+        }
+        lock.unlock();
+        api->destroy(handle);
+    }
+
+    // One side of a game, the agent's instance for it.
+    struct Seat
+    {
+        const ArenaAgent* agent = nullptr;          ///< The entrant.
+        std::unique_ptr<PlacementSearch> search;    ///< A placement search built-in.
+        std::unique_ptr<MonteCarloSearch> tree;     ///< A tree search built-in.
+        std::shared_ptr<PluginCall> call;           ///< A plugin's moves in and out of its thread.
+        std::thread thread;                         ///< Thread making a plugin's moves.
+        bool hung = false;                          ///< Whether a move was left running past the hang limit.
+
+        ~Seat()
+        {
+            if (!thread.joinable())
+            {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(call->mutex);
+                call->stop = true;
+            }
+            call->wake.notify_all();
+            // a hung move may never return, its thread cleans up after it if it does
+            if (hung)
+            {
+                thread.detach();
+            }
+            else
+            {
+                thread.join();
+            }
+        }
+    };
+
+    bool seat(Seat& seat, const ArenaAgent& agent, unsigned int seed, const ArenaOptions& options)
+    {
+        seat.agent = &agent;
+        switch (agent.getKind())
+        {
+        case ArenaAgent::Kind::Search:
+            seat.search = std::make_unique<PlacementSearch>(nullptr, 1);
+            return true;
+        case ArenaAgent::Kind::TreeSearch:
+            seat.tree = std::make_unique<MonteCarloSearch>(1, TreeNodes);
+            return true;
+        case ArenaAgent::Kind::Plugin:
+            break;
+        }
+        TetrisAgentConfig config{};
+        config.width = Board::FixedWidth;
+        config.height = Board::FixedHeight;
+        config.moveLimitMicros = static_cast<std::int32_t>(options.moveLimit * 1000.0);
+        config.seed = seed;
+        for (int type = 1; type <= Pieces::Count; ++type)
+        {
+            for (int rotation = 0; rotation < Pieces::Rotations; ++rotation)
+            {
+                const auto& shape = Pieces::getShape(type, rotation);
+                for (int i = 0; i < Pieces::Size; ++i)
+                {
+                    config.shapes[type - 1][rotation][i] = static_cast<std::uint8_t>(shape[i]);
+                }
+            }
+        }
+        void* handle = agent.getApi()->create(&config);
+        if (!handle)
+        {
+            return false;
+        }
+        seat.call = std::make_shared<PluginCall>();
+        seat.thread = std::thread(runPlugin, seat.call, agent.getApi(), handle);
+        return true;
+    }
+
+    // What a plugin sees, the stack without the active piece as BotLink hands it to bots in other processes.
+    void describe(const Game& game, const Game& opponent, TetrisAgentState& state)
+    {
+        BotLink::Snapshot snapshot;
+        BotLink::Capture(opponent, 0, snapshot);
+        int height = 0;
+        for (int row = 0; row < Board::FixedHeight; ++row)
+        {
+            height = snapshot.rows[row] ? row + 1 : height;
+        }
+        state.opponentHeight = height;
+
+        BotLink::Capture(game, 0, snapshot);
+        std::copy(std::begin(snapshot.rows), std::end(snapshot.rows), std::begin(state.rows));
+        state.piece = snapshot.piece;
+        state.rotation = snapshot.rotation;
+        state.x = snapshot.x;
+        state.y = snapshot.y;
+        std::copy(std::begin(snapshot.preview), std::end(snapshot.preview), std::begin(state.preview));
+        state.pieces = snapshot.pieces;
+        state.lines = snapshot.lines;
+        state.pendingGarbage = game.getPendingGarbage();
+    }
+
+    // Asks a seat for its move and times it, false if a plugin resigned or was still thinking at the hang limit.
+    bool choose(Seat& seat, const Game& game, const Game& opponent, double hangLimit, TetrisAgentMove& move, double& micros)
+    {
+        auto start = Clock::now();
+        if (seat.search || seat.tree)
+        {
+            PlacementSearch::Placement best = seat.search ? seat.search->FindBest(game, static_cast<int>(seat.agent->getSetting()))
+                                                          : seat.tree->Think(game, seat.agent->getSetting());
+            move = {best.rotation, best.x};
+            micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            return true;
+        }
+
+        PluginCall& call = *seat.call;
+        std::unique_lock<std::mutex> lock(call.mutex);
+        describe(game, opponent, call.state);
+        call.pending = true;
+        call.wake.notify_all();
+        auto returned = [&] { return !call.pending; };
+        if (hangLimit <= 0.0)
+        {
+            call.wake.wait(lock, returned);
+        }
+        else if (!call.wake.wait_for(lock, std::chrono::duration<double, std::milli>(hangLimit), returned))
+        {
+            seat.hung = true;
+            seat.agent->Abandon();
+            micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            // one write, other games may be reporting from their threads at the same time
+            std::cerr << seat.agent->getName() + ": a move was still running after " + std::to_string(std::llround(hangLimit)) +
+                         " ms, the seat forfeits and the move is left behind\n";
+            return false;
+        }
+        move = call.move;
+        micros = call.micros;
+        return call.chosen;
+    }
+
+    // Turns and shifts the piece at the spawn row and drops it until it locks, the way the searches place pieces.
+    void place(Game& game, const TetrisAgentMove& move)
+    {
+        int rotation = ((move.rotation % Pieces::Rotations) + Pieces::Rotations) % Pieces::Rotations;
+        for (int turns = 0; game.getTetromino().getRotation() != rotation && turns < Pieces::Rotations; ++turns)
+        {
+            game.Rotate();
+        }
+        while (game.getTetromino().GetX() > move.x && !game.Move(2))
+        {
+        }
+        while (game.getTetromino().GetX() < move.x && !game.Move(3))
+        {
+        }
+        while (!game.isGameOver() && !game.Tick())
+        {
+        }
+    }
+
+    // The time a fraction of the sorted times are at or under.
+    double percentile(const std::vector<float>& sorted, double fraction)
+    {
+        return sorted.empty() ? 0.0 : sorted[static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1))];
+    }
+}
+
+ArenaAgent::~ArenaAgent()
+{
+    // a move left running may still be in the library's code
+    if (_library && _abandoned == 0)
+    {
+        dlclose(_library);
+    }
+}
+
+bool ArenaAgent::Load(const std::string& spec)
+{
+    auto builtin = [&](const std::string& prefix, Kind kind)
+    {
+        if (spec.compare(0, prefix.size(), prefix) != 0)
+        {
+            return false;
+        }
+        _kind = kind;
+        _name = spec;
+        _setting = std::atof(spec.c_str() + prefix.size());
+        return true;
+    };
+    if (builtin("search:", Kind::Search) || builtin("mcts:", Kind::TreeSearch))
+    {
+        bool depth = _kind == Kind::Search;
+        if (depth ? _setting < 1 || _setting > PlacementSearch::MaxDepth || _setting != std::floor(_setting) : _setting <= 0)
+        {
+            std::cerr << spec << ": " << (depth ? "the search depth must be 1 to " + std::to_string(PlacementSearch::MaxDepth)
+                                                : std::string("the thinking time must be positive")) << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    // dlopen searches the library path for bare names, a plugin in the working directory needs a slash
+    _kind = Kind::Plugin;
+    std::string path = spec.find('/') == std::string::npos ? "./" + spec : spec;
+    _library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!_library)
+    {
+        std::cerr << spec << ": " << dlerror() << "\n";
+        return false;
+    }
+    auto entry = reinterpret_cast<TetrisAgentEntry>(dlsym(_library, TETRIS_AGENT_ENTRY));
+    _api = entry ? entry() : nullptr;
+    if (!_api || !_api->create || !_api->choose || !_api->destroy)
+    {
+        std::cerr << spec << ": no " << TETRIS_AGENT_ENTRY << "() or it returned an incomplete table\n";
+        return false;
+    }
+    if (_api->abiVersion != TETRIS_AGENT_ABI_VERSION)
+    {
+        std::cerr << spec << ": built for agent ABI " << _api->abiVersion << ", the arena speaks "
+                  << TETRIS_AGENT_ABI_VERSION << "\n";
+        return false;
+    }
+    _name = _api->name && *_api->name ? _api->name : spec;
+    return true;
+}
+
+Arena::Arena(const ArenaOptions& options)
+    : _options(options), _pool(std::make_unique<WorkerPool>(std::max(options.threads, 1)))
+{
+    _options.games = std::max(_options.games, 1);
+    _options.pieces = std::max(_options.pieces, 1);
+}
+
+bool Arena::AddAgent(const std::string& spec)
+{
+    auto agent = std::make_unique<ArenaAgent>();
+    if (!agent->Load(spec))
+    {
+        return false;
+    }
+
+    // the tables tell agents apart by name, so a second copy of one gets a number
+    const std::string& name = agent->getName();
+    int copies = 1;
+    for (const auto& other : _agents)
+    {
+        copies += other->getName() == name || other->getName().compare(0, name.size() + 1, name + "#") == 0;
+    }
+    if (copies > 1)
+    {
+        agent->setName(agent->getName() + "#" + std::to_string(copies));
+    }
+    _agents.push_back(std::move(agent));
+    _byes.push_back(0);
+    return true;
+}
+
+void Arena::PlayGame(const ArenaAgent& first, const ArenaAgent& second, unsigned int seed, const ArenaOptions& options,
+                     ArenaGame& game)
+{
+    const ArenaAgent* agents[2] = {&first, &second};
+    Game games[2] = {Game(Board(), seed), Game(Board(), seed)};
+    Seat seats[2];
+    game.seed = seed;
+    for (int side = 0; side < 2; ++side)
+    {
+        game.micros[side].clear();
+        game.micros[side].reserve(static_cast<std::size_t>(options.pieces));
+        game.forfeit[side] = !seat(seats[side], *agents[side], seed, options);
+    }
+
+    const double limit = options.moveLimit * 1000.0;
+    const double hangLimit = options.hangLimit > 0.0 ? std::max(options.hangLimit, options.moveLimit) : 0.0;
+    bool over = game.forfeit[0] || game.forfeit[1];
+    while (!over)
+    {
+        // both sides choose before either places, so neither sees the other's move of this turn
+        TetrisAgentMove moves[2] = {};
+        for (int side = 0; side < 2; ++side)
+        {
+            double micros = 0.0;
+            bool chosen = choose(seats[side], games[side], games[1 - side], hangLimit, moves[side], micros);
+            game.micros[side].push_back(static_cast<float>(micros));
+            game.forfeit[side] = !chosen || (limit > 0.0 && micros > limit);
+        }
+        if (game.forfeit[0] || game.forfeit[1])
+        {
+            break;
+        }
+
+        // garbage is exchanged once both pieces are down, as VersusMatch delivers it after every board has stepped
+        int attack[2] = {0, 0};
+        for (int side = 0; side < 2; ++side)
+        {
+            place(games[side], moves[side]);
+            attack[side] = games[side].CancelGarbage(VersusMatch::AttackLines(games[side].getLinesCleared()));
+            game.sent[side] += attack[side];
+        }
+        for (int side = 0; side < 2; ++side)
+        {
+            games[1 - side].AddGarbage(attack[side]);
+        }
+        over = games[0].isGameOver() || games[1].isGameOver() ||
+               (games[0].getPieces() >= options.pieces && games[1].getPieces() >= options.pieces);
+    }
+
+    for (int side = 0; side < 2; ++side)
+    {
+        game.pieces[side] = games[side].getPieces();
+        game.lines[side] = games[side].getLines();
+        game.toppedOut[side] = games[side].isGameOver();
+    }
+    auto decide = [](bool firstLost, bool secondLost) { return firstLost == secondLost ? -1.0 : (firstLost ? 0.0 : 1.0); };
+    // both forfeiting on the same turn is a draw, whatever the stacks look like
+    double score = game.forfeit[0] && game.forfeit[1] ? 0.5 : decide(game.forfeit[0], game.forfeit[1]);
+    if (score < 0.0)
+    {
+        score = decide(game.toppedOut[0], game.toppedOut[1]);
+    }
+    // both topping out on the same turn is a draw, both surviving to the piece limit goes to the stronger attack
+    if (score < 0.0 && !game.toppedOut[0])
+    {
+        score = decide(game.sent[0] < game.sent[1], game.sent[1] < game.sent[0]);
+    }
+    if (score < 0.0 && !game.toppedOut[0])
+    {
+        score = decide(game.lines[0] < game.lines[1], game.lines[1] < game.lines[0]);
+    }
+    game.score = score < 0.0 ? 0.5 : score;
+}
+
+Arena::Pairings Arena::RoundRobinPairings() const
+{
+    Pairings pairings;
+    for (int a = 0; a < getAgentCount(); ++a)
+    {
+        for (int b = a + 1; b < getAgentCount(); ++b)
+        {
+            pairings.emplace_back(a, b);
+        }
+    }
+    return pairings;
+}
+
+Arena::Pairings Arena::SwissPairings()
+{
+    const int count = getAgentCount();
+    std::vector<double> points(static_cast<std::size_t>(count), 0.0);
+    std::set<std::pair<int, int>> met;
+    for (const ArenaGame& game : _games)
+    {
+        points[game.agents[0]] += game.score;
+        points[game.agents[1]] += 1.0 - game.score;
+        met.insert(std::minmax(game.agents[0], game.agents[1]));
+    }
+    std::vector<double> ratings = FitRatings();
+    std::vector<int> order(static_cast<std::size_t>(count));
+    for (int agent = 0; agent < count; ++agent)
+    {
+        order[agent] = agent;
+        points[agent] += _byes[agent] * _options.games;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        return points[a] != points[b] ? points[a] > points[b] : ratings[a] > ratings[b];
+    });
+
+    // the lowest ranked of those with the fewest byes sits out
+    if (count % 2 == 1)
+    {
+        auto bye = std::min_element(order.rbegin(), order.rend(), [&](int a, int b) { return _byes[a] < _byes[b]; });
+        ++_byes[*bye];
+        order.erase(std::next(bye).base());
+    }
+
+    // top down, each agent meets the next one it hasn't met, or the next one if it has met them all
+    Pairings pairings;
+    while (!order.empty())
+    {
+        int a = order.front();
+        auto opponent = std::find_if(order.begin() + 1, order.end(), [&](int b) { return !met.count(std::minmax(a, b)); });
+        if (opponent == order.end())
+        {
+            opponent = order.begin() + 1;
+        }
+        pairings.emplace_back(a, *opponent);
+        order.erase(opponent);
+        order.erase(order.begin());
+    }
+    return pairings;
+}
+
+void Arena::PlayRound(int round, const Pairings& pairings)
+{
+    const int games = _options.games;
+    const std::size_t first = _games.size();
+    _games.resize(first + pairings.size() * static_cast<std::size_t>(games));
+    for (std::size_t pairing = 0; pairing < pairings.size(); ++pairing)
+    {
+        for (int g = 0; g < games; ++g)
+        {
+            ArenaGame& game = _games[first + pairing * games + g];
+            game.round = round;
+            game.agents[0] = pairings[pairing].first;
+            game.agents[1] = pairings[pairing].second;
+            game.seed = gameSeed(_options.seed, round, games, g);
+        }
+    }
+
+    // one game per work item, handed out as threads come free since games vary a lot in length
+    std::atomic<std::size_t> next{first};
+    const std::size_t count = _games.size();
+    auto task = [&](int, int)
+    {
+        for (std::size_t item = next++; item < count; item = next++)
+        {
+            ArenaGame& game = _games[item];
+            PlayGame(*_agents[game.agents[0]], *_agents[game.agents[1]], game.seed, _options, game);
+        }
+    };
+    _pool->Run(_pool->getThreadCount(), task);
+}
+
+std::vector<double> Arena::FitRatings() const
+{
+    // minorisation-maximisation for Bradley-Terry strengths, the anchor has strength 1 and one draw with everybody
+    const int count = getAgentCount();
+    std::vector<double> wins(static_cast<std::size_t>(count), 0.5);
+    std::vector<std::vector<int>> played(static_cast<std::size_t>(count), std::vector<int>(static_cast<std::size_t>(count), 0));
+    for (const ArenaGame& game : _games)
+    {
+        wins[game.agents[0]] += game.score;
+        wins[game.agents[1]] += 1.0 - game.score;
+        ++played[game.agents[0]][game.agents[1]];
+        ++played[game.agents[1]][game.agents[0]];
+    }
+    std::vector<double> strength(static_cast<std::size_t>(count), 1.0);
+    for (int iteration = 0; iteration < 1000; ++iteration)
+    {
+        double change = 0.0;
+        for (int a = 0; a < count; ++a)
+        {
+            double denominator = 1.0 / (strength[a] + 1.0);
+            for (int b = 0; b < count; ++b)
+            {
+                denominator += played[a][b] / (strength[a] + strength[b]);
+            }
+            double updated = wins[a] / denominator;
+            change = std::max(change, std::abs(std::log(updated / strength[a])));
+            strength[a] = updated;
+        }
+        if (change < 1e-9)
+        {
+            break;
+        }
+    }
+    std::vector<double> ratings(static_cast<std::size_t>(count));
+    for (int a = 0; a < count; ++a)
+    {
+        ratings[a] = 1500.0 + 400.0 * std::log10(strength[a]);
+    }
+    return ratings;
+}
+
+std::vector<ArenaStanding> Arena::getStandings() const
+{
+    const int count = getAgentCount();
+    std::vector<double> ratings = FitRatings();
+    std::vector<ArenaStanding> standings(static_cast<std::size_t>(count));
+    std::vector<std::vector<float>> micros(static_cast<std::size_t>(count));
+    std::vector<int> played(static_cast<std::size_t>(count), 0);
+    for (int agent = 0; agent < count; ++agent)
+    {
+        standings[agent].agent = agent;
+        standings[agent].elo = ratings[agent];
+        standings[agent].points = _byes[agent] * _options.games;
+    }
+    for (const ArenaGame& game : _games)
+    {
+        for (int side = 0; side < 2; ++side)
+        {
+            ArenaStanding& standing = standings[game.agents[side]];
+            double score = side == 0 ? game.score : 1.0 - game.score;
+            standing.points += score;
+            standing.wins += score == 1.0;
+            standing.draws += score == 0.5;
+            standing.losses += score == 0.0;
+            standing.forfeits += game.forfeit[side] && score == 0.0;
+            standing.lines += game.lines[side];
+            ++played[game.agents[side]];
+            auto& times = micros[game.agents[side]];
+            times.insert(times.end(), game.micros[side].begin(), game.micros[side].end());
+        }
+    }
+    for (int agent = 0; agent < count; ++agent)
+    {
+        ArenaStanding& standing = standings[agent];
+        std::vector<float>& times = micros[agent];
+        std::sort(times.begin(), times.end());
+        standing.lines /= std::max(played[agent], 1);
+        standing.moves = static_cast<long long>(times.size());
+        standing.medianMicros = percentile(times, 0.5);
+        standing.slowMicros = percentile(times, 0.99);
+        standing.maxMicros = percentile(times, 1.0);
+        for (float time : times)
+        {
+            std::size_t bucket = time < 2.0f ? 0 : static_cast<std::size_t>(std::log2(time));
+            if (bucket >= standing.histogram.size())
+            {
+                standing.histogram.resize(bucket + 1, 0);
+            }
+            ++standing.histogram[bucket];
+        }
+    }
+    std::stable_sort(standings.begin(), standings.end(), [](const ArenaStanding& a, const ArenaStanding& b)
+    {
+        return a.elo > b.elo;
+    });
+    return standings;
+}
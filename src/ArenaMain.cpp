@@ -0,0 +1,238 @@
+/****************************************************************************
+Plays agents against each other and rates them, e.g.
+  ./tetris_arena --games 4 --threads 8 --move-limit 50 search:1 search:2 mcts:5 libtetris_agent_sample.so
+Agents are plugins, shared libraries exporting the C interface in ArenaAgent.h,
+or the built-in searches: search:D looks D pieces ahead, mcts:MS thinks MS
+milliseconds a move. Every pairing plays the same seeded piece sequences as a
+garbage duel; --rounds 5 plays five Swiss rounds instead of a round robin.
+The results are an Elo table, each agent's move time percentiles and a
+histogram of its move times, and --csv writes one line per game. A move over
+--move-limit forfeits once it returns; a plugin move still running after
+--hang-limit ms (10000, 0 to wait for ever) is left behind and forfeits.
+****************************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Arena.h"
+#include "PlacementSearch.h"
+
+namespace
+{
+    // Rank of each value, ties sharing the mean of their ranks.
+    std::vector<double> ranks(const std::vector<double>& values)
+    {
+        std::vector<int> order(values.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = static_cast<int>(i);
+        }
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return values[a] < values[b]; });
+        std::vector<double> result(values.size());
+        for (std::size_t i = 0; i < order.size();)
+        {
+            std::size_t j = i;
+            while (j + 1 < order.size() && values[order[j + 1]] == values[order[i]])
+            {
+                ++j;
+            }
+            for (std::size_t k = i; k <= j; ++k)
+            {
+                result[order[k]] = (static_cast<double>(i) + static_cast<double>(j)) / 2.0;
+            }
+            i = j + 1;
+        }
+        return result;
+    }
+
+    // Spearman's rank correlation, 0 when either side has no spread.
+    double rankCorrelation(const std::vector<double>& x, const std::vector<double>& y)
+    {
+        std::vector<double> rx = ranks(x);
+        std::vector<double> ry = ranks(y);
+        double n = static_cast<double>(x.size());
+        double mean = (n - 1.0) / 2.0;
+        double xy = 0.0;
+        double xx = 0.0;
+        double yy = 0.0;
+        for (std::size_t i = 0; i < x.size(); ++i)
+        {
+            xy += (rx[i] - mean) * (ry[i] - mean);
+            xx += (rx[i] - mean) * (rx[i] - mean);
+            yy += (ry[i] - mean) * (ry[i] - mean);
+        }
+        return xx > 0.0 && yy > 0.0 ? xy / std::sqrt(xx * yy) : 0.0;
+    }
+
+    void writeCsv(std::ostream& out, const Arena& arena)
+    {
+        out << "round,seed,first,second,first_score,first_pieces,second_pieces,first_lines,second_lines,"
+               "first_sent,second_sent,first_topped_out,second_topped_out,first_forfeit,second_forfeit,"
+               "first_mean_us,second_mean_us,first_max_us,second_max_us\n";
+        for (const ArenaGame& game : arena.getGames())
+        {
+            out << game.round << ',' << game.seed << ',' << arena.getAgent(game.agents[0]).getName() << ','
+                << arena.getAgent(game.agents[1]).getName() << ',' << game.score;
+            for (const int* pair : {game.pieces, game.lines, game.sent})
+            {
+                out << ',' << pair[0] << ',' << pair[1];
+            }
+            for (const bool* pair : {game.toppedOut, game.forfeit})
+            {
+                out << ',' << pair[0] << ',' << pair[1];
+            }
+            double mean[2] = {0.0, 0.0};
+            double slowest[2] = {0.0, 0.0};
+            for (int side = 0; side < 2; ++side)
+            {
+                for (float micros : game.micros[side])
+                {
+                    mean[side] += micros;
+                    slowest[side] = std::max(slowest[side], static_cast<double>(micros));
+                }
+                mean[side] /= std::max<std::size_t>(game.micros[side].size(), 1);
+            }
+            out << ',' << mean[0] << ',' << mean[1] << ',' << slowest[0] << ',' << slowest[1] << '\n';
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ArenaOptions options;
+    options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::string csv;
+    std::vector<std::string> specs;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            specs.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            break;
+        }
+        std::string value = argv[++i];
+        if (arg == "--games") options.games = std::stoi(value);
+        else if (arg == "--rounds") options.rounds = std::stoi(value);
+        else if (arg == "--pieces") options.pieces = std::stoi(value);
+        else if (arg == "--move-limit") options.moveLimit = std::stod(value);
+        else if (arg == "--hang-limit") options.hangLimit = std::stod(value);
+        else if (arg == "--seed") options.seed = static_cast<unsigned int>(std::stoul(value));
+        else if (arg == "--threads") options.threads = std::stoi(value);
+        else if (arg == "--csv") csv = value;
+        else
+        {
+            std::cerr << "unknown option " << arg << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (specs.size() < 2 || options.games < 1 || options.rounds < 0 || options.pieces < 1 || options.moveLimit < 0.0 ||
+        options.hangLimit < 0.0 || options.threads < 1)
+    {
+        std::cerr << "usage: tetris_arena [--games N] [--rounds N, 0 for a round robin] [--pieces N] [--move-limit MS]\n"
+                     "                    [--hang-limit MS] [--seed N] [--threads N] [--csv FILE] AGENT AGENT...\n"
+                     "an agent is a plugin library, search:1-" << PlacementSearch::MaxDepth << " or mcts:MS\n";
+        return EXIT_FAILURE;
+    }
+
+    Arena arena(options);
+    for (const std::string& spec : specs)
+    {
+        if (!arena.AddAgent(spec))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    std::cout << arena.getAgentCount() << " agents, " << (options.rounds > 0 ? std::to_string(options.rounds) + " Swiss rounds"
+                                                                            : std::string("round robin"))
+              << ", " << options.games << " games a pairing, " << options.pieces << " pieces a side, ";
+    if (options.moveLimit > 0.0)
+    {
+        std::cout << options.moveLimit << " ms a move";
+    }
+    else
+    {
+        std::cout << "no time limit";
+    }
+    std::cout << ", " << options.threads << " threads\n";
+    arena.Run([&](int round)
+    {
+        if (options.rounds > 0)
+        {
+            std::cout << "round " << round + 1 << " played\n";
+        }
+    });
+
+    std::vector<ArenaStanding> standings = arena.getStandings();
+    std::cout << "\nrank agent                    elo  points    won  drawn   lost  forfeits  lines/game"
+                 "   median us     99% us     max us\n"
+              << std::fixed;
+    for (std::size_t rank = 0; rank < standings.size(); ++rank)
+    {
+        const ArenaStanding& standing = standings[rank];
+        std::cout << std::setw(4) << rank + 1 << ' ' << std::left << std::setw(20)
+                  << arena.getAgent(standing.agent).getName() << std::right << std::setprecision(0) << std::setw(8)
+                  << standing.elo << std::setprecision(1) << std::setw(8) << standing.points << std::setw(7) << standing.wins
+                  << std::setw(7) << standing.draws << std::setw(7) << standing.losses << std::setw(10) << standing.forfeits
+                  << std::setw(12) << standing.lines << std::setw(12) << standing.medianMicros << std::setw(11)
+                  << standing.slowMicros << std::setw(11) << standing.maxMicros << "\n";
+    }
+
+    // one column per octave of move time that any agent used
+    std::size_t octaves = 0;
+    for (const ArenaStanding& standing : standings)
+    {
+        octaves = std::max(octaves, standing.histogram.size());
+    }
+    std::cout << "\nmoves by time  ";
+    for (std::size_t octave = 0; octave < octaves; ++octave)
+    {
+        double low = octave == 0 ? 0.0 : std::ldexp(1.0, static_cast<int>(octave));
+        std::string label = low < 1000.0 ? std::to_string(static_cast<int>(low)) + "us"
+                            : low < 1e6 ? std::to_string(static_cast<int>(low / 1000.0)) + "ms"
+                                        : std::to_string(static_cast<int>(low / 1e6)) + "s";
+        std::cout << std::setw(8) << label;
+    }
+    std::cout << "\n";
+    for (const ArenaStanding& standing : standings)
+    {
+        std::cout << std::left << std::setw(15) << arena.getAgent(standing.agent).getName().substr(0, 14) << std::right;
+        for (std::size_t octave = 0; octave < octaves; ++octave)
+        {
+            std::cout << std::setw(8) << (octave < standing.histogram.size() ? standing.histogram[octave] : 0);
+        }
+        std::cout << "\n";
+    }
+
+    // negative when the faster agents are the stronger ones
+    std::vector<double> times;
+    std::vector<double> ratings;
+    for (const ArenaStanding& standing : standings)
+    {
+        times.push_back(standing.medianMicros);
+        ratings.push_back(standing.elo);
+    }
+    std::cout << "\nrank correlation of median move time with elo " << std::setprecision(2)
+              << rankCorrelation(times, ratings) << "\n";
+
+    if (!csv.empty())
+    {
+        std::ofstream out(csv);
+        writeCsv(out, arena);
+        if (!out)
+        {
+            std::cerr << "could not write " << csv << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
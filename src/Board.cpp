@@ -1,103 +1,166 @@
 #include "Board.h"
-#include "Cube.h"
-#include "ngl/Vec4.h"
+#include <algorithm>
+#include <cassert>
 
-Board::Board(int width, int height) : width_(width), height_(height) {
-    // Initialize occupied array with all false (empty)
-    _blockInfo.resize(height_, std::vector<BlockInfo>(width_, {false, ngl::Vec4()}));
+namespace
+{
+    // Fills fixed storage, or sizes and fills runtime storage.
+    template <typename T, std::size_t N>
+    void resetStorage(std::array<T, N>& storage, int, const T& value)
+    {
+        storage.fill(value);
+    }
+
+    template <typename T>
+    void resetStorage(std::vector<T>& storage, int count, const T& value)
+    {
+        storage.assign(count, value);
+    }
+}
+
+template <int Width, int Height, typename PieceSet>
+BasicBoard<Width, Height, PieceSet>::BasicBoard(int width, int height) : width_(width), height_(height) {
+    assert((Width == Dynamic || width == Width) && (Height == Dynamic || height == Height));
+    assert(width <= MaxWidth);
+    // Initialize every row as empty
+    resetStorage(_rows, height_, RowMask(0));
+    for (auto& plane : _palette)
+    {
+        resetStorage(plane, height_, RowMask(0));
+    }
+}
+
+template <int Width, int Height, typename PieceSet>
+bool BasicBoard<Width, Height, PieceSet>::ShiftRow(std::uint64_t bits, int x, std::uint64_t& out) const
+{
+    if (x < 0)
+    {
+        // blocks in the columns shifted out would be left of the board
+        if (bits & ((1ull << -x) - 1))
+        {
+            return false;
+        }
+        out = bits >> -x;
+    }
+    else
+    {
+        out = bits << x;
+    }
+    return (out & ~FullRow()) == 0;
 }
 
-int Board::getHeight() const
+template <int Width, int Height, typename PieceSet>
+std::uint64_t BasicBoard<Width, Height, PieceSet>::CoveredRow(const Tetromino& tetromino, int row) const
 {
-    return height_;
+    int i = row - tetromino.GetY();
+    if (i < 0 || i >= PieceSet::Size)
+    {
+        return 0;
+    }
+    std::uint64_t covered = 0;
+    ShiftRow(PieceSet::getShape(tetromino.getType(), tetromino.getRotation())[i], tetromino.GetX(), covered);
+    return covered & FullRow();
 }
 
-int Board::getWidth() const
+template <int Width, int Height, typename PieceSet>
+bool BasicBoard<Width, Height, PieceSet>::Collides(const typename PieceSet::Shape& shape, int x, int y,
+                                                   const Tetromino* placed) const
 {
-    return width_;
+    for (int i = 0; i < PieceSet::Size; ++i)
+    {
+        if (shape[i] == 0)
+        {
+            continue;
+        }
+        // Check for out-of-bounds movement (both horizontal and vertical)
+        int row = y + i;
+        std::uint64_t bits = 0;
+        if (row < 0 || row >= getHeight() || !ShiftRow(shape[i], x, bits))
+        {
+            return true;
+        }
+        // Check for collision with occupied positions on board (excluding Tetromino itself)
+        if (bits & _rows[row] & ~(placed ? CoveredRow(*placed, row) : 0))
+        {
+            return true;
+        }
+    }
+    // No collision detected
+    return false;
 }
 
-int Board::getScore() const
+template <int Width, int Height, typename PieceSet>
+bool BasicBoard<Width, Height, PieceSet>::IsCollision(const Tetromino& tetromino, int Down, int Left, int Right) const
 {
-    return _score;
+    return Collides(PieceSet::getShape(tetromino.getType(), tetromino.getRotation()),
+                    tetromino.GetX() + Right - Left, tetromino.GetY() - Down, &tetromino);
 }
 
-bool Board::IsCollision(const Tetromino& tetromino, int Down, int Left, int Right)
+template <int Width, int Height, typename PieceSet>
+bool BasicBoard<Width, Height, PieceSet>::Overlaps(const Tetromino& tetromino) const
 {
-  // Check for collisions with occupied positions or out-of-bounds movement
-  for (int i = 0; i < 4; ++i)
-  {
-    for (int j = 0; j < 4; ++j)
-    {
-      if (tetromino.getBlock(i, j) == 1)
-      {
-      // Calculate potential new position based on Tetromino's shape
-      int newY = tetromino.GetY() + i - Down;
-      int newX = tetromino.GetX() + j + Right - Left;
-
-      // Check for out-of-bounds movement (both horizontal and vertical)
-      if (newX < 0 || newX >= width_-1 || newY < 0)
-      {
-        return true; // Collision detected (out-of-bounds)
-      }
-
-      // Check for collision with occupied positions on board (excluding Tetromino itself)
-      if (tetromino.getBlock(i, j) == 1 &&
-            _blockInfo[newY][newX].occupied &&
-          !tetromino.IsWithinShape(i-Down, j+Right-Left))
-          { // Use unmodified IsWithinShape here
-            return true; // Collision with occupied position (excluding Tetromino itself)
-          }
-      }
+    return Collides(PieceSet::getShape(tetromino.getType(), tetromino.getRotation()),
+                    tetromino.GetX(), tetromino.GetY(), nullptr);
+}
+
+template <int Width, int Height, typename PieceSet>
+bool BasicBoard<Width, Height, PieceSet>::IsBlocked(int row, int col) const
+{
+    if (row < 0 || row >= getHeight() || col < 0 || col >= getWidth())
+    {
+        return true;
     }
-  }
-  // No collision detected
-  return false;
+    return (_rows[row] >> col) & 1;
 }
 
-void Board::ClearTetromino(const Tetromino& tetromino)
+template <int Width, int Height, typename PieceSet>
+void BasicBoard<Width, Height, PieceSet>::ClearTetromino(const Tetromino& tetromino)
 {
-    // Iterate over Tetromino shape and clear positions from the board
-    for (int i = 0; i < 4; ++i)
+    // Clear the rows of the Tetromino shape from the board
+    for (int i = 0; i < PieceSet::Size; ++i)
     {
-        for (int j = 0; j < 4; ++j)
+        int row = tetromino.GetY() + i;
+        if (row >= 0 && row < getHeight())
         {
-            if (tetromino.getBlock(i, j) == 1)
-            {
-                int newY = tetromino.GetY() + i;
-                int newX = tetromino.GetX() + j;
-                if (newY < height_ && newX < width_)
-                {
-                    _blockInfo[newY][newX].occupied = false;  // Clear occupied state
-                    _blockInfo[newY][newX].colour = ngl::Vec4{0,0,0,0};
-                }
-            }
+            SetRow(row, _rows[row] & static_cast<RowMask>(~CoveredRow(tetromino, row)));
         }
     }
 }
 
-void Board::UpdateTetrominoOnBoard(const Tetromino& tetromino)
+template <int Width, int Height, typename PieceSet>
+void BasicBoard<Width, Height, PieceSet>::UpdateTetrominoOnBoard(const Tetromino& tetromino)
 {
     // Update board with new Tetromino positions
-    for (int i = 0; i < 4; ++i)
+    const auto& shape = PieceSet::getShape(tetromino.getType(), tetromino.getRotation());
+    const int palette = tetromino.getPaletteIndex();
+    for (int i = 0; i < PieceSet::Size; ++i)
     {
-        for (int j = 0; j < 4; ++j)
+        int row = tetromino.GetY() + i;
+        if (shape[i] == 0 || row < 0 || row >= getHeight())
         {
-            if (tetromino.getBlock(i, j) == 1)
+            continue;
+        }
+        std::uint64_t covered = 0;
+        ShiftRow(shape[i], tetromino.GetX(), covered);
+        const auto cells = static_cast<RowMask>(covered & FullRow());
+        SetRow(row, _rows[row] | cells);
+        // write the palette index into the covered cells a bit at a time
+        for (int bit = 0; bit < PaletteBits; ++bit)
+        {
+            if ((palette >> bit) & 1)
             {
-                int newY = tetromino.GetY() + i;
-                int newX = tetromino.GetX() + j;
-                if (newY < height_ && newX < width_)
-                {
-                    _blockInfo[newY][newX].occupied = true;
-                    _blockInfo[newY][newX].colour = tetromino.getColour();  // Update color
-                }
+                _palette[bit][row] |= cells;
+            }
+            else
+            {
+                _palette[bit][row] &= static_cast<RowMask>(~cells);
             }
         }
     }
 }
 
-bool Board::MoveTetromino(Tetromino& tetromino, int direction)
+template <int Width, int Height, typename PieceSet>
+bool BasicBoard<Width, Height, PieceSet>::MoveTetromino(Tetromino& tetromino, int direction)
 {
   int Down = 0;
   int Left = 0;
@@ -114,7 +177,6 @@ bool Board::MoveTetromino(Tetromino& tetromino, int direction)
       Right = 1;
       break;
   }
-  //std::cout << Down << "\n" << Left << "\n" << Right << "\n";
 
   // Check for collision with occupied positions below
   if (IsCollision(tetromino, Down, Left, Right))
@@ -122,25 +184,23 @@ bool Board::MoveTetromino(Tetromino& tetromino, int direction)
     return true; // Collision detected, movement blocked
   }
 
-  // Clear current Tetromino positions from occupied_
+  // Clear current Tetromino positions from the rows
   ClearTetromino(tetromino);
 
   // Update Tetromino's position
   tetromino.SetPosition(tetromino.GetX() + Right - Left, tetromino.GetY() - Down);
 
-  // Update Tetromino's position on occupied_
+  // Update Tetromino's position on the rows
   UpdateTetrominoOnBoard(tetromino);
   return false;
 }
 
-bool Board::RotateTetromino(Tetromino& tetromino)
+template <int Width, int Height, typename PieceSet>
+bool BasicBoard<Width, Height, PieceSet>::RotateTetromino(Tetromino& tetromino)
 {
-    // First, simulate rotation to check for potential collisions
-    Tetromino tempTetromino = tetromino;  // Make a copy to simulate rotation
-    tempTetromino.Rotate();  // Perform rotation on the copy
-
-    // Check if the new position would cause a collision
-    if (IsCollision(tempTetromino, 0, 0, 0))
+    // Check the next orientation against the board, ignoring the cells the current one covers
+    int rotation = (tetromino.getRotation() + 1) % PieceSet::Rotations;
+    if (Collides(PieceSet::getShape(tetromino.getType(), rotation), tetromino.GetX(), tetromino.GetY(), &tetromino))
     {
         return false; // If collision, rotation is not performed
     }
@@ -149,7 +209,7 @@ bool Board::RotateTetromino(Tetromino& tetromino)
     ClearTetromino(tetromino);
 
     // Perform actual rotation on original Tetromino
-    tetromino.Rotate();
+    tetromino.SetRotation(rotation);
 
     // Update Tetromino's position on the board
     UpdateTetrominoOnBoard(tetromino);
@@ -157,42 +217,121 @@ bool Board::RotateTetromino(Tetromino& tetromino)
     return true; // Rotation successful
 }
 
-void Board::ClearFullRows()
+template <int Width, int Height, typename PieceSet>
+int BasicBoard<Width, Height, PieceSet>::ClearFullRows(int bottom, int top)
 {
-    for (int row = height_ - 1; row >= 0; --row)
-    { // Start from the topmost row
-        bool rowFull = true;
-        for (int col = 0; col < width_-1; ++col)
+    const auto full = static_cast<RowMask>(FullRow());
+    bottom = std::max(bottom, 0);
+    top = std::min(top, getHeight() - 1);
+
+    // Nothing moves unless a row in the range is full
+    int kept = bottom;
+    while (kept <= top && _rows[kept] != full)
+    {
+        kept++;
+    }
+    if (kept > top)
+    {
+        return 0;
+    }
+
+    // Every row from the first full one up may move, take their keys out of the hash and put the new ones back after
+    const int first = kept;
+    _hash ^= HashRows(first, getHeight());
+
+    // Compact the rows that aren't full towards the bottom in one pass
+    for (int row = kept; row < getHeight(); ++row)
+    {
+        if (row <= top && _rows[row] == full)
+        {
+            continue;
+        }
+        if (kept != row)
         {
-            if (!_blockInfo[row][col].occupied)
+            _rows[kept] = _rows[row];
+            for (auto& plane : _palette)
             {
-                rowFull = false;
-                break;
+                plane[kept] = plane[row];
             }
         }
+        kept++;
+    }
 
-        if (rowFull) {
-            // Move all rows above this one down
-            for (int moveRow = row; moveRow < height_ - 1; ++moveRow)
-            {
-                _blockInfo[moveRow] = _blockInfo[moveRow + 1];
-            }
+    // Clear the rows left empty at the top
+    int cleared = getHeight() - kept;
+    std::fill(_rows.begin() + kept, _rows.end(), RowMask(0));
+    _hash ^= HashRows(first, kept);
+    return cleared;
+}
 
-            // Clear the topmost row
-            _blockInfo[height_ - 1].assign(width_, {false, ngl::Vec4()}); // Reset the bottommost row
+template <int Width, int Height, typename PieceSet>
+bool BasicBoard<Width, Height, PieceSet>::AddGarbageRows(int count, int hole)
+{
+    count = std::min(count, getHeight());
 
-            // Decrease the index to check the same row index again as it now contains what was previously above it
-            row++;
-            _score++;
-        }
+    // Only the rows about to be pushed off need checking for blocks
+    bool toppedOut = std::any_of(_rows.end() - count, _rows.end(), [](RowMask row) { return row != 0; });
+
+    // Move every row up, anything pushed off the top is lost
+    std::copy_backward(_rows.begin(), _rows.end() - count, _rows.end());
+    for (auto& plane : _palette)
+    {
+        std::copy_backward(plane.begin(), plane.end() - count, plane.end());
+    }
+
+    // Fill the bottom rows, garbage has its own palette entry so it stands out from the tetrominoes
+    const auto garbage = static_cast<RowMask>(FullRow() & ~(1ull << hole));
+    std::fill(_rows.begin(), _rows.begin() + count, garbage);
+    for (int bit = 0; bit < PaletteBits; ++bit)
+    {
+        std::fill(_palette[bit].begin(), _palette[bit].begin() + count,
+                  (GarbagePalette >> bit) & 1 ? garbage : RowMask(0));
     }
+
+    // every row moved, so the hash is rebuilt rather than updated
+    _hash = HashRows(0, getHeight());
+    return toppedOut;
 }
 
-ngl::Vec4 Board::GetBlock(int row, int col) const
+template <int Width, int Height, typename PieceSet>
+std::uint64_t BasicBoard<Width, Height, PieceSet>::HashRows(int bottom, int top) const
 {
-    if (row >= 0 && row < height_ && col >= 0 && col < width_)
+    std::uint64_t hash = 0;
+    for (int row = bottom; row < top; ++row)
     {
-        return _blockInfo[row][col].occupied ? _blockInfo[row][col].colour : ngl::Vec4(0,0,0,0);
+        hash ^= RowKey(row, _rows[row]);
     }
-    return ngl::Vec4(0, 0, 0, 0); // Return default color for out-of-bounds
+    return hash;
 }
+
+template <int Width, int Height, typename PieceSet>
+std::uint32_t BasicBoard<Width, Height, PieceSet>::Checksum() const
+{
+    std::uint32_t hash = 2166136261u;
+    auto mix = [&hash](std::uint32_t value)
+    {
+        for (int byte = 0; byte < 4; ++byte)
+        {
+            hash = (hash ^ ((value >> (byte * 8)) & 0xffu)) * 16777619u;
+        }
+    };
+    for (int row = 0; row < getHeight(); ++row)
+    {
+        mix(static_cast<std::uint32_t>(_rows[row]));
+        mix(static_cast<std::uint32_t>(static_cast<std::uint64_t>(_rows[row]) >> 32));
+        for (const auto& plane : _palette)
+        {
+            // palette bits of empty cells are stale, only occupied ones count
+            auto bits = static_cast<std::uint64_t>(plane[row] & _rows[row]);
+            mix(static_cast<std::uint32_t>(bits));
+            mix(static_cast<std::uint32_t>(bits >> 32));
+        }
+    }
+    return hash;
+}
+
+template class BasicBoard<10, 20>;
+template class BasicBoard<10, 40>;
+template class BasicBoard<Dynamic, Dynamic>;
+template class BasicBoard<10, 20, Pentominoes>;
+template class BasicBoard<Dynamic, Dynamic, Polyominoes>;
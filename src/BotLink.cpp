@@ -0,0 +1,210 @@
+#include "BotLink.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "PlacementSearch.h"
+
+namespace
+{
+    constexpr std::uint32_t Magic = 0x544c4b31; // "TLK1"
+    constexpr std::size_t SnapshotWords = (sizeof(BotLink::Snapshot) + 7) / 8;
+
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free && std::atomic<std::uint64_t>::is_always_lock_free,
+                  "The segment's atomics must work across processes");
+
+    std::string segmentName(const std::string& name)
+    {
+        return !name.empty() && name[0] == '/' ? name : "/" + name;
+    }
+}
+
+/// The shared memory layout, the same in both processes. The snapshot is kept as atomic words
+/// so the seqlock's racing reads are well defined; each side's indices sit on their own cache line.
+struct BotSegment
+{
+    std::atomic<std::uint32_t> magic;                   ///< Magic once the game has set the segment up.
+    std::uint32_t size;                                 ///< sizeof(BotSegment) of the game's build.
+    alignas(64) std::atomic<std::uint32_t> sequence;    ///< Seqlock sequence, odd while the game writes.
+    std::atomic<std::uint64_t> words[SnapshotWords];    ///< The snapshot.
+    alignas(64) std::atomic<std::uint32_t> head;        ///< Commands submitted, written by the bot.
+    alignas(64) std::atomic<std::uint32_t> tail;        ///< Commands received, written by the game.
+    BotLink::Command commands[BotLink::RingSize];       ///< The ring.
+};
+
+BotLink::~BotLink()
+{
+    if (_segment)
+    {
+        munmap(_segment, sizeof(BotSegment));
+    }
+    if (_owner)
+    {
+        shm_unlink(_name.c_str());
+    }
+}
+
+bool BotLink::Map(int descriptor)
+{
+    void* memory = mmap(nullptr, sizeof(BotSegment), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (memory == MAP_FAILED)
+    {
+        return false;
+    }
+    _segment = static_cast<BotSegment*>(memory);
+    return true;
+}
+
+bool BotLink::Create(const std::string& name)
+{
+    _name = segmentName(name);
+    shm_unlink(_name.c_str());
+    int descriptor = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (descriptor < 0)
+    {
+        return false;
+    }
+    _owner = true;
+    if (ftruncate(descriptor, sizeof(BotSegment)) != 0)
+    {
+        close(descriptor);
+        return false;
+    }
+    if (!Map(descriptor))
+    {
+        return false;
+    }
+
+    // a fresh segment is zero filled, so only the size and then the magic need writing
+    _segment->size = sizeof(BotSegment);
+    _segment->magic.store(Magic, std::memory_order_release);
+    return true;
+}
+
+bool BotLink::Open(const std::string& name)
+{
+    _name = segmentName(name);
+    int descriptor = shm_open(_name.c_str(), O_RDWR, 0);
+    if (descriptor < 0)
+    {
+        return false;
+    }
+    struct stat info{};
+    if (fstat(descriptor, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(BotSegment) || !Map(descriptor))
+    {
+        return false;
+    }
+    if (_segment->magic.load(std::memory_order_acquire) != Magic || _segment->size != sizeof(BotSegment))
+    {
+        munmap(_segment, sizeof(BotSegment));
+        _segment = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void BotLink::Publish(const Snapshot& snapshot)
+{
+    std::uint64_t words[SnapshotWords] = {};
+    std::memcpy(words, &snapshot, sizeof(Snapshot));
+
+    // odd while writing, the fence keeps the words from being written before the bump is visible
+    std::uint32_t sequence = _segment->sequence.load(std::memory_order_relaxed);
+    _segment->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < SnapshotWords; ++i)
+    {
+        _segment->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    _segment->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+std::uint32_t BotLink::Read(Snapshot& snapshot) const
+{
+    std::uint64_t words[SnapshotWords];
+    for (;;)
+    {
+        std::uint32_t before = _segment->sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            continue;
+        }
+        for (std::size_t i = 0; i < SnapshotWords; ++i)
+        {
+            words[i] = _segment->words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_segment->sequence.load(std::memory_order_relaxed) == before)
+        {
+            std::memcpy(&snapshot, words, sizeof(Snapshot));
+            return before;
+        }
+    }
+}
+
+std::uint32_t BotLink::getSequence() const
+{
+    return _segment->sequence.load(std::memory_order_acquire);
+}
+
+bool BotLink::Submit(const Command& command)
+{
+    std::uint32_t head = _segment->head.load(std::memory_order_relaxed);
+    if (head - _segment->tail.load(std::memory_order_acquire) == RingSize)
+    {
+        return false;
+    }
+    _segment->commands[head % RingSize] = command;
+    _segment->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool BotLink::Receive(Command& command)
+{
+    std::uint32_t tail = _segment->tail.load(std::memory_order_relaxed);
+    if (tail == _segment->head.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    command = _segment->commands[tail % RingSize];
+    _segment->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void BotLink::Capture(const Game& game, std::uint64_t frame, Snapshot& snapshot)
+{
+    const Tetromino& active = game.getTetromino();
+    snapshot.frame = frame;
+    snapshot.width = Board::FixedWidth;
+    snapshot.height = Board::FixedHeight;
+    snapshot.pieces = game.getPieces();
+    snapshot.lines = game.getLines();
+    snapshot.score = game.getScore();
+    snapshot.x = active.GetX();
+    snapshot.y = active.GetY();
+    snapshot.piece = static_cast<std::uint8_t>(active.getType());
+    snapshot.rotation = static_cast<std::uint8_t>(active.getRotation());
+    for (int i = 0; i < PreviewSize; ++i)
+    {
+        snapshot.preview[i] = static_cast<std::uint8_t>(game.getPreview(i));
+    }
+    snapshot.gameOver = game.isGameOver() ? 1 : 0;
+
+    // the board has the active piece drawn in, the bot is sent the stack under it
+    PlacementSearch::Rows stack = PlacementSearch::ExtractStack(game);
+    for (int row = 0; row < MaxRows; ++row)
+    {
+        snapshot.rows[row] = row < Board::FixedHeight ? stack[row] : 0;
+    }
+    snapshot.published = Now();
+}
+
+std::int64_t BotLink::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
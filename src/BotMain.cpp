@@ -0,0 +1,219 @@
+/****************************************************************************
+Sample bot for the shared memory BotLink, and a headless game to test it with:
+  ./tetris_bot --host tetris --pieces 1000
+  ./tetris_bot --name tetris
+The bot drops each piece where the placement search's evaluation likes the
+stack best, looking at the active piece alone. The host plays every placement
+straight away and reports the round trip, from publishing a snapshot to
+receiving the answer. Run the bot alone against ./nglTetris --bot-link tetris
+to watch it play.
+****************************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BotLink.h"
+#include "PlacementSearch.h"
+
+namespace
+{
+    using Rows = PlacementSearch::Rows;
+    using Pieces = Board::Pieces;
+
+    // The bot's answer to a snapshot, the placement with the best stack after it.
+    BotLink::Command choose(const BotLink::Snapshot& snapshot)
+    {
+        const SearchWeights weights;
+        Rows stack{};
+        for (int row = 0; row < Board::FixedHeight; ++row)
+        {
+            stack[row] = static_cast<Board::RowMask>(snapshot.rows[row]);
+        }
+        BotLink::Command command;
+        command.pieces = snapshot.pieces;
+        command.published = snapshot.published;
+        int best = PlacementSearch::LossScore;
+        for (int rotation = 0; rotation < Pieces::Rotations; ++rotation)
+        {
+            for (int x = 1 - Pieces::Size; x < Board::FixedWidth; ++x)
+            {
+                // the same drop the searches use, so the bot plays by the game's placement rules
+                Rows rows = stack;
+                int lines = PlacementSearch::Drop(rows, snapshot.piece, rotation, x);
+                if (lines < 0)
+                {
+                    continue;
+                }
+                int score = lines * weights.lines + PlacementSearch::Evaluate(rows, weights);
+                if (score > best)
+                {
+                    best = score;
+                    command.rotation = rotation;
+                    command.x = x;
+                }
+            }
+        }
+        return command;
+    }
+
+    // Answers snapshots until the game is over.
+    int runBot(const std::string& name)
+    {
+        BotLink link;
+        auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (!link.Open(name))
+        {
+            if (std::chrono::steady_clock::now() > giveUp)
+            {
+                std::cerr << "no game has created " << name << "\n";
+                return EXIT_FAILURE;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        // spin on the sequence, yielding so a game on the same core still gets to run
+        std::uint32_t seen = 0;
+        int answered = -1;
+        BotLink::Snapshot snapshot;
+        for (;;)
+        {
+            std::uint32_t sequence = link.getSequence();
+            if (sequence == seen || (sequence & 1))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            seen = link.Read(snapshot);
+            if (snapshot.gameOver)
+            {
+                std::cout << "game over after " << snapshot.pieces << " pieces, " << snapshot.lines << " lines\n";
+                return EXIT_SUCCESS;
+            }
+            if (snapshot.pieces != answered && snapshot.piece != 0)
+            {
+                answered = snapshot.pieces;
+                while (!link.Submit(choose(snapshot)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    // Buttons that bring the active piece to a placement, one press at a time since buttons act when they go down.
+    InputFrame inputFor(const Game& game, const BotLink::Command& target, InputFrame last)
+    {
+        const Tetromino& piece = game.getTetromino();
+        InputFrame input = InputDown;
+        if (piece.getRotation() != target.rotation)
+        {
+            input = InputRotate;
+        }
+        else if (piece.GetX() > target.x)
+        {
+            input = InputLeft;
+        }
+        else if (piece.GetX() < target.x)
+        {
+            input = InputRight;
+        }
+        return input == last ? 0 : input;
+    }
+
+    // Plays a game on the bot's placements as fast as they come and times the round trips.
+    int runHost(const std::string& name, int pieces, unsigned int seed)
+    {
+        BotLink link;
+        if (!link.Create(name))
+        {
+            std::cerr << "could not create " << name << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "waiting for a bot on " << name << "\n";
+
+        Game game(Board(), seed);
+        std::uint64_t frame = 0;
+        std::vector<double> roundTrips;
+        roundTrips.reserve(static_cast<std::size_t>(pieces));
+        BotLink::Snapshot snapshot;
+        InputFrame last = 0;
+        while (!game.isGameOver() && game.getPieces() < pieces)
+        {
+            BotLink::Capture(game, frame, snapshot);
+            link.Publish(snapshot);
+
+            // the first answer waits for the bot to start and isn't timed, later ones should take microseconds
+            BotLink::Command command;
+            auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(game.getPieces() == 0 ? 30 : 5);
+            bool answered = false;
+            while (!answered)
+            {
+                if (!link.Receive(command))
+                {
+                    if (std::chrono::steady_clock::now() > giveUp)
+                    {
+                        std::cerr << "the bot stopped answering\n";
+                        return EXIT_FAILURE;
+                    }
+                    std::this_thread::yield();
+                    continue;
+                }
+                answered = command.pieces == game.getPieces();
+            }
+            if (game.getPieces() > 0)
+            {
+                roundTrips.push_back(static_cast<double>(BotLink::Now() - command.published) / 1000.0);
+            }
+
+            int placed = game.getPieces();
+            while (!game.isGameOver() && game.getPieces() == placed)
+            {
+                last = inputFor(game, command, last);
+                game.Step(last);
+                ++frame;
+            }
+        }
+
+        // a snapshot marked over tells the bot to stop
+        BotLink::Capture(game, frame, snapshot);
+        snapshot.gameOver = 1;
+        link.Publish(snapshot);
+
+        std::sort(roundTrips.begin(), roundTrips.end());
+        auto percentile = [&](double p)
+        {
+            return roundTrips.empty() ? 0.0 : roundTrips[static_cast<std::size_t>(p * (roundTrips.size() - 1))];
+        };
+        std::cout << game.getPieces() << " pieces, " << game.getLines() << " lines" << (game.isGameOver() ? ", game over" : "")
+                  << "\nround trip us   median " << percentile(0.5) << ", 99% " << percentile(0.99) << ", max "
+                  << percentile(1.0) << "\n";
+        return EXIT_SUCCESS;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string name = "tetris";
+    bool host = false;
+    int pieces = 1000;
+    unsigned int seed = 1;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--host")
+        {
+            host = true;
+            name = value;
+        }
+        else if (arg == "--name") name = value;
+        else if (arg == "--pieces") pieces = std::stoi(value);
+        else if (arg == "--seed") seed = static_cast<unsigned int>(std::stoi(value));
+        else continue;
+        ++i;
+    }
+    return host ? runHost(name, pieces, seed) : runBot(name);
+}
@@ -0,0 +1,242 @@
+#include "ChunkedBoard.h"
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+
+ChunkedBoard::ChunkedBoard(int width, int height)
+    : _width(width), _height(height), _across((width + ChunkSize - 1) / ChunkSize),
+      _down((height + ChunkSize - 1) / ChunkSize),
+      _chunks(static_cast<std::size_t>(_across) * _down)
+{
+    assert(width > 0 && height > 0);
+}
+
+bool ChunkedBoard::IsBlocked(int row, int col) const
+{
+    if (row < 0 || row >= _height || col < 0 || col >= _width)
+    {
+        return true;
+    }
+    const Chunk* chunk = getChunk(col / ChunkSize, row / ChunkSize);
+    return chunk && (chunk->rows[row % ChunkSize] >> (col % ChunkSize) & 1);
+}
+
+int ChunkedBoard::getPaletteIndex(int row, int col) const
+{
+    const Chunk* chunk = getChunk(col / ChunkSize, row / ChunkSize);
+    if (!chunk)
+    {
+        return 0;
+    }
+    int i = row % ChunkSize;
+    int bit = col % ChunkSize;
+    return static_cast<int>((chunk->palette[0][i] >> bit & 1) | (chunk->palette[1][i] >> bit & 1) << 1 |
+                            (chunk->palette[2][i] >> bit & 1) << 2);
+}
+
+std::uint64_t ChunkedBoard::FullChunkRow(int x) const
+{
+    int columns = _width - x * ChunkSize;
+    return columns >= ChunkSize ? ~0ull : (1ull << columns) - 1;
+}
+
+void ChunkedBoard::SetChunkRow(int x, int row, std::uint64_t bits, const std::array<std::uint64_t, PaletteBits>& palette)
+{
+    int y = row / ChunkSize;
+    int i = row % ChunkSize;
+    std::unique_ptr<Chunk>& chunk = _chunks[static_cast<std::size_t>(y) * _across + x];
+    if (!chunk)
+    {
+        if (bits == 0)
+        {
+            return;
+        }
+        chunk = std::make_unique<Chunk>();
+        chunk->x = x;
+        chunk->y = y;
+        chunk->slot = static_cast<int>(_occupied.size());
+        _occupied.push_back(chunk.get());
+    }
+    else if (chunk->rows[i] == bits && chunk->palette[0][i] == (palette[0] & bits) &&
+             chunk->palette[1][i] == (palette[1] & bits) && chunk->palette[2][i] == (palette[2] & bits))
+    {
+        return;
+    }
+    chunk->occupied += static_cast<int>(std::bitset<64>(bits).count()) -
+                       static_cast<int>(std::bitset<64>(chunk->rows[i]).count());
+    chunk->rows[i] = bits;
+    for (int bit = 0; bit < PaletteBits; ++bit)
+    {
+        chunk->palette[bit][i] = palette[bit] & bits;
+    }
+    chunk->revision = ++_revision;
+    if (chunk->occupied == 0)
+    {
+        // the last tile in the list takes the freed one's slot
+        Chunk* last = _occupied.back();
+        last->slot = chunk->slot;
+        _occupied[last->slot] = last;
+        _occupied.pop_back();
+        chunk.reset();
+    }
+}
+
+void ChunkedBoard::SetCell(int row, int col, int palette)
+{
+    int x = col / ChunkSize;
+    std::uint64_t bit = 1ull << (col % ChunkSize);
+    const Chunk* chunk = getChunk(x, row / ChunkSize);
+    std::uint64_t bits = bit;
+    std::array<std::uint64_t, PaletteBits> planes{};
+    if (chunk)
+    {
+        int i = row % ChunkSize;
+        bits |= chunk->rows[i];
+        for (int plane = 0; plane < PaletteBits; ++plane)
+        {
+            planes[plane] = chunk->palette[plane][i] & ~bit;
+        }
+    }
+    for (int plane = 0; plane < PaletteBits; ++plane)
+    {
+        planes[plane] |= (palette >> plane & 1) ? bit : 0;
+    }
+    SetChunkRow(x, row, bits, planes);
+}
+
+void ChunkedBoard::ClearCell(int row, int col)
+{
+    int x = col / ChunkSize;
+    const Chunk* chunk = getChunk(x, row / ChunkSize);
+    if (!chunk)
+    {
+        return;
+    }
+    int i = row % ChunkSize;
+    std::array<std::uint64_t, PaletteBits> planes{};
+    for (int plane = 0; plane < PaletteBits; ++plane)
+    {
+        planes[plane] = chunk->palette[plane][i];
+    }
+    SetChunkRow(x, row, chunk->rows[i] & ~(1ull << (col % ChunkSize)), planes);
+}
+
+bool ChunkedBoard::Overlaps(const Tetromino& tetromino) const
+{
+    const auto& shape = StandardTetrominoes::getShape(tetromino.getType(), tetromino.getRotation());
+    for (int i = 0; i < StandardTetrominoes::Size; ++i)
+    {
+        for (int j = 0; j < StandardTetrominoes::Size; ++j)
+        {
+            if ((shape[i] >> j & 1) && IsBlocked(tetromino.GetY() + i, tetromino.GetX() + j))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ChunkedBoard::Place(const Tetromino& tetromino)
+{
+    const auto& shape = StandardTetrominoes::getShape(tetromino.getType(), tetromino.getRotation());
+    for (int i = 0; i < StandardTetrominoes::Size; ++i)
+    {
+        for (int j = 0; j < StandardTetrominoes::Size; ++j)
+        {
+            if (shape[i] >> j & 1)
+            {
+                SetCell(tetromino.GetY() + i, tetromino.GetX() + j, tetromino.getPaletteIndex());
+            }
+        }
+    }
+}
+
+int ChunkedBoard::ClearFullRows(int bottom, int top)
+{
+    bottom = std::max(bottom, 0);
+    top = std::min(top, _height - 1);
+    auto full = [this](int row)
+    {
+        for (int x = 0; x < _across; ++x)
+        {
+            const Chunk* chunk = getChunk(x, row / ChunkSize);
+            if (!chunk || chunk->rows[row % ChunkSize] != FullChunkRow(x))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    int first = bottom;
+    while (first <= top && !full(first))
+    {
+        ++first;
+    }
+    if (first > top)
+    {
+        return 0;
+    }
+
+    std::vector<int> clearedRows;
+    for (int row = first; row <= top; ++row)
+    {
+        if (full(row))
+        {
+            clearedRows.push_back(row);
+        }
+    }
+    auto source = [&clearedRows](int row)
+    {
+        for (int clearedRow : clearedRows)
+        {
+            row += clearedRow <= row;
+        }
+        return row;
+    };
+
+    // only tile columns with a tile at or above the first cleared row move, each up to its highest tile
+    std::vector<int> columnTop(static_cast<std::size_t>(_across), -1);
+    std::vector<int> columns;
+    for (const Chunk* chunk : _occupied)
+    {
+        if (chunk->y >= first / ChunkSize)
+        {
+            if (columnTop[chunk->x] < 0)
+            {
+                columns.push_back(chunk->x);
+            }
+            columnTop[chunk->x] = std::max(columnTop[chunk->x], chunk->y);
+        }
+    }
+
+    // copy every kept row down over the cleared ones, a tile column at a time; past the cleared
+    // rows the shift is fixed, so tile rows with nothing on either side are skipped whole
+    std::array<std::uint64_t, PaletteBits> empty{};
+    for (int x : columns)
+    {
+        int end = std::min((columnTop[x] + 1) * ChunkSize, _height);
+        for (int row = first; row < end;)
+        {
+            int from = source(row);
+            const Chunk* to = getChunk(x, row / ChunkSize);
+            const Chunk* chunk = from < end ? getChunk(x, from / ChunkSize) : nullptr;
+            if (!to && !chunk && from > top)
+            {
+                row += std::min(ChunkSize - row % ChunkSize, ChunkSize - from % ChunkSize);
+                continue;
+            }
+            if (chunk)
+            {
+                int i = from % ChunkSize;
+                SetChunkRow(x, row, chunk->rows[i], {chunk->palette[0][i], chunk->palette[1][i], chunk->palette[2][i]});
+            }
+            else
+            {
+                SetChunkRow(x, row, 0, empty);
+            }
+            ++row;
+        }
+    }
+    return static_cast<int>(clearedRows.size());
+}
@@ -0,0 +1,105 @@
+#include "ChunkedCubes.h"
+#include <ngl/Vec4.h>
+#include <iterator>
+
+namespace
+{
+  // Whether a box is entirely outside one of the frustum's planes, testing its corners in clip space
+  bool outsideFrustum(const ngl::Mat4 &_mvp, const ngl::Vec3 &_low, const ngl::Vec3 &_high)
+  {
+    int outside[6] = {0, 0, 0, 0, 0, 0};
+    for (int corner = 0; corner < 8; ++corner)
+    {
+      ngl::Vec4 p = _mvp * ngl::Vec4((corner & 1) ? _high.m_x : _low.m_x, (corner & 2) ? _high.m_y : _low.m_y,
+                                     (corner & 4) ? _high.m_z : _low.m_z, 1.0f);
+      outside[0] += p.m_x < -p.m_w;
+      outside[1] += p.m_x > p.m_w;
+      outside[2] += p.m_y < -p.m_w;
+      outside[3] += p.m_y > p.m_w;
+      outside[4] += p.m_z < -p.m_w;
+      outside[5] += p.m_z > p.m_w;
+    }
+    for (int plane : outside)
+    {
+      if (plane == 8)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::uint64_t chunkKey(const ChunkedBoard::Chunk &_chunk)
+  {
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_chunk.y)) << 32 |
+           static_cast<std::uint32_t>(_chunk.x);
+  }
+}
+
+void ChunkedCubes::draw(const ChunkedBoard &_board, const ngl::Vec3 &_origin, const ngl::Vec3 &_boardOffset,
+                        const ngl::Mat4 &_mvp)
+{
+  ++m_draws;
+  m_visible = 0;
+  m_uploads = 0;
+  constexpr float Size = static_cast<float>(ChunkedBoard::ChunkSize);
+  for (int index = 0; index < _board.getChunkCount(); ++index)
+  {
+    const ChunkedBoard::Chunk &chunk = _board.getOccupiedChunk(index);
+    Buffer &buffer = m_buffers[chunkKey(chunk)];
+    buffer.seen = m_draws;
+    // cube centres are on whole cells, so a tile spans half a cell either side of its cells
+    ngl::Vec3 low = _origin + _boardOffset + ngl::Vec3(chunk.x * Size - 0.5f, chunk.y * Size - 0.5f, -0.5f);
+    ngl::Vec3 high = low + ngl::Vec3(Size, Size, 1.0f);
+    if (outsideFrustum(_mvp, low, high))
+    {
+      continue;
+    }
+    if (buffer.revision != chunk.revision)
+    {
+      upload(chunk, _origin, buffer);
+      ++m_uploads;
+    }
+    buffer.cubes->draw();
+    ++m_visible;
+  }
+
+  // tiles the board freed since the last draw take their buffers with them
+  if (m_buffers.size() > static_cast<std::size_t>(_board.getChunkCount()))
+  {
+    for (auto it = m_buffers.begin(); it != m_buffers.end();)
+    {
+      it = it->second.seen == m_draws ? std::next(it) : m_buffers.erase(it);
+    }
+  }
+}
+
+void ChunkedCubes::upload(const ChunkedBoard::Chunk &_chunk, const ngl::Vec3 &_origin, Buffer &_buffer)
+{
+  if (!_buffer.cubes)
+  {
+    _buffer.cubes = std::make_unique<InstancedCubes>();
+    _buffer.cubes->initialize();
+    m_scratch.reserve(ChunkedBoard::ChunkSize * ChunkedBoard::ChunkSize);
+  }
+  m_scratch.clear();
+  int left = _chunk.x * ChunkedBoard::ChunkSize;
+  int bottom = _chunk.y * ChunkedBoard::ChunkSize;
+  for (int i = 0; i < ChunkedBoard::ChunkSize; ++i)
+  {
+    // stop at the row's highest cube, most tile rows of a sparse board are empty or short
+    std::uint64_t bits = _chunk.rows[i];
+    for (int j = 0; j < ChunkedBoard::ChunkSize && (bits >> j) != 0; ++j)
+    {
+      if (bits >> j & 1)
+      {
+        int palette = static_cast<int>((_chunk.palette[0][i] >> j & 1) | (_chunk.palette[1][i] >> j & 1) << 1 |
+                                       (_chunk.palette[2][i] >> j & 1) << 2);
+        ngl::Vec3 pos = _origin + ngl::Vec3(static_cast<float>(left + j), static_cast<float>(bottom + i), 0.0f);
+        m_scratch.emplace_back(pos, palette);
+      }
+    }
+  }
+  _buffer.cubes->upload(m_scratch.data(), m_scratch.size());
+  _buffer.revision = _chunk.revision;
+}
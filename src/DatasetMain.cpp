@@ -0,0 +1,215 @@
+/****************************************************************************
+Writes training samples from games played by the placement search, or reads
+them back, e.g.
+  ./tetris_dataset --out data/run --games 10000 --threads 8 --pieces 500
+  ./tetris_dataset --read --samples 10000000 data/run-*.tds
+Writing plays the games on every thread, each with its own DatasetWriter and
+shards named PREFIX-tT-NNNNN.tds, and reports samples per second overall and
+for the writers alone. Reading maps the shards and draws uniform random
+samples through zero-copy views, reporting samples per second and a few
+averages so a bad export shows.
+****************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DatasetShard.h"
+#include "PlacementSearch.h"
+#include "WorkerPool.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Plays one game, recording every placement; returns the seconds spent in the writer.
+    double playGame(PlacementSearch& search, DatasetWriter& writer, unsigned int seed, int pieces, int depth, std::mt19937& random,
+                    double explore)
+    {
+        double writing = 0.0;
+        Game game(Board(), seed);
+        std::uniform_real_distribution<double> chance(0.0, 1.0);
+        while (!game.isGameOver() && game.getPieces() < pieces)
+        {
+            PlacementSearch::Placement target = search.FindBest(game, depth);
+            if (!target.valid)
+            {
+                break;
+            }
+
+            // an occasional random placement puts stacks the search would avoid into the data
+            if (explore > 0.0 && chance(random) < explore)
+            {
+                target.rotation = static_cast<int>(random() % Board::Pieces::Rotations);
+                target.x = static_cast<int>(random() % Board::FixedWidth);
+            }
+
+            // turn and shift at the spawn row, then drop until it locks, as the tuner plays; a turn or
+            // shift can be blocked, so the sample records where the piece really drops from
+            for (int turns = 0; game.getTetromino().getRotation() != target.rotation && turns < Board::Pieces::Rotations; ++turns)
+            {
+                game.Rotate();
+            }
+            while (game.getTetromino().GetX() > target.x && !game.Move(2))
+            {
+            }
+            while (game.getTetromino().GetX() < target.x && !game.Move(3))
+            {
+            }
+            auto start = Clock::now();
+            writer.Add(game, game.getTetromino().getRotation(), game.getTetromino().GetX());
+            writing += std::chrono::duration<double>(Clock::now() - start).count();
+            while (!game.isGameOver() && !game.Tick())
+            {
+            }
+        }
+        auto start = Clock::now();
+        writer.EndGame(game);
+        return writing + std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    int write(const std::string& prefix, int games, int threads, int pieces, int depth, unsigned int seed, double explore,
+              std::uint64_t shardRecords)
+    {
+        std::vector<std::unique_ptr<DatasetWriter>> writers;
+        for (int t = 0; t < threads; ++t)
+        {
+            writers.push_back(std::make_unique<DatasetWriter>(prefix + "-t" + std::to_string(t), shardRecords));
+        }
+        std::vector<double> writing(static_cast<std::size_t>(threads), 0.0);
+
+        // one thread per slice, each with its own writer and search, games handed out one at a time
+        WorkerPool pool(threads);
+        std::atomic<int> next{0};
+        auto task = [&](int begin, int)
+        {
+            PlacementSearch search(nullptr, 1);
+            std::mt19937 random(static_cast<unsigned int>(ZobristMix(~static_cast<std::uint64_t>(seed) << 32 ^ begin)));
+            for (int game = next++; game < games; game = next++)
+            {
+                unsigned int gameSeed = static_cast<unsigned int>(ZobristMix(static_cast<std::uint64_t>(seed) << 32 ^ game));
+                writing[begin] += playGame(search, *writers[begin], gameSeed, pieces, depth, random, explore);
+            }
+            writers[begin]->Close();
+        };
+        auto start = Clock::now();
+        pool.Run(threads, task);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::uint64_t samples = 0;
+        std::size_t shards = 0;
+        double writerSeconds = 0.0;
+        for (int t = 0; t < threads; ++t)
+        {
+            samples += writers[t]->getRecordCount();
+            shards += writers[t]->getShards().size();
+            writerSeconds += writing[t];
+        }
+        std::cout << samples << " samples from " << games << " games in " << shards << " shards, "
+                  << samples * DatasetSample::RecordSize / (1024.0 * 1024.0) << " MiB\n"
+                  << "overall         " << samples / std::max(seconds, 1e-9) << " samples per second on " << threads << " threads\n"
+                  << "writers alone   " << samples / std::max(writerSeconds, 1e-9) << " samples per second per thread\n";
+        return EXIT_SUCCESS;
+    }
+
+    int read(const std::vector<std::string>& paths, long long samples, unsigned int seed)
+    {
+        DatasetReader reader;
+        for (const std::string& path : paths)
+        {
+            if (!reader.Add(path))
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        if (reader.getRecordCount() == 0)
+        {
+            std::cerr << "no samples in the shards\n";
+            return EXIT_FAILURE;
+        }
+
+        std::mt19937_64 random(seed);
+        long long filled = 0;
+        long long future = 0;
+        long long cleared = 0;
+        long long toppedOut = 0;
+        auto start = Clock::now();
+        for (long long i = 0; i < samples; ++i)
+        {
+            DatasetSample sample = reader.Sample(random);
+            for (int row = 0; row < Board::FixedHeight; ++row)
+            {
+                filled += __builtin_popcount(sample.getRow(row));
+            }
+            future += sample.getFutureLines();
+            cleared += sample.getLinesCleared();
+            toppedOut += sample.isToppedOut();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        double count = static_cast<double>(std::max(samples, 1ll));
+        std::cout << reader.getRecordCount() << " samples in " << paths.size() << " shards\n"
+                  << "random reads    " << samples / std::max(seconds, 1e-9) << " samples per second\n"
+                  << "filled cells    " << filled / count << " per board\n"
+                  << "rows cleared    " << cleared / count << " per placement, " << future / count << " still to come\n"
+                  << "topped out      " << toppedOut * 100.0 / count << "% of samples are from games that did\n";
+        return EXIT_SUCCESS;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string prefix = "dataset";
+    bool reading = false;
+    std::vector<std::string> paths;
+    int games = 100;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int pieces = 500;
+    int depth = 1;
+    unsigned int seed = 1;
+    double explore = 0.0;
+    long long samples = 1000000;
+    long long shardRecords = 1 << 22;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--read")
+        {
+            reading = true;
+            continue;
+        }
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            paths.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            break;
+        }
+        std::string value = argv[++i];
+        if (arg == "--out") prefix = value;
+        else if (arg == "--games") games = std::stoi(value);
+        else if (arg == "--threads") threads = std::stoi(value);
+        else if (arg == "--pieces") pieces = std::stoi(value);
+        else if (arg == "--depth") depth = std::stoi(value);
+        else if (arg == "--seed") seed = static_cast<unsigned int>(std::stoul(value));
+        else if (arg == "--explore") explore = std::stod(value);
+        else if (arg == "--samples") samples = std::stoll(value);
+        else if (arg == "--shard") shardRecords = std::stoll(value);
+    }
+    if (games < 1 || threads < 1 || pieces < 1 || depth < 1 || depth > PlacementSearch::MaxDepth || explore < 0.0 ||
+        explore > 1.0 || samples < 1 || shardRecords < 1 || (reading && paths.empty()))
+    {
+        std::cerr << "usage: tetris_dataset [--out PREFIX] [--games N] [--threads N] [--pieces N] [--depth 1-"
+                  << PlacementSearch::MaxDepth << "] [--seed N] [--explore 0-1] [--shard RECORDS]\n"
+                  << "       tetris_dataset --read [--samples N] [--seed N] SHARD...\n";
+        return EXIT_FAILURE;
+    }
+    return reading ? read(paths, samples, seed) : write(prefix, games, threads, pieces, depth, seed, explore,
+                                                        static_cast<std::uint64_t>(shardRecords));
+}
@@ -0,0 +1,276 @@
+#include "DatasetShard.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "BotLink.h"
+
+namespace
+{
+    constexpr char Magic[4] = {'T', 'D', 'S', '1'};
+    constexpr std::uint32_t Version = 1;
+
+    // Records gathered before each write to the shard file, 128 KiB.
+    constexpr std::size_t WriteRecords = 4096;
+
+    /// The header at the start of every shard, little endian like the records.
+    struct ShardHeader
+    {
+        char magic[4];              ///< "TDS1".
+        std::uint32_t version;      ///< Version.
+        std::uint32_t recordSize;   ///< DatasetSample::RecordSize.
+        std::uint16_t width;        ///< Board columns.
+        std::uint16_t height;       ///< Board rows.
+        std::uint64_t records;      ///< Records after the header.
+        std::uint64_t games;        ///< Games that ended in the shard.
+        std::uint8_t reserved[32];  ///< Zero.
+    };
+    static_assert(sizeof(ShardHeader) == 64, "The header is 64 bytes on disk");
+    static_assert(Board::FixedWidth * Board::FixedHeight <= 25 * 8 && Board::Pieces::Count < 8 && PreviewSize == 5,
+                  "The record layout is for the standard board and pieces");
+
+    ShardHeader makeHeader(std::uint64_t records, std::uint64_t games)
+    {
+        ShardHeader header{};
+        std::memcpy(header.magic, Magic, sizeof(Magic));
+        header.version = Version;
+        header.recordSize = DatasetSample::RecordSize;
+        header.width = Board::FixedWidth;
+        header.height = Board::FixedHeight;
+        header.records = records;
+        header.games = games;
+        return header;
+    }
+
+    std::string shardName(const std::string& prefix, int index)
+    {
+        char number[16];
+        std::snprintf(number, sizeof(number), "-%05d.tds", index);
+        return prefix + number;
+    }
+}
+
+DatasetWriter::DatasetWriter(const std::string& prefix, std::uint64_t shardRecords)
+    : _prefix(prefix), _shardRecords(std::max<std::uint64_t>(shardRecords, 1))
+{
+    _buffer.reserve(WriteRecords * DatasetSample::RecordSize);
+}
+
+DatasetWriter::~DatasetWriter()
+{
+    Close();
+}
+
+void DatasetWriter::Add(const Game& game, int rotation, int x)
+{
+    // the stack without the active piece, the way bots are shown it
+    BotLink::Snapshot snapshot;
+    BotLink::Capture(game, 0, snapshot);
+
+    _game.emplace_back();
+    Pending& pending = _game.back();
+    std::memset(pending.record, 0, sizeof(pending.record));
+    pending.lines = game.getLines();
+
+    std::uint8_t* out = pending.record;
+    std::uint64_t bits = 0;
+    int count = 0;
+    for (int row = 0; row < Board::FixedHeight; ++row)
+    {
+        bits |= snapshot.rows[row] << count;
+        count += Board::FixedWidth;
+        while (count >= 8)
+        {
+            *out++ = static_cast<std::uint8_t>(bits);
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+    if (count > 0)
+    {
+        *out = static_cast<std::uint8_t>(bits);
+    }
+
+    pending.record[25] = static_cast<std::uint8_t>(snapshot.piece | (rotation & 3) << 3);
+    pending.record[26] = static_cast<std::uint8_t>((x + 3) & 15);
+    unsigned int preview = 0;
+    for (int i = 0; i < PreviewSize; ++i)
+    {
+        preview |= (snapshot.preview[i] & 7u) << (i * 3);
+    }
+    pending.record[27] = static_cast<std::uint8_t>(preview);
+    pending.record[28] = static_cast<std::uint8_t>(preview >> 8);
+}
+
+bool DatasetWriter::EndGame(const Game& game)
+{
+    const int lines = game.getLines();
+    const bool toppedOut = game.isGameOver();
+    for (std::size_t i = 0; i < _game.size(); ++i)
+    {
+        Pending& pending = _game[i];
+        int next = i + 1 < _game.size() ? _game[i + 1].lines : lines;
+        int future = std::min(lines - pending.lines, (1 << 24) - 1);
+        pending.record[25] = static_cast<std::uint8_t>(pending.record[25] | std::min(next - pending.lines, 7) << 5);
+        pending.record[26] = static_cast<std::uint8_t>(pending.record[26] | (toppedOut ? 16 : 0));
+        pending.record[29] = static_cast<std::uint8_t>(future);
+        pending.record[30] = static_cast<std::uint8_t>(future >> 8);
+        pending.record[31] = static_cast<std::uint8_t>(future >> 16);
+        _buffer.insert(_buffer.end(), pending.record, pending.record + DatasetSample::RecordSize);
+        ++_records;
+
+        // a game counts in the shard its last sample lands in, a full shard is finished at once
+        _games += i + 1 == _game.size();
+        if (++_inShard == _shardRecords)
+        {
+            if (!Close())
+            {
+                break;
+            }
+        }
+        else if (_buffer.size() >= WriteRecords * DatasetSample::RecordSize)
+        {
+            Flush();
+        }
+    }
+    _game.clear();
+    return !_failed;
+}
+
+bool DatasetWriter::Flush()
+{
+    if (_buffer.empty() || _failed)
+    {
+        _buffer.clear();
+        return !_failed;
+    }
+    if (!_file)
+    {
+        _file = std::fopen((shardName(_prefix, _shardIndex) + ".tmp").c_str(), "wb");
+        ShardHeader header = makeHeader(0, 0);
+        if (!_file || std::fwrite(&header, sizeof(header), 1, _file) != 1)
+        {
+            std::cerr << shardName(_prefix, _shardIndex) << ": cannot write\n";
+            _failed = true;
+            _buffer.clear();
+            return false;
+        }
+    }
+    _failed = std::fwrite(_buffer.data(), 1, _buffer.size(), _file) != _buffer.size();
+    _buffer.clear();
+    return !_failed;
+}
+
+bool DatasetWriter::Close()
+{
+    Flush();
+    if (!_file)
+    {
+        return !_failed;
+    }
+
+    // the count goes in last, then the finished shard takes its real name
+    ShardHeader header = makeHeader(_inShard, _games);
+    std::string name = shardName(_prefix, _shardIndex);
+    std::string temporary = name + ".tmp";
+    _failed = _failed || std::fseek(_file, 0, SEEK_SET) != 0 || std::fwrite(&header, sizeof(header), 1, _file) != 1;
+    _failed = std::fclose(_file) != 0 || _failed;
+    _file = nullptr;
+    if (_failed || std::rename(temporary.c_str(), name.c_str()) != 0)
+    {
+        // a shard that failed part way is removed rather than left for a later run to trip over
+        std::remove(temporary.c_str());
+        std::cerr << name << ": cannot write\n";
+        _failed = true;
+        return false;
+    }
+    _shards.push_back(name);
+    ++_shardIndex;
+    _inShard = 0;
+    _games = 0;
+    return true;
+}
+
+DatasetShard::~DatasetShard()
+{
+    if (_mapping)
+    {
+        munmap(_mapping, _size);
+    }
+}
+
+bool DatasetShard::Open(const std::string& path)
+{
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        std::cerr << path << ": cannot open shard\n";
+        return false;
+    }
+    struct stat info{};
+    if (fstat(descriptor, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(ShardHeader))
+    {
+        close(descriptor);
+        std::cerr << path << ": not a shard\n";
+        return false;
+    }
+    _size = static_cast<std::size_t>(info.st_size);
+    void* memory = mmap(nullptr, _size, PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (memory == MAP_FAILED)
+    {
+        std::cerr << path << ": cannot map shard\n";
+        return false;
+    }
+    _mapping = memory;
+
+    ShardHeader header;
+    std::memcpy(&header, _mapping, sizeof(header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version ||
+        header.recordSize != DatasetSample::RecordSize || header.width != Board::FixedWidth ||
+        header.height != Board::FixedHeight)
+    {
+        std::cerr << path << ": not a shard of this format\n";
+        return false;
+    }
+    if (header.records > (_size - sizeof(ShardHeader)) / DatasetSample::RecordSize)
+    {
+        std::cerr << path << ": truncated, " << header.records << " records in the header\n";
+        return false;
+    }
+
+    // sampling jumps all over the file, read ahead would only fetch pages nobody asked for
+    madvise(_mapping, _size, MADV_RANDOM);
+    _records = static_cast<const std::uint8_t*>(_mapping) + sizeof(ShardHeader);
+    _count = header.records;
+    _gameCount = header.games;
+    return true;
+}
+
+bool DatasetReader::Add(const std::string& path)
+{
+    auto shard = std::make_unique<DatasetShard>();
+    if (!shard->Open(path))
+    {
+        return false;
+    }
+    if (_starts.empty())
+    {
+        _starts.push_back(0);
+    }
+    _starts.push_back(_starts.back() + shard->getRecordCount());
+    _shards.push_back(std::move(shard));
+    return true;
+}
+
+DatasetSample DatasetReader::operator[](std::uint64_t index) const
+{
+    // the last shard starting at or before the index
+    auto start = std::upper_bound(_starts.begin(), _starts.end(), index) - 1;
+    std::size_t shard = static_cast<std::size_t>(start - _starts.begin());
+    return (*_shards[shard])[index - *start];
+}
@@ -0,0 +1,84 @@
+/****************************************************************************
+Throughput benchmark for the reinforcement learning environment, e.g.
+  ./tetris_envbench --envs 4096 --threads 8 --steps 2000
+Steps every environment with random actions and reports env-steps per second.
+****************************************************************************/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AllocationCounter.h"
+#include "TetrisVecEnv.h"
+
+int main(int argc, char** argv)
+{
+    int envs = 4096;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int steps = 2000;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        int value = std::stoi(argv[i + 1]);
+        if (arg == "--envs") envs = value;
+        else if (arg == "--threads") threads = value;
+        else if (arg == "--steps") steps = value;
+        else continue;
+        ++i;
+    }
+    if (envs <= 0 || steps <= 0)
+    {
+        std::cerr << "usage: tetris_envbench [--envs N] [--threads N] [--steps N]\n";
+        return EXIT_FAILURE;
+    }
+
+    // actions are drawn up front so the timing only covers the environments
+    constexpr int ActionFrames = 64;
+    std::vector<std::uint8_t> actions(static_cast<std::size_t>(envs) * ActionFrames);
+    std::minstd_rand random(1);
+    for (auto& action : actions)
+    {
+        action = static_cast<std::uint8_t>(random() & 15);
+    }
+
+    std::vector<std::uint32_t> seeds(envs);
+    for (int i = 0; i < envs; ++i)
+    {
+        seeds[i] = static_cast<std::uint32_t>(i);
+    }
+    std::vector<std::uint8_t> observations(static_cast<std::size_t>(envs) * TETRIS_ENV_OBSERVATION_SIZE);
+    std::vector<float> rewards(envs);
+    std::vector<std::uint8_t> dones(envs);
+
+    TetrisVecEnv* env = tetris_vec_env_create(envs, threads);
+    tetris_vec_env_reset(env, seeds.data(), observations.data());
+
+    long long episodes = 0;
+    double reward = 0.0;
+    long long allocations = AllocationCounter::getCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; ++step)
+    {
+        const std::uint8_t* frame = actions.data() + static_cast<std::size_t>(step % ActionFrames) * envs;
+        tetris_vec_env_step(env, frame, observations.data(), rewards.data(), dones.data());
+        // touch the outputs like a trainer would, it also keeps the loop from being optimised away
+        episodes += dones[step % envs];
+        reward += rewards[step % envs];
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    allocations = AllocationCounter::getCount() - allocations;
+    tetris_vec_env_destroy(env);
+
+    double total = static_cast<double>(envs) * steps;
+    std::cout << envs << " envs x " << steps << " steps on " << threads << " threads\n"
+              << "env-steps/sec   " << total / seconds << "\n"
+              << "ns per env-step " << seconds * 1.0e9 / total << " (per thread " << seconds * 1.0e9 * threads / total << ")\n"
+              << "sampled episodes ended " << episodes << ", sampled reward " << reward << "\n";
+    if (AllocationCounter::isEnabled())
+    {
+        std::cout << "heap allocations while stepping " << allocations << "\n";
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,34 @@
+#include "FrameArena.h"
+
+FrameArena::FrameArena(std::size_t _bytes)
+    : m_block(std::make_unique<unsigned char[]>(_bytes)), m_capacity(_bytes)
+{
+}
+
+void *FrameArena::allocateBytes(std::size_t _bytes, std::size_t _align)
+{
+    std::size_t start = (m_used + _align - 1) & ~(_align - 1);
+    if (start + _bytes <= m_capacity)
+    {
+        m_used = start + _bytes;
+        return m_block.get() + start;
+    }
+
+    // spill into a block of its own, new[] storage suits any fundamental alignment
+    m_overflow.push_back(std::make_unique<unsigned char[]>(_bytes));
+    m_spilled += _bytes + _align;
+    return m_overflow.back().get();
+}
+
+void FrameArena::reset()
+{
+    if (!m_overflow.empty())
+    {
+        // one block for the whole of the largest frame so far, with headroom for it to grow
+        m_capacity = (m_capacity + m_spilled) * 2;
+        m_block = std::make_unique<unsigned char[]>(m_capacity);
+        m_overflow.clear();
+        m_spilled = 0;
+    }
+    m_used = 0;
+}
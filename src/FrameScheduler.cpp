@@ -0,0 +1,29 @@
+#include "FrameScheduler.h"
+
+FrameScheduler::FrameScheduler(std::function<void()> _requestFrame) : m_requestFrame(std::move(_requestFrame))
+{
+}
+
+void FrameScheduler::invalidate(RenderLayers _layers)
+{
+    if (_layers == 0)
+    {
+        return;
+    }
+    ++m_invalidations;
+    // only the first change since the last frame asks for one, the rest ride along
+    bool request = m_dirty == 0;
+    m_dirty |= _layers;
+    if (request)
+    {
+        m_requestFrame();
+    }
+}
+
+RenderLayers FrameScheduler::beginFrame()
+{
+    ++m_frames;
+    RenderLayers layers = m_dirty;
+    m_dirty = 0;
+    return layers;
+}
@@ -0,0 +1,411 @@
+#include "Game.h"
+#include <algorithm>
+#include <type_traits>
+
+namespace
+{
+    constexpr int OneRow = 1 << 16; // one row of gravity in 16.16 fixed point
+    constexpr int MaxRowsPerFrame = 20; // gravity cap, soft drop included
+
+    // Guideline gravity per level in rows per frame, 16.16 fixed point, see BasicGame::GravityPerFrame.
+    constexpr int gravityTable[] = {1092, 1377, 1768, 2311, 3075, 4169, 5759, 8107, 11634, 17026,
+                                    25416, 38709, 60169, 95483, 154742, 256187, 433425, 749597,
+                                    1310720, 1310720};
+}
+
+template <typename BoardType>
+BasicGame<BoardType>::BasicGame(const BoardType& board, unsigned int seed, int startLevel,
+                                const GameHandling& handling)
+    : _board(board), _pieceRandom(seed), _garbageRandom(seed ^ 0x9e3779b9u),
+      _level(std::clamp(startLevel, 1, MaxLevel)), _startLevel(_level), _handling(handling)
+{
+    for (auto& type : _preview)
+    {
+        type = NextPieceType();
+    }
+    SpawnTetromino();
+}
+
+template <typename BoardType>
+int BasicGame<BoardType>::GravityPerFrame(int level)
+{
+    return gravityTable[std::clamp(level, 1, MaxLevel) - 1];
+}
+
+template <typename BoardType>
+int BasicGame<BoardType>::ActionPoints(int lines, TSpin spin)
+{
+    static constexpr int points[3][5] = {
+        {0, 100, 300, 500, 800},       // single, double, triple, tetris
+        {100, 200, 400, 400, 400},     // mini T-spin
+        {400, 800, 1200, 1600, 1600}   // T-spin
+    };
+    return points[static_cast<int>(spin)][std::clamp(lines, 0, 4)];
+}
+
+template <typename BoardType>
+bool BasicGame<BoardType>::Step(InputFrame input)
+{
+    // rotate and down only act on the frame they go down
+    InputFrame pressed = input & ~_lastInput;
+    _lastInput = input;
+    if (_gameOver)
+    {
+        return false;
+    }
+
+    bool changed = false;
+    if ((pressed & InputRotate) && Rotate())
+    {
+        RestartLockDelay();
+        changed = true;
+    }
+
+    // the most recent of left and right shifts, falling back to the other if it's let go while both are held
+    InputFrame held = input & (InputLeft | InputRight);
+    if (pressed & held)
+    {
+        _shiftButton = (pressed & held) == (InputLeft | InputRight) ? InputFrame(InputLeft) : InputFrame(pressed & held);
+        _shiftFrames = 0;
+        changed |= Shift(_shiftButton);
+    }
+    else if (!(held & _shiftButton))
+    {
+        _shiftButton = held == (InputLeft | InputRight) ? InputFrame(InputLeft) : held;
+        _shiftFrames = 0;
+    }
+    else if (++_shiftFrames >= _handling.das)
+    {
+        // auto shift, every arr frames once the delay is up or straight to the wall with no arr
+        int repeat = _shiftFrames - _handling.das;
+        if (_handling.arr <= 0)
+        {
+            while (Shift(_shiftButton))
+            {
+                changed = true;
+            }
+        }
+        else if (repeat % _handling.arr == 0)
+        {
+            changed |= Shift(_shiftButton);
+        }
+    }
+
+    if ((pressed & InputDown) && !Move(1))
+    {
+        // soft drop scores a point per row
+        _score++;
+        changed = true;
+    }
+
+    // gravity can pull several rows a frame at high levels, holding down speeds it up
+    bool softDrop = (input & InputDown) != 0;
+    int gravity = GravityPerFrame(_level);
+    if (softDrop)
+    {
+        gravity = std::min(gravity * std::max(_handling.softDropFactor, 1), MaxRowsPerFrame * OneRow);
+    }
+    _gravityProgress += gravity;
+    while (_gravityProgress >= OneRow && !_board.IsCollision(_tetromino, 1, 0, 0))
+    {
+        _gravityProgress -= OneRow;
+        Move(1);
+        _score += softDrop;
+        changed = true;
+    }
+
+    // a resting piece locks once it has rested for the lock delay, falling again if a move takes it off the edge
+    if (_board.IsCollision(_tetromino, 1, 0, 0))
+    {
+        _gravityProgress = 0;
+        if (++_lockFrames >= _handling.lockDelay)
+        {
+            Lock();
+            changed = true;
+        }
+    }
+    else
+    {
+        _lockFrames = 0;
+    }
+    return changed;
+}
+
+template <typename BoardType>
+bool BasicGame<BoardType>::Move(int direction)
+{
+    bool blocked = _board.MoveTetromino(_tetromino, direction);
+    if (!blocked)
+    {
+        _lastMoveRotate = false;
+    }
+    return blocked;
+}
+
+template <typename BoardType>
+bool BasicGame<BoardType>::Rotate()
+{
+    bool rotated = _board.RotateTetromino(_tetromino);
+    if (rotated)
+    {
+        _lastMoveRotate = true;
+    }
+    return rotated;
+}
+
+template <typename BoardType>
+bool BasicGame<BoardType>::Shift(InputFrame button)
+{
+    if (Move(button == InputLeft ? 2 : 3))
+    {
+        return false;
+    }
+    RestartLockDelay();
+    return true;
+}
+
+template <typename BoardType>
+void BasicGame<BoardType>::RestartLockDelay()
+{
+    if (_lockFrames > 0 && _lockResets < _handling.lockResets)
+    {
+        _lockFrames = 0;
+        _lockResets++;
+    }
+}
+
+template <typename BoardType>
+bool BasicGame<BoardType>::Tick()
+{
+    if (_gameOver)
+    {
+        return false;
+    }
+
+    // move tetromino down and check for collision
+    if (!_board.MoveTetromino(_tetromino, 1))
+    {
+        _lastMoveRotate = false;
+        return false;
+    }
+    Lock();
+    return true;
+}
+
+template <typename BoardType>
+void BasicGame<BoardType>::Lock()
+{
+    // the tetromino is already drawn where it landed, only its rows can have filled up
+    _lastSpin = DetectTSpin();
+    int bottom = _tetromino.GetY();
+    _lockedPiece = _tetromino;
+    _clearedRows = 0;
+    for (int i = 0; i < BoardType::Pieces::Size; ++i)
+    {
+        if (bottom + i >= 0 && bottom + i < _board.getHeight() && _board.IsRowFull(bottom + i))
+        {
+            _clearedRows |= 1u << i;
+        }
+    }
+    _linesCleared = _board.ClearFullRows(bottom, bottom + BoardType::Pieces::Size - 1);
+    ScoreLock(_linesCleared, _lastSpin);
+
+    // garbage only rises when the lock didn't clear anything
+    if (_linesCleared == 0 && _pendingGarbage > 0)
+    {
+        int hole = static_cast<int>(_garbageRandom() % _board.getWidth());
+        _gameOver = _board.AddGarbageRows(_pendingGarbage, hole);
+        _lockedPiece.SetPosition(_lockedPiece.GetX(), _lockedPiece.GetY() + _pendingGarbage);
+        _pendingGarbage = 0;
+    }
+
+    _pieces++;
+    if (!_gameOver)
+    {
+        SpawnTetromino();
+    }
+}
+
+template <typename BoardType>
+TSpin BasicGame<BoardType>::DetectTSpin() const
+{
+    if constexpr (!std::is_same_v<typename BoardType::Pieces, StandardTetrominoes>)
+    {
+        return TSpin::None;
+    }
+    else
+    {
+        if (!_lastMoveRotate || _tetromino.getType() != StandardTetrominoes::TBlock)
+        {
+            return TSpin::None;
+        }
+
+        // the T's centre is (1, 1) in its box in every rotation, check the four diagonal
+        // cells clockwise from top left; walls and floor count as filled
+        int x = _tetromino.GetX() + 1;
+        int y = _tetromino.GetY() + 1;
+        const bool corners[4] = {_board.IsBlocked(y + 1, x - 1), _board.IsBlocked(y + 1, x + 1),
+                                 _board.IsBlocked(y - 1, x + 1), _board.IsBlocked(y - 1, x - 1)};
+        int filled = corners[0] + corners[1] + corners[2] + corners[3];
+        if (filled < 3)
+        {
+            return TSpin::None;
+        }
+
+        // rotation 0 points up and each rotation turns a quarter clockwise,
+        // so the two corners the T points at start at the rotation index
+        int rotation = _tetromino.getRotation();
+        bool front = corners[rotation] && corners[(rotation + 1) % 4];
+        return front ? TSpin::Full : TSpin::Mini;
+    }
+}
+
+template <typename BoardType>
+void BasicGame<BoardType>::ScoreLock(int lines, TSpin spin)
+{
+    int points = ActionPoints(lines, spin) * _level;
+    if (lines > 0)
+    {
+        // tetrises and T-spin clears in a row are worth half as much again
+        bool difficult = lines >= 4 || spin != TSpin::None;
+        if (difficult && _backToBack)
+        {
+            points = points * 3 / 2;
+        }
+        _backToBack = difficult;
+
+        _combo++;
+        points += 50 * _combo * _level;
+
+        _lines += lines;
+        _level = std::min(MaxLevel, std::max(_level, _startLevel + _lines / LinesPerLevel));
+    }
+    else
+    {
+        // a lock without a clear breaks the combo but not back-to-back
+        _combo = -1;
+    }
+    _score += points;
+}
+
+template <typename BoardType>
+void BasicGame<BoardType>::AddGarbage(int lines)
+{
+    _pendingGarbage += lines;
+}
+
+template <typename BoardType>
+int BasicGame<BoardType>::CancelGarbage(int lines)
+{
+    int cancelled = std::min(lines, _pendingGarbage);
+    _pendingGarbage -= cancelled;
+    return lines - cancelled;
+}
+
+template <typename BoardType>
+void BasicGame<BoardType>::SpawnTetromino()
+{
+    // spawn the next piece near the top, roughly centred, and refill the preview
+    _tetromino = Tetromino(_preview[0], _board.getSpawnX(), _board.getSpawnY());
+    std::copy(_preview.begin() + 1, _preview.end(), _preview.begin());
+    _preview.back() = NextPieceType();
+    _lastMoveRotate = false;
+    _gravityProgress = 0;
+    _lockFrames = 0;
+    _lockResets = 0;
+
+    // block out, the new piece has nowhere to go
+    if (_board.Overlaps(_tetromino))
+    {
+        _gameOver = true;
+        return;
+    }
+    _board.UpdateTetrominoOnBoard(_tetromino);
+}
+
+template <typename BoardType>
+std::uint8_t BasicGame<BoardType>::NextPieceType()
+{
+    return static_cast<std::uint8_t>(_pieceRandom() % BoardType::Pieces::getCount() + 1);
+}
+
+template <typename BoardType>
+void BasicGame<BoardType>::SaveState(State& state) const
+{
+    state.board = _board;
+    state.tetromino = _tetromino;
+    state.preview = _preview;
+    state.pieceRandom = _pieceRandom;
+    state.garbageRandom = _garbageRandom;
+    state.linesCleared = _linesCleared;
+    state.pendingGarbage = _pendingGarbage;
+    state.gravityProgress = _gravityProgress;
+    state.pieces = _pieces;
+    state.score = _score;
+    state.lines = _lines;
+    state.level = _level;
+    state.startLevel = _startLevel;
+    state.combo = _combo;
+    state.backToBack = _backToBack;
+    state.gameOver = _gameOver;
+    state.lastMoveRotate = _lastMoveRotate;
+    state.lastSpin = _lastSpin;
+    state.lockedPiece = _lockedPiece;
+    state.clearedRows = _clearedRows;
+    state.lastInput = _lastInput;
+    state.shiftButton = _shiftButton;
+    state.shiftFrames = _shiftFrames;
+    state.lockFrames = _lockFrames;
+    state.lockResets = _lockResets;
+}
+
+template <typename BoardType>
+void BasicGame<BoardType>::LoadState(const State& state)
+{
+    _board = state.board;
+    _tetromino = state.tetromino;
+    _preview = state.preview;
+    _pieceRandom = state.pieceRandom;
+    _garbageRandom = state.garbageRandom;
+    _linesCleared = state.linesCleared;
+    _pendingGarbage = state.pendingGarbage;
+    _gravityProgress = state.gravityProgress;
+    _pieces = state.pieces;
+    _score = state.score;
+    _lines = state.lines;
+    _level = state.level;
+    _startLevel = state.startLevel;
+    _combo = state.combo;
+    _backToBack = state.backToBack;
+    _gameOver = state.gameOver;
+    _lastMoveRotate = state.lastMoveRotate;
+    _lastSpin = state.lastSpin;
+    _lockedPiece = state.lockedPiece;
+    _clearedRows = state.clearedRows;
+    _lastInput = state.lastInput;
+    _shiftButton = state.shiftButton;
+    _shiftFrames = state.shiftFrames;
+    _lockFrames = state.lockFrames;
+    _lockResets = state.lockResets;
+}
+
+template <typename BoardType>
+std::uint32_t BasicGame<BoardType>::Checksum() const
+{
+    // the board hash already covers the locked stack and the active piece drawn into it
+    std::uint32_t hash = _board.Checksum();
+    for (auto value : {_tetromino.GetX(), _tetromino.GetY(), _tetromino.getRotation(), _pendingGarbage,
+                       _gravityProgress, _pieces, _score, _lines, _level, _combo,
+                       int(_backToBack), int(_gameOver), int(_lastMoveRotate),
+                       int(_lastInput), int(_shiftButton), _shiftFrames, _lockFrames, _lockResets})
+    {
+        hash = (hash ^ static_cast<std::uint32_t>(value)) * 16777619u;
+    }
+    return hash;
+}
+
+template class BasicGame<Board>;
+template class BasicGame<TallBoard>;
+template class BasicGame<DynamicBoard>;
+template class BasicGame<PentominoBoard>;
+template class BasicGame<PolyominoBoard>;
@@ -0,0 +1,148 @@
+#include "InputTimeline.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr std::chrono::nanoseconds FrameTime{1000000000 / Game::FrameRate};
+}
+
+void LatencyHistogram::Add(std::chrono::nanoseconds duration)
+{
+    duration = std::max(duration, std::chrono::nanoseconds(0));
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    auto bucket = std::min<long long>(micros / BucketMicros, Buckets - 1);
+    _counts[static_cast<std::size_t>(bucket)]++;
+    _count++;
+    _max = std::max(_max, duration);
+}
+
+void LatencyHistogram::Clear()
+{
+    _counts.fill(0);
+    _count = 0;
+    _max = std::chrono::nanoseconds(0);
+}
+
+double LatencyHistogram::getPercentile(double fraction) const
+{
+    if (_count == 0)
+    {
+        return 0.0;
+    }
+    // the sample at this rank, counting from one
+    auto rank = std::max<long long>(1, static_cast<long long>(fraction * static_cast<double>(_count) + 0.5));
+    long long seen = 0;
+    for (int bucket = 0; bucket < Buckets; ++bucket)
+    {
+        seen += _counts[bucket];
+        if (seen >= rank)
+        {
+            return (bucket + 1) * BucketMicros * 1.0e-3;
+        }
+    }
+    return getMax();
+}
+
+InputTimeline::InputTimeline(int players, Clock::time_point start)
+    : _playerCount(std::clamp(players, 1, VersusMatch::MaxPlayers)), _start(start)
+{
+}
+
+void InputTimeline::Press(int player, InputFrame button, Clock::time_point time)
+{
+    Push(player, {time, button, true});
+}
+
+void InputTimeline::Release(int player, InputFrame button, Clock::time_point time)
+{
+    Push(player, {time, button, false});
+}
+
+void InputTimeline::Push(int player, const Event& event)
+{
+    if (player < 0 || player >= _playerCount)
+    {
+        return;
+    }
+    Player& state = _players[player];
+    if (state.size == EventCapacity)
+    {
+        _dropped++;
+        return;
+    }
+    state.events[(state.head + state.size) % EventCapacity] = event;
+    state.size++;
+}
+
+InputTimeline::Clock::time_point InputTimeline::FrameEnd(long long frame) const
+{
+    return _start + FrameTime * (frame + 1);
+}
+
+int InputTimeline::Advance(Clock::time_point now)
+{
+    if (now < FrameEnd(_frame))
+    {
+        return 0;
+    }
+    long long due = (now - _start) / FrameTime - _frame;
+    if (due > MaxCatchUp)
+    {
+        // the skipped frames' events fall into the first frame that is run
+        _skipped += due - MaxCatchUp;
+        _frame += due - MaxCatchUp;
+        due = MaxCatchUp;
+    }
+    return static_cast<int>(due);
+}
+
+void InputTimeline::NextFrame(InputFrame* inputs, Clock::time_point now)
+{
+    Clock::time_point end = FrameEnd(_frame);
+    for (int player = 0; player < _playerCount; ++player)
+    {
+        Player& state = _players[player];
+        InputFrame input = state.held;
+        InputFrame tapped = 0;
+        while (state.size > 0)
+        {
+            const Event& event = state.events[state.head];
+            if (event.time >= end)
+            {
+                break;
+            }
+            if (event.press)
+            {
+                // down last frame, or already tapped this one, would show no edge, so wait a frame
+                if (!(state.held & event.button) && ((state.last | tapped) & event.button))
+                {
+                    break;
+                }
+                state.held |= event.button;
+                tapped |= event.button;
+                input |= event.button;
+            }
+            else
+            {
+                // a tap released in the frame it went down still counts for that frame
+                state.held &= ~event.button;
+                input &= ~(event.button & ~tapped);
+            }
+            _quantisation.Add(end - event.time);
+            _processing.Add(now - end);
+            _total.Add(now - event.time);
+            state.head = (state.head + 1) % EventCapacity;
+            state.size--;
+        }
+        state.last = input;
+        inputs[player] = input;
+    }
+    _frame++;
+}
+
+void InputTimeline::ClearLatency()
+{
+    _quantisation.Clear();
+    _processing.Clear();
+    _total.Clear();
+}
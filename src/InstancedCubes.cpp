@@ -0,0 +1,99 @@
+#include "InstancedCubes.h"
+#include <array>
+#include <cstddef>
+#include <vector>
+
+InstancedCubes::~InstancedCubes()
+{
+    if (m_vao != 0)
+    {
+        glDeleteBuffers(1, &m_meshBuffer);
+        glDeleteBuffers(1, &m_instanceBuffer);
+        glDeleteVertexArrays(1, &m_vao);
+    }
+}
+
+void InstancedCubes::initialize()
+{
+    // unit cube centred on the origin, two triangles per face, position then normal
+    constexpr std::array<std::array<float, 3>, 6> normals =
+            {{{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}}};
+    std::vector<GLfloat> mesh;
+    mesh.reserve(6 * 6 * 6);
+    for (const auto &n : normals)
+    {
+        // two axes spanning the face with u x v = n, so the corners wind anticlockwise seen from outside
+        std::array<float, 3> u = {n[1], n[2], n[0]};
+        std::array<float, 3> v = {n[1] * u[2] - n[2] * u[1], n[2] * u[0] - n[0] * u[2], n[0] * u[1] - n[1] * u[0]};
+        constexpr std::array<std::array<float, 2>, 6> corners =
+                {{{-1, -1}, {1, -1}, {1, 1}, {-1, -1}, {1, 1}, {-1, 1}}};
+        for (const auto &c : corners)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                mesh.push_back(0.5f * (n[i] + c[0] * u[i] + c[1] * v[i]));
+            }
+            mesh.insert(mesh.end(), n.begin(), n.end());
+        }
+    }
+    m_vertexCount = static_cast<GLsizei>(mesh.size() / 6);
+
+    glGenVertexArrays(1, &m_vao);
+    glBindVertexArray(m_vao);
+
+    glGenBuffers(1, &m_meshBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_meshBuffer);
+    glBufferData(GL_ARRAY_BUFFER, mesh.size() * sizeof(GLfloat), mesh.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), nullptr);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
+                          reinterpret_cast<void *>(3 * sizeof(GLfloat)));
+
+    // per-instance attributes read straight from Cube, matching attributes 3 to 5 in PBRVertex.glsl;
+    // the palette and board bytes are converted to float indices
+    glGenBuffers(1, &m_instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Cube),
+                          reinterpret_cast<void *>(offsetof(Cube, m_pos)));
+    glVertexAttribDivisor(3, 1);
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 1, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(Cube),
+                          reinterpret_cast<void *>(offsetof(Cube, m_palette)));
+    glVertexAttribDivisor(4, 1);
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(5, 1, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(Cube),
+                          reinterpret_cast<void *>(offsetof(Cube, m_board)));
+    glVertexAttribDivisor(5, 1);
+
+    glBindVertexArray(0);
+}
+
+void InstancedCubes::upload(const Cube *_cubes, std::size_t _count)
+{
+    m_instanceCount = static_cast<GLsizei>(_count);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    if (_count > m_capacity)
+    {
+        // grow with headroom so a filling board doesn't reallocate every tick
+        m_capacity = _count * 2;
+        glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(Cube), nullptr, GL_DYNAMIC_DRAW);
+    }
+    if (_count > 0)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, _count * sizeof(Cube), _cubes);
+    }
+}
+
+void InstancedCubes::draw() const
+{
+    if (m_instanceCount == 0)
+    {
+        return;
+    }
+    glBindVertexArray(m_vao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, m_vertexCount, m_instanceCount);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,436 @@
+#include "MonteCarloSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+template <typename BoardType>
+BasicMonteCarloSearch<BoardType>::BasicMonteCarloSearch(int threads, std::size_t nodes, const SearchWeights& weights)
+    : _pool(std::make_unique<WorkerPool>(std::max(threads, 1))), _weights(weights)
+{
+    nodes = std::clamp<std::size_t>(nodes, MaxPlacements + 1, Expanding);
+    for (Pool& pool : _pools)
+    {
+        pool.nodes = std::make_unique<Node[]>(nodes);
+        pool.capacity = nodes;
+    }
+}
+
+template <typename BoardType>
+void BasicMonteCarloSearch<BoardType>::Reset()
+{
+    _root = Unexpanded;
+    _played = Unexpanded;
+    _rootPieces = -1;
+    for (Pool& pool : _pools)
+    {
+        pool.used = 0;
+    }
+}
+
+template <typename BoardType>
+std::uint32_t BasicMonteCarloSearch<BoardType>::Allocate(int count)
+{
+    Pool& pool = _pools[_active];
+    std::size_t first = pool.used.fetch_add(static_cast<std::size_t>(count), std::memory_order_relaxed);
+    if (first + static_cast<std::size_t>(count) > pool.capacity)
+    {
+        _full.store(true, std::memory_order_relaxed);
+        return Unexpanded;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        Node& node = pool.nodes[first + i];
+        node.total.store(0, std::memory_order_relaxed);
+        node.visits.store(0, std::memory_order_relaxed);
+        node.pending.store(0, std::memory_order_relaxed);
+        node.children.store(Unexpanded, std::memory_order_relaxed);
+        node.childCount = 0;
+    }
+    return static_cast<std::uint32_t>(first);
+}
+
+template <typename BoardType>
+bool BasicMonteCarloSearch<BoardType>::Expand(Node& node, bool decision, const Rows& rows)
+{
+    Node* nodes = _pools[_active].nodes.get();
+    std::uint32_t first = Unexpanded;
+    int count = 0;
+    if (decision)
+    {
+        // a chance node for every placement that fits, allocated together once they are counted
+        std::array<std::uint8_t, MaxPlacements> rotations;
+        std::array<std::int8_t, MaxPlacements> columns;
+        for (int rotation = 0; rotation < Pieces::Rotations; ++rotation)
+        {
+            for (int x = 1 - Pieces::Size; x < BoardType::FixedWidth; ++x)
+            {
+                Rows after = rows;
+                if (Search::Drop(after, node.piece, rotation, x) >= 0)
+                {
+                    rotations[count] = static_cast<std::uint8_t>(rotation);
+                    columns[count] = static_cast<std::int8_t>(x);
+                    ++count;
+                }
+            }
+        }
+        if (count > 0 && (first = Allocate(count)) == Unexpanded)
+        {
+            node.children.store(Unexpanded, std::memory_order_release);
+            return false;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            nodes[first + i].rotation = rotations[i];
+            nodes[first + i].x = columns[i];
+        }
+    }
+    else
+    {
+        // a decision node per piece type, the descent picks the one that comes
+        count = Pieces::Count;
+        if ((first = Allocate(count)) == Unexpanded)
+        {
+            node.children.store(Unexpanded, std::memory_order_release);
+            return false;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            nodes[first + i].piece = static_cast<std::uint8_t>(i + 1);
+        }
+    }
+
+    // a piece with nowhere to go is a decision node without children, a top out
+    node.childCount = static_cast<std::uint8_t>(count);
+    node.children.store(count > 0 ? first : 0, std::memory_order_release);
+    return true;
+}
+
+template <typename BoardType>
+std::uint32_t BasicMonteCarloSearch<BoardType>::Select(const Node& node) const
+{
+    const Node* nodes = _pools[_active].nodes.get();
+    const std::uint32_t first = node.children.load(std::memory_order_acquire);
+    const int count = node.childCount;
+
+    // the siblings' means scaled to 0..1 between the worst and the best
+    double low = std::numeric_limits<double>::max();
+    double high = std::numeric_limits<double>::lowest();
+    for (int i = 0; i < count; ++i)
+    {
+        const Node& child = nodes[first + i];
+        std::uint32_t visits = child.visits.load(std::memory_order_relaxed);
+        if (visits > 0)
+        {
+            double mean = static_cast<double>(child.total.load(std::memory_order_relaxed)) / visits;
+            low = std::min(low, mean);
+            high = std::max(high, mean);
+        }
+    }
+    const double range = high > low ? high - low : 1.0;
+    const double parent = node.visits.load(std::memory_order_relaxed) +
+                          static_cast<double>(node.pending.load(std::memory_order_relaxed)) * _virtualLoss;
+    const double logParent = std::log(std::max(parent, 1.0));
+
+    // pending threads count as visits scoring as badly as the worst sibling
+    std::uint32_t best = first;
+    double bestValue = std::numeric_limits<double>::lowest();
+    for (int i = 0; i < count; ++i)
+    {
+        const Node& child = nodes[first + i];
+        std::uint32_t visits = child.visits.load(std::memory_order_relaxed);
+        double virtualVisits = static_cast<double>(child.pending.load(std::memory_order_relaxed)) * _virtualLoss;
+        if (visits + virtualVisits == 0.0)
+        {
+            return first + i;
+        }
+        double value = 0.0;
+        if (visits > 0)
+        {
+            double mean = static_cast<double>(child.total.load(std::memory_order_relaxed)) / visits;
+            value = (mean - low) / range * visits / (visits + virtualVisits);
+        }
+        value += _exploration * std::sqrt(logParent / (visits + virtualVisits));
+        if (value > bestValue)
+        {
+            bestValue = value;
+            best = first + i;
+        }
+    }
+    return best;
+}
+
+template <typename BoardType>
+void BasicMonteCarloSearch<BoardType>::Descend(std::minstd_rand& random, int& depth)
+{
+    Node* nodes = _pools[_active].nodes.get();
+    std::array<Node*, 2 * MaxPly + 1> path;
+    int length = 0;
+    auto enter = [&](Node* node)
+    {
+        node->pending.fetch_add(1, std::memory_order_relaxed);
+        path[length++] = node;
+    };
+
+    // tries to expand a node nobody has, false if it is a leaf for now
+    auto expanded = [&](Node* node, bool decision)
+    {
+        std::uint32_t children = node->children.load(std::memory_order_acquire);
+        if (children == Unexpanded)
+        {
+            if (!node->children.compare_exchange_strong(children, Expanding, std::memory_order_acquire) ||
+                !Expand(*node, decision, _rootRows))
+            {
+                return false;
+            }
+            children = node->children.load(std::memory_order_acquire);
+        }
+        return children != Expanding;
+    };
+
+    Rows rows = _rootRows;
+    int lines = 0;
+    int ply = 0;
+    bool toppedOut = false;
+    Node* node = &nodes[_root];
+    enter(node);
+    while (ply < MaxPly)
+    {
+        // decision node: the root's children were expanded before the threads started, deeper ones
+        // are expanded on the way through, the stack is only needed for the placements
+        std::uint32_t children = node->children.load(std::memory_order_acquire);
+        if (children == Unexpanded)
+        {
+            if (!node->children.compare_exchange_strong(children, Expanding, std::memory_order_acquire) ||
+                !Expand(*node, true, rows))
+            {
+                break;
+            }
+        }
+        else if (children == Expanding)
+        {
+            break;
+        }
+        if (node->childCount == 0)
+        {
+            toppedOut = true;
+            break;
+        }
+        Node* chance = &nodes[Select(*node)];
+        lines += Search::Drop(rows, node->piece, chance->rotation, chance->x);
+        enter(chance);
+        ++ply;
+
+        // chance node: scored the first time through, expanded the second
+        if (chance->visits.load(std::memory_order_relaxed) == 0 || !expanded(chance, false))
+        {
+            break;
+        }
+        int piece = ply < Known ? _known[ply] : static_cast<int>(random() % Pieces::Count) + 1;
+        node = &nodes[chance->children.load(std::memory_order_acquire) + piece - 1];
+        enter(node);
+    }
+    depth = ply;
+
+    // the leaf's stack and the lines on the way, a top out costs a full well's height on top
+    std::int64_t score = static_cast<std::int64_t>(lines) * _weights.lines +
+                         Search::Evaluate(rows, _weights);
+    if (toppedOut)
+    {
+        score -= static_cast<std::int64_t>(_weights.height) * BoardType::FixedWidth * BoardType::FixedHeight;
+    }
+    for (int i = 0; i < length; ++i)
+    {
+        path[i]->total.fetch_add(score, std::memory_order_relaxed);
+        path[i]->visits.fetch_add(1, std::memory_order_relaxed);
+        path[i]->pending.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+template <typename BoardType>
+bool BasicMonteCarloSearch<BoardType>::Reroot(const BasicGame<BoardType>& game, const Rows& rows)
+{
+    if (_root == Unexpanded || _played == Unexpanded || game.getPieces() != _rootPieces + 1)
+    {
+        return false;
+    }
+
+    // the sequence moved on by one piece and the suggested placement was the one played
+    if (game.getTetromino().getType() != _known[1])
+    {
+        return false;
+    }
+    for (int i = 0; i + 2 < Known; ++i)
+    {
+        if (game.getPreview(i) != _known[i + 2])
+        {
+            return false;
+        }
+    }
+    const Node& played = _pools[_active].nodes[_played];
+    Rows after = _rootRows;
+    if (Search::Drop(after, _known[0], played.rotation, played.x) < 0 || after != rows)
+    {
+        return false;
+    }
+    std::uint32_t children = played.children.load(std::memory_order_relaxed);
+    if (children >= Expanding)
+    {
+        return false;
+    }
+    Compact(children + _known[1] - 1);
+    return true;
+}
+
+template <typename BoardType>
+void BasicMonteCarloSearch<BoardType>::Compact(std::uint32_t root)
+{
+    // breadth first, the copied nodes double as the queue: a copied node's children index still
+    // points into the old pool until its own children have been copied behind it
+    const Node* from = _pools[_active].nodes.get();
+    Pool& to = _pools[1 - _active];
+    auto copy = [](const Node& source, Node& target)
+    {
+        target.total.store(source.total.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        target.visits.store(source.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        target.pending.store(0, std::memory_order_relaxed);
+        target.children.store(source.children.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        target.childCount = source.childCount;
+        target.piece = source.piece;
+        target.rotation = source.rotation;
+        target.x = source.x;
+    };
+
+    std::size_t used = 1;
+    copy(from[root], to.nodes[0]);
+    for (std::size_t i = 0; i < used; ++i)
+    {
+        Node& node = to.nodes[i];
+        std::uint32_t children = node.children.load(std::memory_order_relaxed);
+        if (children >= Expanding || node.childCount == 0)
+        {
+            continue;
+        }
+        for (int child = 0; child < node.childCount; ++child)
+        {
+            copy(from[children + child], to.nodes[used + child]);
+        }
+        node.children.store(static_cast<std::uint32_t>(used), std::memory_order_relaxed);
+        used += node.childCount;
+    }
+    to.used = used;
+    _active = 1 - _active;
+    _root = 0;
+}
+
+template <typename BoardType>
+typename BasicMonteCarloSearch<BoardType>::Placement BasicMonteCarloSearch<BoardType>::Think(
+        const BasicGame<BoardType>& game, double milliseconds)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                          std::chrono::duration<double, std::milli>(milliseconds));
+    _stats = MonteCarloStats();
+    if (game.isGameOver())
+    {
+        Reset();
+        return Placement();
+    }
+
+    // the board has the active piece drawn in, the search starts from the stack under it
+    const Tetromino& active = game.getTetromino();
+    Rows rows = Search::ExtractStack(game);
+
+    if (Reroot(game, rows))
+    {
+        _stats.reused = _pools[_active].used;
+    }
+    else
+    {
+        Reset();
+        _root = Allocate(1);
+        _pools[_active].nodes[_root].piece = static_cast<std::uint8_t>(active.getType());
+    }
+    _rootRows = rows;
+    _rootPieces = game.getPieces();
+    _known[0] = active.getType();
+    for (int i = 1; i < Known; ++i)
+    {
+        _known[i] = game.getPreview(i - 1);
+    }
+
+    Node& root = _pools[_active].nodes[_root];
+    _full = false;
+    std::uint32_t expected = Unexpanded;
+    if (root.children.compare_exchange_strong(expected, Expanding))
+    {
+        Expand(root, true, rows);
+    }
+    _played = Unexpanded;
+    if (root.children.load() >= Expanding || root.childCount == 0)
+    {
+        Reset();
+        return Placement();
+    }
+
+    _depth = 0;
+    _iterations = 0;
+    auto task = [&](int begin, int end)
+    {
+        std::minstd_rand random(static_cast<unsigned int>(_rootPieces) * 7919u + _nextSeed.fetch_add(1) + 1u);
+        long long iterations = 0;
+        int deepest = 0;
+        for (int slice = begin; slice < end; ++slice)
+        {
+            // the clock is only read every few descents, a descent takes microseconds
+            while (!_full.load(std::memory_order_relaxed) &&
+                   ((iterations & 15) != 0 || std::chrono::steady_clock::now() < deadline))
+            {
+                int depth = 0;
+                Descend(random, depth);
+                deepest = std::max(deepest, depth);
+                ++iterations;
+            }
+        }
+        _iterations += iterations;
+        int known = _depth.load();
+        while (deepest > known && !_depth.compare_exchange_weak(known, deepest))
+        {
+        }
+    };
+    _pool->Run(_pool->getThreadCount(), task);
+
+    // the most visited placement, the mean breaking ties
+    const Node* nodes = _pools[_active].nodes.get();
+    const std::uint32_t first = root.children.load();
+    std::uint32_t best = first;
+    for (int i = 1; i < root.childCount; ++i)
+    {
+        const Node& child = nodes[first + i];
+        const Node& leader = nodes[best];
+        if (child.visits > leader.visits ||
+            (child.visits == leader.visits && child.visits > 0 &&
+             child.total / static_cast<std::int64_t>(child.visits) > leader.total / static_cast<std::int64_t>(leader.visits)))
+        {
+            best = first + i;
+        }
+    }
+    _played = best;
+
+    _stats.iterations = _iterations;
+    _stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    _stats.nodes = std::min(_pools[_active].used.load(), _pools[_active].capacity);
+    _stats.depth = _depth;
+    _stats.full = _full;
+
+    Placement placement;
+    const Node& chosen = nodes[best];
+    placement.rotation = chosen.rotation;
+    placement.x = chosen.x;
+    placement.score = chosen.visits > 0 ? static_cast<int>(chosen.total / static_cast<std::int64_t>(chosen.visits)) : 0;
+    placement.valid = true;
+    return placement;
+}
+
+template class BasicMonteCarloSearch<Board>;
+template class BasicMonteCarloSearch<TallBoard>;
@@ -1,25 +1,136 @@
 #include "NGLScene.h"
 #include <ngl/NGLInit.h>
 #include <ngl/NGLStream.h>
-#include <ngl/ShaderLib.h>
 #include <ngl/VAOPrimitives.h>
 #include <QGuiApplication>
 #include <QMouseEvent>
+#include "AllocationCounter.h"
 #include "Cube.h"
-#include "Tetromino.h"
-#include "Board.h"
-#include <cstdlib>
-#include <ctime>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
 #include <QPainter>
 
-NGLScene::NGLScene()
+namespace
+{
+  constexpr int BoardsPerRow = 4;        // boards side by side before starting a new row
+  constexpr float BoardSpacingX = 14.0f; // distance between board centres across
+  constexpr float BoardSpacingY = 24.0f; // distance between rows of boards
+  constexpr int WarmupFrames = 2;        // frames the frame arena may take to reach its working size
+  constexpr int LatencyReportFrames = 10 * Game::FrameRate; // simulation frames between latency reports
+  constexpr float FloorY = -0.6f;         // height of the floor under the boards
+  constexpr float FloorHalfWidth = 5.0f;  // the 20 unit plane scaled by half across
+  constexpr float FloorHalfDepth = 2.5f;  // and by a quarter in depth
+  constexpr float LockFlashSeconds = 0.2f; // a locked piece glows and fades
+  constexpr float CollapseSeconds = 0.15f; // cleared rows flash and shrink away
+  constexpr float FallSeconds = 0.2f;      // then the rows above fall into the gap
+  constexpr float NoEvent = -1000.0f;      // the time of an event that never happened, long finished
+  constexpr int ClearingPalette = PaletteSize; // past the palette, marks the cubes of cleared rows the shaders collapse
+  constexpr int ClearedRowBits = 31;           // rows the shaders' int mask of cleared rows holds, clear of the sign bit
+
+  ngl::Mat4 floorTransform()
+  {
+    return ngl::Mat4::translate(0.0f, FloorY, 0.0f) * ngl::Mat4::scale(0.5f, 0.5f, 0.25f);
+  }
+
+  int boardColumns(int _boards) { return std::min(_boards, BoardsPerRow); }
+  int boardRows(int _boards) { return (_boards + BoardsPerRow - 1) / BoardsPerRow; }
+
+  // Where a board's bottom left cell sits, boards are laid out in rows centred on the origin
+  ngl::Vec3 boardOffset(int _board, int _boards)
+  {
+    int cols = boardColumns(_boards);
+    float col = static_cast<float>(_board % BoardsPerRow) - (cols - 1) * 0.5f;
+    float row = static_cast<float>(_board / BoardsPerRow);
+    // shift by half a board so the blocks are centred around the origin
+    return {col * BoardSpacingX - 4.5f, row * BoardSpacingY, 0.0f};
+  }
+
+  std::array<ngl::Vec3, VersusMatch::MaxPlayers> boardOffsets(int _boards)
+  {
+    std::array<ngl::Vec3, VersusMatch::MaxPlayers> offsets;
+    for (int board = 0; board < VersusMatch::MaxPlayers; ++board)
+    {
+      offsets[board] = boardOffset(board, _boards);
+    }
+    return offsets;
+  }
+
+  // The cells of a game's falling piece in one row of its board, the rest of the row is locked stack
+  Board::RowMask pieceCells(const Game &_game, int _row)
+  {
+    const Tetromino &piece = _game.getTetromino();
+    int i = _row - piece.GetY();
+    // a piece that blocked out was never drawn on the board
+    if (_game.isGameOver() || piece.getType() == 0 || i < 0 || i >= Board::Pieces::Size)
+    {
+      return 0;
+    }
+    std::uint64_t shape = Board::Pieces::getShape(piece.getType(), piece.getRotation())[i];
+    int x = piece.GetX();
+    return static_cast<Board::RowMask>(x < 0 ? shape >> -x : shape << x);
+  }
+
+  // Which button of the 3D well mode a key drives
+  InputFrame voxelButton(int _key)
+  {
+    switch (_key)
+    {
+    case Qt::Key_Left: return VoxelLeft;
+    case Qt::Key_Right: return VoxelRight;
+    case Qt::Key_Up: return VoxelFar;
+    case Qt::Key_Down: return VoxelNear;
+    case Qt::Key_Q: return VoxelTurnX;
+    case Qt::Key_A: return VoxelTurnY;
+    case Qt::Key_Z: return VoxelTurnZ;
+    case Qt::Key_Return: return VoxelDrop;
+    case Qt::Key_Enter: return VoxelDrop;
+    default: return 0;
+    }
+  }
+
+  // Which game button a key drives and for which of the players at the keyboard
+  InputFrame gameButton(int _key, int &_player)
+  {
+    _player = 0;
+    switch (_key)
+    {
+    case Qt::Key_Up: return InputRotate;
+    case Qt::Key_Down: return InputDown;
+    case Qt::Key_Left: return InputLeft;
+    case Qt::Key_Right: return InputRight;
+    default: break;
+    }
+    // second player on the same keyboard
+    _player = 1;
+    switch (_key)
+    {
+    case Qt::Key_Y: return InputRotate;
+    case Qt::Key_H: return InputDown;
+    case Qt::Key_G: return InputLeft;
+    case Qt::Key_J: return InputRight;
+    default: return 0;
+    }
+  }
+}
+
+NGLScene::NGLScene() : m_scheduler([this] { update(); }), m_created(std::chrono::steady_clock::now())
 {
   setTitle("nglTetris");
+  m_lockTimes.fill(NoEvent);
+  m_clearTimes.fill(NoEvent);
+  m_lockedCells.fill(-1);
 }
 
 NGLScene::~NGLScene()
 {
   std::cout << "Shutting down NGL, removing VAO's and Shaders\n";
+  std::cout << m_scheduler.invalidations() << " changes drawn in " << m_scheduler.frames() << " frames\n";
+  if (m_measureInput)
+  {
+    reportInputLatency();
+  }
 }
 
 void NGLScene::resizeGL(int _w, int _h)
@@ -29,8 +140,6 @@ void NGLScene::resizeGL(int _w, int _h)
   m_win.width = static_cast<int>(_w * devicePixelRatio());
   m_win.height = static_cast<int>(_h * devicePixelRatio());
 }
-constexpr auto shaderProgram = "PBR";
-
 void NGLScene::initializeGL()
 {
   // we must call that first before any other GL commands to load and link the
@@ -43,91 +152,256 @@ void NGLScene::initializeGL()
   glEnable(GL_DEPTH_TEST);
   // enable multisampling for smoother drawing
   glEnable(GL_MULTISAMPLE);
-  // now to load the shader and set the values
-  // grab an instance of shader manager
-  // in the code create some constexpr
-  constexpr auto vertexShader = "PBRVertex";
-  constexpr auto fragShader = "PBRFragment";
-  // create the shader program
-  ngl::ShaderLib::createShaderProgram(shaderProgram);
-  // now we are going to create empty shaders for Frag and Vert
-  ngl::ShaderLib::attachShader(vertexShader, ngl::ShaderType::VERTEX);
-  ngl::ShaderLib::attachShader(fragShader, ngl::ShaderType::FRAGMENT);
-  // attach the source
-  ngl::ShaderLib::loadShaderSource(vertexShader, "shaders/PBRVertex.glsl");
-  ngl::ShaderLib::loadShaderSource(fragShader, "shaders/PBRFragment.glsl");
-  // compile the shaders
-  ngl::ShaderLib::compileShader(vertexShader);
-  ngl::ShaderLib::compileShader(fragShader);
-  // add them to the program
-  ngl::ShaderLib::attachShaderToProgram(shaderProgram, vertexShader);
-  ngl::ShaderLib::attachShaderToProgram(shaderProgram, fragShader);
-  // now we have associated that data we can link the shader
-  ngl::ShaderLib::linkProgramObject(shaderProgram);
-  // and make it active ready to load values
-  ngl::ShaderLib::use(shaderProgram);
-  // We now create our view matrix for a static camera
-  ngl::Vec3 from{0.0f, 15.0f, 20.0f};
-  ngl::Vec3 to{0.0f, 8.0f, 0.0f};
+  // We now create our view matrix for a static camera, pulled back to fit every board
+  int cols = boardColumns(boardCount());
+  int rows = boardRows(boardCount());
+  float lift = (rows - 1) * BoardSpacingY * 0.5f;
+  float back = 0.0f;
+  if (m_sandbox)
+  {
+    // a sandbox board can be any height, frame all of it and a lane's worth of width
+    lift = std::max(0.0f, m_sandbox->getBoard().getHeight() * 0.5f - 8.0f);
+    back = lift * 1.2f;
+  }
+  m_cameraPos = {0.0f, 15.0f + lift, 20.0f + back + 24.0f * (cols - 1) + 30.0f * (rows - 1)};
+  ngl::Vec3 to{0.0f, 8.0f + lift, 0.0f};
   ngl::Vec3 up{0.0f, 1.0f, 0.0f};
   // now load to our new camera
-  m_view = ngl::lookAt(from, to, up);
-  ngl::ShaderLib::setUniform("camPos", from);
+  m_view = ngl::lookAt(m_cameraPos, to, up);
   // now a light
   m_lightPos.set(5.0, 5.0f, 30.0f, 1.0f);
   m_lightAngle = 0.0f;
-  // setup the default shader material and light porerties
-  // these are "uniform" so will retain their values
-  ngl::ShaderLib::setUniform("lightPosition", m_lightPos.toVec3());
-  ngl::ShaderLib::setUniform("lightColor", 1600.0f, 1600.0f, 1600.0f);
-  ngl::ShaderLib::setUniform("exposure", 6.0f);
-  ngl::ShaderLib::setUniform("albedo", 0.950f, 0.71f, 0.29f);
-
-  ngl::ShaderLib::setUniform("metallic", 1.02f);
-  ngl::ShaderLib::setUniform("roughness", 0.38f);
-  ngl::ShaderLib::setUniform("ao", 0.2f);
+  // build every shading tier up front, from the program cache after the first run; the matcap
+  // tier bakes its lighting from the light direction as seen by the static camera
+  ngl::Vec4 lightDir = m_view * m_lightPos - m_view * ngl::Vec4(to.m_x, to.m_y, to.m_z, 1.0f);
+  m_shading.initialize(lightDir.toVec3(), [this] { m_scheduler.invalidate(LayerSettings); });
+
+  // the shadow frustum holds every board and the floor whatever the camera sees, so the
+  // maps only depend on the cubes and survive any camera or mouse movement
+  const VersusMatch &match = activeMatch();
+  ngl::Vec3 low{-FloorHalfWidth, FloorY, -FloorHalfDepth};
+  ngl::Vec3 high{FloorHalfWidth, FloorY, FloorHalfDepth};
+  for (int player = 0; player < match.getPlayerCount(); ++player)
+  {
+    const Board &board = match.getGame(player).getBoard();
+    ngl::Vec3 offset = boardOffset(player, match.getPlayerCount());
+    low.m_x = std::min(low.m_x, offset.m_x - 0.5f);
+    high.m_x = std::max(high.m_x, offset.m_x + board.getWidth() - 0.5f);
+    high.m_y = std::max(high.m_y, offset.m_y + board.getHeight() - 0.5f);
+  }
+  if (m_voxel)
+  {
+    low.m_z = std::min(low.m_z, -0.5f * VoxelWell::getDepth());
+    high.m_z = std::max(high.m_z, 0.5f * VoxelWell::getDepth());
+    high.m_y = std::max(high.m_y, VoxelWell::getHeight() - 0.5f);
+  }
+  if (m_sandbox)
+  {
+    // only the falling pieces cast shadows on a sandbox board, which may be far wider than the map
+    high.m_y = std::max(high.m_y, m_sandbox->getBoard().getHeight() - 0.5f);
+  }
+  m_shadows.initialize(m_shading.cache());
+  m_shadows.setLight(m_lightPos.toVec3(), (low + high) * 0.5f, (high - low).length() * 0.5f);
+  auto offsets = boardOffsets(boardCount());
+  m_shadows.setBoardOffsets(offsets.data(), VersusMatch::MaxPlayers);
+
+  for (int tier = 0; tier < ShadingTiers::TierCount; ++tier)
+  {
+    loadTierUniforms(static_cast<ShadingTier>(tier));
+  }
+  m_instances.initialize();
+  m_pieceInstances.initialize();
   ngl::VAOPrimitives::createTrianglePlane("floor", 20, 20, 1, 1, ngl::Vec3::up());
-  ngl::ShaderLib::printRegisteredUniforms(shaderProgram);
-  ngl::ShaderLib::use(ngl::nglCheckerShader);
-  ngl::ShaderLib::setUniform("lightDiffuse", 1.0f, 1.0f, 1.0f, 1.0f);
-  ngl::ShaderLib::setUniform("checkOn", true);
-  ngl::ShaderLib::setUniform("lightPos", m_lightPos.toVec3());
-  ngl::ShaderLib::setUniform("colour1", 0.9f, 0.9f, 0.9f, 1.0f);
-  ngl::ShaderLib::setUniform("colour2", 0.6f, 0.6f, 0.6f, 1.0f);
-  ngl::ShaderLib::setUniform("checkSize", 60.0f);
-  ngl::ShaderLib::printRegisteredUniforms(ngl::nglCheckerShader);
+  // checkered floor that receives the cubes' shadows, its program built with the tiers
+  loadFloorUniforms();
 
     // Set up the timer
     connect(&m_timer, SIGNAL(timeout()), this, SLOT(gameLoopTick()));
-    m_timer.start(300); // Start the timer with a 300ms interval
+    // Wake once per simulation frame as it ends, the timeline stamps each key with when it was pressed
+    // so sleeping until then costs no latency, and nothing wakes the process between frames
+    m_input = InputTimeline(LocalPlayers, std::chrono::steady_clock::now());
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setSingleShot(true);
+    scheduleTick();
+}
+
+void NGLScene::scheduleTick()
+{
+    // rounded up, a timer firing just before the boundary would find no frame due and sleep again
+    auto wait = m_input.getNextFrameEnd() - std::chrono::steady_clock::now();
+    long long ms = std::chrono::ceil<std::chrono::milliseconds>(wait).count();
+    m_timer.start(static_cast<int>(std::max(ms, 0ll)));
+}
+
+void NGLScene::loadTierUniforms(ShadingTier _tier)
+{
+  // setup the default shader material and light porerties
+  // these are "uniform" so will retain their values until the program is rebuilt
+  m_shading.use(_tier);
+  m_shading.setUniform("lightPosition", m_lightPos.toVec3());
+  // every cube shares one material, colour comes per instance
+  m_shading.setUniform("metallic", 0.5f);
+  m_shading.setUniform("roughness", 0.5f);
+  m_shading.setUniform("ao", 1.0f);
+  if (_tier != ShadingTier::Lambert)
+  {
+    m_shading.setUniform("lightColor", 1600.0f, 1600.0f, 1600.0f);
+    m_shading.setUniform("exposure", 6.0f);
+  }
+  if (_tier == ShadingTier::FullPBR)
+  {
+    m_shading.setUniform("camPos", m_cameraPos);
+  }
+  m_shading.setUniform("lightMatrix", m_shadows.lightMatrix());
+  m_shading.setUniform("stackShadow", ShadowMaps::StackUnit);
+  m_shading.setUniform("pieceShadow", ShadowMaps::PieceUnit);
+  m_shading.setUniform("animationSeconds", LockFlashSeconds, CollapseSeconds, FallSeconds);
+  loadBoardOffsets(_tier);
+  loadPalette(_tier);
+  loadBoardEvents(_tier);
+}
+
+void NGLScene::loadBoardOffsets(ShadingTier _tier)
+{
+  auto offsets = boardOffsets(boardCount());
+  m_shading.use(_tier);
+  m_shading.setUniform("boardOffset", offsets.data(), VersusMatch::MaxPlayers);
+}
+
+void NGLScene::loadBoardEvents(ShadingTier _tier)
+{
+  m_shading.use(_tier);
+  m_shading.setUniform("lockTime", m_lockTimes.data(), VersusMatch::MaxPlayers);
+  m_shading.setUniform("clearTime", m_clearTimes.data(), VersusMatch::MaxPlayers);
+  m_shading.setUniform("clearedRows", m_clearedRows.data(), VersusMatch::MaxPlayers);
+  m_shading.setUniform("lockedCells", m_lockedCells.data(), VersusMatch::MaxPlayers * LockedCells);
+}
+
+float NGLScene::animationTime() const
+{
+  return std::chrono::duration<float>(std::chrono::steady_clock::now() - m_created).count();
+}
 
-    // Seed the random number generator with the current time
-    srand(time(NULL));
+void NGLScene::recordBoardEvents(float _time)
+{
+    const VersusMatch& match = activeMatch();
+    for (int player = 0; player < match.getPlayerCount(); ++player)
+    {
+        // a rollback can take pieces back, only a lock since the last look is news
+        const Game& game = match.getGame(player);
+        bool locked = game.getPieces() > m_eventPieces[player];
+        m_eventPieces[player] = game.getPieces();
+        if (!locked)
+        {
+            continue;
+        }
+
+        // where the piece's cells ended up, each row moving down past the cleared rows under it
+        const Tetromino& piece = game.getLockedPiece();
+        std::uint32_t cleared = game.getClearedRows();
+        const auto& shape = Board::Pieces::getShape(piece.getType(), piece.getRotation());
+        int cell = 0;
+        for (int i = 0; i < Board::Pieces::Size; ++i)
+        {
+            int row = piece.GetY() + i - __builtin_popcount(cleared & ((1u << i) - 1));
+            for (int j = 0; j < Board::Pieces::Size && cell < LockedCells; ++j)
+            {
+                if (shape[i] >> j & 1)
+                {
+                    m_lockedCells[player * LockedCells + cell++] = (cleared >> i & 1) ? -1 : row * 256 + piece.GetX() + j;
+                }
+            }
+        }
+        m_lockTimes[player] = _time;
+        float end = _time + LockFlashSeconds;
+        if (cleared)
+        {
+            m_clearTimes[player] = _time;
+            // rows past the mask aren't animated, they only exist on boards taller than any played here
+            std::uint32_t rows = piece.GetY() < 0 ? cleared >> -piece.GetY()
+                                 : piece.GetY() < ClearedRowBits ? cleared << piece.GetY() : 0u;
+            m_clearedRows[player] = static_cast<int>(rows & ((1u << ClearedRowBits) - 1));
+            end = std::max(end, _time + CollapseSeconds + FallSeconds);
+        }
+        m_animationEnd = std::max(m_animationEnd, end);
+        m_eventsChanged = true;
+    }
 }
 
 void NGLScene::updateCubes()
 {
-    // update cubes
-    m_cubes.clear();
-    for (int row = 0; row < m_board.getHeight(); ++row)
+    if (m_voxel)
+    {
+        updateVoxelCubes();
+        return;
+    }
+    if (m_sandbox)
+    {
+        updateSandboxCubes();
+        return;
+    }
+    // last frame's cubes are either uploaded or replaced by these, so the arena starts over
+    m_frameArena.reset();
+    const VersusMatch& match = activeMatch();
+    std::size_t capacity = 0;
+    for (int player = 0; player < match.getPlayerCount(); ++player)
     {
-        for (int col = 0; col < m_board.getWidth(); ++col)
+        const Board& board = match.getGame(player).getBoard();
+        // and the rows a clear took out, while they collapse
+        capacity += static_cast<std::size_t>((board.getHeight() + Board::Pieces::Size) * board.getWidth());
+    }
+    m_cubes = m_frameArena.allocate<Cube>(capacity);
+    m_cubeCount = 0;
+    m_pieceCubes = m_frameArena.allocate<Cube>(static_cast<std::size_t>(match.getPlayerCount()) *
+                                               Board::Pieces::Size * Board::Pieces::Size);
+    m_pieceCubeCount = 0;
+    m_stackKey = ZobristMix(static_cast<std::uint64_t>(match.getPlayerCount()));
+    float time = animationTime();
+
+    for (int player = 0; player < match.getPlayerCount(); ++player)
+    {
+        const Game& game = match.getGame(player);
+        const Board& board = game.getBoard();
+        // the board's hash less the falling piece identifies the stack
+        std::uint64_t stackHash = board.getHash();
+        for (int row = 0; row < board.getHeight(); ++row)
         {
-            if (m_board.GetBlock(row, col) != ngl::Vec4 {0,0,0,0})
+            Board::RowMask piece = pieceCells(game, row);
+            if (piece)
             {
-                // Calculate the position of the cube based on row and column
-                auto posX = static_cast<float>(col);// Adjust cubeSize as needed
-                auto posY = static_cast<float>(row); // Adjust cubeSize as needed
-                float posZ = 0.0f; // Adjust if you want the cubes to be in different planes
-
-                // Create a cube at the calculated position
-                ngl::Vec3 pos = {posX, posY, posZ};
-                ngl::Vec4 colour = m_board.GetBlock(row, col); // Green color for blocks
-                Cube blockCube(pos, colour);
-
-                // Add the cube to the vector in NGLScene
-                AddCube(blockCube);
-                update();
+                stackHash ^= Board::RowKey(row, board.getRow(row)) ^ Board::RowKey(row, board.getRow(row) & ~piece);
+            }
+            for (int col = 0; col < board.getWidth(); ++col)
+            {
+                if ((board.getRow(row) >> col) & 1)
+                {
+                    // Create a cube at the row and column, the board offset is added in the shader
+                    ngl::Vec3 pos = {static_cast<float>(col), static_cast<float>(row), 0.0f};
+                    Cube cube(pos, board.getPaletteIndex(row, col), player);
+                    if ((piece >> col) & 1)
+                    {
+                        m_pieceCubes[m_pieceCubeCount++] = cube;
+                    }
+                    else
+                    {
+                        m_cubes[m_cubeCount++] = cube;
+                    }
+                }
+            }
+        }
+        m_stackKey ^= ZobristMix(stackHash + static_cast<std::uint64_t>(player));
+
+        // the cleared rows are full, so they can be put back from the row mask alone; once they have
+        // collapsed the shader draws nothing of them and the next rebuild leaves them out
+        if (time - m_clearTimes[player] < CollapseSeconds)
+        {
+            for (int row = 0; row < std::min(board.getHeight(), ClearedRowBits); ++row)
+            {
+                for (int col = 0; (m_clearedRows[player] >> row & 1) && col < board.getWidth(); ++col)
+                {
+                    ngl::Vec3 pos = {static_cast<float>(col), static_cast<float>(row), 0.0f};
+                    m_cubes[m_cubeCount++] = Cube(pos, ClearingPalette, player);
+                }
             }
         }
     }
@@ -135,22 +409,294 @@ void NGLScene::updateCubes()
 
 void NGLScene::gameLoopTick()
 {
-    // game loop //
-    if(m_board.MoveTetromino(m_tetromino, 1))
-    { // move tetromino down and check for collision
-        //std::cout << "collision";
-        m_board.UpdateTetrominoOnBoard(m_tetromino);
-        m_board.ClearFullRows();
-        std::cout<<m_board.getScore();
-        m_tetromino = Tetromino(rand() % 7 + 1, 4, 16); // Spawn new Tetromino
-    }
-    updateCubes();
+    // game loop, every simulation frame that has ended, each with the keys pressed during it //
+    auto now = std::chrono::steady_clock::now();
+    int due = m_input.Advance(now);
+    if (due == 0)
+    {
+        scheduleTick();
+        return;
+    }
+
+    // simulating and building the frame should never touch the heap, the counter is only live with TETRIS_COUNT_ALLOCATIONS
+    long long allocations = AllocationCounter::getCount();
+
+    for (int frame = 0; frame < due; ++frame)
+    {
+        std::array<InputFrame, VersusMatch::MaxPlayers> inputs{};
+        m_input.NextFrame(inputs.data(), now);
+        if (m_netplay)
+        {
+            m_netplay->Poll();
+            m_netplay->AdvanceFrame(inputs[0]);
+        }
+        else if (m_voxel)
+        {
+            m_voxel->Step(inputs[0]);
+        }
+        else if (m_sandbox)
+        {
+            m_sandbox->Step(inputs.data());
+        }
+        else
+        {
+            if (m_bot || m_botLink)
+            {
+                inputs[0] = botInput();
+            }
+            m_match.Step(inputs.data());
+        }
+    }
+    if (!m_voxel && !m_sandbox)
+    {
+        recordBoardEvents(animationTime());
+    }
+
+    // a rollback can change a board even on frames we don't advance, and a blocked move changes
+    // nothing, so what decides a rebuild is whether the boards actually differ from the last one
+    const VersusMatch& match = activeMatch();
+    std::uint64_t sceneKey = 0;
+    bool playing = false;
+    int pieces = 0;
+    if (m_voxel)
+    {
+        // the well hash leaves the falling piece out, so it goes into the key separately
+        const VoxelPiece& piece = m_voxel->getPiece();
+        std::uint64_t place = static_cast<std::uint64_t>(piece.type) | static_cast<std::uint64_t>(piece.orientation) << 8 |
+                              static_cast<std::uint64_t>(piece.x & 0xff) << 16 |
+                              static_cast<std::uint64_t>(piece.y & 0xff) << 24 |
+                              static_cast<std::uint64_t>(piece.z & 0xff) << 32;
+        sceneKey = ZobristMix(m_voxel->getWell().getHash() + (static_cast<std::uint64_t>(m_voxel->getPieces()) << 32)) ^
+                   ZobristMix(place);
+        playing = !m_voxel->isGameOver();
+        pieces = m_voxel->getPieces();
+    }
+    else if (m_sandbox)
+    {
+        // the board revision covers the locked cells, the pieces are keyed by where they are
+        sceneKey = ZobristMix(m_sandbox->getBoard().getRevision());
+        for (int player = 0; player < m_sandbox->getPlayerCount(); ++player)
+        {
+            const Tetromino& piece = m_sandbox->getTetromino(player);
+            std::uint64_t place = static_cast<std::uint64_t>(piece.getType()) |
+                                  static_cast<std::uint64_t>(piece.getRotation()) << 8 |
+                                  static_cast<std::uint64_t>(static_cast<std::uint32_t>(piece.GetX())) << 16 |
+                                  static_cast<std::uint64_t>(piece.GetY() & 0xffff) << 48;
+            sceneKey ^= ZobristMix(place + static_cast<std::uint64_t>(player));
+        }
+        playing = !m_sandbox->isGameOver();
+        pieces = m_sandbox->getPieces();
+    }
+    else
+    {
+        for (int player = 0; player < match.getPlayerCount(); ++player)
+        {
+            const Game& game = match.getGame(player);
+            sceneKey ^= ZobristMix(game.getBoard().getHash() + static_cast<std::uint64_t>(player) +
+                                   (static_cast<std::uint64_t>(game.getPieces()) << 32));
+            playing |= !game.isGameOver();
+            pieces += game.getPieces();
+        }
+    }
+    bool changed = sceneKey != m_sceneKey;
+    m_sceneKey = sceneKey;
+
+    // the bot process sees every change to the first board
+    if (m_botLink && changed && !m_voxel && !m_sandbox)
+    {
+        BotLink::Snapshot snapshot;
+        BotLink::Capture(match.getGame(0), static_cast<std::uint64_t>(m_frames), snapshot);
+        m_botLink->Publish(snapshot);
+    }
+
+    // report the scores and levels whenever a piece locks somewhere
+    if (pieces != m_piecesLocked)
+    {
+        m_piecesLocked = pieces;
+        if (m_voxel)
+        {
+            std::cout << m_voxel->getScore() << " (level " << m_voxel->getLevel() << ", " << m_voxel->getLayers()
+                      << " layers" << (m_voxel->isGameOver() ? ", game over)\n" : ")\n");
+        }
+        if (m_sandbox)
+        {
+            std::cout << pieces << " pieces, " << m_sandbox->getLines() << " lines, "
+                      << m_sandbox->getBoard().getChunkCount() << " tiles"
+                      << (m_sandbox->isGameOver() ? ", game over\n" : "\n");
+        }
+        for (int player = 0; !m_voxel && !m_sandbox && player < match.getPlayerCount(); ++player)
+        {
+            const Game& game = match.getGame(player);
+            std::cout << game.getScore() << " (level " << game.getLevel() << (game.isGameOver() ? ", game over)" : ")")
+                      << (player + 1 < match.getPlayerCount() ? "  " : "\n");
+        }
+    }
+
+    if (changed)
+    {
+        // the GL buffers are refreshed in paintGL where the context is current, the stack's only if it changed
+        std::uint64_t stackKey = m_stackKey;
+        updateCubes();
+        m_scheduler.invalidate(LayerPieces | (m_stackKey != stackKey ? LayerStack : 0));
+    }
+    // netplay sends and receives through the socket layer, so only local matches are held to it
+    m_frames += due;
+    // the count takes in every thread, so a bot searching alongside is left out too
+    if (AllocationCounter::isEnabled() && !m_netplay && !m_bot && m_frames > WarmupFrames &&
+        AllocationCounter::getCount() != allocations)
+    {
+        std::cerr << "frame " << m_frames << " made " << AllocationCounter::getCount() - allocations
+                  << " heap allocations, steady state frames should make none\n";
+    }
+    if (m_measureInput && m_frames / LatencyReportFrames != (m_frames - due) / LatencyReportFrames)
+    {
+        reportInputLatency();
+    }
+    // nothing moves once every game has ended, so the timer is left stopped
+    if (playing || m_netplay)
+    {
+        scheduleTick();
+    }
+}
+
+void NGLScene::reportInputLatency() const
+{
+    const LatencyHistogram &total = m_input.getTotal();
+    if (total.getCount() == 0)
+    {
+        return;
+    }
+    // quantisation is waiting for the frame to end, processing is the loop waking up after it did
+    auto line = [](const char *_name, const LatencyHistogram &_histogram)
+    {
+      std::cout << _name << " p50 " << _histogram.getPercentile(0.5) << "ms, p90 " << _histogram.getPercentile(0.9)
+                << "ms, p99 " << _histogram.getPercentile(0.99) << "ms, max " << _histogram.getMax() << "ms\n";
+    };
+    std::cout << "input latency over " << total.getCount() << " key events, " << m_input.getSkippedFrames()
+              << " frames skipped\n";
+    line("  key to simulation", total);
+    line("  key to frame end ", m_input.getQuantisation());
+    line("  frame end to run ", m_input.getProcessing());
+}
+
+void NGLScene::loadFloorUniforms()
+{
+  m_shading.useFloor();
+  m_shading.setUniform("lightPosition", m_lightPos.toVec3());
+  m_shading.setUniform("colour1", 0.9f, 0.9f, 0.9f);
+  m_shading.setUniform("colour2", 0.6f, 0.6f, 0.6f);
+  m_shading.setUniform("model", floorTransform());
+  m_shading.setUniform("lightMatrix", m_shadows.lightMatrix());
+  m_shading.setUniform("stackShadow", ShadowMaps::StackUnit);
+  m_shading.setUniform("pieceShadow", ShadowMaps::PieceUnit);
+}
+
+void NGLScene::loadPalette(ShadingTier _tier)
+{
+  const auto &colours = Palette::colours(m_palette);
+  m_shading.use(_tier);
+  m_shading.setUniform("palette", colours.data(), PaletteSize);
+}
+
+const VersusMatch& NGLScene::activeMatch() const
+{
+    return m_netplay ? m_netplay->getSession().getMatch() : m_match;
+}
+
+int NGLScene::boardCount() const
+{
+    return m_voxel || m_sandbox ? 1 : activeMatch().getPlayerCount();
+}
+
+ngl::Vec3 NGLScene::sandboxOrigin() const
+{
+    // the middle of the first player's spawn box lands where the middle of a board would
+    float spawn = m_sandbox->getSpawnX(0) + (StandardTetrominoes::Size - 1) * 0.5f;
+    return {4.5f - spawn, 0.0f, 0.0f};
+}
+
+void NGLScene::updateSandboxCubes()
+{
+    m_frameArena.reset();
+    m_cubes = nullptr;
+    m_cubeCount = 0;
+    m_pieceCubes = m_frameArena.allocate<Cube>(static_cast<std::size_t>(m_sandbox->getPlayerCount()) *
+                                               StandardTetrominoes::Size * StandardTetrominoes::Size);
+    m_pieceCubeCount = 0;
+    m_stackKey = 0;
+    ngl::Vec3 origin = sandboxOrigin();
+    for (int player = 0; player < m_sandbox->getPlayerCount(); ++player)
+    {
+        if (!m_sandbox->isPlaying(player))
+        {
+            continue;
+        }
+        const Tetromino& piece = m_sandbox->getTetromino(player);
+        const auto& shape = StandardTetrominoes::getShape(piece.getType(), piece.getRotation());
+        for (int i = 0; i < StandardTetrominoes::Size; ++i)
+        {
+            for (int j = 0; j < StandardTetrominoes::Size; ++j)
+            {
+                if (shape[i] >> j & 1)
+                {
+                    ngl::Vec3 pos = origin + ngl::Vec3(static_cast<float>(piece.GetX() + j),
+                                                       static_cast<float>(piece.GetY() + i), 0.0f);
+                    m_pieceCubes[m_pieceCubeCount++] = Cube(pos, piece.getPaletteIndex());
+                }
+            }
+        }
+    }
+}
+
+void NGLScene::updateVoxelCubes()
+{
+    m_frameArena.reset();
+    const VoxelWell& well = m_voxel->getWell();
+    constexpr int Width = VoxelWell::getWidth();
+    constexpr int Depth = VoxelWell::getDepth();
+    m_cubes = m_frameArena.allocate<Cube>(static_cast<std::size_t>(Width * Depth * VoxelWell::getHeight()));
+    m_cubeCount = 0;
+    m_pieceCubes = m_frameArena.allocate<Cube>(Polycubes::MaxCells);
+    m_pieceCubeCount = 0;
+    m_stackKey = well.getHash();
+
+    // the well stands where the first board would, layers going up and y away from the camera
+    auto position = [](int _x, int _y, int _z)
+    {
+        return ngl::Vec3{_x + 4.5f - (Width - 1) * 0.5f, static_cast<float>(_z), (Depth - 1) * 0.5f - _y};
+    };
+    for (int z = 0; z < VoxelWell::getHeight(); ++z)
+    {
+        VoxelWell::LayerMask layer = well.getLayer(z);
+        for (int y = 0; layer && y < Depth; ++y)
+        {
+            for (int x = 0; x < Width; ++x)
+            {
+                if ((layer >> (x + Width * y)) & 1)
+                {
+                    m_cubes[m_cubeCount++] = Cube(position(x, y, z), well.getPaletteIndex(x, y, z));
+                }
+            }
+        }
+    }
+
+    const VoxelPiece& piece = m_voxel->getPiece();
+    if (piece.type != 0)
+    {
+        const Polycubes::Orientation& shape = piece.getShape();
+        for (int i = 0; i < shape.cellCount; ++i)
+        {
+            const Polycubes::Cell& cell = shape.cells[i];
+            m_pieceCubes[m_pieceCubeCount++] = Cube(position(piece.x + cell.x, piece.y + cell.y, piece.z + cell.z),
+                                                    VoxelGame::PaletteIndex(piece.type));
+        }
+    }
 }
 
 
 void NGLScene::loadMatricesToShader()
 {
-  ngl::ShaderLib::use("PBR");
+  m_shading.useActive();
   struct transform
   {
     ngl::Mat4 MVP;
@@ -167,33 +713,162 @@ void NGLScene::loadMatricesToShader()
   // ngl::msg->addMessage(fmt::format("size {0}",sizeof(transform)));
   if (m_transformLight)
   {
-    ngl::ShaderLib::setUniform("lightPosition", (m_mouseGlobalTX * m_lightPos).toVec3());
+    m_shading.setUniform("lightPosition", (m_mouseGlobalTX * m_lightPos).toVec3());
   }
 }
 
-void NGLScene::AddCube(const Cube& cube)
+void NGLScene::setMatch(VersusMatch match)
 {
-    m_cubes.push_back(cube);
+    m_match = std::move(match);
 }
 
-void NGLScene::setTetromino(const Tetromino& tetromino)
+void NGLScene::setBot(std::unique_ptr<MonteCarloSearch> _bot, double _milliseconds)
 {
-    m_tetromino = tetromino;
+    // the search still running belongs to the old bot and reads the old budget
+    if (m_botThinking.valid())
+    {
+        m_botThinking.wait();
+    }
+    m_botThinking = std::future<MonteCarloSearch::Placement>();
+    m_bot = std::move(_bot);
+    m_botBudget = _milliseconds;
+    m_botPieces = -1;
+    m_botThinkingPieces = -1;
 }
 
-void NGLScene::setBoard(const Board& board)
+InputFrame NGLScene::botInput()
 {
-    m_board = board;
+    // think once per piece, the tree carries over so each search picks up where the last left off;
+    // a bot process answers the snapshot published when the piece spawned instead
+    const Game& game = m_match.getGame(0);
+    if (game.getPieces() != m_botPieces)
+    {
+        m_botTarget = MonteCarloSearch::Placement();
+        m_botPieces = game.getPieces();
+    }
+    if (m_bot)
+    {
+        // the search runs on its own thread over a copy of the game, so drawing, the keys and the
+        // match carry on while it thinks, the piece falling as usual until its placement arrives; a
+        // search outlived by its piece is let finish and dropped, the tree takes one search at a time
+        if (m_botThinking.valid() && m_botThinking.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            MonteCarloSearch::Placement placement = m_botThinking.get();
+            if (m_botThinkingPieces == game.getPieces())
+            {
+                m_botTarget = placement;
+            }
+        }
+        if (!m_botThinking.valid() && m_botThinkingPieces != game.getPieces() && !game.isGameOver())
+        {
+            m_botGame = game;
+            m_botThinkingPieces = game.getPieces();
+            m_botThinking = std::async(std::launch::async, [this] { return m_bot->Think(m_botGame, m_botBudget); });
+        }
+    }
+    BotLink::Command command;
+    while (m_botLink && m_botLink->Receive(command))
+    {
+        if (command.pieces == game.getPieces())
+        {
+            m_botTarget.rotation = command.rotation;
+            m_botTarget.x = command.x;
+            m_botTarget.valid = true;
+        }
+    }
+    if (!m_botTarget.valid)
+    {
+        return 0;
+    }
+
+    // rotate, then shift, then drop, one press at a time since buttons act when they go down
+    const Tetromino& piece = game.getTetromino();
+    InputFrame input = InputDown;
+    if (piece.getRotation() != m_botTarget.rotation)
+    {
+        input = InputRotate;
+    }
+    else if (piece.GetX() > m_botTarget.x)
+    {
+        input = InputLeft;
+    }
+    else if (piece.GetX() < m_botTarget.x)
+    {
+        input = InputRight;
+    }
+    m_botLast = input == m_botLast ? 0 : input;
+    return m_botLast;
+}
+
+void NGLScene::setNetplay(std::unique_ptr<NetplaySession> netplay)
+{
+    m_netplay = std::move(netplay);
+}
+
+void NGLScene::setVoxelGame(std::unique_ptr<VoxelGame> _game)
+{
+    m_voxel = std::move(_game);
+}
+
+void NGLScene::setSandbox(std::unique_ptr<SandboxGame> _game)
+{
+    m_sandbox = std::move(_game);
 }
 
 void NGLScene::paintGL()
 {
+  // only the layers that changed are uploaded and redrawn into their shadow maps, a frame the
+  // window system asked for, e.g. after a resize, just draws what is already there
+  RenderLayers layers = m_scheduler.beginFrame();
+  if (layers & LayerStack)
+  {
+    m_instances.upload(m_cubes, m_cubeCount);
+    m_shadows.renderStack(m_instances, m_stackKey);
+  }
+  if (layers & LayerPieces)
+  {
+    m_pieceInstances.upload(m_pieceCubes, m_pieceCubeCount);
+    m_shadows.renderPieces(m_pieceInstances);
+  }
+
   glViewport(0, 0, m_win.width, m_win.height);
   // clear the screen and depth buffer
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  // swap in any shader rebuilt since the last frame, its uniforms start from scratch
+  if (m_shading.isReloading())
+  {
+    unsigned int swapped = m_shading.updatePrograms();
+    for (int tier = 0; tier < ShadingTiers::TierCount; ++tier)
+    {
+      if (swapped & (1u << tier))
+      {
+        loadTierUniforms(static_cast<ShadingTier>(tier));
+      }
+    }
+    if (swapped & ShadingTiers::FloorReloaded)
+    {
+      loadFloorUniforms();
+    }
+    // keep drawing frames until the driver has finished
+    if (m_shading.isReloading())
+    {
+      m_scheduler.invalidate(LayerSettings);
+    }
+  }
+  m_shading.beginFrame();
+  // a lock or clear is uploaded once, every frame of its animation after that only moves the time on
+  float time = animationTime();
+  if (m_eventsChanged)
+  {
+    for (int tier = 0; tier < ShadingTiers::TierCount; ++tier)
+    {
+      loadBoardEvents(static_cast<ShadingTier>(tier));
+    }
+    m_eventsChanged = false;
+  }
 
   // grab an instance of the shader manager
-  ngl::ShaderLib::use("PBR");
+  m_shading.useActive();
 
   // Rotation based on the mouse position for our global transform
   auto rotX = ngl::Mat4::rotateX(m_win.spinXFace);
@@ -208,36 +883,72 @@ void NGLScene::paintGL()
   // draw
   loadMatricesToShader();
 
-  ngl::ShaderLib::use("PBR");
-  // draw tetris cubes
-  for (auto& cube : m_cubes)
+  m_shading.useActive();
+  m_shading.bindTextures();
+  m_shadows.bindTextures();
+  // draw tetris cubes for every board, the stacks and the falling pieces in one instanced call each
+  ngl::Mat4 cubeMV = m_view * m_mouseGlobalTX;
+  ngl::Mat3 cubeNormalMatrix = cubeMV;
+  cubeNormalMatrix.inverse().transpose();
+  m_shading.setUniform("MVP", m_projection * cubeMV);
+  m_shading.setUniform("normalMatrix", cubeNormalMatrix);
+  m_shading.setUniform("time", time);
+  m_shading.setUniform("stack", 1);
+  m_instances.draw();
+  m_shading.setUniform("stack", 0);
+  m_pieceInstances.draw();
+  if (m_sandbox)
   {
-        cube.updatePos();
-        cube.draw("PBR", m_mouseGlobalTX, m_view, m_projection);
+    m_chunkCubes.draw(m_sandbox->getBoard(), sandboxOrigin(), boardOffset(0, 1), m_projection * cubeMV);
   }
 
-  ngl::ShaderLib::use(ngl::nglCheckerShader);
-  auto tx = ngl::Mat4::translate(0.0f, -0.6f, 0.0f);
-  auto ts = ngl::Mat4::scale(0.5f, 0.5f, 0.25f);
-  auto MVP = m_projection * m_view * m_mouseGlobalTX * tx * ts;
-  ngl::Mat3 normalMatrix = m_view * m_mouseGlobalTX;
-  normalMatrix.inverse().transpose();
-  ngl::ShaderLib::setUniform("MVP", MVP);
-  ngl::ShaderLib::setUniform("normalMatrix", normalMatrix);
+  m_shading.useFloor();
+  m_shading.setUniform("MVP", m_projection * m_view * m_mouseGlobalTX * floorTransform());
   if (m_transformLight)
   {
-    ngl::ShaderLib::setUniform("lightPosition", (m_mouseGlobalTX * m_lightPos).toVec3());
+    m_shading.setUniform("lightPosition", (m_mouseGlobalTX * m_lightPos).toVec3());
   }
   ngl::VAOPrimitives::draw("floor");
+  m_shading.endFrame();
+
+  // keep drawing until every animation has played out, then stop until something changes
+  if (time < m_animationEnd)
+  {
+    m_scheduler.invalidate(LayerAnimation);
+  }
 
+  if (m_firstFrame)
+  {
+    // wait for the GPU so the time covers everything startup queued, once
+    glFinish();
+    m_firstFrame = false;
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_created);
+    const ShaderProgramCache &cache = m_shading.cache();
+    std::cout << "first frame after " << elapsed.count() << "ms, " << cache.cacheHits() << " shader programs from cache, "
+              << cache.compiles() << " compiled" << (cache.hasParallelCompile() ? " in parallel" : "") << "\n";
+  }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
 void NGLScene::keyPressEvent(QKeyEvent *_event)
 {
+  // Game controls are stamped now and reach the simulation frame they happened in //
+  int player = 0;
+  if (InputFrame button = m_voxel ? voxelButton(_event->key()) : gameButton(_event->key(), player))
+  {
+    // the game repeats held buttons itself, at its own rate, so the keyboard's repeats are ignored
+    if (!_event->isAutoRepeat())
+    {
+      m_input.Press(player, button, std::chrono::steady_clock::now());
+    }
+    return;
+  }
+
   // that method is called every time the main window recives a key event.
-  // we then switch on the key value and set the camera in the GLWindow
+  // we then switch on the key value and set the camera in the GLWindow,
+  // keys that change nothing on screen don't cost a frame
+  RenderLayers layers = 0;
   switch (_event->key())
   {
   // escape key to quit
@@ -248,30 +959,14 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
 #ifndef USINGIOS_
   case Qt::Key_W:
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    layers = LayerSettings;
     break;
   // turn off wire frame
   case Qt::Key_S:
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    layers = LayerSettings;
     break;
 #endif
-    // Game controls //
-  case Qt::Key_Down:
-      m_board.MoveTetromino(m_tetromino, 1);
-      updateCubes();
-      break;
-  case Qt::Key_Left:
-    m_board.MoveTetromino(m_tetromino, 2);
-      updateCubes();
-    break;
-  case Qt::Key_Right:
-      m_board.MoveTetromino(m_tetromino, 3);
-      updateCubes();
-      break;
-  case Qt::Key_Up:
-      m_board.RotateTetromino(m_tetromino);
-      updateCubes();
-      break;
-    //              //
   // show full screen
   case Qt::Key_F:
     showFullScreen();
@@ -284,12 +979,52 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
     m_win.spinXFace = 0;
     m_win.spinYFace = 0;
     m_modelPos.set(ngl::Vec3::zero());
+    layers = LayerCamera;
     break;
   case Qt::Key_L:
     m_transformLight ^= true;
+    layers = LayerCamera;
+    break;
+  // shading tiers, 0 lets GPU frame time choose
+  case Qt::Key_1:
+    m_shading.setTier(ShadingTier::FullPBR);
+    layers = LayerSettings;
+    break;
+  case Qt::Key_2:
+    m_shading.setTier(ShadingTier::Matcap);
+    layers = LayerSettings;
+    break;
+  case Qt::Key_3:
+    m_shading.setTier(ShadingTier::Lambert);
+    layers = LayerSettings;
+    break;
+  case Qt::Key_0:
+    m_shading.setAuto(!m_shading.isAuto());
+    layers = LayerSettings;
+    break;
+  // cycle the colour theme, the boards only store palette indices so this is one upload
+  case Qt::Key_P:
+    makeCurrent();
+    m_palette = static_cast<PaletteTheme>((static_cast<int>(m_palette) + 1) % Palette::ThemeCount);
+    for (int tier = 0; tier < ShadingTiers::TierCount; ++tier)
+    {
+      loadPalette(static_cast<ShadingTier>(tier));
+    }
+    std::cout << "palette: " << Palette::name(m_palette) << "\n";
+    layers = LayerSettings;
     break;
   default:
     break;
   }
-  update();
+  m_scheduler.invalidate(layers);
+}
+
+void NGLScene::keyReleaseEvent(QKeyEvent *_event)
+{
+  int player = 0;
+  InputFrame button = m_voxel ? voxelButton(_event->key()) : gameButton(_event->key(), player);
+  if (button && !_event->isAutoRepeat())
+  {
+    m_input.Release(player, button, std::chrono::steady_clock::now());
+  }
 }
@@ -0,0 +1,122 @@
+/****************************************************************************
+Headless rollback netplay test, run one server and one client, e.g.
+  ./tetris_netplay --server 7000 --latency 40 --loss 0.1
+  ./tetris_netplay --client 127.0.0.1:7000 --latency 40 --loss 0.1
+Both sides play scripted random input and report rollback and desync statistics.
+****************************************************************************/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include "NetplaySession.h"
+
+int main(int argc, char** argv)
+{
+    NetplayOptions options;
+    int frames = 3600;
+    unsigned int botSeed = 1;
+    bool haveRole = false;
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--server")
+        {
+            options.server = true;
+            options.port = std::stoi(value);
+            haveRole = true;
+        }
+        else if (arg == "--client")
+        {
+            auto colon = value.find(':');
+            options.host = value.substr(0, colon);
+            options.port = colon == std::string::npos ? options.port : std::stoi(value.substr(colon + 1));
+            haveRole = true;
+        }
+        else if (arg == "--delay") options.inputDelay = std::stoi(value);
+        else if (arg == "--latency") options.latencyMs = std::stoi(value);
+        else if (arg == "--jitter") options.jitterMs = std::stoi(value);
+        else if (arg == "--loss") options.loss = std::stod(value);
+        else if (arg == "--seed") options.seed = static_cast<unsigned int>(std::stoul(value));
+        else if (arg == "--frames") frames = std::stoi(value);
+        else if (arg == "--bot-seed") botSeed = static_cast<unsigned int>(std::stoul(value));
+        else continue;
+        ++i;
+    }
+    if (!haveRole)
+    {
+        std::cerr << "usage: tetris_netplay (--server PORT | --client HOST:PORT) [--delay N] [--latency MS]\n"
+                     "       [--jitter MS] [--loss P] [--seed N] [--frames N] [--bot-seed N]\n";
+        return EXIT_FAILURE;
+    }
+
+    NetplaySession session;
+    std::cout << (options.server ? "Waiting for client on port " : "Connecting to ") << options.host << ":" << options.port << "\n";
+    if (!session.Connect(Board(), options, 30000))
+    {
+        std::cerr << "No peer\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "Connected as player " << session.getSession().getLocalPlayer() << "\n";
+
+    // scripted player: hold a random set of buttons for a random number of frames
+    std::minstd_rand bot(botSeed + session.getSession().getLocalPlayer());
+    InputFrame held = 0;
+    int holdFrames = 0;
+
+    using Clock = std::chrono::steady_clock;
+    const auto frameTime = std::chrono::microseconds(1000000 / Game::FrameRate);
+    auto start = Clock::now();
+    auto next = start;
+    auto deadline = start + frameTime * frames + std::chrono::seconds(10);
+    while (Clock::now() < deadline)
+    {
+        session.Poll();
+        const RollbackSession& rollback = session.getSession();
+        if (rollback.getFrame() < frames)
+        {
+            if (--holdFrames <= 0)
+            {
+                held = static_cast<InputFrame>(bot() % 16);
+                holdFrames = 4 + static_cast<int>(bot() % 16);
+            }
+            session.AdvanceFrame(held);
+        }
+        else
+        {
+            // finished, keep exchanging until the peer has confirmed our last frame too
+            session.Service();
+            if (rollback.getConfirmedFrame() >= frames - 1)
+            {
+                break;
+            }
+        }
+        next += frameTime;
+        std::this_thread::sleep_until(next);
+    }
+
+    const RollbackSession& rollback = session.getSession();
+    const auto& stats = rollback.getStats();
+    int checksumFrame = 0;
+    std::uint32_t checksum = rollback.getConfirmedChecksum(checksumFrame);
+    std::cout << "frames simulated      " << rollback.getFrame() << "\n"
+              << "frames stalled        " << session.getStalls() << "\n"
+              << "datagrams dropped     " << session.getDropped() << "\n"
+              << "rollbacks             " << stats.rollbacks << "\n"
+              << "frames resimulated    " << stats.resimulatedFrames << "\n"
+              << "deepest rollback      " << stats.maxRollbackFrames << " frames\n"
+              << "mean rollback time    " << (stats.rollbacks ? stats.totalResimMicros / stats.rollbacks : 0.0) << " us\n"
+              << "worst rollback time   " << stats.maxResimMicros << " us\n"
+              << "checksums compared    " << session.getChecksumsCompared() << "\n"
+              << "confirmed checksum    " << std::hex << checksum << std::dec << " at frame " << checksumFrame << "\n";
+    if (session.hasDesynced())
+    {
+        std::cout << "DESYNC at frame " << session.getDesyncFrame() << "\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "in sync\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,253 @@
+#include "NetplaySession.h"
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    // Datagram layout, all integers little-endian:
+    //   'N' 'T' type
+    //   Hello: nothing
+    //   Start: u32 seed, u8 input delay
+    //   Input: i32 first frame, u8 count, count x u8 input, i32 ack frame, i32 checksum frame, u32 checksum
+    enum PacketType : std::uint8_t { PacketHello = 1, PacketStart = 2, PacketInput = 3 };
+
+    constexpr std::size_t MaxPacket = 512;
+
+    struct Writer
+    {
+        std::array<std::uint8_t, MaxPacket> bytes;
+        std::size_t size = 0;
+
+        void u8(std::uint8_t value) { bytes[size++] = value; }
+        void u32(std::uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                u8(static_cast<std::uint8_t>(value >> (i * 8)));
+            }
+        }
+        void header(PacketType type) { u8('N'); u8('T'); u8(type); }
+    };
+
+    struct Reader
+    {
+        const std::uint8_t* bytes;
+        std::size_t size;
+        std::size_t pos = 3;
+
+        bool has(std::size_t count) const { return pos + count <= size; }
+        std::uint8_t u8() { return bytes[pos++]; }
+        std::uint32_t u32()
+        {
+            std::uint32_t value = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                value |= static_cast<std::uint32_t>(bytes[pos++]) << (i * 8);
+            }
+            return value;
+        }
+    };
+
+    bool validHeader(const std::uint8_t* bytes, int size)
+    {
+        return size >= 3 && bytes[0] == 'N' && bytes[1] == 'T';
+    }
+}
+
+bool NetplaySession::Connect(const Board& board, const NetplayOptions& options, int timeoutMs)
+{
+    if (!_link.Open(options.server ? options.port : 0))
+    {
+        return false;
+    }
+    _link.SetImpairment(options.latencyMs, options.jitterMs, options.loss, options.seed ^ (options.server ? 1u : 2u));
+    if (!options.server && !_link.SetPeer(options.host, options.port))
+    {
+        return false;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    auto nextHello = std::chrono::steady_clock::now();
+    std::array<std::uint8_t, MaxPacket> buffer;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        if (!options.server && std::chrono::steady_clock::now() >= nextHello)
+        {
+            // keep saying hello until the start arrives, either may be lost
+            Writer hello;
+            hello.header(PacketHello);
+            _link.Send(hello.bytes.data(), hello.size);
+            nextHello += std::chrono::milliseconds(100);
+        }
+        _link.Flush();
+
+        sockaddr_in from{};
+        int size = _link.Receive(buffer.data(), buffer.size(), &from);
+        if (size < 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (!validHeader(buffer.data(), size))
+        {
+            continue;
+        }
+
+        if (options.server && buffer[2] == PacketHello)
+        {
+            _link.SetPeer(from);
+            _seed = options.seed;
+            _inputDelay = std::clamp(options.inputDelay, 0, RollbackSession::MaxInputDelay);
+            _session = std::make_unique<RollbackSession>(board, _seed, 0, _inputDelay);
+            Writer start;
+            start.header(PacketStart);
+            start.u32(_seed);
+            start.u8(static_cast<std::uint8_t>(_inputDelay));
+            _link.Send(start.bytes.data(), start.size);
+            return true;
+        }
+        if (!options.server && buffer[2] == PacketStart && _link.isPeer(from))
+        {
+            Reader reader{buffer.data(), static_cast<std::size_t>(size)};
+            if (!reader.has(5))
+            {
+                continue;
+            }
+            _seed = reader.u32();
+            _inputDelay = reader.u8();
+            if (_inputDelay != std::clamp(options.inputDelay, 0, RollbackSession::MaxInputDelay))
+            {
+                std::cerr << "the server plays with " << _inputDelay << " frames of input delay, not "
+                          << options.inputDelay << "\n";
+            }
+            _session = std::make_unique<RollbackSession>(board, _seed, 1, _inputDelay);
+            return true;
+        }
+    }
+    return false;
+}
+
+void NetplaySession::Poll()
+{
+    std::array<std::uint8_t, MaxPacket> buffer;
+    sockaddr_in from{};
+    int size;
+    while ((size = _link.Receive(buffer.data(), buffer.size(), &from)) >= 0)
+    {
+        // only the peer the handshake settled on is listened to, anything else on the port is dropped
+        if (!_link.isPeer(from) || !validHeader(buffer.data(), size))
+        {
+            continue;
+        }
+        if (buffer[2] == PacketHello)
+        {
+            // our start was lost, the client is still waiting for it
+            Writer start;
+            start.header(PacketStart);
+            start.u32(_seed);
+            start.u8(static_cast<std::uint8_t>(_inputDelay));
+            _link.Send(start.bytes.data(), start.size);
+            continue;
+        }
+        if (buffer[2] != PacketInput)
+        {
+            continue;
+        }
+
+        Reader reader{buffer.data(), static_cast<std::size_t>(size)};
+        if (!reader.has(5))
+        {
+            continue;
+        }
+        auto first = static_cast<int>(reader.u32());
+        int count = reader.u8();
+        if (!reader.has(count + 12))
+        {
+            continue;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            _session->AddRemoteInput(first + i, reader.u8());
+        }
+        _peerAck = std::max(_peerAck, static_cast<int>(reader.u32()));
+        auto checksumFrame = static_cast<int>(reader.u32());
+        auto checksum = reader.u32();
+        if (checksumFrame > _remoteChecksumFrame)
+        {
+            _remoteChecksumFrame = checksumFrame;
+            _remoteChecksum = checksum;
+        }
+    }
+}
+
+bool NetplaySession::AdvanceFrame(InputFrame localInput)
+{
+    bool advanced = _session->CanAdvance();
+    if (advanced)
+    {
+        _session->AdvanceFrame(localInput);
+    }
+    else
+    {
+        _stalls++;
+    }
+    CheckRemoteChecksum();
+    SendInputs();
+    return advanced;
+}
+
+void NetplaySession::Service()
+{
+    _session->ApplyRollback();
+    CheckRemoteChecksum();
+    SendInputs();
+}
+
+void NetplaySession::SendInputs()
+{
+    // resend everything the peer hasn't acknowledged, capped to what the history still holds
+    int end = _session->getLocalInputEnd();
+    int first = std::max({_peerAck + 1, end - (RollbackSession::HistorySize - RollbackSession::MaxRollback), 0});
+
+    Writer packet;
+    packet.header(PacketInput);
+    packet.u32(static_cast<std::uint32_t>(first));
+    packet.u8(static_cast<std::uint8_t>(end - first));
+    for (int frame = first; frame < end; ++frame)
+    {
+        packet.u8(_session->getLocalInput(frame));
+    }
+    int checksumFrame = 0;
+    std::uint32_t checksum = _session->getConfirmedChecksum(checksumFrame);
+    packet.u32(static_cast<std::uint32_t>(_session->getConfirmedFrame()));
+    packet.u32(static_cast<std::uint32_t>(checksumFrame));
+    packet.u32(checksum);
+    _link.Send(packet.bytes.data(), packet.size);
+    _link.Flush();
+}
+
+void NetplaySession::CheckRemoteChecksum()
+{
+    if (_remoteChecksumFrame < 0)
+    {
+        return;
+    }
+    int confirmedFrame = 0;
+    std::uint32_t confirmed = _session->getConfirmedChecksum(confirmedFrame);
+    if (_remoteChecksumFrame > confirmedFrame)
+    {
+        return; // we haven't confirmed that far yet
+    }
+    if (_remoteChecksumFrame > _session->getFrame() - RollbackSession::HistorySize)
+    {
+        std::uint32_t ours = _remoteChecksumFrame == confirmedFrame ? confirmed : _session->getChecksum(_remoteChecksumFrame);
+        _checksumsCompared++;
+        if (ours != _remoteChecksum && _desyncFrame < 0)
+        {
+            _desyncFrame = _remoteChecksumFrame;
+        }
+    }
+    _remoteChecksumFrame = -1;
+}
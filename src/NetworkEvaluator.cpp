@@ -0,0 +1,412 @@
+#include "NetworkEvaluator.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TETRIS_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    constexpr char Magic[4] = {'T', 'N', 'N', '1'};
+    constexpr int Lanes = 32; // bytes of one 256-bit vector, weight rows are padded to a multiple of it
+
+    constexpr int Group = 4;  // boards run through each weight row together, so the row is loaded once for all of them
+
+    // A layer's sums before the biases, each weight row times the activations of a group of boards stride bytes apart.
+    using DotFunction = void (*)(const std::uint8_t*, int, const std::int8_t*, int, int, std::int32_t (*)[Group]);
+
+    void dotPortable(const std::uint8_t* activations, int stride, const std::int8_t* weights, int length, int outputs,
+                     std::int32_t (*sums)[Group])
+    {
+        for (int output = 0; output < outputs; ++output, weights += length)
+        {
+            for (int board = 0; board < Group; ++board)
+            {
+                const std::uint8_t* a = activations + board * stride;
+                std::int32_t sum = 0;
+                for (int i = 0; i < length; ++i)
+                {
+                    sum += static_cast<std::int32_t>(a[i]) * weights[i];
+                }
+                sums[output][board] = sum;
+            }
+        }
+    }
+
+#ifdef TETRIS_X86_KERNELS
+    static_assert(Group == 4, "the kernels run four boards at a time");
+
+    // The kernels are compiled for their instruction sets whatever the build's flags, and only
+    // called once the CPU has been checked for them.
+    __attribute__((target("avx2"))) __m256i load(const std::uint8_t* activations, int i)
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(activations + i));
+    }
+
+    // Written out per board rather than looped so the accumulators stay in registers.
+    __attribute__((target("avx2"))) void storeSums(const __m256i* sum, std::int32_t* out)
+    {
+        // the four boards' lanes summed together, board b's total in element b
+        __m256i pairs = _mm256_hadd_epi32(_mm256_hadd_epi32(sum[0], sum[1]), _mm256_hadd_epi32(sum[2], sum[3]));
+        __m128i totals = _mm_add_epi32(_mm256_castsi256_si128(pairs), _mm256_extracti128_si256(pairs, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), totals);
+    }
+
+    __attribute__((target("avx2"))) void dotAvx2(const std::uint8_t* activations, int stride,
+                                                 const std::int8_t* weights, int length, int outputs,
+                                                 std::int32_t (*sums)[Group])
+    {
+        // byte products summed in pairs to 16 bits, activations under 128 keep the pairs from saturating
+        const __m256i ones = _mm256_set1_epi16(1);
+        for (int output = 0; output < outputs; ++output, weights += length)
+        {
+            __m256i sum[Group] = {};
+            for (int i = 0; i < length; i += Lanes)
+            {
+                __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+                sum[0] = _mm256_add_epi32(sum[0], _mm256_madd_epi16(_mm256_maddubs_epi16(load(activations, i), w), ones));
+                sum[1] = _mm256_add_epi32(sum[1], _mm256_madd_epi16(_mm256_maddubs_epi16(load(activations + stride, i), w), ones));
+                sum[2] = _mm256_add_epi32(sum[2], _mm256_madd_epi16(_mm256_maddubs_epi16(load(activations + 2 * stride, i), w), ones));
+                sum[3] = _mm256_add_epi32(sum[3], _mm256_madd_epi16(_mm256_maddubs_epi16(load(activations + 3 * stride, i), w), ones));
+            }
+            storeSums(sum, sums[output]);
+        }
+    }
+
+    __attribute__((target("avx2,avx512vnni,avx512vl"))) void dotVnni(const std::uint8_t* activations, int stride,
+                                                                     const std::int8_t* weights, int length,
+                                                                     int outputs, std::int32_t (*sums)[Group])
+    {
+        // four byte products summed straight into each 32-bit lane
+        for (int output = 0; output < outputs; ++output, weights += length)
+        {
+            __m256i sum[Group] = {};
+            for (int i = 0; i < length; i += Lanes)
+            {
+                __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+                sum[0] = _mm256_dpbusd_epi32(sum[0], load(activations, i), w);
+                sum[1] = _mm256_dpbusd_epi32(sum[1], load(activations + stride, i), w);
+                sum[2] = _mm256_dpbusd_epi32(sum[2], load(activations + 2 * stride, i), w);
+                sum[3] = _mm256_dpbusd_epi32(sum[3], load(activations + 3 * stride, i), w);
+            }
+            storeSums(sum, sums[output]);
+        }
+    }
+#endif
+
+    DotFunction dotFor(NetworkKernel kernel)
+    {
+#ifdef TETRIS_X86_KERNELS
+        switch (kernel)
+        {
+        case NetworkKernel::Avx2: return dotAvx2;
+        case NetworkKernel::Vnni: return dotVnni;
+        default: break;
+        }
+#else
+        (void)kernel;
+#endif
+        return dotPortable;
+    }
+
+    bool supported(NetworkKernel kernel)
+    {
+#ifdef TETRIS_X86_KERNELS
+        switch (kernel)
+        {
+        case NetworkKernel::Avx2: return __builtin_cpu_supports("avx2");
+        case NetworkKernel::Vnni:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("avx512vnni") &&
+                   __builtin_cpu_supports("avx512vl");
+        default: return true;
+        }
+#else
+        return kernel == NetworkKernel::Portable;
+#endif
+    }
+
+    int padded(int inputs)
+    {
+        return (inputs + Lanes - 1) / Lanes * Lanes;
+    }
+
+    template <typename T>
+    bool readValue(std::istream& in, T& value)
+    {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    template <typename T>
+    void writeValue(std::ostream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+}
+
+NetworkKernel NetworkEvaluator::BestKernel()
+{
+    for (NetworkKernel kernel : {NetworkKernel::Vnni, NetworkKernel::Avx2})
+    {
+        if (supported(kernel))
+        {
+            return kernel;
+        }
+    }
+    return NetworkKernel::Portable;
+}
+
+const char* NetworkEvaluator::KernelName(NetworkKernel kernel)
+{
+    switch (kernel)
+    {
+    case NetworkKernel::Avx2: return "avx2";
+    case NetworkKernel::Vnni: return "vnni";
+    default: return "portable";
+    }
+}
+
+NetworkKernel NetworkEvaluator::setKernel(NetworkKernel kernel)
+{
+    _kernel = supported(kernel) ? kernel : NetworkKernel::Portable;
+    return _kernel;
+}
+
+long long NetworkEvaluator::getOperations() const
+{
+    long long operations = 0;
+    for (const Layer& layer : _layers)
+    {
+        operations += static_cast<long long>(layer.inputs) * layer.outputs;
+    }
+    return operations;
+}
+
+std::string NetworkEvaluator::Validate() const
+{
+    if (_width < 1 || _width > 64 || _height < 1)
+    {
+        return "board size out of range";
+    }
+    if (_layers.empty() || _layers.back().outputs != 1)
+    {
+        return "the last layer must have one output";
+    }
+    int inputs = _width * _height + _width;
+    for (const Layer& layer : _layers)
+    {
+        if (layer.inputs != inputs || layer.stride > MaxInputs)
+        {
+            return "layer inputs don't match, at most " + std::to_string(MaxInputs);
+        }
+        if (layer.outputs < 1 || (&layer != &_layers.back() && layer.outputs > MaxNeurons))
+        {
+            return "hidden layers take 1 to " + std::to_string(MaxNeurons) + " outputs";
+        }
+        if (layer.shift < 0 || layer.shift > 31)
+        {
+            return "shift out of range";
+        }
+        inputs = layer.outputs;
+    }
+    return std::string();
+}
+
+bool NetworkEvaluator::Load(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        std::cerr << path << ": cannot open network file\n";
+        return false;
+    }
+    return Read(in);
+}
+
+bool NetworkEvaluator::Read(std::istream& in)
+{
+    char magic[4] = {};
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint32_t count = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, Magic, sizeof(Magic)) != 0 || !readValue(in, width) ||
+        !readValue(in, height) || !readValue(in, count) || count == 0 || count > 16 || width > 64 || height > MaxInputs)
+    {
+        std::cerr << "not a network file\n";
+        return false;
+    }
+
+    NetworkEvaluator network;
+    network._width = static_cast<int>(width);
+    network._height = static_cast<int>(height);
+    int inputs = network._width * network._height + network._width;
+    for (std::uint32_t index = 0; index < count; ++index)
+    {
+        Layer layer;
+        std::uint32_t outputs = 0;
+        std::uint32_t shift = 0;
+        if (!readValue(in, outputs) || !readValue(in, shift) || outputs == 0 || outputs > MaxNeurons)
+        {
+            std::cerr << "network layer " << index << " is truncated or too large\n";
+            return false;
+        }
+        layer.inputs = inputs;
+        layer.stride = padded(inputs);
+        layer.outputs = static_cast<int>(outputs);
+        layer.shift = static_cast<int>(shift);
+        if (layer.stride > MaxInputs)
+        {
+            std::cerr << "network layer " << index << " has more than " << MaxInputs << " inputs\n";
+            return false;
+        }
+        layer.biases.resize(outputs);
+        layer.weights.assign(static_cast<std::size_t>(layer.stride) * outputs, 0);
+        in.read(reinterpret_cast<char*>(layer.biases.data()), static_cast<std::streamsize>(outputs * sizeof(std::int32_t)));
+        for (int output = 0; output < layer.outputs; ++output)
+        {
+            in.read(reinterpret_cast<char*>(layer.weights.data() + static_cast<std::size_t>(output) * layer.stride), inputs);
+        }
+        if (!in)
+        {
+            std::cerr << "network layer " << index << " is truncated\n";
+            return false;
+        }
+        inputs = layer.outputs;
+        network._layers.push_back(std::move(layer));
+    }
+    std::string error = network.Validate();
+    if (!error.empty())
+    {
+        std::cerr << "invalid network: " << error << "\n";
+        return false;
+    }
+    network._kernel = BestKernel();
+    *this = std::move(network);
+    return true;
+}
+
+void NetworkEvaluator::Write(std::ostream& out) const
+{
+    out.write(Magic, sizeof(Magic));
+    writeValue(out, static_cast<std::uint32_t>(_width));
+    writeValue(out, static_cast<std::uint32_t>(_height));
+    writeValue(out, static_cast<std::uint32_t>(_layers.size()));
+    for (const Layer& layer : _layers)
+    {
+        writeValue(out, static_cast<std::uint32_t>(layer.outputs));
+        writeValue(out, static_cast<std::uint32_t>(layer.shift));
+        out.write(reinterpret_cast<const char*>(layer.biases.data()),
+                  static_cast<std::streamsize>(layer.biases.size() * sizeof(std::int32_t)));
+        for (int output = 0; output < layer.outputs; ++output)
+        {
+            out.write(reinterpret_cast<const char*>(layer.weights.data() + static_cast<std::size_t>(output) * layer.stride),
+                      layer.inputs);
+        }
+    }
+}
+
+void NetworkEvaluator::Randomise(int width, int height, const std::vector<int>& hidden, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> weight(-24, 24);
+    std::uniform_int_distribution<int> bias(-256, 256);
+    _width = width;
+    _height = height;
+    _layers.clear();
+    int inputs = width * height + width;
+    std::vector<int> sizes = hidden;
+    sizes.push_back(1);
+    for (int outputs : sizes)
+    {
+        Layer layer;
+        layer.inputs = inputs;
+        layer.stride = padded(inputs);
+        layer.outputs = outputs;
+        // keeps a typical sum in range of the next layer's bytes
+        layer.shift = 6;
+        layer.biases.resize(static_cast<std::size_t>(outputs));
+        layer.weights.assign(static_cast<std::size_t>(layer.stride) * outputs, 0);
+        for (int output = 0; output < outputs; ++output)
+        {
+            layer.biases[output] = bias(random);
+            for (int input = 0; input < inputs; ++input)
+            {
+                layer.weights[static_cast<std::size_t>(output) * layer.stride + input] =
+                        static_cast<std::int8_t>(weight(random));
+            }
+        }
+        inputs = outputs;
+        _layers.push_back(std::move(layer));
+    }
+    _kernel = BestKernel();
+}
+
+void NetworkEvaluator::EvaluateBatch(const std::uint64_t* rows, int count, int* scores) const
+{
+    const DotFunction dot = dotFor(_kernel);
+    alignas(Lanes) std::uint8_t input[Group][MaxInputs];
+    alignas(Lanes) std::uint8_t hidden[2][Group][MaxNeurons];
+    std::int32_t sums[MaxNeurons][Group];
+    const int cells = _width * _height;
+
+    for (int first = 0; first < count; first += Group)
+    {
+        // the cells row by row, then each column's height, zero padded to a whole vector; a short
+        // last group runs its spare slots on empty boards and drops their scores
+        const int boards = std::min(Group, count - first);
+        for (int board = 0; board < Group; ++board)
+        {
+            std::memset(input[board], 0, static_cast<std::size_t>(_layers.front().stride));
+            if (board >= boards)
+            {
+                continue;
+            }
+            const std::uint64_t* boardRows = rows + static_cast<std::size_t>(first + board) * _height;
+            std::uint8_t* heights = input[board] + cells;
+            for (int row = 0; row < _height; ++row)
+            {
+                std::uint64_t bits = boardRows[row];
+                for (int col = 0; bits >> col; ++col)
+                {
+                    if (bits >> col & 1)
+                    {
+                        input[board][row * _width + col] = 1;
+                        heights[col] = static_cast<std::uint8_t>(std::min(row + 1, 127));
+                    }
+                }
+            }
+        }
+
+        const std::uint8_t* activations = input[0];
+        int stride = MaxInputs;
+        for (std::size_t index = 0; index < _layers.size(); ++index)
+        {
+            const Layer& layer = _layers[index];
+            dot(activations, stride, layer.weights.data(), layer.stride, layer.outputs, sums);
+            if (index + 1 == _layers.size())
+            {
+                break;
+            }
+            auto& next = hidden[index & 1];
+            for (int board = 0; board < Group; ++board)
+            {
+                std::memset(next[board], 0, static_cast<std::size_t>(padded(layer.outputs)));
+                for (int output = 0; output < layer.outputs; ++output)
+                {
+                    next[board][output] =
+                            static_cast<std::uint8_t>(std::clamp((sums[output][board] + layer.biases[output]) >> layer.shift, 0, 127));
+                }
+            }
+            activations = next[0];
+            stride = MaxNeurons;
+        }
+        for (int board = 0; board < boards; ++board)
+        {
+            scores[first + board] = sums[0][board] + _layers.back().biases[0];
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#include "Palette.h"
+
+const std::array<ngl::Vec3, PaletteSize> &Palette::colours(PaletteTheme _theme)
+{
+    static const std::array<ngl::Vec3, PaletteSize> themes[ThemeCount] = {
+        {{
+            {0.5f, 0.5f, 0.5f},  // garbage
+            {0.0f, 0.0f, 1.0f},  // I-block
+            {1.0f, 0.0f, 1.0f},  // T-block
+            {0.5f, 0.0f, 1.0f},  // O-block
+            {0.0f, 1.0f, 0.0f},  // Z-block
+            {1.0f, 0.0f, 0.0f},  // S-block
+            {1.0f, 1.0f, 0.0f},  // L-block
+            {0.0f, 1.0f, 1.0f}   // J-block
+        }},
+        {{
+            {0.6f, 0.6f, 0.6f},        // garbage
+            {0.0f, 0.447f, 0.698f},    // I-block, blue
+            {0.8f, 0.475f, 0.655f},    // T-block, reddish purple
+            {0.941f, 0.894f, 0.259f},  // O-block, yellow
+            {0.0f, 0.62f, 0.451f},     // Z-block, bluish green
+            {0.835f, 0.369f, 0.0f},    // S-block, vermillion
+            {0.902f, 0.624f, 0.0f},    // L-block, orange
+            {0.337f, 0.706f, 0.914f}   // J-block, sky blue
+        }}
+    };
+    return themes[static_cast<int>(_theme)];
+}
+
+const char *Palette::name(PaletteTheme _theme)
+{
+    switch (_theme)
+    {
+    case PaletteTheme::Classic: return "classic";
+    case PaletteTheme::ColourBlind: return "colour blind";
+    }
+    return "unknown";
+}
@@ -0,0 +1,399 @@
+#include "PerfectClearSolver.h"
+#include <algorithm>
+#include <bitset>
+
+namespace
+{
+    constexpr int MemoBits = 15; // failed stacks each thread remembers, as a power of two
+
+    int popCount(std::uint64_t bits)
+    {
+        return static_cast<int>(std::bitset<64>(bits).count());
+    }
+}
+
+template <typename BoardType>
+BasicPerfectClearSolver<BoardType>::BasicPerfectClearSolver(int threads)
+    : _pool(std::make_unique<WorkerPool>(std::max(threads, 1)))
+{
+    _workers.resize(static_cast<std::size_t>(_pool->getThreadCount()));
+    for (Worker& worker : _workers)
+    {
+        worker.memo.resize(std::size_t(1) << MemoBits);
+    }
+}
+
+template <typename BoardType>
+int BasicPerfectClearSolver<BoardType>::Place(Field field, int lines, int type, int rotation, int x, Field& child)
+{
+    constexpr int Width = BoardType::FixedWidth;
+    constexpr Field full = (Field(1) << Width) - 1;
+
+    typename Placements::PieceRows bits;
+    if (!Placements::ShiftPiece(type, rotation, x, bits))
+    {
+        return -1;
+    }
+
+    // everything above the field is empty, so the piece falls freely until it meets the field
+    auto fits = [&](int y)
+    {
+        for (int i = 0; i < Pieces::Size; ++i)
+        {
+            int row = y + i;
+            if (bits[i] && (row < 0 || (row < lines && (bits[i] << (row * Width) & field))))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    int y = lines;
+    while (fits(y - 1))
+    {
+        --y;
+    }
+
+    child = field;
+    for (int i = 0; i < Pieces::Size; ++i)
+    {
+        if (bits[i])
+        {
+            if (y + i >= lines)
+            {
+                return -1; // sticks out above the rows to clear
+            }
+            child |= bits[i] << ((y + i) * Width);
+        }
+    }
+
+    // take the full rows out and close the gaps
+    Field kept = 0;
+    int keptRows = 0;
+    for (int row = 0; row < lines; ++row)
+    {
+        Field bitsOfRow = child >> (row * Width) & full;
+        if (bitsOfRow != full)
+        {
+            kept |= bitsOfRow << (keptRows++ * Width);
+        }
+    }
+    child = kept;
+    return keptRows;
+}
+
+template <typename BoardType>
+bool BasicPerfectClearSolver<BoardType>::Hopeless(Field field, int lines, int piecesLeft)
+{
+    constexpr int Width = BoardType::FixedWidth;
+    constexpr Field full = (Field(1) << Width) - 1;
+
+    int empty = lines * Width - popCount(field);
+    if (empty % Pieces::Size != 0 || empty / Pieces::Size > piecesLeft)
+    {
+        return true;
+    }
+
+    // top down: an empty cell under a filled one can't be reached by a straight drop
+    Field covered = 0;
+    Field fullColumns = full;
+    for (int row = lines - 1; row >= 0; --row)
+    {
+        Field bits = field >> (row * Width) & full;
+        if (covered & ~bits)
+        {
+            return true;
+        }
+        covered |= bits;
+        fullColumns &= bits;
+    }
+
+    // a run of columns between full ones is filled by pieces that fit inside it alone
+    int run = 0;
+    for (int col = 0; col <= Width; ++col)
+    {
+        if (col == Width || (fullColumns >> col & 1))
+        {
+            if (run % Pieces::Size != 0)
+            {
+                return true;
+            }
+            run = 0;
+            continue;
+        }
+        for (int row = 0; row < lines; ++row)
+        {
+            run += !(field >> (row * Width + col) & 1);
+        }
+    }
+    return false;
+}
+
+template <typename BoardType>
+bool BasicPerfectClearSolver<BoardType>::Search(Field field, int lines, int ply, Worker& worker,
+                                                std::array<Step, MaxPieces>& steps)
+{
+    if (lines == 0)
+    {
+        return true;
+    }
+    if (ply == _pieceCount || Hopeless(field, lines, _pieceCount - ply))
+    {
+        return false;
+    }
+    if (_nodeLimit > 0 && worker.nodes >= _nodeLimit)
+    {
+        worker.aborted = true;
+        return false;
+    }
+    worker.nodes++;
+
+    MemoEntry& slot = worker.memo[ZobristMix(field + static_cast<std::uint64_t>(lines << 8 | ply) * 0x9e3779b97f4a7c15ull) &
+                                  ((std::size_t(1) << MemoBits) - 1)];
+    if (slot.ply == ply + 1 && slot.lines == lines && slot.field == field)
+    {
+        return false;
+    }
+
+    const int type = _pieces[ply];
+    Field child;
+    for (int rotation = 0; rotation < Pieces::Rotations; ++rotation)
+    {
+        // I, S, Z and O repeat orientations, each shape is only tried once
+        bool repeated = false;
+        for (int earlier = 0; earlier < rotation && !repeated; ++earlier)
+        {
+            repeated = Pieces::getShape(type, earlier) == Pieces::getShape(type, rotation);
+        }
+        if (repeated)
+        {
+            continue;
+        }
+        for (int x = 1 - Pieces::Size; x < BoardType::FixedWidth; ++x)
+        {
+            int left = Place(field, lines, type, rotation, x, child);
+            if (left >= 0 && Search(child, left, ply + 1, worker, steps))
+            {
+                steps[ply] = {rotation, x};
+                return true;
+            }
+        }
+    }
+
+    // a stack cut short by the node limit hasn't failed, it just wasn't finished
+    if (!worker.aborted)
+    {
+        slot = {field, static_cast<std::uint8_t>(lines), static_cast<std::uint8_t>(ply + 1)};
+    }
+    return false;
+}
+
+template <typename BoardType>
+typename BasicPerfectClearSolver<BoardType>::Solution BasicPerfectClearSolver<BoardType>::Solve(
+        const BasicGame<BoardType>& game, int maxLines, long long nodeLimit)
+{
+    constexpr int Width = BoardType::FixedWidth;
+    Solution solution;
+    if (game.isGameOver())
+    {
+        return solution;
+    }
+
+    _pieceCount = MaxPieces;
+    const Tetromino& active = game.getTetromino();
+    _pieces[0] = active.getType();
+    for (int ply = 1; ply < _pieceCount; ++ply)
+    {
+        _pieces[ply] = game.getPreview(ply - 1);
+    }
+    _nodeLimit = nodeLimit;
+
+    // the stack under the active piece; a perfect clear within maxLines needs everything above
+    // those rows to be empty already
+    const typename Placements::Rows stack = Placements::ExtractStack(game);
+    Field root = 0;
+    int height = 0;
+    int filled = 0;
+    for (int row = 0; row < BoardType::FixedHeight; ++row)
+    {
+        std::uint64_t bits = stack[row];
+        if (bits)
+        {
+            height = row + 1;
+            filled += popCount(bits);
+            if (row < MaxLines)
+            {
+                root |= bits << (row * Width);
+            }
+        }
+    }
+
+    for (Worker& worker : _workers)
+    {
+        std::fill(worker.memo.begin(), worker.memo.end(), MemoEntry());
+    }
+    for (int lines = std::max(height, 1); lines <= std::min(maxLines, MaxLines); ++lines)
+    {
+        int empty = lines * Width - filled;
+        if (empty % Pieces::Size != 0 || empty / Pieces::Size > _pieceCount || Hopeless(root, lines, _pieceCount))
+        {
+            continue;
+        }
+
+        _branches.clear();
+        Field child;
+        for (int rotation = 0; rotation < Pieces::Rotations; ++rotation)
+        {
+            bool repeated = false;
+            for (int earlier = 0; earlier < rotation && !repeated; ++earlier)
+            {
+                repeated = Pieces::getShape(_pieces[0], earlier) == Pieces::getShape(_pieces[0], rotation);
+            }
+            for (int x = 1 - Pieces::Size; !repeated && x < Width; ++x)
+            {
+                int left = Place(root, lines, _pieces[0], rotation, x, child);
+                if (left >= 0)
+                {
+                    Branch branch;
+                    branch.step = {rotation, x};
+                    branch.field = child;
+                    branch.lines = left;
+                    _branches.push_back(branch);
+                }
+            }
+        }
+
+        // a branch after one that already succeeded can't be the answer, so it isn't searched
+        _firstFound = static_cast<int>(_branches.size());
+        _nextWorker = 0;
+        for (Worker& worker : _workers)
+        {
+            worker.nodes = 0;
+            worker.aborted = false;
+        }
+        auto task = [&](int begin, int end)
+        {
+            Worker& worker = _workers[_nextWorker++];
+            for (int i = begin; i < end && i < _firstFound; ++i)
+            {
+                Branch& branch = _branches[i];
+                branch.found = Search(branch.field, branch.lines, 1, worker, branch.steps);
+                if (branch.found)
+                {
+                    int first = _firstFound;
+                    while (i < first && !_firstFound.compare_exchange_weak(first, i))
+                    {
+                    }
+                    break;
+                }
+            }
+        };
+        _pool->Run(static_cast<int>(_branches.size()), task);
+
+        for (const Worker& worker : _workers)
+        {
+            solution.nodes += worker.nodes;
+            solution.complete &= !worker.aborted;
+        }
+        int first = _firstFound;
+        if (first < static_cast<int>(_branches.size()))
+        {
+            const Branch& branch = _branches[first];
+            solution.steps = branch.steps;
+            solution.steps[0] = branch.step;
+            solution.pieces = (lines * Width - filled) / Pieces::Size;
+            solution.lines = lines;
+            solution.found = true;
+            return solution;
+        }
+    }
+    return solution;
+}
+
+template <typename BoardType>
+typename BasicPerfectClearSolver<BoardType>::FinessePath BasicPerfectClearSolver<BoardType>::Finesse(
+        const BasicGame<BoardType>& game, const Step& target)
+{
+    constexpr int Columns = BoardType::FixedWidth + Pieces::Size;
+    constexpr int States = Pieces::Rotations * Columns;
+    FinessePath path;
+    if (game.isGameOver())
+    {
+        return path;
+    }
+
+    // breadth first over rotation and column at the active piece's row, on the stack without it
+    BoardType board = game.getBoard();
+    const Tetromino& active = game.getTetromino();
+    board.ClearTetromino(active);
+    auto index = [](int rotation, int x) { return rotation * Columns + x + Pieces::Size - 1; };
+    std::array<int, States> from{};
+    std::array<FinesseKey, States> key{};
+    from.fill(-1);
+    std::array<Tetromino, States> queue;
+    int head = 0;
+    int tail = 0;
+    queue[tail++] = active;
+    from[index(active.getRotation(), active.GetX())] = index(active.getRotation(), active.GetX());
+
+    const auto& targetShape = Pieces::getShape(active.getType(), target.rotation);
+    while (head < tail)
+    {
+        Tetromino piece = queue[head++];
+        int at = index(piece.getRotation(), piece.GetX());
+        if (piece.GetX() == target.x && Pieces::getShape(piece.getType(), piece.getRotation()) == targetShape)
+        {
+            // walk back to the start, then lay the keys out in order and finish with the drop
+            std::array<FinesseKey, MaxKeys> reversed{};
+            int count = 0;
+            while (from[at] != at && count < MaxKeys - 1)
+            {
+                reversed[count++] = key[at];
+                at = from[at];
+            }
+            for (int i = 0; i < count; ++i)
+            {
+                path.keys[i] = reversed[count - 1 - i];
+            }
+            path.keys[count] = FinesseKey::Drop;
+            path.count = count + 1;
+            path.valid = true;
+            return path;
+        }
+
+        auto visit = [&](Tetromino next, FinesseKey pressed)
+        {
+            int to = index(next.getRotation(), next.GetX());
+            if (from[to] < 0 && !board.Overlaps(next))
+            {
+                from[to] = at;
+                key[to] = pressed;
+                queue[tail++] = next;
+            }
+        };
+        Tetromino turned = piece;
+        turned.SetRotation((piece.getRotation() + 1) % Pieces::Rotations);
+        visit(turned, FinesseKey::Rotate);
+        for (int direction : {-1, 1})
+        {
+            Tetromino shifted = piece;
+            shifted.SetPosition(piece.GetX() + direction, piece.GetY());
+            visit(shifted, direction < 0 ? FinesseKey::Left : FinesseKey::Right);
+
+            // auto shift carries on to the last free column
+            Tetromino slid = piece;
+            Tetromino further = slid;
+            further.SetPosition(slid.GetX() + direction, slid.GetY());
+            while (!board.Overlaps(further))
+            {
+                slid = further;
+                further.SetPosition(slid.GetX() + direction, slid.GetY());
+            }
+            visit(slid, direction < 0 ? FinesseKey::DasLeft : FinesseKey::DasRight);
+        }
+    }
+    return path;
+}
+
+template class BasicPerfectClearSolver<Board>;
+template class BasicPerfectClearSolver<TallBoard>;
@@ -0,0 +1,203 @@
+#include "PieceTable.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+bool PieceTable::Load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << path << ": could not open piece file\n";
+        return false;
+    }
+    return Parse(file, path);
+}
+
+bool PieceTable::Parse(std::istream& input, const std::string& source)
+{
+    _names.clear();
+    _shapes.clear();
+    _size = 0;
+
+    std::string name;
+    std::vector<std::string> rows;
+    int pieceLine = 0;
+    auto finishPiece = [&]()
+    {
+        if (name.empty())
+        {
+            return true;
+        }
+        if (!AddPiece(name, rows))
+        {
+            std::cerr << source << ":" << pieceLine << ": piece " << name
+                      << " must be a connected shape of X within " << MaxSize << "x" << MaxSize << "\n";
+            return false;
+        }
+        name.clear();
+        rows.clear();
+        return true;
+    };
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(input, line); ++lineNumber)
+    {
+        // ignore trailing whitespace and carriage returns from files saved on Windows
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+        if (line.compare(0, 6, "piece ") == 0)
+        {
+            if (!finishPiece())
+            {
+                return false;
+            }
+            name = line.substr(6);
+            pieceLine = lineNumber;
+            continue;
+        }
+        if (name.empty() || line.find_first_not_of("X.") != std::string::npos)
+        {
+            std::cerr << source << ":" << lineNumber << ": expected \"piece <name>\" or a row of X and .\n";
+            return false;
+        }
+        rows.push_back(line);
+    }
+    return finishPiece() && !_names.empty();
+}
+
+bool PieceTable::AddPiece(const std::string& name, const std::vector<std::string>& rows)
+{
+    // bounds of the blocks, rows drawn with nothing in them don't count
+    int height = static_cast<int>(rows.size());
+    int left = -1;
+    int right = -1;
+    int top = -1;
+    int bottom = -1;
+    int blocks = 0;
+    int sumX = 0;
+    int sumY = 0;
+    for (int i = 0; i < height; ++i)
+    {
+        for (int j = 0; j < static_cast<int>(rows[i].size()); ++j)
+        {
+            if (rows[i][j] == 'X')
+            {
+                left = left < 0 ? j : std::min(left, j);
+                right = std::max(right, j);
+                top = top < 0 ? i : top;
+                bottom = i;
+                sumX += j;
+                sumY -= i;
+                blocks++;
+            }
+        }
+    }
+    if (blocks == 0)
+    {
+        return false;
+    }
+    int width = right - left + 1;
+    height = bottom - top + 1;
+    int box = std::max(width, height);
+    if (box > MaxSize)
+    {
+        return false;
+    }
+
+    // centre the blocks in a square box so turning about the box's centre keeps the piece in place;
+    // where the space left over is odd, the blocks go to the side that brings their middle closer
+    // to the centre, which puts a T's long row on the pivot, and to the bottom left on a tie
+    auto centre = [&](int size, int sum)
+    {
+        int offset = (box - size) / 2;
+        auto distance = [&](int o) { return std::abs(2 * (o * blocks + sum) - (box - 1) * blocks); };
+        return distance(offset + 1) < distance(offset) && offset + 1 <= box - size ? offset + 1 : offset;
+    };
+    int offsetX = centre(width, sumX - left * blocks);
+    int offsetY = centre(height, sumY + bottom * blocks);
+
+    // rows are written top to bottom but stored bottom up
+    std::array<bool, MaxSize * MaxSize> cells{};
+    int first = -1;
+    for (int i = top; i <= bottom; ++i)
+    {
+        for (int j = left; j < static_cast<int>(rows[i].size()); ++j)
+        {
+            if (rows[i][j] == 'X')
+            {
+                first = (offsetY + bottom - i) * MaxSize + offsetX + j - left;
+                cells[first] = true;
+            }
+        }
+    }
+
+    // flood fill from one block, every block must be reached for the piece to be one polyomino
+    std::array<bool, MaxSize * MaxSize> reached{};
+    std::vector<int> open{first};
+    reached[first] = true;
+    int found = 0;
+    while (!open.empty())
+    {
+        int cell = open.back();
+        open.pop_back();
+        found++;
+        int x = cell % MaxSize;
+        int y = cell / MaxSize;
+        const int neighbours[4][2] = {{x - 1, y}, {x + 1, y}, {x, y - 1}, {x, y + 1}};
+        for (const auto& n : neighbours)
+        {
+            if (n[0] < 0 || n[0] >= MaxSize || n[1] < 0 || n[1] >= MaxSize)
+            {
+                continue;
+            }
+            int next = n[1] * MaxSize + n[0];
+            if (cells[next] && !reached[next])
+            {
+                reached[next] = true;
+                open.push_back(next);
+            }
+        }
+    }
+    if (found != blocks)
+    {
+        return false;
+    }
+
+    // turn clockwise a quarter at a time about the box's centre, (x, y) -> (y, box - 1 - x) with y
+    // pointing up; an odd box turns about its middle cell, an even one about the corner between its
+    // middle cells, so a long piece there alternates between the two middle rows and columns
+    for (int rotation = 0; rotation < Rotations; ++rotation)
+    {
+        Shape shape{};
+        for (int y = 0; y < box; ++y)
+        {
+            for (int x = 0; x < box; ++x)
+            {
+                if (cells[y * MaxSize + x])
+                {
+                    shape[y] |= static_cast<std::uint8_t>(1u << x);
+                }
+            }
+        }
+        _shapes.push_back(shape);
+
+        std::array<bool, MaxSize * MaxSize> turned{};
+        for (int y = 0; y < box; ++y)
+        {
+            for (int x = 0; x < box; ++x)
+            {
+                turned[(box - 1 - x) * MaxSize + y] = cells[y * MaxSize + x];
+            }
+        }
+        cells = turned;
+    }
+
+    _names.push_back(name);
+    _size = std::max(_size, box);
+    return true;
+}
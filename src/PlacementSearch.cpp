@@ -0,0 +1,438 @@
+#include "PlacementSearch.h"
+#include <algorithm>
+#include <bitset>
+#include <cstdlib>
+
+namespace
+{
+    // Moves stored in the table, rotation and column.
+    std::uint16_t encodeMove(int rotation, int x)
+    {
+        return static_cast<std::uint16_t>(rotation << 8 | (x + 128));
+    }
+
+    int popCount(std::uint64_t bits)
+    {
+        return static_cast<int>(std::bitset<64>(bits).count());
+    }
+}
+
+template <typename BoardType>
+BasicPlacementSearch<BoardType>::BasicPlacementSearch(TranspositionTable* table, int threads,
+                                                      const SearchWeights& weights)
+    : _table(table), _weights(weights), _pool(std::make_unique<WorkerPool>(std::max(threads, 1)))
+{
+}
+
+template <typename BoardType>
+bool BasicPlacementSearch<BoardType>::setNetwork(const NetworkEvaluator* network)
+{
+    if (network && (network->getWidth() != BoardType::FixedWidth || network->getHeight() != BoardType::FixedHeight))
+    {
+        return false;
+    }
+    _network = network;
+    return true;
+}
+
+template <typename BoardType>
+bool BasicPlacementSearch<BoardType>::ShiftPiece(int type, int rotation, int x, PieceRows& bits)
+{
+    constexpr std::uint64_t full = (1ull << BoardType::FixedWidth) - 1;
+    const auto& shape = Pieces::getShape(type, rotation);
+    for (int i = 0; i < Pieces::Size; ++i)
+    {
+        if (x < 0)
+        {
+            if (shape[i] & ((1u << -x) - 1))
+            {
+                return false;
+            }
+            bits[i] = shape[i] >> -x;
+        }
+        else
+        {
+            bits[i] = static_cast<std::uint64_t>(shape[i]) << x;
+        }
+        if (bits[i] & ~full)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename BoardType>
+bool BasicPlacementSearch<BoardType>::Land(const Rows& rows, const PieceRows& bits, int& y)
+{
+    constexpr int Height = BoardType::FixedHeight;
+    auto fits = [&](int at)
+    {
+        for (int i = 0; i < Pieces::Size; ++i)
+        {
+            int row = at + i;
+            if (bits[i] && (row < 0 || row >= Height || (bits[i] & rows[row])))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // drop from the spawn row until the next row down is blocked
+    y = Height - Pieces::Size;
+    if (!fits(y))
+    {
+        return false;
+    }
+    while (fits(y - 1))
+    {
+        --y;
+    }
+    return true;
+}
+
+template <typename BoardType>
+int BasicPlacementSearch<BoardType>::Drop(Rows& rows, int type, int rotation, int x)
+{
+    constexpr int Height = BoardType::FixedHeight;
+    constexpr std::uint64_t full = (1ull << BoardType::FixedWidth) - 1;
+    PieceRows bits;
+    int y = 0;
+    if (!ShiftPiece(type, rotation, x, bits) || !Land(rows, bits, y))
+    {
+        return -1;
+    }
+    for (int i = 0; i < Pieces::Size; ++i)
+    {
+        if (bits[i])
+        {
+            rows[y + i] = static_cast<typename BoardType::RowMask>(rows[y + i] | bits[i]);
+        }
+    }
+
+    // only the rows the piece landed in can have filled up
+    int top = std::min(y + Pieces::Size, Height);
+    int kept = std::max(y, 0);
+    for (int row = kept; row < Height; ++row)
+    {
+        if (row < top && rows[row] == full)
+        {
+            continue;
+        }
+        rows[kept++] = rows[row];
+    }
+    std::fill(rows.begin() + kept, rows.end(), 0);
+    return Height - kept;
+}
+
+template <typename BoardType>
+typename BasicPlacementSearch<BoardType>::Rows BasicPlacementSearch<BoardType>::ExtractStack(
+        const BasicGame<BoardType>& game)
+{
+    const BoardType& board = game.getBoard();
+    Rows rows;
+    for (int row = 0; row < BoardType::FixedHeight; ++row)
+    {
+        rows[row] = board.getRow(row);
+    }
+
+    // a game that is over never drew its last piece in
+    const Tetromino& active = game.getTetromino();
+    PieceRows bits;
+    if (game.isGameOver() || !ShiftPiece(active.getType(), active.getRotation(), active.GetX(), bits))
+    {
+        return rows;
+    }
+    for (int i = 0; i < Pieces::Size; ++i)
+    {
+        int row = active.GetY() + i;
+        if (bits[i] && row >= 0 && row < BoardType::FixedHeight)
+        {
+            rows[row] = static_cast<typename BoardType::RowMask>(rows[row] & ~bits[i]);
+        }
+    }
+    return rows;
+}
+
+template <typename BoardType>
+int BasicPlacementSearch<BoardType>::Place(const Node& node, int type, int rotation, int x, Node& child)
+{
+    constexpr int Width = BoardType::FixedWidth;
+    constexpr int Height = BoardType::FixedHeight;
+    constexpr std::uint64_t full = (1ull << Width) - 1;
+
+    PieceRows bits;
+    int y = 0;
+    if (!ShiftPiece(type, rotation, x, bits) || !Land(node.rows, bits, y))
+    {
+        return -1;
+    }
+
+    child = node;
+    for (int i = 0; i < Pieces::Size; ++i)
+    {
+        if (bits[i])
+        {
+            int row = y + i;
+            auto after = static_cast<typename BoardType::RowMask>(child.rows[row] | bits[i]);
+            child.hash ^= BoardType::RowKey(row, child.rows[row]) ^ BoardType::RowKey(row, after);
+            child.rows[row] = after;
+        }
+    }
+
+    // only the rows the piece landed in can have filled up
+    int first = std::max(y, 0);
+    int top = std::min(y + Pieces::Size, Height);
+    while (first < top && child.rows[first] != full)
+    {
+        ++first;
+    }
+    if (first == top)
+    {
+        return 0;
+    }
+
+    // same as BasicBoard::ClearFullRows, the moved rows' keys come out of the hash and go back in
+    int kept = first;
+    for (int row = first; row < Height; ++row)
+    {
+        child.hash ^= BoardType::RowKey(row, child.rows[row]);
+        if (row < top && child.rows[row] == full)
+        {
+            continue;
+        }
+        child.rows[kept++] = child.rows[row];
+    }
+    int cleared = Height - kept;
+    std::fill(child.rows.begin() + kept, child.rows.end(), 0);
+    for (int row = first; row < kept; ++row)
+    {
+        child.hash ^= BoardType::RowKey(row, child.rows[row]);
+    }
+    return cleared;
+}
+
+template <typename BoardType>
+int BasicPlacementSearch<BoardType>::Evaluate(const Rows& rows, const SearchWeights& weights)
+{
+    constexpr int Width = BoardType::FixedWidth;
+    std::array<int, Width> heights{};
+    std::uint64_t covered = 0;
+    int holes = 0;
+
+    // top down: a column's height is the first row it is filled in, and every empty cell under that is a hole
+    for (int row = BoardType::FixedHeight - 1; row >= 0; --row)
+    {
+        std::uint64_t bits = rows[row];
+        holes += popCount(covered & ~bits);
+        for (std::uint64_t fresh = bits & ~covered; fresh; fresh &= fresh - 1)
+        {
+            heights[popCount((fresh & (~fresh + 1)) - 1)] = row + 1;
+        }
+        covered |= bits;
+    }
+
+    int aggregate = 0;
+    int bumpiness = 0;
+    for (int col = 0; col < Width; ++col)
+    {
+        aggregate += heights[col];
+        if (col + 1 < Width)
+        {
+            bumpiness += std::abs(heights[col] - heights[col + 1]);
+        }
+    }
+    return -(weights.height * aggregate + weights.holes * holes + weights.bumpiness * bumpiness);
+}
+
+template <typename BoardType>
+int BasicPlacementSearch<BoardType>::SearchLastPly(const Node& node, int ply, TranspositionStats& stats,
+                                                   std::uint16_t& bestMove)
+{
+    constexpr int Height = BoardType::FixedHeight;
+    std::array<std::uint64_t, MaxPlacements * Height> rows;
+    std::array<int, MaxPlacements> lines;
+    std::array<int, MaxPlacements> scores;
+    std::array<std::uint16_t, MaxPlacements> moves;
+    int count = 0;
+    Node child;
+    for (int rotation = 0; rotation < Pieces::Rotations; ++rotation)
+    {
+        for (int x = 1 - Pieces::Size; x < BoardType::FixedWidth; ++x)
+        {
+            int cleared = Place(node, _pieces[ply], rotation, x, child);
+            if (cleared < 0)
+            {
+                continue;
+            }
+            std::copy(child.rows.begin(), child.rows.end(), rows.begin() + count * Height);
+            lines[count] = cleared;
+            moves[count] = encodeMove(rotation, x);
+            ++count;
+        }
+    }
+    _network->EvaluateBatch(rows.data(), count, scores.data());
+    stats.evaluations += count;
+
+    int best = LossScore;
+    for (int i = 0; i < count; ++i)
+    {
+        int score = lines[i] * _weights.lines + scores[i];
+        if (score > best)
+        {
+            best = score;
+            bestMove = moves[i];
+        }
+    }
+    return best;
+}
+
+template <typename BoardType>
+int BasicPlacementSearch<BoardType>::Search(const Node& node, int ply, TranspositionStats& stats)
+{
+    if (ply == _depth)
+    {
+        stats.evaluations++;
+        if (_network)
+        {
+            std::array<std::uint64_t, BoardType::FixedHeight> rows;
+            std::copy(node.rows.begin(), node.rows.end(), rows.begin());
+            return _network->Evaluate(rows.data());
+        }
+        return Evaluate(node.rows, _weights);
+    }
+
+    const std::uint64_t key = node.hash ^ _sequenceKeys[ply];
+    TranspositionEntry entry;
+    if (_table && _table->Probe(key, entry, stats))
+    {
+        return entry.score;
+    }
+
+    int best = LossScore;
+    std::uint16_t bestMove = 0;
+    if (_network && ply + 1 == _depth)
+    {
+        best = SearchLastPly(node, ply, stats, bestMove);
+    }
+    else
+    {
+        Node child;
+        for (int rotation = 0; rotation < Pieces::Rotations; ++rotation)
+        {
+            for (int x = 1 - Pieces::Size; x < BoardType::FixedWidth; ++x)
+            {
+                int lines = Place(node, _pieces[ply], rotation, x, child);
+                if (lines < 0)
+                {
+                    continue;
+                }
+                int score = lines * _weights.lines + Search(child, ply + 1, stats);
+                if (score > best)
+                {
+                    best = score;
+                    bestMove = encodeMove(rotation, x);
+                }
+            }
+        }
+    }
+
+    if (_table)
+    {
+        entry.score = best;
+        entry.depth = static_cast<std::uint8_t>(_depth - ply);
+        entry.move = bestMove;
+        _table->Store(key, entry, stats);
+    }
+    return best;
+}
+
+template <typename BoardType>
+typename BasicPlacementSearch<BoardType>::Placement BasicPlacementSearch<BoardType>::FindBest(
+        const BasicGame<BoardType>& game, int depth)
+{
+    if (game.isGameOver())
+    {
+        return Placement();
+    }
+
+    // the pieces to place and a key for each tail of the sequence, so a stack is only
+    // shared between nodes with the same pieces still to come
+    _depth = std::clamp(depth, 1, MaxDepth);
+    const Tetromino& active = game.getTetromino();
+    _pieces[0] = active.getType();
+    for (int ply = 1; ply < _depth; ++ply)
+    {
+        _pieces[ply] = game.getPreview(ply - 1);
+    }
+    std::uint64_t sequence = 0;
+    for (int ply = _depth - 1; ply >= 0; --ply)
+    {
+        sequence = ZobristMix(sequence ^ (static_cast<std::uint64_t>(_pieces[ply]) << 56 | 0x5851f42d4c957f2dull));
+        _sequenceKeys[ply] = sequence;
+    }
+
+    // the board has the active piece drawn in, take it back out of the rows and the hash
+    const BoardType& board = game.getBoard();
+    Node root;
+    root.rows = ExtractStack(game);
+    root.hash = board.getHash();
+    for (int row = 0; row < BoardType::FixedHeight; ++row)
+    {
+        if (root.rows[row] != board.getRow(row))
+        {
+            root.hash ^= BoardType::RowKey(row, board.getRow(row)) ^ BoardType::RowKey(row, root.rows[row]);
+        }
+    }
+
+    _candidates.clear();
+    Node child;
+    for (int rotation = 0; rotation < Pieces::Rotations; ++rotation)
+    {
+        for (int x = 1 - Pieces::Size; x < BoardType::FixedWidth; ++x)
+        {
+            if (Place(root, _pieces[0], rotation, x, child) >= 0)
+            {
+                _candidates.push_back({rotation, x, LossScore});
+            }
+        }
+    }
+
+    if (_table)
+    {
+        _table->NewSearch();
+    }
+    auto task = [&](int begin, int end)
+    {
+        TranspositionStats stats;
+        Node placed;
+        for (int i = begin; i < end; ++i)
+        {
+            Candidate& candidate = _candidates[i];
+            int lines = Place(root, _pieces[0], candidate.rotation, candidate.x, placed);
+            candidate.score = lines * _weights.lines + Search(placed, 1, stats);
+        }
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        _stats += stats;
+    };
+    _pool->Run(static_cast<int>(_candidates.size()), task);
+
+    // the first of equal candidates wins so the choice doesn't depend on the thread count
+    Placement best;
+    for (const Candidate& candidate : _candidates)
+    {
+        if (!best.valid || candidate.score > best.score)
+        {
+            best.rotation = candidate.rotation;
+            best.x = candidate.x;
+            best.score = candidate.score;
+            best.valid = true;
+        }
+    }
+    return best;
+}
+
+template class BasicPlacementSearch<Board>;
+template class BasicPlacementSearch<TallBoard>;
+template class BasicPlacementSearch<PentominoBoard>;
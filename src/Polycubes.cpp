@@ -0,0 +1,127 @@
+#include "Polycubes.h"
+#include <algorithm>
+#include <tuple>
+
+namespace
+{
+    using Cell = Polycubes::Cell;
+    using Cells = std::array<Cell, Polycubes::MaxCells>;
+
+    /// The pieces as they spawn, lying flat where they can.
+    struct PieceCells
+    {
+        Cells cells;
+        int count;
+    };
+
+    constexpr PieceCells pieceCells[Polycubes::Count] =
+            {
+            {{{{0, 0, 0}, {1, 0, 0}, {2, 0, 0}, {3, 0, 0}}}, 4}, // I
+            {{{{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}}}, 4}, // O
+            {{{{0, 0, 0}, {1, 0, 0}, {2, 0, 0}, {2, 1, 0}}}, 4}, // L
+            {{{{0, 0, 0}, {1, 0, 0}, {2, 0, 0}, {1, 1, 0}}}, 4}, // T
+            {{{{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {2, 1, 0}}}, 4}, // S
+            {{{{0, 0, 0}, {1, 0, 0}, {0, 1, 0}}}, 3},            // corner
+            {{{{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}}}, 4}, // branch
+            {{{{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {1, 1, 1}}}, 4}  // screw
+            };
+
+    struct Table
+    {
+        std::array<std::array<Polycubes::Orientation, Polycubes::MaxOrientations>, Polycubes::Count> orientations;
+        std::array<int, Polycubes::Count> counts{};
+    };
+
+    // Moves cells so their box starts at the origin and sorts them, so equal shapes compare equal.
+    Polycubes::Orientation normalise(Cells cells, int count)
+    {
+        int low[3] = {127, 127, 127};
+        for (int i = 0; i < count; ++i)
+        {
+            low[0] = std::min<int>(low[0], cells[i].x);
+            low[1] = std::min<int>(low[1], cells[i].y);
+            low[2] = std::min<int>(low[2], cells[i].z);
+        }
+        Polycubes::Orientation orientation;
+        orientation.cellCount = count;
+        for (int i = 0; i < count; ++i)
+        {
+            Cell cell{static_cast<std::int8_t>(cells[i].x - low[0]), static_cast<std::int8_t>(cells[i].y - low[1]),
+                      static_cast<std::int8_t>(cells[i].z - low[2])};
+            orientation.cells[i] = cell;
+            orientation.layers[cell.z] |= static_cast<std::uint16_t>(1u << (cell.x + Polycubes::Size * cell.y));
+            orientation.size[AxisX] = std::max(orientation.size[AxisX], cell.x + 1);
+            orientation.size[AxisY] = std::max(orientation.size[AxisY], cell.y + 1);
+            orientation.size[AxisZ] = std::max(orientation.size[AxisZ], cell.z + 1);
+        }
+        std::sort(orientation.cells.begin(), orientation.cells.begin() + count, [](const Cell& a, const Cell& b)
+                  { return std::tie(a.z, a.y, a.x) < std::tie(b.z, b.y, b.x); });
+        return orientation;
+    }
+
+    // A quarter turn, anticlockwise looking down the axis towards the origin.
+    Cell turn(Cell cell, int axis)
+    {
+        switch (axis)
+        {
+        case AxisX: return {cell.x, static_cast<std::int8_t>(-cell.z), cell.y};
+        case AxisY: return {cell.z, cell.y, static_cast<std::int8_t>(-cell.x)};
+        default: return {static_cast<std::int8_t>(-cell.y), cell.x, cell.z};
+        }
+    }
+
+    bool sameShape(const Polycubes::Orientation& a, const Polycubes::Orientation& b)
+    {
+        return a.layers == b.layers && a.size == b.size;
+    }
+
+    const Table& table()
+    {
+        // every orientation reachable from the spawn one by quarter turns, found breadth first
+        static const Table built = []
+        {
+            Table table;
+            for (int type = 0; type < Polycubes::Count; ++type)
+            {
+                auto& orientations = table.orientations[type];
+                int& count = table.counts[type];
+                orientations[0] = normalise(pieceCells[type].cells, pieceCells[type].count);
+                count = 1;
+                for (int next = 0; next < count; ++next)
+                {
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        Cells cells{};
+                        for (int i = 0; i < orientations[next].cellCount; ++i)
+                        {
+                            cells[i] = turn(orientations[next].cells[i], axis);
+                        }
+                        Polycubes::Orientation turned = normalise(cells, orientations[next].cellCount);
+                        int found = 0;
+                        while (found < count && !sameShape(orientations[found], turned))
+                        {
+                            ++found;
+                        }
+                        if (found == count)
+                        {
+                            orientations[count++] = turned;
+                        }
+                        orientations[next].turned[axis] = static_cast<std::uint8_t>(found);
+                    }
+                }
+            }
+            return table;
+        }();
+        return built;
+    }
+}
+
+int Polycubes::getOrientationCount(int type)
+{
+    return table().counts[type - 1];
+}
+
+const Polycubes::Orientation& Polycubes::getOrientation(int type, int orientation)
+{
+    return table().orientations[type - 1][orientation];
+}
@@ -0,0 +1,127 @@
+#include "RollbackSession.h"
+#include <algorithm>
+#include <chrono>
+
+RollbackSession::RollbackSession(const Board& board, unsigned int seed, int localPlayer, int inputDelay)
+    : _match(2, board, seed),
+      _localPlayer(localPlayer & 1),
+      _inputDelay(std::clamp(inputDelay, 0, MaxInputDelay))
+{
+    _remoteFrames.fill(-1);
+    // nobody has input for the first InputDelay frames, both peers know they are empty
+    for (int frame = 0; frame < _inputDelay; ++frame)
+    {
+        _remoteFrames[frame] = frame;
+    }
+    _remoteConfirmed = _inputDelay - 1;
+}
+
+bool RollbackSession::CanAdvance() const
+{
+    return _frame - _remoteConfirmed <= MaxRollback;
+}
+
+InputFrame RollbackSession::PredictRemote() const
+{
+    if (_remoteConfirmed < 0)
+    {
+        return 0;
+    }
+    return _inputs[1 - _localPlayer][_remoteConfirmed % HistorySize];
+}
+
+void RollbackSession::AddRemoteInput(int frame, InputFrame input)
+{
+    // ignore anything already confirmed, or so far ahead its slot is still needed for rollback
+    if (frame <= _remoteConfirmed || frame >= _frame - MaxRollback + HistorySize)
+    {
+        return;
+    }
+    int slot = frame % HistorySize;
+    if (_remoteFrames[slot] == frame)
+    {
+        return; // duplicate from a redundant packet
+    }
+    _remoteFrames[slot] = frame;
+    _inputs[1 - _localPlayer][slot] = input;
+
+    if (frame < _frame && input != _remoteUsed[slot])
+    {
+        _rollbackFrom = _rollbackFrom < 0 ? frame : std::min(_rollbackFrom, frame);
+    }
+
+    while (_remoteFrames[(_remoteConfirmed + 1) % HistorySize] == _remoteConfirmed + 1)
+    {
+        ++_remoteConfirmed;
+    }
+}
+
+void RollbackSession::SaveFrame(int frame)
+{
+    int slot = frame % HistorySize;
+    _match.SaveState(_snapshots[slot]);
+    _checksums[slot] = _match.Checksum();
+}
+
+void RollbackSession::SimulateFrame(int frame)
+{
+    int slot = frame % HistorySize;
+    int remote = 1 - _localPlayer;
+    std::array<InputFrame, 2> inputs;
+    inputs[_localPlayer] = _inputs[_localPlayer][slot];
+    inputs[remote] = _remoteFrames[slot] == frame ? _inputs[remote][slot] : PredictRemote();
+    _remoteUsed[slot] = inputs[remote];
+    _match.Step(inputs.data());
+}
+
+void RollbackSession::ApplyRollback()
+{
+    if (_rollbackFrom >= 0)
+    {
+        auto start = std::chrono::steady_clock::now();
+        _match.LoadState(_snapshots[_rollbackFrom % HistorySize]);
+        for (int frame = _rollbackFrom; frame < _frame; ++frame)
+        {
+            if (frame != _rollbackFrom)
+            {
+                SaveFrame(frame);
+            }
+            SimulateFrame(frame);
+        }
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        int depth = _frame - _rollbackFrom;
+        _stats.rollbacks++;
+        _stats.resimulatedFrames += depth;
+        _stats.maxRollbackFrames = std::max(_stats.maxRollbackFrames, depth);
+        _stats.totalResimMicros += micros;
+        _stats.maxResimMicros = std::max(_stats.maxResimMicros, micros);
+        _rollbackFrom = -1;
+    }
+}
+
+void RollbackSession::AdvanceFrame(InputFrame localInput)
+{
+    if (!CanAdvance())
+    {
+        return;
+    }
+
+    ApplyRollback();
+    _inputs[_localPlayer][(_frame + _inputDelay) % HistorySize] = localInput;
+    SaveFrame(_frame);
+    SimulateFrame(_frame);
+    ++_frame;
+}
+
+std::uint32_t RollbackSession::getConfirmedChecksum(int& frame) const
+{
+    // the state at the start of frame c + 1 is final once every input up to c is known
+    int confirmed = std::min(_remoteConfirmed, _frame - 1);
+    if (_rollbackFrom >= 0)
+    {
+        confirmed = std::min(confirmed, _rollbackFrom - 1);
+    }
+    frame = confirmed + 1;
+    return frame == _frame ? _match.Checksum() : _checksums[frame % HistorySize];
+}
@@ -0,0 +1,179 @@
+/****************************************************************************
+Sample agent plugin for tetris_arena, built as libtetris_agent_sample.so:
+  ./tetris_arena libtetris_agent_sample.so search:1 search:2
+It only includes ArenaAgent.h, the engine isn't linked in, and drops each piece
+where the stack scores best on the features of Pierre Dellacherie's classic
+hand tuned player: landing height, rows cleared, row and column transitions,
+holes and wells. Copy it to start an agent of your own.
+****************************************************************************/
+#include <cstdint>
+#include <new>
+#include "ArenaAgent.h"
+
+namespace
+{
+    struct SampleAgent
+    {
+        TetrisAgentConfig config; ///< Board size and piece shapes.
+    };
+
+    // Drops a piece from the top and clears full rows, false if it doesn't fit; fills in the landing row and rows cleared.
+    // A copy of BasicPlacementSearch::Drop(), since a plugin only sees the C interface and can't link the engine.
+    bool drop(const SampleAgent& agent, std::uint64_t* rows, int piece, int rotation, int x, int& landing, int& cleared)
+    {
+        const int width = agent.config.width;
+        const int height = agent.config.height;
+        const std::uint64_t full = (1ull << width) - 1;
+        const std::uint8_t* shape = agent.config.shapes[piece - 1][rotation];
+        std::uint64_t bits[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            if (x < 0 && (shape[i] & ((1u << -x) - 1)))
+            {
+                return false;
+            }
+            bits[i] = x < 0 ? shape[i] >> -x : static_cast<std::uint64_t>(shape[i]) << x;
+            if (bits[i] & ~full)
+            {
+                return false;
+            }
+        }
+        auto fits = [&](int y)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                if (bits[i] && (y + i < 0 || y + i >= height || (bits[i] & rows[y + i])))
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+        int y = height - 4;
+        if (!fits(y))
+        {
+            return false;
+        }
+        while (fits(y - 1))
+        {
+            --y;
+        }
+        for (int i = 0; i < 4; ++i)
+        {
+            if (bits[i])
+            {
+                rows[y + i] |= bits[i];
+            }
+        }
+        landing = y;
+        cleared = 0;
+        int kept = 0;
+        for (int row = 0; row < height; ++row)
+        {
+            if (rows[row] == full)
+            {
+                ++cleared;
+                continue;
+            }
+            rows[kept++] = rows[row];
+        }
+        while (kept < height)
+        {
+            rows[kept++] = 0;
+        }
+        return true;
+    }
+
+    // Dellacherie's weights, scaled to integers.
+    int evaluate(const SampleAgent& agent, const std::uint64_t* rows, int landing, int cleared)
+    {
+        const int width = agent.config.width;
+        const int height = agent.config.height;
+        const std::uint64_t walls = 1ull | 1ull << (width + 1);
+        const std::uint64_t mask = (1ull << width) - 1;
+        int rowTransitions = 0;
+        int columnTransitions = 0;
+        int holes = 0;
+        std::uint64_t previous = 0;
+        std::uint64_t above = 0;
+        for (int row = height - 1; row >= 0; --row)
+        {
+            // the walls count as filled
+            std::uint64_t line = rows[row] << 1 | walls;
+            rowTransitions += __builtin_popcountll((line ^ line >> 1) & ((1ull << (width + 1)) - 1));
+            columnTransitions += __builtin_popcountll(rows[row] ^ previous);
+            holes += __builtin_popcountll(above & ~rows[row]);
+            previous = rows[row];
+            above |= rows[row];
+        }
+        // and so does the floor
+        columnTransitions += __builtin_popcountll(~rows[0] & mask);
+
+        // empty cells with both neighbours filled, each counting one more than the well cell above it
+        int wells = 0;
+        for (int column = 0; column < width; ++column)
+        {
+            int depth = 0;
+            for (int row = height - 1; row >= 0; --row)
+            {
+                std::uint64_t line = rows[row] << 1 | walls;
+                bool well = !(line >> (column + 1) & 1) && (line >> column & 1) && (line >> (column + 2) & 1);
+                depth = well ? depth + 1 : 0;
+                wells += depth;
+            }
+        }
+        return -45 * (landing + 2) + 34 * cleared - 32 * rowTransitions - 93 * columnTransitions - 79 * holes - 34 * wells;
+    }
+
+    void* create(const TetrisAgentConfig* config)
+    {
+        if (config->width > 62 || config->height > TETRIS_AGENT_MAX_ROWS)
+        {
+            return nullptr;
+        }
+        return new (std::nothrow) SampleAgent{*config};
+    }
+
+    int choose(void* handle, const TetrisAgentState* state, TetrisAgentMove* move)
+    {
+        const SampleAgent& agent = *static_cast<SampleAgent*>(handle);
+        int best = -2000000000;
+        *move = {state->rotation, state->x};
+        for (int rotation = 0; rotation < TETRIS_AGENT_ROTATIONS; ++rotation)
+        {
+            for (int x = -3; x < agent.config.width; ++x)
+            {
+                std::uint64_t rows[TETRIS_AGENT_MAX_ROWS];
+                for (int row = 0; row < agent.config.height; ++row)
+                {
+                    rows[row] = state->rows[row];
+                }
+                int landing = 0;
+                int cleared = 0;
+                if (!drop(agent, rows, state->piece, rotation, x, landing, cleared))
+                {
+                    continue;
+                }
+                int score = evaluate(agent, rows, landing, cleared);
+                if (score > best)
+                {
+                    best = score;
+                    *move = {rotation, x};
+                }
+            }
+        }
+        return 0;
+    }
+
+    void destroy(void* handle)
+    {
+        delete static_cast<SampleAgent*>(handle);
+    }
+
+    const TetrisAgentApi api = {TETRIS_AGENT_ABI_VERSION, "sample", create, choose, destroy};
+}
+
+TETRIS_AGENT_EXPORT const TetrisAgentApi* tetris_agent_api(void)
+{
+    return &api;
+}
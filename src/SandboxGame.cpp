@@ -0,0 +1,110 @@
+#include "SandboxGame.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr int OneRow = 1 << 16; // one row of gravity in 16.16 fixed point
+}
+
+SandboxGame::SandboxGame(int width, int height, int players, unsigned int seed, int level)
+    : _board(width, height), _playerCount(std::clamp(players, 1, MaxPlayers)),
+      _gravity(Game::GravityPerFrame(level)), _random(seed)
+{
+    for (int player = 0; player < _playerCount; ++player)
+    {
+        Spawn(player);
+    }
+}
+
+int SandboxGame::getSpawnX(int player) const
+{
+    return (2 * player + 1) * _board.getWidth() / (2 * _playerCount) - StandardTetrominoes::Size / 2;
+}
+
+bool SandboxGame::isGameOver() const
+{
+    for (int player = 0; player < _playerCount; ++player)
+    {
+        if (_players[player].playing)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SandboxGame::Step(const InputFrame* inputs)
+{
+    for (int index = 0; index < _playerCount; ++index)
+    {
+        Player& player = _players[index];
+        InputFrame pressed = inputs[index] & ~player.lastInput;
+        player.lastInput = inputs[index];
+        if (!player.playing)
+        {
+            continue;
+        }
+        if (pressed & InputRotate)
+        {
+            Tetromino turned = player.tetromino;
+            turned.SetRotation((turned.getRotation() + 1) % StandardTetrominoes::Rotations);
+            if (!_board.Overlaps(turned))
+            {
+                player.tetromino = turned;
+            }
+        }
+        if (pressed & InputLeft)
+        {
+            Move(player, -1, 0);
+        }
+        if (pressed & InputRight)
+        {
+            Move(player, 1, 0);
+        }
+
+        // holding down falls a row every frame on top of gravity
+        player.gravityProgress += _gravity + ((inputs[index] & InputDown) ? OneRow : 0);
+        while (player.gravityProgress >= OneRow)
+        {
+            player.gravityProgress -= OneRow;
+            if (!Move(player, 0, -1))
+            {
+                Lock(index);
+                break;
+            }
+        }
+    }
+}
+
+bool SandboxGame::Move(Player& player, int dx, int dy)
+{
+    Tetromino moved = player.tetromino;
+    moved.SetPosition(moved.GetX() + dx, moved.GetY() + dy);
+    if (_board.Overlaps(moved))
+    {
+        return false;
+    }
+    player.tetromino = moved;
+    return true;
+}
+
+void SandboxGame::Lock(int player)
+{
+    const Tetromino& tetromino = _players[player].tetromino;
+    _board.Place(tetromino);
+    _lines += _board.ClearFullRows(tetromino.GetY(), tetromino.GetY() + StandardTetrominoes::Size - 1);
+    _pieces++;
+    Spawn(player);
+}
+
+void SandboxGame::Spawn(int player)
+{
+    Player& spawning = _players[player];
+    int type = static_cast<int>(_random() % StandardTetrominoes::Count) + 1;
+    spawning.tetromino = Tetromino(type, getSpawnX(player), _board.getHeight() - StandardTetrominoes::Size);
+    spawning.gravityProgress = 0;
+    if (_board.Overlaps(spawning.tetromino))
+    {
+        spawning.playing = false;
+    }
+}
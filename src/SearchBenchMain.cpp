@@ -0,0 +1,321 @@
+/****************************************************************************
+Plays a game with the placement search and reports its speed and how often
+the transposition table saved a subtree, e.g.
+  ./tetris_search --depth 3 --threads 8 --pieces 200 --hash 64
+--hash 0 searches without a table for comparison. --perfect-clear 4 also
+asks the perfect clear solver for a clear within 4 lines before every piece,
+plays it when there is one and reports how long the solver took.
+--network FILE scores the stacks with a NetworkEvaluator instead of the
+heuristic, --network random with random weights, and first measures boards
+per second on one core for the heuristic and every kernel the CPU supports.
+--mcts 20 plays with the Monte Carlo tree search instead, 20 ms a piece, and
+reports its descents per second and how much of each tree the next move kept.
+--piece-file pieces/pentominoes.txt plays with the pieces of a piece file,
+each at most 5x5, on a pentomino board instead of with the tetrominoes.
+****************************************************************************/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <random>
+#include <vector>
+#include "MonteCarloSearch.h"
+#include "PerfectClearSolver.h"
+#include "PlacementSearch.h"
+
+namespace
+{
+    // Buttons that bring the active piece to a placement, one press at a time since buttons act when they go down.
+    template <typename GameType, typename PlacementType>
+    InputFrame inputFor(const GameType& game, const PlacementType& target, InputFrame last)
+    {
+        const Tetromino& piece = game.getTetromino();
+        InputFrame input = InputDown;
+        if (piece.getRotation() != target.rotation)
+        {
+            input = InputRotate;
+        }
+        else if (piece.GetX() > target.x)
+        {
+            input = InputLeft;
+        }
+        else if (piece.GetX() < target.x)
+        {
+            input = InputRight;
+        }
+        return input == last ? 0 : input;
+    }
+
+    // Boards scored per second on the calling thread, the heuristic and then every kernel the CPU has.
+    void benchmarkEvaluators(NetworkEvaluator& network, unsigned int seed)
+    {
+        // ragged stacks with holes, a batch the size the search sends
+        constexpr int Boards = 64;
+        constexpr int Height = Board::FixedHeight;
+        std::mt19937 random(seed);
+        std::vector<std::uint64_t> rows(Boards * Height);
+        std::vector<PlacementSearch::Rows> stacks(Boards);
+        for (int b = 0; b < Boards; ++b)
+        {
+            int top = static_cast<int>(random() % Height);
+            for (int row = 0; row < Height; ++row)
+            {
+                std::uint64_t bits = row < top ? random() & random() & ((1u << Board::FixedWidth) - 1) : 0;
+                rows[b * Height + row] = bits;
+                stacks[b][row] = static_cast<Board::RowMask>(bits);
+            }
+        }
+
+        auto measure = [](const char* name, auto&& evaluate)
+        {
+            long long boards = 0;
+            volatile int sink = 0;
+            auto start = std::chrono::steady_clock::now();
+            double seconds = 0.0;
+            while (seconds < 0.25)
+            {
+                sink = sink + evaluate();
+                boards += Boards;
+                seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+            std::cout << "evaluate " << name << std::string(10 - std::string(name).size(), ' ')
+                      << boards / seconds << " boards per second per core\n";
+        };
+
+        measure("heuristic", [&]
+        {
+            int sum = 0;
+            for (const PlacementSearch::Rows& stack : stacks)
+            {
+                sum += PlacementSearch::Evaluate(stack);
+            }
+            return sum;
+        });
+        NetworkKernel best = network.getKernel();
+        std::vector<int> scores(Boards);
+        for (NetworkKernel kernel : {NetworkKernel::Portable, NetworkKernel::Avx2, NetworkKernel::Vnni})
+        {
+            if (network.setKernel(kernel) != kernel)
+            {
+                continue;
+            }
+            measure(NetworkEvaluator::KernelName(kernel), [&]
+            {
+                network.EvaluateBatch(rows.data(), Boards, scores.data());
+                return scores[0];
+            });
+        }
+        network.setKernel(best);
+    }
+
+    // Plays a game with the pieces of a file on a pentomino board, the only custom board the search is built for.
+    int playPieceFile(const std::string& path, int depth, int threads, int pieces, TranspositionTable* table, unsigned int seed)
+    {
+        PieceTable pieceTable;
+        if (!pieceTable.Load(path))
+        {
+            return EXIT_FAILURE;
+        }
+        if (!Pentominoes::Use(pieceTable))
+        {
+            std::cerr << path << ": pieces must fit in " << Pentominoes::Size << "x" << Pentominoes::Size << "\n";
+            return EXIT_FAILURE;
+        }
+
+        BasicPlacementSearch<PentominoBoard> search(table, threads);
+        BasicGame<PentominoBoard> game(PentominoBoard(), seed);
+        double searchSeconds = 0.0;
+        InputFrame last = 0;
+        while (!game.isGameOver() && game.getPieces() < pieces)
+        {
+            auto start = std::chrono::steady_clock::now();
+            auto target = search.FindBest(game, depth);
+            searchSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (!target.valid)
+            {
+                break;
+            }
+            int placed = game.getPieces();
+            while (!game.isGameOver() && game.getPieces() == placed)
+            {
+                last = inputFor(game, target, last);
+                game.Step(last);
+            }
+        }
+
+        std::cout << game.getPieces() << " pieces from " << pieceTable.getCount() << " in " << path << " at depth " << depth
+                  << " on " << threads << " threads\n"
+                  << "lines " << game.getLines() << ", score " << game.getScore() << (game.isGameOver() ? ", game over" : "") << "\n"
+                  << "search time     " << searchSeconds << " s, " << searchSeconds * 1000.0 / std::max(game.getPieces(), 1) << " ms per piece\n";
+        return EXIT_SUCCESS;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int depth = 3;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int pieces = 200;
+    int hash = 64;
+    unsigned int seed = 1;
+    int perfectClear = 0;
+    int mcts = 0;
+    std::string networkPath;
+    std::string pieceFile;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--network")
+        {
+            networkPath = argv[++i];
+            continue;
+        }
+        if (arg == "--piece-file")
+        {
+            pieceFile = argv[++i];
+            continue;
+        }
+        int value = std::stoi(argv[i + 1]);
+        if (arg == "--depth") depth = value;
+        else if (arg == "--threads") threads = value;
+        else if (arg == "--pieces") pieces = value;
+        else if (arg == "--hash") hash = value;
+        else if (arg == "--seed") seed = static_cast<unsigned int>(value);
+        else if (arg == "--perfect-clear") perfectClear = value;
+        else if (arg == "--mcts") mcts = value;
+        else continue;
+        ++i;
+    }
+    if (depth < 1 || depth > PlacementSearch::MaxDepth || pieces <= 0 || hash < 0 || perfectClear < 0 || mcts < 0 ||
+        perfectClear > PerfectClearSolver::MaxLines)
+    {
+        std::cerr << "usage: tetris_search [--depth 1-" << PlacementSearch::MaxDepth
+                  << "] [--threads N] [--pieces N] [--hash MB] [--seed N] [--perfect-clear 1-"
+                  << PerfectClearSolver::MaxLines << "] [--network FILE|random] [--mcts MS] [--piece-file FILE]\n";
+        return EXIT_FAILURE;
+    }
+
+    NetworkEvaluator network;
+    if (networkPath == "random")
+    {
+        network.Randomise(Board::FixedWidth, Board::FixedHeight, {256, 32}, seed);
+    }
+    else if (!networkPath.empty() && !network.Load(networkPath))
+    {
+        return EXIT_FAILURE;
+    }
+    if (network.isLoaded())
+    {
+        std::cout << "network " << network.getOperations() << " multiply-adds per board, "
+                  << NetworkEvaluator::KernelName(network.getKernel()) << " kernel\n";
+        benchmarkEvaluators(network, seed);
+    }
+
+    std::unique_ptr<TranspositionTable> table;
+    if (hash > 0)
+    {
+        table = std::make_unique<TranspositionTable>(static_cast<std::size_t>(hash));
+    }
+    if (!pieceFile.empty())
+    {
+        return playPieceFile(pieceFile, depth, threads, pieces, table.get(), seed);
+    }
+    PlacementSearch search(table.get(), threads);
+    if (network.isLoaded() && !search.setNetwork(&network))
+    {
+        std::cerr << "the network was made for a " << network.getWidth() << "x" << network.getHeight() << " board\n";
+        return EXIT_FAILURE;
+    }
+    PerfectClearSolver solver(threads);
+    std::unique_ptr<MonteCarloSearch> tree;
+    if (mcts > 0)
+    {
+        tree = std::make_unique<MonteCarloSearch>(threads);
+    }
+    Game game(Board(), seed);
+
+    double searchSeconds = 0.0;
+    double solveSeconds = 0.0;
+    double slowestSolve = 0.0;
+    long long solveNodes = 0;
+    int solves = 0;
+    int perfectClears = 0;
+    int finesseKeys = 0;
+    long long descents = 0;
+    std::size_t reused = 0;
+    std::size_t nodes = 0;
+    int treeDepth = 0;
+    InputFrame last = 0;
+    while (!game.isGameOver() && game.getPieces() < pieces)
+    {
+        auto start = std::chrono::steady_clock::now();
+        PlacementSearch::Placement target = tree ? tree->Think(game, mcts) : search.FindBest(game, depth);
+        if (tree)
+        {
+            const MonteCarloStats& treeStats = tree->getStats();
+            descents += treeStats.iterations;
+            reused += treeStats.reused;
+            nodes += treeStats.nodes;
+            treeDepth = std::max(treeDepth, treeStats.depth);
+        }
+        searchSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!target.valid)
+        {
+            break;
+        }
+        if (perfectClear > 0)
+        {
+            start = std::chrono::steady_clock::now();
+            PerfectClearSolver::Solution clear = solver.Solve(game, perfectClear);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            solveSeconds += seconds;
+            slowestSolve = std::max(slowestSolve, seconds);
+            solveNodes += clear.nodes;
+            solves++;
+            if (clear.found)
+            {
+                target.rotation = clear.steps[0].rotation;
+                target.x = clear.steps[0].x;
+                perfectClears += clear.pieces == 1;
+            }
+            finesseKeys += PerfectClearSolver::Finesse(game, {target.rotation, target.x}).count;
+        }
+
+        // play the frames until this piece locks
+        int placed = game.getPieces();
+        while (!game.isGameOver() && game.getPieces() == placed)
+        {
+            last = inputFor(game, target, last);
+            game.Step(last);
+        }
+    }
+
+    if (tree)
+    {
+        int played = std::max(game.getPieces(), 1);
+        std::cout << game.getPieces() << " pieces by tree search, " << mcts << " ms a piece on " << threads << " threads\n"
+                  << "lines " << game.getLines() << ", score " << game.getScore() << (game.isGameOver() ? ", game over" : "") << "\n"
+                  << "descents        " << descents << " (" << descents / std::max(searchSeconds, 1e-9) << " per second, "
+                  << descents / played << " per piece)\n"
+                  << "tree            " << nodes / played << " nodes per piece, " << reused / played
+                  << " kept from the move before, deepest " << treeDepth << " pieces\n";
+        return EXIT_SUCCESS;
+    }
+
+    const TranspositionStats& stats = search.getStats();
+    std::cout << game.getPieces() << " pieces at depth " << depth << " on " << threads << " threads, "
+              << (table ? std::to_string(table->getCapacity()) + " table entries" : std::string("no table")) << "\n"
+              << "lines " << game.getLines() << ", score " << game.getScore() << (game.isGameOver() ? ", game over" : "") << "\n"
+              << "search time     " << searchSeconds << " s, " << searchSeconds * 1000.0 / std::max(game.getPieces(), 1) << " ms per piece\n"
+              << "evaluations     " << stats.evaluations << " (" << stats.evaluations / std::max(searchSeconds, 1e-9) << " per second)\n"
+              << "table probes    " << stats.probes << ", hit rate " << stats.getHitRate() * 100.0 << "%\n"
+              << "table stores    " << stats.stores << ", replaced " << stats.replaced << "\n";
+    if (solves > 0)
+    {
+        std::cout << "perfect clears  " << perfectClears << ", solver " << solveSeconds * 1000.0 / solves
+                  << " ms per piece, slowest " << slowestSolve * 1000.0 << " ms, " << solveNodes << " nodes\n"
+                  << "finesse         " << static_cast<double>(finesseKeys) / solves << " keys per piece\n";
+    }
+    return EXIT_SUCCESS;
+}
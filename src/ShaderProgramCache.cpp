@@ -0,0 +1,233 @@
+#include "ShaderProgramCache.h"
+#include <QOpenGLContext>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+    // GL_KHR_parallel_shader_compile and GL_ARB_parallel_shader_compile share their enum values
+    constexpr GLenum CompletionStatus = 0x91B1;
+    constexpr GLuint AllCompilerThreads = 0xFFFFFFFF;
+    typedef void (APIENTRY *MaxShaderCompilerThreadsFn)(GLuint);
+
+    bool readFile(const std::string &_file, std::string &_text)
+    {
+        std::ifstream in(_file, std::ios::binary);
+        if (!in)
+        {
+            return false;
+        }
+        std::ostringstream text;
+        text << in.rdbuf();
+        _text = text.str();
+        return true;
+    }
+
+    // 64-bit FNV-1a, only has to tell one set of sources and driver from another
+    std::uint64_t hashText(std::uint64_t _hash, const std::string &_text)
+    {
+        for (unsigned char c : _text)
+        {
+            _hash = (_hash ^ c) * 0x100000001b3ull;
+        }
+        // end marker so moving text between the strings changes the key
+        return (_hash ^ 0xff) * 0x100000001b3ull;
+    }
+
+    GLuint compileStage(GLenum _type, const std::string &_source)
+    {
+        GLuint shader = glCreateShader(_type);
+        const char *text = _source.c_str();
+        glShaderSource(shader, 1, &text, nullptr);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    void printShaderLog(GLuint _shader, const char *_stage)
+    {
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(_shader, GL_COMPILE_STATUS, &compiled);
+        if (compiled)
+        {
+            return;
+        }
+        GLint length = 0;
+        glGetShaderiv(_shader, GL_INFO_LOG_LENGTH, &length);
+        std::vector<char> log(static_cast<std::size_t>(std::max(length, 1)));
+        glGetShaderInfoLog(_shader, length, nullptr, log.data());
+        std::cerr << _stage << " shader:\n" << log.data() << "\n";
+    }
+}
+
+ShaderProgramCache::ShaderProgramCache(std::string _directory) : m_directory(std::move(_directory))
+{
+}
+
+void ShaderProgramCache::initialize()
+{
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+        const GLubyte *text = glGetString(name);
+        m_driver += text ? reinterpret_cast<const char *>(text) : "";
+        m_driver += '\n';
+    }
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    m_binaries = formats > 0;
+
+    GLint extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+    const char *threadsFunction = nullptr;
+    for (GLint i = 0; i < extensions; ++i)
+    {
+        auto extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (std::strcmp(extension, "GL_KHR_parallel_shader_compile") == 0)
+        {
+            threadsFunction = "glMaxShaderCompilerThreadsKHR";
+            break;
+        }
+        if (std::strcmp(extension, "GL_ARB_parallel_shader_compile") == 0)
+        {
+            threadsFunction = "glMaxShaderCompilerThreadsARB";
+        }
+    }
+    if (threadsFunction)
+    {
+        auto maxThreads = reinterpret_cast<MaxShaderCompilerThreadsFn>(
+                QOpenGLContext::currentContext()->getProcAddress(threadsFunction));
+        if (maxThreads)
+        {
+            maxThreads(AllCompilerThreads);
+            m_parallel = true;
+        }
+    }
+}
+
+ShaderProgramCache::Build ShaderProgramCache::begin(const std::string &_vertexFile, const std::string &_fragmentFile,
+                                                    const std::string &_includeFile, const std::string &_defines)
+{
+    Build build;
+    std::string vertexSource;
+    std::string fragmentSource;
+    std::string includeSource;
+    if (!readFile(_vertexFile, vertexSource) || !readFile(_fragmentFile, fragmentSource) ||
+        (!_includeFile.empty() && !readFile(_includeFile, includeSource)))
+    {
+        std::cerr << "can't read " << _vertexFile << ", " << _fragmentFile << " or " << _includeFile << "\n";
+        return build;
+    }
+    if (!_includeFile.empty())
+    {
+        // #version has to come first, and #line keeps the fragment shader's own line numbers in the logs
+        std::size_t body = fragmentSource.find('\n');
+        body = body == std::string::npos ? fragmentSource.size() : body + 1;
+        fragmentSource = fragmentSource.substr(0, body) + _defines + includeSource + "\n#line 2\n" + fragmentSource.substr(body);
+    }
+
+    std::uint64_t key = hashText(hashText(hashText(0xcbf29ce484222325ull, vertexSource), fragmentSource), m_driver);
+    std::ostringstream file;
+    file << m_directory << "/" << std::hex << key << ".bin";
+    build.cacheFile = file.str();
+
+    // a binary the driver turns down despite the matching key is compiled again and overwritten
+    std::string binary;
+    if (m_binaries && readFile(build.cacheFile, binary) && binary.size() > sizeof(GLenum))
+    {
+        GLenum format = 0;
+        std::memcpy(&format, binary.data(), sizeof(format));
+        build.program = glCreateProgram();
+        glProgramBinary(build.program, format, binary.data() + sizeof(format),
+                        static_cast<GLsizei>(binary.size() - sizeof(format)));
+        GLint linked = GL_FALSE;
+        glGetProgramiv(build.program, GL_LINK_STATUS, &linked);
+        if (linked)
+        {
+            build.cached = true;
+            ++m_hits;
+            return build;
+        }
+        glDeleteProgram(build.program);
+    }
+
+    // queue the compile and link without asking for their status, which is what would wait on the driver
+    build.vertex = compileStage(GL_VERTEX_SHADER, vertexSource);
+    build.fragment = compileStage(GL_FRAGMENT_SHADER, fragmentSource);
+    build.program = glCreateProgram();
+    glAttachShader(build.program, build.vertex);
+    glAttachShader(build.program, build.fragment);
+    glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(build.program);
+    ++m_compiles;
+    return build;
+}
+
+bool ShaderProgramCache::isReady(const Build &_build) const
+{
+    if (!m_parallel || _build.cached || !_build.program)
+    {
+        return true;
+    }
+    GLint done = GL_FALSE;
+    glGetProgramiv(_build.program, CompletionStatus, &done);
+    return done == GL_TRUE;
+}
+
+GLuint ShaderProgramCache::finish(Build &_build)
+{
+    GLuint program = _build.program;
+    if (program && !_build.cached)
+    {
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked)
+        {
+            save(program, _build.cacheFile);
+        }
+        else
+        {
+            printShaderLog(_build.vertex, "vertex");
+            printShaderLog(_build.fragment, "fragment");
+            GLint length = 0;
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+            std::vector<char> log(static_cast<std::size_t>(std::max(length, 1)));
+            glGetProgramInfoLog(program, length, nullptr, log.data());
+            std::cerr << "link:\n" << log.data() << "\n";
+            glDeleteProgram(program);
+            program = 0;
+        }
+        // the program keeps what it linked, the shader objects are only needed until then
+        glDeleteShader(_build.vertex);
+        glDeleteShader(_build.fragment);
+    }
+    _build = Build();
+    return program;
+}
+
+void ShaderProgramCache::save(GLuint _program, const std::string &_file) const
+{
+    if (!m_binaries)
+    {
+        return;
+    }
+    GLint length = 0;
+    glGetProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+    std::vector<char> binary(sizeof(GLenum) + static_cast<std::size_t>(length));
+    GLenum format = 0;
+    glGetProgramBinary(_program, length, nullptr, &format, binary.data() + sizeof(format));
+    std::memcpy(binary.data(), &format, sizeof(format));
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    std::ofstream out(_file, std::ios::binary);
+    out.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+}
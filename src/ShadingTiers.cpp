@@ -0,0 +1,391 @@
+#include "ShadingTiers.h"
+#include <QFileInfo>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    constexpr auto vertexFile = "shaders/PBRVertex.glsl";
+    // shadow() for every fragment shader, the cheapest tier takes its single lookup variant
+    constexpr auto shadowFile = "shaders/Shadow.glsl";
+    constexpr auto sourceDirectory = "shaders";
+
+    /// Program name and source files of each program, the tiers indexed by ShadingTier and then the floor.
+    struct ProgramSource
+    {
+        const char *program;
+        const char *vertFile;
+        const char *fragFile;
+        const char *shadowDefines;
+    };
+
+    constexpr std::array<ProgramSource, ShadingTiers::ProgramCount> programSources =
+            {{
+            {"PBR", vertexFile, "shaders/PBRFragment.glsl", ""},
+            {"PBRMatcap", vertexFile, "shaders/MatcapFragment.glsl", ""},
+            {"Lambert", vertexFile, "shaders/LambertFragment.glsl", "#define SINGLE_TAP_SHADOW\n"},
+            {"Floor", "shaders/FloorVertex.glsl", "shaders/FloorFragment.glsl", ""}
+            }};
+
+    ShaderProgramCache::Build beginProgram(ShaderProgramCache &_cache, const ProgramSource &_source)
+    {
+        return _cache.begin(_source.vertFile, _source.fragFile, shadowFile, _source.shadowDefines);
+    }
+
+    constexpr float PI = 3.14159265359f;
+
+    // Same terms as PBRFragment.glsl, evaluated on the CPU for the bake.
+    float distributionGGX(float NdotH, float roughness)
+    {
+        float a = roughness * roughness;
+        float a2 = a * a;
+        float denom = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+        return a2 / (PI * denom * denom);
+    }
+
+    float geometrySchlickGGX(float NdotV, float roughness)
+    {
+        float r = roughness + 1.0f;
+        float k = (r * r) / 8.0f;
+        return NdotV / (NdotV * (1.0f - k) + k);
+    }
+}
+
+const char *ShadingTiers::programName(ShadingTier _tier)
+{
+    return programSources[static_cast<int>(_tier)].program;
+}
+
+void ShadingTiers::initialize(const ngl::Vec3 &_viewLightDir, std::function<void()> _sourcesChanged)
+{
+    // start every program before finishing any, so a driver that compiles in parallel has them all at once
+    m_cache.initialize();
+    std::array<ShaderProgramCache::Build, ProgramCount> builds;
+    for (int program = 0; program < ProgramCount; ++program)
+    {
+        builds[program] = beginProgram(m_cache, programSources[program]);
+    }
+    for (int program = 0; program < ProgramCount; ++program)
+    {
+        m_programs[program] = m_cache.finish(builds[program]);
+    }
+
+    bakeMatcap(_viewLightDir);
+    for (int tier = 0; tier < TierCount; ++tier)
+    {
+        loadTierDefaults(static_cast<ShadingTier>(tier));
+    }
+
+    glGenQueries(QueryCount, m_queries.data());
+
+    // the directory is watched too, it reports a file saved by renaming a new one over it
+    m_sourcesChanged = std::move(_sourcesChanged);
+    m_watcher.addPath(sourceDirectory);
+    watchSources();
+    QObject::connect(&m_watcher, &QFileSystemWatcher::fileChanged, [this](const QString &_file) { sourceChanged(_file); });
+    QObject::connect(&m_watcher, &QFileSystemWatcher::directoryChanged, [this](const QString &)
+    {
+        for (const QString &file : watchSources())
+        {
+            sourceChanged(file);
+        }
+    });
+}
+
+void ShadingTiers::loadTierDefaults(ShadingTier _tier)
+{
+    if (_tier == ShadingTier::Matcap)
+    {
+        use(_tier);
+        setUniform("brdfLUT", 0);
+    }
+}
+
+void ShadingTiers::use(ShadingTier _tier)
+{
+    m_current = program(_tier);
+    glUseProgram(m_current);
+}
+
+void ShadingTiers::useFloor()
+{
+    m_current = m_programs[TierCount];
+    glUseProgram(m_current);
+}
+
+void ShadingTiers::setUniform(const char *_name, int _value) const
+{
+    glUniform1i(glGetUniformLocation(m_current, _name), _value);
+}
+
+void ShadingTiers::setUniform(const char *_name, float _value) const
+{
+    glUniform1f(glGetUniformLocation(m_current, _name), _value);
+}
+
+void ShadingTiers::setUniform(const char *_name, float _x, float _y, float _z) const
+{
+    glUniform3f(glGetUniformLocation(m_current, _name), _x, _y, _z);
+}
+
+void ShadingTiers::setUniform(const char *_name, const ngl::Vec3 &_value) const
+{
+    glUniform3f(glGetUniformLocation(m_current, _name), _value.m_x, _value.m_y, _value.m_z);
+}
+
+void ShadingTiers::setUniform(const char *_name, const ngl::Mat3 &_value) const
+{
+    glUniformMatrix3fv(glGetUniformLocation(m_current, _name), 1, GL_FALSE, &_value.m_m[0][0]);
+}
+
+void ShadingTiers::setUniform(const char *_name, const ngl::Mat4 &_value) const
+{
+    glUniformMatrix4fv(glGetUniformLocation(m_current, _name), 1, GL_FALSE, &_value.m_m[0][0]);
+}
+
+void ShadingTiers::setUniform(const char *_name, const ngl::Vec3 *_values, int _count) const
+{
+    glUniform3fv(glGetUniformLocation(m_current, _name), _count, &_values[0].m_x);
+}
+
+void ShadingTiers::setUniform(const char *_name, const float *_values, int _count) const
+{
+    glUniform1fv(glGetUniformLocation(m_current, _name), _count, _values);
+}
+
+void ShadingTiers::setUniform(const char *_name, const int *_values, int _count) const
+{
+    glUniform1iv(glGetUniformLocation(m_current, _name), _count, _values);
+}
+
+QStringList ShadingTiers::watchSources()
+{
+    QStringList files;
+    for (const ProgramSource &source : programSources)
+    {
+        for (const char *file : {source.vertFile, source.fragFile, shadowFile})
+        {
+            if (!m_watcher.files().contains(file) && QFileInfo::exists(file) && !files.contains(file))
+            {
+                files << file;
+            }
+        }
+    }
+    if (!files.isEmpty())
+    {
+        m_watcher.addPaths(files);
+    }
+    return files;
+}
+
+void ShadingTiers::sourceChanged(const QString &_file)
+{
+    bool stale = false;
+    for (int program = 0; program < ProgramCount; ++program)
+    {
+        if (_file == programSources[program].vertFile || _file == programSources[program].fragFile || _file == shadowFile)
+        {
+            m_stale[program] = true;
+            stale = true;
+        }
+    }
+    if (stale && m_sourcesChanged)
+    {
+        m_sourcesChanged();
+    }
+}
+
+unsigned int ShadingTiers::updatePrograms()
+{
+    unsigned int swapped = 0;
+    for (int program = 0; program < ProgramCount; ++program)
+    {
+        const ProgramSource &source = programSources[program];
+        ShaderProgramCache::Build &build = m_builds[program];
+        // a change during a rebuild waits for it, then starts another
+        if (m_stale[program] && !build.program)
+        {
+            build = beginProgram(m_cache, source);
+            m_stale[program] = false;
+            if (!build.program)
+            {
+                continue;
+            }
+        }
+        if (!build.program || !m_cache.isReady(build))
+        {
+            continue;
+        }
+
+        GLuint rebuilt = m_cache.finish(build);
+        if (!rebuilt)
+        {
+            std::cerr << "keeping the previous " << source.program << " program\n";
+            continue;
+        }
+        glDeleteProgram(m_programs[program]);
+        m_programs[program] = rebuilt;
+        if (program < TierCount)
+        {
+            loadTierDefaults(static_cast<ShadingTier>(program));
+        }
+        swapped |= 1u << program;
+        std::cout << "reloaded " << source.program << " shading\n";
+    }
+    return swapped;
+}
+
+bool ShadingTiers::isReloading() const
+{
+    for (int program = 0; program < ProgramCount; ++program)
+    {
+        if (m_stale[program] || m_builds[program].program)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShadingTiers::bakeMatcap(const ngl::Vec3 &_viewLightDir)
+{
+    // Two specular lobes are baked so roughness can still be blended at runtime;
+    // they bracket the 0.5 used by Cube so the default material lands between them.
+    constexpr float roughLow = 0.25f;
+    constexpr float roughHigh = 0.75f;
+
+    ngl::Vec3 L = _viewLightDir;
+    L.normalize();
+    const ngl::Vec3 V(0.0f, 0.0f, 1.0f);
+    ngl::Vec3 H = V + L;
+    H.normalize();
+    const float HdotV = std::max(H.dot(V), 0.0f);
+
+    std::vector<float> texels(MatcapSize * MatcapSize * 4, 0.0f);
+    for (int y = 0; y < MatcapSize; ++y)
+    {
+        for (int x = 0; x < MatcapSize; ++x)
+        {
+            // map the texel centre back to a view space normal on the unit hemisphere
+            float nx = (x + 0.5f) / MatcapSize * 2.0f - 1.0f;
+            float ny = (y + 0.5f) / MatcapSize * 2.0f - 1.0f;
+            float nz2 = 1.0f - nx * nx - ny * ny;
+            ngl::Vec3 N(nx, ny, std::sqrt(std::max(nz2, 0.0f)));
+            N.normalize();
+
+            float NdotL = std::max(N.dot(L), 0.0f);
+            float NdotV = std::max(N.dot(V), 0.0f);
+            float NdotH = std::max(N.dot(H), 0.0f);
+            float denominator = 4.0f * NdotV * NdotL + 0.001f;
+            auto specular = [&](float roughness)
+            {
+                float G = geometrySchlickGGX(NdotV, roughness) * geometrySchlickGGX(NdotL, roughness);
+                return distributionGGX(NdotH, roughness) * G / denominator * NdotL;
+            };
+
+            float *texel = &texels[(y * MatcapSize + x) * 4];
+            texel[0] = NdotL / PI;
+            texel[1] = specular(roughLow);
+            texel[2] = specular(roughHigh);
+            texel[3] = std::pow(1.0f - HdotV, 5.0f);
+        }
+    }
+
+    glGenTextures(1, &m_matcap);
+    glBindTexture(GL_TEXTURE_2D, m_matcap);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, MatcapSize, MatcapSize, 0, GL_RGBA, GL_FLOAT, texels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void ShadingTiers::setTier(ShadingTier _tier)
+{
+    m_tier = _tier;
+    m_auto = false;
+    m_overBudget = 0;
+}
+
+void ShadingTiers::setAuto(bool _enabled)
+{
+    m_auto = _enabled;
+    m_overBudget = 0;
+    if (m_auto)
+    {
+        // start from the best tier and let the frame time pull it down
+        m_tier = ShadingTier::FullPBR;
+        m_gpuMs = 0.0f;
+    }
+}
+
+void ShadingTiers::bindTextures() const
+{
+    if (m_tier == ShadingTier::Matcap)
+    {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_matcap);
+    }
+}
+
+void ShadingTiers::beginFrame()
+{
+    collectQueries();
+    // if the slot is still in flight the GPU is more than QueryCount frames behind; skip timing this frame
+    if (m_pending[m_query])
+    {
+        return;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[m_query]);
+}
+
+void ShadingTiers::endFrame()
+{
+    if (m_pending[m_query])
+    {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    m_pending[m_query] = true;
+    m_query = (m_query + 1) % QueryCount;
+}
+
+void ShadingTiers::collectQueries()
+{
+    for (int i = 0; i < QueryCount; ++i)
+    {
+        if (!m_pending[i])
+        {
+            continue;
+        }
+        GLint available = 0;
+        glGetQueryObjectiv(m_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            continue;
+        }
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &elapsed);
+        m_pending[i] = false;
+
+        float ms = static_cast<float>(elapsed) * 1.0e-6f;
+        m_gpuMs = m_gpuMs == 0.0f ? ms : m_gpuMs * 0.9f + ms * 0.1f;
+
+        if (!m_auto)
+        {
+            continue;
+        }
+        m_overBudget = m_gpuMs > m_budgetMs ? m_overBudget + 1 : 0;
+        if (m_overBudget >= OverBudgetFrames && m_tier != ShadingTier::Lambert)
+        {
+            m_tier = static_cast<ShadingTier>(static_cast<int>(m_tier) + 1);
+            m_overBudget = 0;
+            // the average still holds the old tier's cost, so start measuring afresh
+            m_gpuMs = 0.0f;
+            std::cout << "GPU frame time over " << m_budgetMs << "ms, dropping to "
+                      << programName(m_tier) << " shading\n";
+        }
+    }
+}
@@ -0,0 +1,130 @@
+#include "ShadowMaps.h"
+#include <ngl/Util.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+ShadowMaps::~ShadowMaps()
+{
+    if (m_program != 0)
+    {
+        for (Map *map : {&m_stack, &m_pieces})
+        {
+            glDeleteFramebuffers(1, &map->framebuffer);
+            glDeleteTextures(1, &map->texture);
+        }
+        glDeleteProgram(m_program);
+    }
+}
+
+void ShadowMaps::initialize(ShaderProgramCache &_cache)
+{
+    ShaderProgramCache::Build build = _cache.begin("shaders/ShadowVertex.glsl", "shaders/ShadowFragment.glsl");
+    m_program = _cache.finish(build);
+    createMap(m_stack, StackSize);
+    createMap(m_pieces, PieceSize);
+}
+
+void ShadowMaps::createMap(Map &_map, int _size)
+{
+    _map.size = _size;
+    glGenTextures(1, &_map.texture);
+    glBindTexture(GL_TEXTURE_2D, _map.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, _size, _size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    // linear filtering with comparison gives 2x2 PCF for free
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    // outside the light's frustum reads as the far plane, lit
+    constexpr GLfloat border[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &_map.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, _map.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _map.texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "shadow map framebuffer incomplete, drawing without shadows\n";
+    }
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+}
+
+void ShadowMaps::setLight(const ngl::Vec3 &_light, const ngl::Vec3 &_centre, float _radius)
+{
+    // the narrowest cone from the light that holds the whole sphere
+    ngl::Vec3 toCentre = _centre - _light;
+    float distance = toCentre.length();
+    float halfAngle = distance > _radius ? std::asin(_radius / distance) : 1.0f;
+    float nearPlane = std::max(distance - _radius, 0.1f);
+    float farPlane = distance + _radius;
+
+    // any up vector not along the light's direction will do
+    ngl::Vec3 up = std::abs(toCentre.m_y) > 0.99f * distance ? ngl::Vec3(0.0f, 0.0f, 1.0f) : ngl::Vec3::up();
+    m_lightMatrix = ngl::perspective(2.0f * halfAngle * 180.0f / 3.14159265f, 1.0f, nearPlane, farPlane) *
+                    ngl::lookAt(_light, _centre, up);
+    m_stackValid = false;
+}
+
+void ShadowMaps::setBoardOffsets(const ngl::Vec3 *_offsets, int _count)
+{
+    glUseProgram(m_program);
+    glUniform3fv(glGetUniformLocation(m_program, "boardOffset"), _count, &_offsets[0].m_x);
+    m_stackValid = false;
+}
+
+bool ShadowMaps::renderStack(const InstancedCubes &_cubes, std::uint64_t _key)
+{
+    if (m_stackValid && _key == m_stackKey)
+    {
+        return false;
+    }
+    render(m_stack, _cubes);
+    m_stackKey = _key;
+    m_stackValid = true;
+    ++m_stackRenders;
+    return true;
+}
+
+void ShadowMaps::renderPieces(const InstancedCubes &_cubes)
+{
+    render(m_pieces, _cubes);
+}
+
+void ShadowMaps::render(const Map &_map, const InstancedCubes &_cubes) const
+{
+    GLint framebuffer = 0;
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _map.framebuffer);
+    glViewport(0, 0, _map.size, _map.size);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glUseProgram(m_program);
+    glUniformMatrix4fv(glGetUniformLocation(m_program, "lightMatrix"), 1, GL_FALSE, &m_lightMatrix.m_m[0][0]);
+    // push the depths back a little so faces don't shadow themselves
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+    _cubes.draw();
+    glDisable(GL_POLYGON_OFFSET_FILL);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void ShadowMaps::bindTextures() const
+{
+    glActiveTexture(GL_TEXTURE0 + StackUnit);
+    glBindTexture(GL_TEXTURE_2D, m_stack.texture);
+    glActiveTexture(GL_TEXTURE0 + PieceUnit);
+    glBindTexture(GL_TEXTURE_2D, m_pieces.texture);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,158 @@
+#include "TerminalRenderer.h"
+#include <algorithm>
+#include <cerrno>
+#include <unistd.h>
+
+namespace
+{
+    // SGR escapes per Colour, each starting from a reset so they don't depend on the one before;
+    // palette colours are the nearest of the 256 colour cube to the classic theme in Palette.cpp
+    const char* const colourEscapes[TerminalRenderer::ColourCount] = {
+        "\x1b[0m",              // default
+        "\x1b[0;48;5;244m",     // garbage
+        "\x1b[0;48;5;21m",      // I-block
+        "\x1b[0;48;5;201m",     // T-block
+        "\x1b[0;48;5;93m",      // O-block
+        "\x1b[0;48;5;46m",      // Z-block
+        "\x1b[0;48;5;196m",     // S-block
+        "\x1b[0;48;5;226m",     // L-block
+        "\x1b[0;48;5;51m",      // J-block
+        "\x1b[0;38;5;244m"      // wall
+    };
+
+    // A cursor move is at least 6 bytes, unchanged cells shorter than that are cheaper to send again
+    constexpr int MaxRewrite = 4;
+}
+
+TerminalRenderer::TerminalRenderer(int columns, int rows)
+    : _columns(std::max(columns, 1)), _rows(std::max(rows, 1)),
+      _front(static_cast<std::size_t>(_columns * _rows)), _back(_front.size())
+{
+    // a full redraw is about a cursor move, a colour and a glyph a cell
+    _output.reserve(_front.size() * 16 + 64);
+}
+
+void TerminalRenderer::Clear()
+{
+    std::fill(_back.begin(), _back.end(), Cell());
+}
+
+void TerminalRenderer::DrawText(int column, int row, const std::string& text)
+{
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+        Put(column + static_cast<int>(i), row, text[i], DefaultColour);
+    }
+}
+
+const std::string& TerminalRenderer::Present()
+{
+    _output.clear();
+    if (_clear)
+    {
+        // a cleared screen is every cell blank in the default colour, the same as a cleared grid
+        _output += "\x1b[0m\x1b[2J";
+        _colour = DefaultColour;
+        std::fill(_front.begin(), _front.end(), Cell());
+        _clear = false;
+    }
+
+    for (int row = 0; row < _rows; ++row)
+    {
+        // where the cursor is on this row, -1 until a glyph has been sent on it
+        int cursor = -1;
+        const Cell* front = &_front[static_cast<std::size_t>(row * _columns)];
+        const Cell* back = &_back[static_cast<std::size_t>(row * _columns)];
+        for (int column = 0; column < _columns; ++column)
+        {
+            if (back[column] == front[column])
+            {
+                continue;
+            }
+            if (column != cursor)
+            {
+                // a short run of unchanged cells in the current colour is cheaper to send again than to jump over
+                bool rewrite = cursor >= 0 && column - cursor <= MaxRewrite;
+                for (int skipped = cursor; rewrite && skipped < column; ++skipped)
+                {
+                    rewrite = back[skipped].colour == _colour;
+                }
+                if (rewrite)
+                {
+                    for (int skipped = cursor; skipped < column; ++skipped)
+                    {
+                        _output += back[skipped].glyph;
+                    }
+                }
+                else
+                {
+                    _output += "\x1b[";
+                    AppendNumber(row + 1);
+                    _output += ';';
+                    AppendNumber(column + 1);
+                    _output += 'H';
+                }
+            }
+            if (back[column].colour != _colour)
+            {
+                _colour = back[column].colour;
+                _output += colourEscapes[_colour];
+            }
+            _output += back[column].glyph;
+
+            // past the last column the cursor waits to wrap and where it is depends on the terminal
+            cursor = column + 1 < _columns ? column + 1 : -1;
+        }
+    }
+    std::copy(_back.begin(), _back.end(), _front.begin());
+    return _output;
+}
+
+void TerminalRenderer::Invalidate()
+{
+    _clear = true;
+}
+
+bool TerminalRenderer::Write(int descriptor, const std::string& bytes)
+{
+    std::size_t sent = 0;
+    while (sent < bytes.size())
+    {
+        ssize_t written = write(descriptor, bytes.data() + sent, bytes.size() - sent);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        sent += static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+const char* TerminalRenderer::EnterSequence()
+{
+    return "\x1b[?1049h\x1b[?25l";
+}
+
+const char* TerminalRenderer::LeaveSequence()
+{
+    return "\x1b[0m\x1b[?25h\x1b[?1049l";
+}
+
+void TerminalRenderer::AppendNumber(int value)
+{
+    char digits[12];
+    int count = 0;
+    do
+    {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0)
+    {
+        _output += digits[--count];
+    }
+}
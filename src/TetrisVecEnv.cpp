@@ -0,0 +1,161 @@
+#include "TetrisVecEnv.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace
+{
+    static_assert(TETRIS_ENV_ROWS == 20 && TETRIS_ENV_COLS == 10, "Observation is laid out for the standard Board");
+    static_assert(TETRIS_ENV_PREVIEW == PreviewSize, "Observation preview must match the game's");
+    static_assert(TETRIS_ENV_LEFT == int(InputLeft) && TETRIS_ENV_RIGHT == int(InputRight) &&
+                  TETRIS_ENV_DOWN == int(InputDown) && TETRIS_ENV_ROTATE == int(InputRotate), "Action bits must match InputButton");
+
+    // One row mask expanded to a byte per column, so a row of the observation is one copy.
+    using RowBytes = std::array<std::uint8_t, TETRIS_ENV_COLS>;
+
+    const std::array<RowBytes, 1 << TETRIS_ENV_COLS>& rowBytes()
+    {
+        static const auto table = []
+        {
+            std::array<RowBytes, 1 << TETRIS_ENV_COLS> bytes{};
+            for (int mask = 0; mask < (1 << TETRIS_ENV_COLS); ++mask)
+            {
+                for (int col = 0; col < TETRIS_ENV_COLS; ++col)
+                {
+                    bytes[mask][col] = static_cast<std::uint8_t>((mask >> col) & 1);
+                }
+            }
+            return bytes;
+        }();
+        return table;
+    }
+
+    // The seed of the episode after one, so automatic resets stay reproducible.
+    std::uint32_t nextSeed(std::uint32_t seed)
+    {
+        return seed * 1664525u + 1013904223u;
+    }
+}
+
+TetrisVecEnv::TetrisVecEnv(int count, int threads)
+    : _games(count), _seeds(count, 0), _pool(std::make_unique<WorkerPool>(std::clamp(threads, 1, std::max(count, 1))))
+{
+    rowBytes();
+}
+
+void TetrisVecEnv::ResetGame(int index, std::uint32_t seed)
+{
+    _seeds[index] = seed;
+    _games[index] = Game(Board(), seed);
+}
+
+void TetrisVecEnv::WriteObservation(int index, std::uint8_t* out) const
+{
+    const Game& game = _games[index];
+    const Board& board = game.getBoard();
+    const Tetromino& piece = game.getTetromino();
+    const auto& table = rowBytes();
+
+    // locked blocks and active piece both live in the row masks, so copy whole rows first
+    std::uint8_t* cells = out + TETRIS_ENV_BOARD_OFFSET;
+    for (int row = 0; row < TETRIS_ENV_ROWS; ++row)
+    {
+        std::memcpy(cells + row * TETRIS_ENV_COLS, table[board.getRow(row)].data(), TETRIS_ENV_COLS);
+    }
+
+    // then mark the active piece's cells, unless the game ended before it was drawn
+    if (!game.isGameOver())
+    {
+        const auto& shape = Board::Pieces::getShape(piece.getType(), piece.getRotation());
+        for (int i = 0; i < Board::Pieces::Size; ++i)
+        {
+            int row = piece.GetY() + i;
+            for (int j = 0; j < Board::Pieces::Size; ++j)
+            {
+                int col = piece.GetX() + j;
+                if ((shape[i] >> j) & 1 && row >= 0 && row < TETRIS_ENV_ROWS && col >= 0 && col < TETRIS_ENV_COLS)
+                {
+                    cells[row * TETRIS_ENV_COLS + col] = 2;
+                }
+            }
+        }
+    }
+
+    std::uint8_t* pieceInfo = out + TETRIS_ENV_PIECE_OFFSET;
+    pieceInfo[0] = static_cast<std::uint8_t>(piece.getType());
+    pieceInfo[1] = static_cast<std::uint8_t>(piece.getRotation());
+    pieceInfo[2] = static_cast<std::uint8_t>(static_cast<std::int8_t>(piece.GetX()));
+    pieceInfo[3] = static_cast<std::uint8_t>(static_cast<std::int8_t>(piece.GetY()));
+
+    for (int i = 0; i < PreviewSize; ++i)
+    {
+        out[TETRIS_ENV_PREVIEW_OFFSET + i] = static_cast<std::uint8_t>(game.getPreview(i));
+    }
+
+    std::uint8_t* status = out + TETRIS_ENV_STATUS_OFFSET;
+    status[0] = static_cast<std::uint8_t>(game.getLevel());
+    status[1] = static_cast<std::uint8_t>(std::min(game.getCombo() + 1, 255));
+    status[2] = game.isBackToBack();
+}
+
+void TetrisVecEnv::Reset(const std::uint32_t* seeds, std::uint8_t* observations)
+{
+    auto task = [&](int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            ResetGame(i, seeds[i]);
+            WriteObservation(i, observations + static_cast<std::size_t>(i) * TETRIS_ENV_OBSERVATION_SIZE);
+        }
+    };
+    _pool->Run(getCount(), task);
+}
+
+void TetrisVecEnv::Step(const InputFrame* actions, std::uint8_t* observations, float* rewards, std::uint8_t* dones)
+{
+    auto task = [&](int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            Game& game = _games[i];
+            int score = game.getScore();
+            game.Step(actions[i]);
+            rewards[i] = static_cast<float>(game.getScore() - score);
+            dones[i] = game.isGameOver();
+            if (dones[i])
+            {
+                ResetGame(i, nextSeed(_seeds[i]));
+            }
+            WriteObservation(i, observations + static_cast<std::size_t>(i) * TETRIS_ENV_OBSERVATION_SIZE);
+        }
+    };
+    _pool->Run(getCount(), task);
+}
+
+extern "C"
+{
+TetrisVecEnv* tetris_vec_env_create(int count, int threads)
+{
+    if (count <= 0)
+    {
+        return nullptr;
+    }
+    return new TetrisVecEnv(count, threads);
+}
+
+void tetris_vec_env_destroy(TetrisVecEnv* env)
+{
+    delete env;
+}
+
+void tetris_vec_env_reset(TetrisVecEnv* env, const uint32_t* seeds, uint8_t* observations)
+{
+    env->Reset(seeds, observations);
+}
+
+void tetris_vec_env_step(TetrisVecEnv* env, const uint8_t* actions, uint8_t* observations,
+                         float* rewards, uint8_t* dones)
+{
+    env->Step(actions, observations, rewards, dones);
+}
+}
@@ -0,0 +1,110 @@
+#include "TranspositionTable.h"
+#include <algorithm>
+
+namespace
+{
+    // Bit layout of a slot's data word: score, depth, generation, move, and a bit that makes it non-zero.
+    constexpr int DepthShift = 32;
+    constexpr int GenerationShift = 40;
+    constexpr int MoveShift = 48;
+    constexpr std::uint64_t OccupiedBit = 1ull << 63;
+}
+
+TranspositionTable::TranspositionTable(std::size_t megabytes)
+{
+    std::size_t buckets = 1;
+    while (buckets * 2 * sizeof(Bucket) <= std::max<std::size_t>(megabytes, 1) << 20)
+    {
+        buckets *= 2;
+    }
+    _buckets = std::make_unique<Bucket[]>(buckets);
+    _mask = buckets - 1;
+}
+
+std::uint64_t TranspositionTable::Pack(const TranspositionEntry& entry) const
+{
+    return static_cast<std::uint32_t>(entry.score) |
+           static_cast<std::uint64_t>(entry.depth) << DepthShift |
+           static_cast<std::uint64_t>(_generation) << GenerationShift |
+           static_cast<std::uint64_t>(entry.move & 0x7fff) << MoveShift |
+           OccupiedBit;
+}
+
+TranspositionEntry TranspositionTable::Unpack(std::uint64_t data)
+{
+    TranspositionEntry entry;
+    entry.score = static_cast<std::int32_t>(static_cast<std::uint32_t>(data));
+    entry.depth = static_cast<std::uint8_t>(data >> DepthShift);
+    entry.move = static_cast<std::uint16_t>((data >> MoveShift) & 0x7fff);
+    return entry;
+}
+
+bool TranspositionTable::Probe(std::uint64_t key, TranspositionEntry& entry, TranspositionStats& stats) const
+{
+    stats.probes++;
+    for (const Slot& slot : BucketFor(key).slots)
+    {
+        std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if (data && (slot.check.load(std::memory_order_relaxed) ^ data) == key)
+        {
+            entry = Unpack(data);
+            stats.hits++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::Store(std::uint64_t key, const TranspositionEntry& entry, TranspositionStats& stats)
+{
+    Bucket& bucket = BucketFor(key);
+    Slot* victim = nullptr;
+    int victimValue = 0;
+    bool evicts = true;
+    for (Slot& slot : bucket.slots)
+    {
+        std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if (!data || (slot.check.load(std::memory_order_relaxed) ^ data) == key)
+        {
+            // an empty slot or the position's own; keep a deeper result from this search over a shallower one
+            if (data && Unpack(data).depth > entry.depth &&
+                static_cast<std::uint8_t>(data >> GenerationShift) == _generation)
+            {
+                return;
+            }
+            victim = &slot;
+            evicts = false;
+            break;
+        }
+
+        // entries lose a ply of value for every search since they were written
+        int age = static_cast<std::uint8_t>(_generation - static_cast<std::uint8_t>(data >> GenerationShift));
+        int value = Unpack(data).depth - age;
+        if (!victim || value < victimValue)
+        {
+            victim = &slot;
+            victimValue = value;
+        }
+    }
+
+    if (evicts)
+    {
+        stats.replaced++;
+    }
+    std::uint64_t data = Pack(entry);
+    victim->data.store(data, std::memory_order_relaxed);
+    victim->check.store(key ^ data, std::memory_order_relaxed);
+    stats.stores++;
+}
+
+void TranspositionTable::Clear()
+{
+    for (std::size_t i = 0; i <= _mask; ++i)
+    {
+        for (Slot& slot : _buckets[i].slots)
+        {
+            slot.data.store(0, std::memory_order_relaxed);
+            slot.check.store(0, std::memory_order_relaxed);
+        }
+    }
+}
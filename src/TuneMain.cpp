@@ -0,0 +1,132 @@
+/****************************************************************************
+Tunes the placement search's evaluation weights with the cross-entropy method, e.g.
+  ./tetris_tune --generations 50 --population 32 --games 16 --pieces 500 --log tune.csv
+Every weight set plays the same seeded games spread over all cores. The state is
+saved to --checkpoint after each generation, and --resume carries on from it with
+the options it was started with; each generation is appended to --log as CSV.
+****************************************************************************/
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "WeightTuner.h"
+
+namespace
+{
+    // Writes the checkpoint beside the old one and renames it over, so an interrupted write loses nothing.
+    bool saveCheckpoint(const WeightTuner& tuner, const std::string& path)
+    {
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary);
+            tuner.SaveCheckpoint(out);
+            if (!out)
+            {
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        return !error;
+    }
+
+    void writeWeights(std::ostream& out, const SearchWeights& weights)
+    {
+        out << ',' << weights.height << ',' << weights.holes << ',' << weights.bumpiness << ',' << weights.lines;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    TunerOptions options;
+    options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int generations = 50;
+    std::string checkpoint = "tune.checkpoint";
+    std::string resume;
+    std::string log = "tune.csv";
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--generations") generations = std::stoi(value);
+        else if (arg == "--population") options.population = std::stoi(value);
+        else if (arg == "--elite") options.elite = std::stoi(value);
+        else if (arg == "--games") options.games = std::stoi(value);
+        else if (arg == "--pieces") options.pieces = std::stoi(value);
+        else if (arg == "--depth") options.depth = std::stoi(value);
+        else if (arg == "--seed") options.seed = static_cast<unsigned int>(std::stoul(value));
+        else if (arg == "--sigma") options.initialSigma = std::stod(value);
+        else if (arg == "--threads") options.threads = std::stoi(value);
+        else if (arg == "--checkpoint") checkpoint = value;
+        else if (arg == "--resume") resume = value;
+        else if (arg == "--log") log = value;
+        else continue;
+        ++i;
+    }
+    if (generations <= 0 || options.population < 2 || options.elite < 1 || options.elite > options.population ||
+        options.games <= 0 || options.pieces <= 0 || options.depth < 1 || options.depth > PlacementSearch::MaxDepth)
+    {
+        std::cerr << "usage: tetris_tune [--generations N] [--population N] [--elite N] [--games N] [--pieces N]\n"
+                  << "                   [--depth 1-" << PlacementSearch::MaxDepth << "] [--seed N] [--sigma N] [--threads N]\n"
+                  << "                   [--checkpoint FILE] [--resume FILE] [--log FILE]\n";
+        return EXIT_FAILURE;
+    }
+
+    WeightTuner tuner(options);
+    if (!resume.empty())
+    {
+        std::ifstream in(resume);
+        if (!in || !tuner.LoadCheckpoint(in))
+        {
+            std::cerr << "could not resume from " << resume << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "resuming after generation " << tuner.getGeneration() << "\n";
+    }
+
+    // a fresh run starts a fresh log, a resumed one adds to it
+    bool header = resume.empty() || !std::filesystem::exists(log);
+    std::ofstream csv(log, header ? std::ios::trunc : std::ios::app);
+    if (!csv)
+    {
+        std::cerr << "could not open " << log << "\n";
+        return EXIT_FAILURE;
+    }
+    if (header)
+    {
+        csv << "generation,best_lines,mean_lines,best_height,best_holes,best_bumpiness,best_line_value,"
+               "mean_height,mean_holes,mean_bumpiness,mean_line_value,"
+               "sigma_height,sigma_holes,sigma_bumpiness,sigma_line_value\n";
+    }
+
+    const TunerOptions& used = tuner.getOptions();
+    std::cout << used.population << " weight sets of " << used.games << " games up to " << used.pieces
+              << " pieces at depth " << used.depth << " on " << used.threads << " threads\n";
+    for (int run = 0; run < generations; ++run)
+    {
+        TunerGeneration result = tuner.RunGeneration();
+        csv << result.generation << ',' << result.bestFitness << ',' << result.meanFitness;
+        writeWeights(csv, result.best);
+        writeWeights(csv, result.mean);
+        for (double sigma : result.sigma)
+        {
+            csv << ',' << sigma;
+        }
+        csv << std::endl;
+
+        std::cout << "generation " << result.generation << ": best " << result.bestFitness << " lines, mean "
+                  << result.meanFitness << ", weights " << result.mean.height << ' ' << result.mean.holes << ' '
+                  << result.mean.bumpiness << ' ' << result.mean.lines << "\n";
+        if (!saveCheckpoint(tuner, checkpoint))
+        {
+            std::cerr << "could not write " << checkpoint << "\n";
+        }
+    }
+
+    SearchWeights weights = tuner.getMean();
+    std::cout << "tuned weights: height " << weights.height << ", holes " << weights.holes << ", bumpiness "
+              << weights.bumpiness << ", lines " << weights.lines << "\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+#include "UdpLink.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+UdpLink::~UdpLink()
+{
+    if (_socket >= 0)
+    {
+        close(_socket);
+    }
+}
+
+bool UdpLink::Open(int port)
+{
+    _socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (_socket < 0)
+    {
+        return false;
+    }
+    fcntl(_socket, F_SETFL, fcntl(_socket, F_GETFL, 0) | O_NONBLOCK);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<std::uint16_t>(port));
+    return bind(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+}
+
+bool UdpLink::SetPeer(const std::string& host, int port)
+{
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<std::uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+    {
+        return false;
+    }
+    SetPeer(address);
+    return true;
+}
+
+void UdpLink::SetPeer(const sockaddr_in& address)
+{
+    _peer = address;
+    _hasPeer = true;
+}
+
+bool UdpLink::isPeer(const sockaddr_in& address) const
+{
+    return _hasPeer && address.sin_family == _peer.sin_family && address.sin_port == _peer.sin_port &&
+           address.sin_addr.s_addr == _peer.sin_addr.s_addr;
+}
+
+void UdpLink::SetImpairment(int latencyMs, int jitterMs, double loss, unsigned int seed)
+{
+    _latencyMs = std::max(latencyMs, 0);
+    _jitterMs = std::max(jitterMs, 0);
+    _loss = std::clamp(loss, 0.0, 1.0);
+    _random.seed(seed);
+}
+
+void UdpLink::Send(const std::uint8_t* data, std::size_t size)
+{
+    if (!_hasPeer)
+    {
+        return;
+    }
+    if (_loss > 0.0 && static_cast<double>(_random() - _random.min()) / (_random.max() - _random.min()) < _loss)
+    {
+        _dropped++;
+        return;
+    }
+    if (_latencyMs == 0 && _jitterMs == 0)
+    {
+        SendNow(data, size);
+        return;
+    }
+
+    int delay = _latencyMs + (_jitterMs > 0 ? static_cast<int>(_random() % (_jitterMs + 1)) : 0);
+    Delayed delayed{Clock::now() + std::chrono::milliseconds(delay), {data, data + size}};
+    // keep the queue in due order, jitter can reorder datagrams just like a real network
+    auto it = std::upper_bound(_delayed.begin(), _delayed.end(), delayed.due,
+                               [](Clock::time_point due, const Delayed& d) { return due < d.due; });
+    _delayed.insert(it, std::move(delayed));
+}
+
+void UdpLink::Flush()
+{
+    auto now = Clock::now();
+    while (!_delayed.empty() && _delayed.front().due <= now)
+    {
+        SendNow(_delayed.front().data.data(), _delayed.front().data.size());
+        _delayed.pop_front();
+    }
+}
+
+void UdpLink::SendNow(const std::uint8_t* data, std::size_t size)
+{
+    sendto(_socket, data, size, 0, reinterpret_cast<const sockaddr*>(&_peer), sizeof(_peer));
+}
+
+int UdpLink::Receive(std::uint8_t* buffer, std::size_t capacity, sockaddr_in* from)
+{
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    auto received = recvfrom(_socket, buffer, capacity, 0, reinterpret_cast<sockaddr*>(&address), &length);
+    if (received < 0)
+    {
+        return -1;
+    }
+    if (from != nullptr)
+    {
+        *from = address;
+    }
+    return static_cast<int>(received);
+}
@@ -0,0 +1,105 @@
+#include "VersusMatch.h"
+#include <algorithm>
+
+VersusMatch::VersusMatch(int players, const Board& board, unsigned int seed, int threads)
+{
+    players = std::clamp(players, 1, MaxPlayers);
+    threads = std::clamp(threads, 1, players);
+    if (threads > 1)
+    {
+        _pool = std::make_unique<WorkerPool>(threads);
+    }
+    _games.reserve(players);
+    for (int i = 0; i < players; ++i)
+    {
+        _games.emplace_back(board, seed);
+        _inbox.push_back(std::make_unique<GarbageQueue>());
+    }
+    _changed.assign(players, 0);
+}
+
+int VersusMatch::AttackLines(int lines)
+{
+    // singles send nothing, a tetris sends four
+    static constexpr int attack[] = {0, 0, 1, 2, 4};
+    return attack[std::clamp(lines, 0, 4)];
+}
+
+void VersusMatch::StepPlayer(int player, InputFrame input)
+{
+    Game& game = _games[player];
+    int pieces = game.getPieces();
+    _changed[player] = game.Step(input);
+    if (game.getPieces() == pieces || getPlayerCount() < 2)
+    {
+        return;
+    }
+
+    int lines = game.CancelGarbage(AttackLines(game.getLinesCleared()));
+    if (lines > 0)
+    {
+        // attack the next board round the table; a full inbox drops the packet rather than block
+        int target = (player + 1) % getPlayerCount();
+        _inbox[target]->TryPush({player, lines});
+    }
+}
+
+bool VersusMatch::Step(const InputFrame* inputs)
+{
+    int players = getPlayerCount();
+    auto task = [this, inputs](int begin, int end)
+    {
+        for (int player = begin; player < end; ++player)
+        {
+            StepPlayer(player, inputs[player]);
+        }
+    };
+    if (_pool)
+    {
+        _pool->Run(players, task);
+    }
+    else
+    {
+        task(0, players);
+    }
+
+    // deliver garbage only after every board has stepped
+    bool changed = false;
+    for (int player = 0; player < players; ++player)
+    {
+        GarbagePacket packet;
+        while (_inbox[player]->TryPop(packet))
+        {
+            _games[player].AddGarbage(packet.lines);
+        }
+        changed |= _changed[player] != 0;
+    }
+    return changed;
+}
+
+void VersusMatch::SaveState(MatchState& state) const
+{
+    state.games.resize(_games.size());
+    for (std::size_t player = 0; player < _games.size(); ++player)
+    {
+        _games[player].SaveState(state.games[player]);
+    }
+}
+
+void VersusMatch::LoadState(const MatchState& state)
+{
+    for (std::size_t player = 0; player < _games.size(); ++player)
+    {
+        _games[player].LoadState(state.games[player]);
+    }
+}
+
+std::uint32_t VersusMatch::Checksum() const
+{
+    std::uint32_t hash = 2166136261u;
+    for (const auto& game : _games)
+    {
+        hash = (hash ^ game.Checksum()) * 16777619u;
+    }
+    return hash;
+}
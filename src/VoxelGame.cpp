@@ -0,0 +1,189 @@
+#include "VoxelGame.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr int OneLayer = 1 << 16; // one layer of gravity in 16.16 fixed point
+
+    // Where a turn that doesn't fit tries next: either side, then up.
+    constexpr int kicks[][3] = {{0, 0, 0}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, 1}};
+}
+
+template <typename WellType>
+BasicVoxelGame<WellType>::BasicVoxelGame(unsigned int seed, int startLevel)
+    : _random(seed), _level(std::clamp(startLevel, 1, Game::MaxLevel)), _startLevel(_level)
+{
+    _next = NextPieceType();
+    SpawnPiece();
+}
+
+template <typename WellType>
+bool BasicVoxelGame<WellType>::Step(InputFrame input)
+{
+    InputFrame pressed = input & ~_lastInput;
+    _lastInput = input;
+    if (_gameOver)
+    {
+        return false;
+    }
+
+    bool changed = false;
+    for (int axis = AxisX; axis <= AxisZ; ++axis)
+    {
+        if (pressed & (VoxelTurnX << axis))
+        {
+            changed |= Rotate(axis);
+        }
+    }
+    if (pressed & VoxelLeft)
+    {
+        changed |= !Move(-1, 0, 0);
+    }
+    if (pressed & VoxelRight)
+    {
+        changed |= !Move(1, 0, 0);
+    }
+    if (pressed & VoxelFar)
+    {
+        changed |= !Move(0, 1, 0);
+    }
+    if (pressed & VoxelNear)
+    {
+        changed |= !Move(0, -1, 0);
+    }
+    if (pressed & VoxelDrop)
+    {
+        Drop();
+        return true;
+    }
+
+    _gravityProgress += Game::GravityPerFrame(_level);
+    while (_gravityProgress >= OneLayer && !_gameOver)
+    {
+        _gravityProgress -= OneLayer;
+        changed = true;
+        if (Tick())
+        {
+            _gravityProgress = 0;
+            break;
+        }
+    }
+    return changed;
+}
+
+template <typename WellType>
+bool BasicVoxelGame<WellType>::Move(int dx, int dy, int dz)
+{
+    if (_gameOver)
+    {
+        return true;
+    }
+    VoxelPiece moved = _piece;
+    moved.x += dx;
+    moved.y += dy;
+    moved.z += dz;
+    if (_well.Collides(moved))
+    {
+        return true;
+    }
+    _piece = moved;
+    return false;
+}
+
+template <typename WellType>
+bool BasicVoxelGame<WellType>::Rotate(int axis)
+{
+    if (_gameOver)
+    {
+        return false;
+    }
+    const Polycubes::Orientation& shape = _piece.getShape();
+    VoxelPiece turned = _piece;
+    turned.orientation = shape.turned[axis];
+    const Polycubes::Orientation& next = turned.getShape();
+    // keep the centre of the box still, truncating the same way both ways so turning back undoes it
+    turned.x += (shape.size[AxisX] - next.size[AxisX]) / 2;
+    turned.y += (shape.size[AxisY] - next.size[AxisY]) / 2;
+    turned.z += (shape.size[AxisZ] - next.size[AxisZ]) / 2;
+    for (const auto& kick : kicks)
+    {
+        VoxelPiece kicked = turned;
+        kicked.x += kick[0];
+        kicked.y += kick[1];
+        kicked.z += kick[2];
+        if (!_well.Collides(kicked))
+        {
+            _piece = kicked;
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename WellType>
+void BasicVoxelGame<WellType>::Drop()
+{
+    if (_gameOver)
+    {
+        return;
+    }
+    while (!Move(0, 0, -1))
+    {
+        _score += 2;
+    }
+    Lock();
+}
+
+template <typename WellType>
+bool BasicVoxelGame<WellType>::Tick()
+{
+    if (_gameOver)
+    {
+        return false;
+    }
+    if (!Move(0, 0, -1))
+    {
+        return false;
+    }
+    Lock();
+    return true;
+}
+
+template <typename WellType>
+void BasicVoxelGame<WellType>::Lock()
+{
+    static constexpr int points[] = {0, 100, 300, 600, 1000};
+    _layersCleared = _well.Lock(_piece, PaletteIndex(_piece.type));
+    _score += points[std::min(_layersCleared, 4)] * _level;
+    _layers += _layersCleared;
+    _level = std::min(Game::MaxLevel, std::max(_level, _startLevel + _layers / LayersPerLevel));
+    _pieces++;
+    SpawnPiece();
+}
+
+template <typename WellType>
+void BasicVoxelGame<WellType>::SpawnPiece()
+{
+    _piece.type = _next;
+    _piece.orientation = 0;
+    const Polycubes::Orientation& shape = _piece.getShape();
+    _piece.x = (WellType::getWidth() - shape.size[AxisX]) / 2;
+    _piece.y = (WellType::getDepth() - shape.size[AxisY]) / 2;
+    _piece.z = WellType::getHeight() - shape.size[AxisZ];
+    _next = NextPieceType();
+    _gravityProgress = 0;
+    if (_well.Collides(_piece))
+    {
+        _gameOver = true;
+        _piece.type = 0;
+    }
+}
+
+template <typename WellType>
+std::uint8_t BasicVoxelGame<WellType>::NextPieceType()
+{
+    return static_cast<std::uint8_t>(_random() % Polycubes::Count + 1);
+}
+
+template class BasicVoxelGame<VoxelWell>;
+template class BasicVoxelGame<WideVoxelWell>;
@@ -0,0 +1,103 @@
+#include "VoxelWell.h"
+#include <algorithm>
+
+template <int Width, int Depth, int Height>
+const typename BasicVoxelWell<Width, Depth, Height>::MaskTable& BasicVoxelWell<Width, Depth, Height>::Masks()
+{
+    static const MaskTable masks = []
+    {
+        MaskTable table{};
+        for (int type = 1; type <= Polycubes::Count; ++type)
+        {
+            for (int orientation = 0; orientation < Polycubes::getOrientationCount(type); ++orientation)
+            {
+                // move each cube from bit x + 4 * y of the box to bit x + Width * y of the layer
+                const Polycubes::Orientation& shape = Polycubes::getOrientation(type, orientation);
+                for (int i = 0; i < shape.cellCount; ++i)
+                {
+                    const Polycubes::Cell& cell = shape.cells[i];
+                    table[type - 1][orientation][cell.z] |= 1ull << (cell.x + Width * cell.y);
+                }
+            }
+        }
+        return table;
+    }();
+    return masks;
+}
+
+template <int Width, int Depth, int Height>
+typename BasicVoxelWell<Width, Depth, Height>::LayerMask BasicVoxelWell<Width, Depth, Height>::PieceLayer(
+        const VoxelPiece& piece, int layer)
+{
+    return Masks()[piece.type - 1][piece.orientation][layer] << (piece.x + Width * piece.y);
+}
+
+template <int Width, int Depth, int Height>
+bool BasicVoxelWell<Width, Depth, Height>::Collides(const VoxelPiece& piece) const
+{
+    // inside the walls the box never wraps from one row of a layer into the next
+    const Polycubes::Orientation& shape = piece.getShape();
+    if (piece.x < 0 || piece.x + shape.size[AxisX] > Width || piece.y < 0 || piece.y + shape.size[AxisY] > Depth ||
+        piece.z < 0 || piece.z + shape.size[AxisZ] > Height)
+    {
+        return true;
+    }
+    for (int layer = 0; layer < shape.size[AxisZ]; ++layer)
+    {
+        if (PieceLayer(piece, layer) & _layers[piece.z + layer])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <int Width, int Depth, int Height>
+int BasicVoxelWell<Width, Depth, Height>::Lock(const VoxelPiece& piece, int palette)
+{
+    const int layers = piece.getShape().size[AxisZ];
+    for (int layer = 0; layer < layers; ++layer)
+    {
+        int z = piece.z + layer;
+        LayerMask cells = PieceLayer(piece, layer);
+        SetLayer(z, _layers[z] | cells);
+        for (int bit = 0; bit < PaletteBits; ++bit)
+        {
+            _palette[bit][z] = (palette >> bit & 1) ? _palette[bit][z] | cells : _palette[bit][z] & ~cells;
+        }
+    }
+
+    // only the layers the piece landed in can have filled up
+    int first = piece.z;
+    int top = piece.z + layers;
+    while (first < top && _layers[first] != FullLayer)
+    {
+        ++first;
+    }
+    if (first == top)
+    {
+        return 0;
+    }
+    int kept = first;
+    for (int z = first; z < Height; ++z)
+    {
+        if (z < top && _layers[z] == FullLayer)
+        {
+            continue;
+        }
+        SetLayer(kept, _layers[z]);
+        for (auto& plane : _palette)
+        {
+            plane[kept] = plane[z];
+        }
+        ++kept;
+    }
+    for (int z = kept; z < Height; ++z)
+    {
+        SetLayer(z, 0);
+    }
+    return Height - kept;
+}
+
+template class BasicVoxelWell<5, 5, 12>;
+template class BasicVoxelWell<8, 8, 16>;
@@ -0,0 +1,176 @@
+/****************************************************************************
+Watches bots play in the terminal, no GPU or display needed, e.g.
+  ./tetris_watch --players 2 --depth 2 --fps 60
+Every board is played by the placement search in a versus match and drawn
+with ANSI colours every frame, sending only the cells that changed, so it
+keeps up over SSH. --fps 0 draws as fast as the bots play; on exit, or on
+Ctrl-C, it reports how many frames were drawn, the frames per second the
+drawing alone would sustain and the bytes sent per frame, e.g.
+  ./tetris_watch --fps 0 --frames 100000 > /dev/null
+measures the renderer without a terminal in the way.
+****************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PlacementSearch.h"
+#include "TerminalRenderer.h"
+#include "VersusMatch.h"
+
+namespace
+{
+    std::atomic<bool> interrupted{false};
+
+    void onInterrupt(int)
+    {
+        interrupted.store(true);
+    }
+
+    // Buttons that bring the active piece to a placement, one press at a time since buttons act when they go down.
+    InputFrame inputFor(const Game& game, const PlacementSearch::Placement& target, InputFrame last)
+    {
+        const Tetromino& piece = game.getTetromino();
+        InputFrame input = InputDown;
+        if (piece.getRotation() != target.rotation)
+        {
+            input = InputRotate;
+        }
+        else if (piece.GetX() > target.x)
+        {
+            input = InputLeft;
+        }
+        else if (piece.GetX() < target.x)
+        {
+            input = InputRight;
+        }
+        return input == last ? 0 : input;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int players = 1;
+    int depth = 1;
+    int fps = 60;
+    long long frames = 0;
+    unsigned int seed = 1;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        int value = std::atoi(argv[i + 1]);
+        if (arg == "--players") players = value;
+        else if (arg == "--depth") depth = value;
+        else if (arg == "--fps") fps = value;
+        else if (arg == "--frames") frames = std::atoll(argv[i + 1]);
+        else if (arg == "--seed") seed = static_cast<unsigned int>(value);
+        else continue;
+        ++i;
+    }
+    if (players < 1 || players > VersusMatch::MaxPlayers || depth < 1 || depth > PlacementSearch::MaxDepth ||
+        fps < 0 || frames < 0)
+    {
+        std::cerr << "usage: tetris_watch [--players 1-" << VersusMatch::MaxPlayers << "] [--depth 1-"
+                  << PlacementSearch::MaxDepth << "] [--fps N, 0 unlimited] [--frames N] [--seed N]\n";
+        return EXIT_FAILURE;
+    }
+
+    VersusMatch match(players, Board(), seed);
+    PlacementSearch search(nullptr, 1);
+    std::vector<PlacementSearch::Placement> targets(static_cast<std::size_t>(players));
+    std::vector<int> searched(static_cast<std::size_t>(players), -1);
+    std::vector<InputFrame> inputs(static_cast<std::size_t>(players), 0);
+
+    // a title row above the wells, lines and score below them and a status row at the bottom
+    const int boardColumns = TerminalRenderer::BoardColumns(Board::FixedWidth) + 2;
+    const int statusRow = Board::FixedHeight + 4;
+    TerminalRenderer terminal(std::max(players * boardColumns, 48), statusRow + 1);
+    std::signal(SIGINT, onInterrupt);
+    TerminalRenderer::Write(1, TerminalRenderer::EnterSequence());
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    auto nextFrame = start;
+    auto nextStatus = start;
+    double drawSeconds = 0.0;
+    long long drawn = 0;
+    long long bytes = 0;
+    std::string status;
+    bool playing = true;
+    for (long long frame = 0; playing && !interrupted.load() && (frames == 0 || frame < frames); ++frame)
+    {
+        playing = false;
+        for (int p = 0; p < players; ++p)
+        {
+            const Game& game = match.getGame(p);
+            if (game.isGameOver())
+            {
+                inputs[p] = 0;
+                continue;
+            }
+            playing = true;
+            if (searched[p] != game.getPieces())
+            {
+                searched[p] = game.getPieces();
+                targets[p] = search.FindBest(game, depth);
+            }
+            inputs[p] = inputFor(game, targets[p], inputs[p]);
+        }
+        match.Step(inputs.data());
+
+        // the status line changes at most once a second so it doesn't dirty every frame
+        auto now = Clock::now();
+        if (now >= nextStatus)
+        {
+            double seconds = std::chrono::duration<double>(now - start).count();
+            status = "frame " + std::to_string(frame) + "  " +
+                     std::to_string(static_cast<long long>(frame / std::max(seconds, 1e-9))) + " fps  " +
+                     std::to_string(drawn > 0 ? bytes / drawn : 0) + " bytes a frame";
+            nextStatus = now + std::chrono::seconds(1);
+        }
+
+        auto drawStart = Clock::now();
+        terminal.Clear();
+        for (int p = 0; p < players; ++p)
+        {
+            const Game& game = match.getGame(p);
+            int column = p * boardColumns;
+            terminal.DrawText(column, 0, "player " + std::to_string(p + 1) + (game.isGameOver() ? "  game over" : ""));
+            terminal.DrawBoard(game.getBoard(), column, 1);
+            terminal.DrawText(column, Board::FixedHeight + 2, "lines " + std::to_string(game.getLines()));
+            terminal.DrawText(column, Board::FixedHeight + 3, "score " + std::to_string(game.getScore()));
+        }
+        terminal.DrawText(0, statusRow, status);
+        const std::string& output = terminal.Present();
+        if (!TerminalRenderer::Write(1, output))
+        {
+            break;
+        }
+        drawSeconds += std::chrono::duration<double>(Clock::now() - drawStart).count();
+        bytes += static_cast<long long>(output.size());
+        ++drawn;
+
+        if (fps > 0)
+        {
+            nextFrame += std::chrono::nanoseconds(1000000000 / fps);
+            std::this_thread::sleep_until(nextFrame);
+        }
+    }
+
+    TerminalRenderer::Write(1, TerminalRenderer::LeaveSequence());
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cerr << drawn << " frames in " << seconds << " s, " << drawn / std::max(seconds, 1e-9) << " frames per second\n"
+              << "drawing         " << drawn / std::max(drawSeconds, 1e-9) << " frames per second, "
+              << (drawn > 0 ? bytes / drawn : 0) << " bytes per frame, " << bytes << " bytes in all\n";
+    for (int p = 0; p < players; ++p)
+    {
+        const Game& game = match.getGame(p);
+        std::cerr << "player " << p + 1 << "        " << game.getPieces() << " pieces, " << game.getLines() << " lines, score "
+                  << game.getScore() << (game.isGameOver() ? ", game over" : "") << "\n";
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,234 @@
+#include "WeightTuner.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <string>
+
+namespace
+{
+    constexpr auto CheckpointTag = "tetris_tune";
+    constexpr int CheckpointVersion = 1;
+
+    // Seed of one game of a generation, the same for every weight set in it.
+    unsigned int gameSeed(unsigned int seed, int generation, int games, int game)
+    {
+        std::uint64_t index = static_cast<std::uint64_t>(generation) * static_cast<std::uint64_t>(games) +
+                              static_cast<std::uint64_t>(game);
+        return static_cast<unsigned int>(ZobristMix(static_cast<std::uint64_t>(seed) << 32 ^ index));
+    }
+}
+
+WeightTuner::WeightTuner(const TunerOptions& options)
+    : _options(options), _random(options.seed),
+      _pool(std::make_unique<WorkerPool>(std::max(options.threads, 1)))
+{
+    _options.population = std::max(_options.population, 2);
+    _options.elite = std::clamp(_options.elite, 1, _options.population);
+    _options.games = std::max(_options.games, 1);
+    const SearchWeights defaults;
+    _mean = {static_cast<double>(defaults.height), static_cast<double>(defaults.holes),
+             static_cast<double>(defaults.bumpiness), static_cast<double>(defaults.lines)};
+    _sigma.fill(_options.initialSigma);
+}
+
+SearchWeights WeightTuner::ToWeights(const Vector& values)
+{
+    SearchWeights weights;
+    weights.height = static_cast<int>(std::lround(values[0]));
+    weights.holes = static_cast<int>(std::lround(values[1]));
+    weights.bumpiness = static_cast<int>(std::lround(values[2]));
+    weights.lines = static_cast<int>(std::lround(values[3]));
+    return weights;
+}
+
+double WeightTuner::Normal()
+{
+    // Box-Muller from the generator's raw bits, std::normal_distribution differs between standard libraries
+    constexpr double scale = 1.0 / 9007199254740992.0; // 2^-53
+    double u1 = (static_cast<double>(_random() >> 11) + 1.0) * scale;
+    double u2 = static_cast<double>(_random() >> 11) * scale;
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+int WeightTuner::PlayGame(const SearchWeights& weights, unsigned int seed, int pieces, int depth)
+{
+    Game game(Board(), seed);
+    PlacementSearch search(nullptr, 1, weights);
+    while (!game.isGameOver() && game.getPieces() < pieces)
+    {
+        PlacementSearch::Placement target = search.FindBest(game, depth);
+        if (!target.valid)
+        {
+            break;
+        }
+
+        // turn and shift at the spawn row, the way the search placed it, then drop until it locks
+        for (int turns = 0; game.getTetromino().getRotation() != target.rotation && turns < Board::Pieces::Rotations; ++turns)
+        {
+            game.Rotate();
+        }
+        while (game.getTetromino().GetX() > target.x && !game.Move(2))
+        {
+        }
+        while (game.getTetromino().GetX() < target.x && !game.Move(3))
+        {
+        }
+        while (!game.isGameOver() && !game.Tick())
+        {
+        }
+    }
+    return game.getLines();
+}
+
+TunerGeneration WeightTuner::RunGeneration()
+{
+    const int population = _options.population;
+    const int games = _options.games;
+    _samples.resize(static_cast<std::size_t>(population));
+    for (Vector& sample : _samples)
+    {
+        for (int i = 0; i < Dimensions; ++i)
+        {
+            sample[i] = _mean[i] + _sigma[i] * Normal();
+        }
+    }
+
+    // one game per work item, handed out as threads come free since games vary a lot in length
+    _lines.assign(static_cast<std::size_t>(population) * static_cast<std::size_t>(games), 0);
+    std::atomic<int> next{0};
+    const int count = static_cast<int>(_lines.size());
+    auto task = [&](int, int)
+    {
+        for (int item = next++; item < count; item = next++)
+        {
+            int set = item / games;
+            int game = item % games;
+            _lines[item] = PlayGame(ToWeights(_samples[set]), gameSeed(_options.seed, _generation, games, game),
+                                    _options.pieces, _options.depth);
+        }
+    };
+    _pool->Run(_pool->getThreadCount(), task);
+
+    // integer totals and a stable ranking keep the result independent of the thread count
+    std::vector<long long> totals(static_cast<std::size_t>(population), 0);
+    for (int set = 0; set < population; ++set)
+    {
+        for (int game = 0; game < games; ++game)
+        {
+            totals[set] += _lines[static_cast<std::size_t>(set) * games + game];
+        }
+    }
+    std::vector<int> order(static_cast<std::size_t>(population));
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return totals[a] > totals[b]; });
+
+    TunerGeneration result;
+    result.generation = _generation;
+    result.bestFitness = static_cast<double>(totals[order[0]]) / games;
+    result.meanFitness = static_cast<double>(std::accumulate(totals.begin(), totals.end(), 0ll)) / (population * games);
+    result.best = ToWeights(_samples[order[0]]);
+
+    // refit each Gaussian to the elite
+    const int elite = _options.elite;
+    for (int i = 0; i < Dimensions; ++i)
+    {
+        double mean = 0.0;
+        for (int rank = 0; rank < elite; ++rank)
+        {
+            mean += _samples[order[rank]][i];
+        }
+        mean /= elite;
+        double variance = 0.0;
+        for (int rank = 0; rank < elite; ++rank)
+        {
+            double offset = _samples[order[rank]][i] - mean;
+            variance += offset * offset;
+        }
+        _mean[i] = mean;
+        _sigma[i] = std::max(std::sqrt(variance / elite), _options.minSigma);
+    }
+    result.mean = ToWeights(_mean);
+    result.sigma = _sigma;
+    _generation++;
+    return result;
+}
+
+void WeightTuner::SaveCheckpoint(std::ostream& out) const
+{
+    // hex floats so the distribution comes back bit for bit
+    out << CheckpointTag << ' ' << CheckpointVersion << '\n'
+        << "generation " << _generation << '\n'
+        << "options " << _options.population << ' ' << _options.elite << ' ' << _options.games << ' '
+        << _options.pieces << ' ' << _options.depth << ' ' << _options.seed << ' ' << std::hexfloat
+        << _options.initialSigma << ' ' << _options.minSigma << '\n'
+        << "mean";
+    for (double value : _mean)
+    {
+        out << ' ' << value;
+    }
+    out << "\nsigma";
+    for (double value : _sigma)
+    {
+        out << ' ' << value;
+    }
+    out << std::defaultfloat << "\nrandom " << _random << '\n';
+}
+
+bool WeightTuner::LoadCheckpoint(std::istream& in)
+{
+    // hex floats are read through strtod, operator>> doesn't accept them everywhere
+    auto readDouble = [&in](double& value)
+    {
+        std::string text;
+        if (!(in >> text))
+        {
+            return false;
+        }
+        char* end = nullptr;
+        value = std::strtod(text.c_str(), &end);
+        return end != text.c_str() && *end == '\0';
+    };
+
+    std::string tag;
+    std::string label;
+    int version = 0;
+    int generation = 0;
+    TunerOptions options = _options;
+    Vector mean{};
+    Vector sigma{};
+    std::mt19937_64 random;
+    if (!(in >> tag >> version) || tag != CheckpointTag || version != CheckpointVersion)
+    {
+        return false;
+    }
+    bool ok = static_cast<bool>(in >> label >> generation) && label == "generation";
+    ok = ok && (in >> label >> options.population >> options.elite >> options.games >> options.pieces >>
+                options.depth >> options.seed) && label == "options";
+    ok = ok && readDouble(options.initialSigma) && readDouble(options.minSigma);
+    ok = ok && (in >> label) && label == "mean";
+    for (int i = 0; ok && i < Dimensions; ++i)
+    {
+        ok = readDouble(mean[i]);
+    }
+    ok = ok && (in >> label) && label == "sigma";
+    for (int i = 0; ok && i < Dimensions; ++i)
+    {
+        ok = readDouble(sigma[i]);
+    }
+    ok = ok && (in >> label) && label == "random" && (in >> random);
+    if (!ok || options.population < 2 || options.elite < 1 || options.elite > options.population || options.games < 1)
+    {
+        return false;
+    }
+
+    _options = options;
+    _generation = generation;
+    _mean = mean;
+    _sigma = sigma;
+    _random = random;
+    return true;
+}
@@ -0,0 +1,82 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int threads)
+{
+    for (int i = 1; i < threads; ++i)
+    {
+        _workers.emplace_back(&WorkerPool::WorkerLoop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _start.notify_all();
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void WorkerPool::RunSlice(int index)
+{
+    int threads = getThreadCount();
+    int begin = static_cast<int>(static_cast<long long>(_count) * index / threads);
+    int end = static_cast<int>(static_cast<long long>(_count) * (index + 1) / threads);
+    if (begin < end)
+    {
+        _function(_context, begin, end);
+    }
+}
+
+void WorkerPool::Dispatch(int count, TaskFunction function, void* context)
+{
+    if (_workers.empty())
+    {
+        function(context, 0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _function = function;
+        _context = context;
+        _count = count;
+        _running = static_cast<int>(_workers.size());
+        _generation++;
+    }
+    _start.notify_all();
+
+    RunSlice(0);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _running == 0; });
+}
+
+void WorkerPool::WorkerLoop(int index)
+{
+    int seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _start.wait(lock, [&] { return _stop || _generation != seen; });
+            if (_stop)
+            {
+                return;
+            }
+            seen = _generation;
+        }
+
+        RunSlice(index);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_running == 0)
+        {
+            _done.notify_one();
+        }
+    }
+}
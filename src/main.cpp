@@ -3,9 +3,15 @@ OpenGL Tetris game modified from http://qt-project.org/doc/qt-5.0/qtgui/openglwi
 ****************************************************************************/
 #include "NGLScene.h"
 #include <QtGui/QGuiApplication>
+#include <algorithm>
+#include <ctime>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
 #include "Board.h"
-#include "Tetromino.h"
+#include "VersusMatch.h"
+#include "NetplaySession.h"
 
 int main(int argc, char** argv) {
     // Create a GUI application
@@ -48,14 +54,123 @@ int main(int argc, char** argv) {
     window.resize(720, 1024);
 
     // Tetris-specific setup
-    int startx = 4; // Initial x-coordinate for Tetromino (adjusted to leave space)
-    int starty = 16; // Initial y-coordinate for Tetromino
-
-    // Initialize the game board and a tetromino piece
-    Board board(11, 20);
-    Tetromino tetromino(6, startx, starty);
-    window.setTetromino(tetromino);
-    window.setBoard(board);
+    // Number of boards, e.g. ./nglTetris --players 4 for a four way versus match,
+    // or --server PORT / --client HOST:PORT to play one other person over the network
+    int players = 1;
+    bool online = false;
+    bool measureInput = false;
+    bool blockout = false;
+    int sandboxWidth = 0;
+    int sandboxHeight = 0;
+    int botBudget = 0;
+    std::string botLink;
+    NetplayOptions netplay;
+    netplay.seed = static_cast<unsigned int>(std::time(nullptr));
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        // --measure-input reports how long key presses take to reach the simulation
+        if (arg == "--measure-input")
+        {
+            measureInput = true;
+            continue;
+        }
+        // --blockout plays the 3D well mode
+        if (arg == "--blockout")
+        {
+            blockout = true;
+            continue;
+        }
+        if (i + 1 == argc)
+        {
+            break;
+        }
+        std::string value = argv[i + 1];
+        if (arg == "--players")
+        {
+            players = std::stoi(value);
+        }
+        else if (arg == "--server")
+        {
+            online = true;
+            netplay.server = true;
+            netplay.port = std::stoi(value);
+        }
+        else if (arg == "--client")
+        {
+            online = true;
+            auto colon = value.find(':');
+            netplay.host = value.substr(0, colon);
+            if (colon != std::string::npos)
+            {
+                netplay.port = std::stoi(value.substr(colon + 1));
+            }
+        }
+        else if (arg == "--delay")
+        {
+            netplay.inputDelay = std::stoi(value);
+        }
+        // --sandbox WIDTHxHEIGHT, co-op on one large board, one lane per --players
+        else if (arg == "--sandbox")
+        {
+            auto x = value.find('x');
+            sandboxWidth = std::stoi(value.substr(0, x));
+            sandboxHeight = x != std::string::npos ? std::stoi(value.substr(x + 1)) : 40;
+        }
+        // --mcts MS lets the tree search play the first board, thinking MS milliseconds a piece
+        else if (arg == "--mcts")
+        {
+            botBudget = std::stoi(value);
+        }
+        // --bot-link NAME lets a bot process play the first board through shared memory, e.g. tetris_bot --name NAME
+        else if (arg == "--bot-link")
+        {
+            botLink = value;
+        }
+    }
+
+    // Initialize the game board, every player starts with the same empty board and piece sequence
+    Board board;
+    if (online)
+    {
+        std::cout << (netplay.server ? "Waiting for a client" : "Connecting to server") << "\n";
+        auto session = std::make_unique<NetplaySession>();
+        if (!session->Connect(board, netplay, 30000))
+        {
+            std::cerr << "Could not reach the other player\n";
+            return EXIT_FAILURE;
+        }
+        window.setNetplay(std::move(session));
+    }
+    else
+    {
+        window.setMatch(VersusMatch(players, board, netplay.seed));
+    }
+
+    if (blockout)
+    {
+        window.setVoxelGame(std::make_unique<VoxelGame>(netplay.seed));
+    }
+    else if (sandboxWidth > 0)
+    {
+        window.setSandbox(std::make_unique<SandboxGame>(sandboxWidth, sandboxHeight, players, netplay.seed));
+    }
+    else if (botBudget > 0 && !online)
+    {
+        int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        window.setBot(std::make_unique<MonteCarloSearch>(threads), botBudget);
+    }
+    else if (!botLink.empty() && !online)
+    {
+        auto link = std::make_unique<BotLink>();
+        if (!link->Create(botLink))
+        {
+            std::cerr << "Could not create the shared memory " << botLink << "\n";
+            return EXIT_FAILURE;
+        }
+        window.setBotLink(std::move(link));
+    }
+    window.setMeasureInput(measureInput);
 
     // Display the window
     window.show();